@@ -24,6 +24,7 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include <algorithm>
 #include <unordered_map>
 
 struct WTTFormatMapItem {
@@ -131,14 +132,24 @@ static basist::transcoder_texture_format SelectBasisTextureformat(const std::uno
 }
 // clang-format on
 
-basisu_transcode_result_t
-basisu_transcode(basisu_data_t basisu_data,
-                 WGPUTextureFormat (*supported_formats)[12],
-                 uint32_t supported_format_count, bool mipmaps)
-{
+struct basisu_transcoder_t {
+  basist::basisu_transcoder transcoder;
+  basisu_data_t data;
+  basist::transcoder_texture_format basis_format;
+  basisu_texture_desc_t desc;
 
-  basisu_transcode_result_t transcodeResult = {};
-  transcodeResult.result_code = BASIS_TRANSCODE_RESULT_TRANSCODE_FAILURE;
+  basisu_transcoder_t() : transcoder(g_pGlobal_codebook), data(), desc()
+  {
+  }
+};
+
+basisu_transcoder_t*
+basisu_transcoder_create(basisu_data_t basisu_data,
+                         const WGPUTextureFormat* supported_formats,
+                         uint32_t supported_format_count, bool mipmaps,
+                         uint32_t* result_code)
+{
+  *result_code = BASIS_TRANSCODE_RESULT_TRANSCODE_FAILURE;
 
   // The formats this device supports
   std::unordered_map<basist::transcoder_texture_format, bool>
@@ -148,7 +159,7 @@ basisu_transcode(basisu_data_t basisu_data,
     const auto wttFormat                = item.second.format;
     supportedBasisFormats[targetFormat] = false;
     for (uint32_t i = 0; i < supported_format_count; ++i) {
-      if ((*supported_formats)[i] == wttFormat) {
+      if (supported_formats[i] == wttFormat) {
         supportedBasisFormats[targetFormat] = true;
         break;
       }
@@ -158,32 +169,40 @@ basisu_transcode(basisu_data_t basisu_data,
   const auto basisuDataSize = static_cast<uint32_t>(basisu_data.size);
 
   assert(g_pGlobal_codebook);
-  basist::basisu_transcoder transcoder(g_pGlobal_codebook);
+  basisu_transcoder_t* result = new basisu_transcoder_t();
+  result->data                = basisu_data;
+
+  basist::basisu_transcoder& transcoder = result->transcoder;
   if (!transcoder.validate_header(basisu_data.ptr, basisuDataSize)) {
-    transcodeResult.result_code = BASIS_TRANSCODE_RESULT_INVALID_BASIS_HEADER;
-    return transcodeResult;
+    *result_code = BASIS_TRANSCODE_RESULT_INVALID_BASIS_HEADER;
+    delete result;
+    return nullptr;
   }
+  // Decodes the codebooks and tables shared by all images and levels
   if (!transcoder.start_transcoding(basisu_data.ptr, basisuDataSize)) {
-    transcodeResult.result_code = BASIS_TRANSCODE_RESULT_TRANSCODE_FAILURE;
-    return transcodeResult;
+    delete result;
+    return nullptr;
   }
 
+  basist::basisu_file_info fileInfo;
   basist::basisu_image_info imageInfo;
-  transcoder.get_image_info(basisu_data.ptr, basisuDataSize, imageInfo, 0);
+  if (!transcoder.get_file_info(basisu_data.ptr, basisuDataSize, fileInfo)
+      || !transcoder.get_image_info(basisu_data.ptr, basisuDataSize,
+                                    imageInfo, 0)
+      || imageInfo.m_total_levels == 0) {
+    *result_code = BASIS_TRANSCODE_RESULT_INVALID_BASIS_DATA;
+    delete result;
+    return nullptr;
+  }
 
   auto hasAlpha    = imageInfo.m_alpha_flag;
   auto levels      = imageInfo.m_total_levels;
   auto basisFormat = SelectBasisTextureformat(supportedBasisFormats, hasAlpha);
 
-  if (levels == 0) {
-    transcodeResult.result_code = BASIS_TRANSCODE_RESULT_INVALID_BASIS_DATA;
-    return transcodeResult;
-  }
-
   if (WTT_FORMAT_MAP.find(basisFormat) == WTT_FORMAT_MAP.end()) {
-    transcodeResult.result_code
-      = BASIS_TRANSCODE_RESULT_UNSUPPORTED_TRANSCODE_FORMAT;
-    return transcodeResult;
+    *result_code = BASIS_TRANSCODE_RESULT_UNSUPPORTED_TRANSCODE_FORMAT;
+    delete result;
+    return nullptr;
   }
 
   const auto& wttFormat = WTT_FORMAT_MAP.at(basisFormat);
@@ -193,58 +212,72 @@ basisu_transcode(basisu_data_t basisu_data,
   if (wttFormat.uncompressed || !mipmaps) {
     levels = 1;
   }
+  levels = std::min(levels, static_cast<uint32_t>(BASISU_MAX_MIPMAPS));
 
-  // Set image info
-  transcodeResult.image_desc.format      = wttFormat.format;
-  transcodeResult.image_desc.width       = imageInfo.m_width;
-  transcodeResult.image_desc.height      = imageInfo.m_height;
-  transcodeResult.image_desc.level_count = levels;
+  // Cube maps use the six faces, which have the same size and level count,
+  // other files only the first image
+  const bool isCubemap
+    = fileInfo.m_tex_type == basist::cBASISTexTypeCubemapArray
+      && fileInfo.m_total_images == 6;
+  const uint32_t images = isCubemap ? 6u : 1u;
 
-  // Transcode each mip level
-  uint32_t descW, descH, blocks;
-  for (uint32_t level = 0; level < levels; level++) {
-    // reset per level
-    bool success = false;
-    if (transcoder.get_image_level_desc(basisu_data.ptr, basisuDataSize, 0,
-                                        level, descW, descH, blocks)) {
-      uint32_t decSize = basis_get_bytes_per_block_or_pixel(basisFormat);
-      if (basis_transcoder_format_is_uncompressed(basisFormat)) {
-        decSize *= descW * descH;
-      }
-      else {
-        decSize *= blocks;
-      }
-      if (void* decBuf = malloc(decSize)) {
-        if (basis_transcoder_format_is_uncompressed(basisFormat)) {
-          // note that blocks becomes total number of pixels for RGB/RGBA
-          blocks = descW * descH;
-        }
-        if (transcoder.transcode_image_level(basisu_data.ptr, basisuDataSize, 0,
-                                             level, decBuf, blocks,
-                                             basisFormat)) {
-          transcodeResult.image_desc.levels[level].ptr  = decBuf;
-          transcodeResult.image_desc.levels[level].size = decSize;
-          success                                       = true;
-        }
-      }
-    }
-    if (!success) {
-      basisu_free(&transcodeResult.image_desc);
-      transcodeResult.result_code = BASIS_TRANSCODE_RESULT_TRANSCODE_FAILURE;
-      return transcodeResult;
-    }
-  }
-  transcodeResult.result_code = BASIS_TRANSCODE_RESULT_SUCCESS;
+  // Compressed textures use the size padded to whole blocks
+  const bool uncompressed
+    = basist::basis_transcoder_format_is_uncompressed(basisFormat);
+  result->basis_format = basisFormat;
+  result->desc.format  = wttFormat.format;
+  result->desc.width
+    = uncompressed ? imageInfo.m_orig_width : imageInfo.m_width;
+  result->desc.height
+    = uncompressed ? imageInfo.m_orig_height : imageInfo.m_height;
+  result->desc.image_count  = images;
+  result->desc.level_count  = levels;
+  result->desc.block_width  = uncompressed ? 1u : 4u;
+  result->desc.block_height = uncompressed ? 1u : 4u;
+  result->desc.block_size
+    = basist::basis_get_bytes_per_block_or_pixel(basisFormat);
+  result->desc.is_cubemap = isCubemap;
 
-  return transcodeResult;
+  *result_code = BASIS_TRANSCODE_RESULT_SUCCESS;
+  return result;
 }
 
-void basisu_free(const basisu_image_desc_t* desc)
+void basisu_transcoder_destroy(basisu_transcoder_t* transcoder)
 {
-  assert(desc);
-  for (uint32_t i = 0; i < desc->level_count; ++i) {
-    if (desc->levels[i].ptr) {
-      free((void*)desc->levels[i].ptr);
-    }
+  delete transcoder;
+}
+
+void basisu_transcoder_get_texture_desc(const basisu_transcoder_t* transcoder,
+                                        basisu_texture_desc_t* desc)
+{
+  *desc = transcoder->desc;
+}
+
+bool basisu_transcoder_transcode_level(const basisu_transcoder_t* transcoder,
+                                       uint32_t image_index,
+                                       uint32_t level_index, void* output,
+                                       uint32_t row_pitch)
+{
+  const auto dataSize = static_cast<uint32_t>(transcoder->data.size);
+  uint32_t descW, descH, blocks;
+  if (!transcoder->transcoder.get_image_level_desc(transcoder->data.ptr,
+                                                   dataSize, image_index,
+                                                   level_index, descW, descH,
+                                                   blocks)) {
+    return false;
   }
+
+  // The buffer size and the pitch are given in blocks, or pixels for
+  // uncompressed formats
+  const basisu_texture_desc_t& desc = transcoder->desc;
+  const uint32_t rows     = (descH + desc.block_height - 1) / desc.block_height;
+  const uint32_t rowPitch = row_pitch / desc.block_size;
+
+  // The state holds the per call decoder scratch memory, the transcoder
+  // itself is only read
+  basist::basisu_transcoder_state state;
+  return transcoder->transcoder.transcode_image_level(
+    transcoder->data.ptr, dataSize, image_index, level_index, output,
+    rowPitch * rows, transcoder->basis_format, 0, rowPitch, &state,
+    desc.block_height == 1 ? rows : 0);
 }
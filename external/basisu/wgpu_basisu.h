@@ -31,18 +31,20 @@ typedef struct basisu_data_t {
   size_t size;
 } basisu_data_t;
 
-typedef struct basisu_image_desc_t {
+/* Layout of the transcoded texture, the images are the faces of cube maps */
+typedef struct basisu_texture_desc_t {
   WGPUTextureFormat format;
   uint32_t width;
   uint32_t height;
+  uint32_t image_count; // 6 for cube maps
   uint32_t level_count; // Number of mipmaps
-  basisu_data_t levels[BASISU_MAX_MIPMAPS];
-} basisu_image_desc_t;
+  uint32_t block_width; // 1 for uncompressed formats
+  uint32_t block_height;
+  uint32_t block_size; // Bytes per block or pixel
+  bool is_cubemap;
+} basisu_texture_desc_t;
 
-typedef struct basisu_transcode_result_t {
-  uint32_t result_code;
-  basisu_image_desc_t image_desc;
-} basisu_transcode_result_t;
+typedef struct basisu_transcoder_t basisu_transcoder_t;
 
 /* Basis Universal Setup/Shudown */
 void basisu_setup(void);
@@ -50,11 +52,35 @@ void basisu_shutdown(void);
 bool basisu_is_initialized(void);
 
 /* Basis Universal transcoding */
-basisu_transcode_result_t
-basisu_transcode(basisu_data_t basisu_data,
-                 WGPUTextureFormat (*supported_formats)[12],
-                 uint32_t supported_format_count, bool mipmaps);
-void basisu_free(const basisu_image_desc_t* desc);
+
+/**
+ * @brief Validates the file, prepares the transcoder and selects the transcode
+ * target from the supported formats. basisu_setup() must have been called, the
+ * data must stay valid until the transcoder is destroyed.
+ * @param result_code set to one of the BASIS_TRANSCODE_RESULT_* values
+ * @return the transcoder or NULL on failure
+ */
+basisu_transcoder_t*
+basisu_transcoder_create(basisu_data_t basisu_data,
+                         const WGPUTextureFormat* supported_formats,
+                         uint32_t supported_format_count, bool mipmaps,
+                         uint32_t* result_code);
+void basisu_transcoder_destroy(basisu_transcoder_t* transcoder);
+
+void basisu_transcoder_get_texture_desc(const basisu_transcoder_t* transcoder,
+                                        basisu_texture_desc_t* desc);
+
+/**
+ * @brief Transcodes one level of one image into the output memory. Different
+ * (image, level) pairs can be transcoded on different threads at the same
+ * time.
+ * @param row_pitch bytes per row of blocks (pixels for uncompressed formats)
+ * in the output, a multiple of the block size
+ */
+bool basisu_transcoder_transcode_level(const basisu_transcoder_t* transcoder,
+                                       uint32_t image_index,
+                                       uint32_t level_index, void* output,
+                                       uint32_t row_pitch);
 
 #if defined(__cplusplus)
 } // extern "C"
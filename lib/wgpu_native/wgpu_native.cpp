@@ -2,12 +2,27 @@
 
 #include <dawn/dawn_proc.h>
 #include <dawn/native/DawnNative.h>
+#include <dawn/platform/DawnPlatform.h>
 #include <dawn/webgpu_cpp.h>
 
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 //****************************** Implementation *******************************/
 
@@ -29,9 +44,492 @@ namespace WGPUImpl {
 static const char* BackendTypeName(wgpu::BackendType);
 static const char* AdapterTypeName(wgpu::AdapterType);
 
+//******************************** Blob cache *********************************/
+
+// Persistent storage for Dawn's blob cache. Each blob is stored in its own file
+// named after the hash of its key, the file also holds the key itself so hash
+// collisions are detected. Blobs are written to a temporary file which is then
+// renamed, so concurrent launches never observe partially written blobs. The
+// file modification time records the last use and drives the LRU eviction
+// across launches.
+class BlobCache : public dawn::platform::CachingInterface {
+public:
+  BlobCache(const std::filesystem::path& directory, uint64_t maxSize)
+      : mDirectory(directory), mMaxSize(maxSize)
+  {
+    std::random_device rd;
+    mTempToken = (static_cast<uint64_t>(rd()) << 32) | rd();
+    ScanDirectory();
+  }
+
+  size_t LoadData(const void* key, size_t keySize, void* value,
+                  size_t valueSize) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const std::string name = BlobName(key, keySize);
+    std::ifstream file(mDirectory / name, std::ios::binary);
+    BlobHeader header = {};
+    if (!file || !ReadHeader(file, key, keySize, &header)) {
+      ++mStats.load_misses;
+      return 0;
+    }
+
+    // Dawn first queries the size of the blob
+    if (value == nullptr || valueSize == 0) {
+      return static_cast<size_t>(header.valueSize);
+    }
+    if (valueSize < header.valueSize) {
+      return 0;
+    }
+
+    file.read(static_cast<char*>(value),
+              static_cast<std::streamsize>(header.valueSize));
+    if (!file || Hash(value, header.valueSize, kValueSeed) != header.valueHash) {
+      // Corrupted blob, it is replaced by the next store
+      dlog("Discarding corrupted blob %s", name.c_str());
+      file.close();
+      RemoveEntry(name);
+      ++mStats.load_misses;
+      return 0;
+    }
+
+    TouchEntry(name);
+    ++mStats.load_hits;
+    mStats.load_bytes += header.valueSize;
+    return static_cast<size_t>(header.valueSize);
+  }
+
+  void StoreData(const void* key, size_t keySize, const void* value,
+                 size_t valueSize) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const std::string name  = BlobName(key, keySize);
+    const uint64_t fileSize = sizeof(BlobHeader) + keySize + valueSize;
+    if (fileSize > mMaxSize) {
+      return;
+    }
+
+    const BlobHeader header = {
+      kMagic,
+      kVersion,
+      static_cast<uint64_t>(keySize),
+      static_cast<uint64_t>(valueSize),
+      Hash(value, valueSize, kValueSeed),
+    };
+    const std::filesystem::path tempPath
+      = mDirectory
+        / (name + ".tmp" + std::to_string(mTempToken) + "_"
+           + std::to_string(mTempCounter++));
+    {
+      std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(static_cast<const char*>(key),
+                 static_cast<std::streamsize>(keySize));
+      file.write(static_cast<const char*>(value),
+                 static_cast<std::streamsize>(valueSize));
+      file.close();
+      if (!file) {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        return;
+      }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, mDirectory / name, ec);
+    if (ec) {
+      std::filesystem::remove(tempPath, ec);
+      return;
+    }
+
+    auto it = mEntries.find(name);
+    if (it != mEntries.end()) {
+      mSize -= it->second.size;
+    }
+    mEntries[name] = {fileSize, ++mUseCounter};
+    mSize += fileSize;
+    ++mStats.store_count;
+    mStats.store_bytes += valueSize;
+    Evict();
+  }
+
+  void GetStats(wgpu_blob_cache_stats_t* stats)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    *stats             = mStats;
+    stats->entry_count = static_cast<uint32_t>(mEntries.size());
+    stats->size        = mSize;
+  }
+
+private:
+  static constexpr uint32_t kMagic     = 0x424c4257; // "WBLB"
+  static constexpr uint32_t kVersion   = 1;
+  static constexpr uint64_t kNameSeed0 = 0xcbf29ce484222325ull;
+  static constexpr uint64_t kNameSeed1 = 0x84222325cbf29ce4ull;
+  static constexpr uint64_t kValueSeed = 0x9e3779b97f4a7c15ull;
+
+  struct BlobHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t keySize;
+    uint64_t valueSize;
+    uint64_t valueHash;
+  };
+
+  struct Entry {
+    uint64_t size;
+    uint64_t lastUse;
+  };
+
+  // FNV-1a
+  static uint64_t Hash(const void* data, size_t size, uint64_t seed)
+  {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash        = seed;
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+  }
+
+  static std::string BlobName(const void* key, size_t keySize)
+  {
+    char name[40];
+    snprintf(name, sizeof(name), "%016llx%016llx.blob",
+             static_cast<unsigned long long>(Hash(key, keySize, kNameSeed0)),
+             static_cast<unsigned long long>(Hash(key, keySize, kNameSeed1)));
+    return name;
+  }
+
+  static bool ReadHeader(std::ifstream& file, const void* key, size_t keySize,
+                         BlobHeader* header)
+  {
+    file.read(reinterpret_cast<char*>(header), sizeof(BlobHeader));
+    if (!file || header->magic != kMagic || header->version != kVersion
+        || header->keySize != keySize) {
+      return false;
+    }
+    std::vector<char> storedKey(keySize);
+    file.read(storedKey.data(), static_cast<std::streamsize>(keySize));
+    return file && memcmp(storedKey.data(), key, keySize) == 0;
+  }
+
+  // Rebuilds the LRU order of the blobs stored by previous launches
+  void ScanDirectory()
+  {
+    struct StoredBlob {
+      std::string name;
+      uint64_t size;
+      std::filesystem::file_time_type time;
+    };
+    std::vector<StoredBlob> blobs;
+    std::error_code ec;
+    for (const auto& item :
+         std::filesystem::directory_iterator(mDirectory, ec)) {
+      const std::string name = item.path().filename().string();
+      if (!item.is_regular_file(ec)) {
+        continue;
+      }
+      if (name.find(".tmp") != std::string::npos) {
+        // Left behind by an interrupted launch
+        std::filesystem::remove(item.path(), ec);
+        continue;
+      }
+      if (item.path().extension() != ".blob") {
+        continue;
+      }
+      blobs.push_back({name, static_cast<uint64_t>(item.file_size(ec)),
+                       item.last_write_time(ec)});
+    }
+    std::sort(blobs.begin(), blobs.end(),
+              [](const StoredBlob& a, const StoredBlob& b) {
+                return a.time < b.time;
+              });
+    for (const StoredBlob& blob : blobs) {
+      mEntries[blob.name] = {blob.size, ++mUseCounter};
+      mSize += blob.size;
+    }
+    Evict();
+  }
+
+  void TouchEntry(const std::string& name)
+  {
+    auto it = mEntries.find(name);
+    if (it != mEntries.end()) {
+      it->second.lastUse = ++mUseCounter;
+    }
+    std::error_code ec;
+    std::filesystem::last_write_time(
+      mDirectory / name, std::filesystem::file_time_type::clock::now(), ec);
+  }
+
+  void RemoveEntry(const std::string& name)
+  {
+    auto it = mEntries.find(name);
+    if (it != mEntries.end()) {
+      mSize -= it->second.size;
+      mEntries.erase(it);
+    }
+    std::error_code ec;
+    std::filesystem::remove(mDirectory / name, ec);
+  }
+
+  // Removes the least recently used blobs until the cache fits its limit
+  void Evict()
+  {
+    while (mSize > mMaxSize && !mEntries.empty()) {
+      auto oldest = std::min_element(
+        mEntries.begin(), mEntries.end(), [](const auto& a, const auto& b) {
+          return a.second.lastUse < b.second.lastUse;
+        });
+      const std::string name = oldest->first;
+      RemoveEntry(name);
+      ++mStats.evict_count;
+    }
+  }
+
+  const std::filesystem::path mDirectory;
+  const uint64_t mMaxSize;
+  std::mutex mMutex;
+  std::unordered_map<std::string, Entry> mEntries;
+  uint64_t mSize                 = 0;
+  uint64_t mUseCounter           = 0;
+  uint64_t mTempToken            = 0;
+  uint64_t mTempCounter          = 0;
+  wgpu_blob_cache_stats_t mStats = {};
+};
+
+//***************************** Worker task pool ******************************/
+
+// Trace event forwarding, set by the host application while Dawn's worker
+// threads may be reading the callbacks
+static struct {
+  std::atomic<uint64_t (*)(void)> getTimeNs{nullptr};
+  std::atomic<void (*)(const char*, uint64_t, uint64_t)> recordSpan{nullptr};
+  std::atomic<void (*)(const char*)> setThreadName{nullptr};
+  // Category flag read by Dawn's trace macros
+  std::atomic<unsigned char> enabled{0};
+  const unsigned char disabled = 0;
+} traceForwarding;
+static_assert(sizeof(std::atomic<unsigned char>) == sizeof(unsigned char)
+                && std::atomic<unsigned char>::is_always_lock_free,
+              "Dawn reads the trace category flag as a plain byte");
+
+// Dawn's worker pool counters
+static struct {
+  std::atomic<uint32_t> threadCount{0};
+  std::atomic<uint64_t> taskCount{0};
+} workerPoolStats;
+
+static uint64_t GetTimeNs()
+{
+  const auto getTimeNs
+    = traceForwarding.getTimeNs.load(std::memory_order_acquire);
+  if (getTimeNs != nullptr) {
+    return getTimeNs();
+  }
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count());
+}
+
+// Completion state shared by a posted task and its waitable event
+struct TaskState {
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool complete = false;
+};
+
+class WaitableEvent : public dawn::platform::WaitableEvent {
+public:
+  explicit WaitableEvent(std::shared_ptr<TaskState> state)
+      : mState(std::move(state))
+  {
+  }
+
+  void Wait() override
+  {
+    std::unique_lock<std::mutex> lock(mState->mutex);
+    mState->condition.wait(lock, [this] { return mState->complete; });
+  }
+
+  bool IsComplete() override
+  {
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    return mState->complete;
+  }
+
+private:
+  std::shared_ptr<TaskState> mState;
+};
+
+// Fixed set of threads running Dawn's background work (shader translation,
+// async pipeline creation). Dawn's default pool spawns a thread per task.
+class WorkerTaskPool : public dawn::platform::WorkerTaskPool {
+public:
+  explicit WorkerTaskPool(uint32_t threadCount)
+  {
+    for (uint32_t i = 0; i < threadCount; ++i) {
+      mThreads.emplace_back([this, i] { Run(i); });
+    }
+    workerPoolStats.threadCount += threadCount;
+  }
+
+  ~WorkerTaskPool() override
+  {
+    // Pending tasks are completed before the threads exit
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+    }
+    mCondition.notify_all();
+    for (std::thread& thread : mThreads) {
+      thread.join();
+    }
+    workerPoolStats.threadCount -= static_cast<uint32_t>(mThreads.size());
+  }
+
+  std::unique_ptr<dawn::platform::WaitableEvent>
+  PostWorkerTask(dawn::platform::PostWorkerTaskCallback callback,
+                 void* userdata) override
+  {
+    std::shared_ptr<TaskState> state = std::make_shared<TaskState>();
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mTasks.push_back({callback, userdata, state});
+    }
+    mCondition.notify_one();
+    return std::make_unique<WaitableEvent>(std::move(state));
+  }
+
+private:
+  struct Task {
+    dawn::platform::PostWorkerTaskCallback callback;
+    void* userdata;
+    std::shared_ptr<TaskState> state;
+  };
+
+  void Run(uint32_t index)
+  {
+    const auto setThreadName
+      = traceForwarding.setThreadName.load(std::memory_order_acquire);
+    if (setThreadName != nullptr) {
+      char name[32];
+      snprintf(name, sizeof(name), "Dawn worker %u", index);
+      setThreadName(name);
+    }
+
+    for (;;) {
+      Task task;
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mStopping || !mTasks.empty(); });
+        if (mTasks.empty()) {
+          return;
+        }
+        task = std::move(mTasks.front());
+        mTasks.pop_front();
+      }
+
+      task.callback(task.userdata);
+      {
+        std::lock_guard<std::mutex> lock(task.state->mutex);
+        task.state->complete = true;
+      }
+      task.state->condition.notify_all();
+      ++workerPoolStats.taskCount;
+    }
+  }
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::deque<Task> mTasks;
+  std::vector<std::thread> mThreads;
+  bool mStopping = false;
+};
+
+//********************************* Platform **********************************/
+
+// Provides the blob cache, the worker task pool and forwards Dawn's CPU trace
+// events (begin/end pairs) as spans into the host's trace
+class Platform : public dawn::platform::Platform {
+public:
+  explicit Platform(BlobCache* blobCache) : mBlobCache(blobCache)
+  {
+  }
+
+  dawn::platform::CachingInterface* GetCachingInterface() override
+  {
+    return mBlobCache;
+  }
+
+  std::unique_ptr<dawn::platform::WorkerTaskPool>
+  CreateWorkerTaskPool() override
+  {
+    // Leaves one core to the render thread
+    const uint32_t coreCount = std::thread::hardware_concurrency();
+    return std::make_unique<WorkerTaskPool>(
+      std::clamp(coreCount > 1u ? coreCount - 1u : 1u, 1u, 8u));
+  }
+
+  const unsigned char*
+  GetTraceCategoryEnabledFlag(dawn::platform::TraceCategory category) override
+  {
+    // GPU work is traced with async events which are not forwarded
+    return (category == dawn::platform::TraceCategory::GPUWork) ?
+             &traceForwarding.disabled :
+             reinterpret_cast<const unsigned char*>(&traceForwarding.enabled);
+  }
+
+  double MonotonicallyIncreasingTime() override
+  {
+    return static_cast<double>(GetTimeNs()) / 1e9;
+  }
+
+  uint64_t AddTraceEvent(char phase, const unsigned char* categoryGroupEnabled,
+                         const char* name, uint64_t id, double timestamp,
+                         int numArgs, const char** argNames,
+                         const unsigned char* argTypes,
+                         const uint64_t* argValues,
+                         unsigned char flags) override
+  {
+    (void)categoryGroupEnabled;
+    (void)id;
+    (void)numArgs;
+    (void)argNames;
+    (void)argTypes;
+    (void)argValues;
+    (void)flags;
+
+    // Scoped events are reported as begin/end pairs on the same thread
+    thread_local std::vector<std::pair<const char*, uint64_t>> openEvents;
+    const uint64_t timestampNs = static_cast<uint64_t>(timestamp * 1e9);
+    if (phase == 'B') {
+      openEvents.emplace_back(name, timestampNs);
+    }
+    else if (phase == 'E' && !openEvents.empty()) {
+      const std::pair<const char*, uint64_t> event = openEvents.back();
+      openEvents.pop_back();
+      const auto recordSpan
+        = traceForwarding.recordSpan.load(std::memory_order_acquire);
+      if (recordSpan != nullptr) {
+        recordSpan(event.first, event.second, timestampNs);
+      }
+    }
+    return 0;
+  }
+
+private:
+  BlobCache* mBlobCache;
+};
+
 static struct {
   struct {
     DawnProcTable procTable;
+    std::unique_ptr<BlobCache> blobCache             = nullptr;
+    std::unique_ptr<Platform> platform               = nullptr;
     std::unique_ptr<dawn::native::Instance> instance = nullptr;
   } dawn_native;
   struct {
@@ -43,6 +541,13 @@ static struct {
       const char* backendName;
     } info;
   } adapter;
+  struct {
+    std::string backend; // backend type name, empty matches all backends
+    std::string type;    // adapter type name, empty matches all types
+    std::string name;    // adapter name substring, empty matches all names
+  } adapterFilter;
+  wgpu_backend_validation_level_enum validationLevel
+    = BackendValidationLevel_Full;
   bool initialized = false;
 } gpuContext = {};
 
@@ -55,12 +560,27 @@ static void Initialize()
   // Set up the native procs for the global proctable
   gpuContext.dawn_native.procTable = dawn::native::GetProcs();
   dawnProcSetProcs(&gpuContext.dawn_native.procTable);
-  gpuContext.dawn_native.instance = std::make_unique<dawn::native::Instance>();
+  // The platform provides the persistent blob cache (when enabled), the worker
+  // threads and the trace event forwarding
+  gpuContext.dawn_native.platform
+    = std::make_unique<Platform>(gpuContext.dawn_native.blobCache.get());
+  dawn::native::DawnInstanceDescriptor dawnInstanceDesc;
+  dawnInstanceDesc.platform = gpuContext.dawn_native.platform.get();
+  wgpu::InstanceDescriptor instanceDesc;
+  instanceDesc.nextInChain = &dawnInstanceDesc;
+  gpuContext.dawn_native.instance = std::make_unique<dawn::native::Instance>(
+    reinterpret_cast<const WGPUInstanceDescriptor*>(&instanceDesc));
+  // Backend validation is set up when the backends are initialized
+  gpuContext.dawn_native.instance->EnableBackendValidation(
+    gpuContext.validationLevel != BackendValidationLevel_Off);
+  gpuContext.dawn_native.instance->SetBackendValidationLevel(
+    gpuContext.validationLevel == BackendValidationLevel_Full ?
+      dawn::native::BackendValidationLevel::Full :
+    gpuContext.validationLevel == BackendValidationLevel_Partial ?
+      dawn::native::BackendValidationLevel::Partial :
+      dawn::native::BackendValidationLevel::Disabled);
   // Discovers adapters
   (void)gpuContext.dawn_native.instance->EnumerateAdapters();
-  gpuContext.dawn_native.instance->EnableBackendValidation(true);
-  gpuContext.dawn_native.instance->SetBackendValidationLevel(
-    dawn::native::BackendValidationLevel::Full);
 
   // Dawn backend type.
   // Default to D3D12, Metal, Vulkan, OpenGL in that order as D3D12 and Metal
@@ -82,6 +602,72 @@ static void Initialize()
   gpuContext.initialized    = true;
 }
 
+static bool SetBackendValidationLevel(wgpu_backend_validation_level_enum level)
+{
+  if (gpuContext.initialized) {
+    if (level != gpuContext.validationLevel) {
+      fprintf(stderr, "Backend validation level has to be set before the "
+                      "instance is created\n");
+    }
+    return level == gpuContext.validationLevel;
+  }
+
+  gpuContext.validationLevel = level;
+  return true;
+}
+
+static bool EnableBlobCache(const char* directory, uint64_t maxSize)
+{
+  if (gpuContext.initialized) {
+    fprintf(stderr, "Blob cache has to be enabled before the instance is "
+                    "created\n");
+    return false;
+  }
+  if (gpuContext.dawn_native.blobCache != nullptr) {
+    return true;
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+  if (ec || !std::filesystem::is_directory(directory, ec)) {
+    fprintf(stderr, "Unable to create blob cache directory: %s\n", directory);
+    return false;
+  }
+  gpuContext.dawn_native.blobCache
+    = std::make_unique<BlobCache>(directory, maxSize);
+  dlog("Blob cache enabled in %s (%llu bytes)", directory,
+       static_cast<unsigned long long>(maxSize));
+  return true;
+}
+
+static void GetBlobCacheStats(wgpu_blob_cache_stats_t* stats)
+{
+  *stats = {};
+  if (gpuContext.dawn_native.blobCache != nullptr) {
+    gpuContext.dawn_native.blobCache->GetStats(stats);
+  }
+}
+
+static void SetTraceCallbacks(const wgpu_trace_callbacks_t* callbacks)
+{
+  const wgpu_trace_callbacks_t forwarded
+    = callbacks ? *callbacks : wgpu_trace_callbacks_t{};
+  traceForwarding.getTimeNs.store(forwarded.get_time_ns,
+                                  std::memory_order_release);
+  traceForwarding.setThreadName.store(forwarded.set_thread_name,
+                                      std::memory_order_release);
+  traceForwarding.recordSpan.store(forwarded.record_span,
+                                   std::memory_order_release);
+  traceForwarding.enabled.store((forwarded.record_span != nullptr) ? 1 : 0,
+                                std::memory_order_release);
+}
+
+static void GetWorkerPoolStats(wgpu_worker_pool_stats_t* stats)
+{
+  stats->thread_count = workerPoolStats.threadCount.load();
+  stats->task_count   = workerPoolStats.taskCount.load();
+}
+
 static void SetAdapterInfo(const wgpu::AdapterProperties& ap)
 {
   gpuContext.adapter.info.name        = ap.name;
@@ -89,10 +675,128 @@ static void SetAdapterInfo(const wgpu::AdapterProperties& ap)
   gpuContext.adapter.info.backendName = BackendTypeName(ap.backendType);
 }
 
+// Names accepted by the adapter filter, compared case-insensitively
+static const struct {
+  const char* name;
+  wgpu::BackendType type;
+} kBackendTypeNames[] = {
+  {"null", wgpu::BackendType::Null},
+  {"webgpu", wgpu::BackendType::WebGPU},
+  {"d3d11", wgpu::BackendType::D3D11},
+  {"d3d12", wgpu::BackendType::D3D12},
+  {"metal", wgpu::BackendType::Metal},
+  {"vulkan", wgpu::BackendType::Vulkan},
+  {"opengl", wgpu::BackendType::OpenGL},
+  {"opengles", wgpu::BackendType::OpenGLES},
+};
+static const struct {
+  const char* name;
+  wgpu::AdapterType type;
+} kAdapterTypeNames[] = {
+  {"discrete", wgpu::AdapterType::DiscreteGPU},
+  {"integrated", wgpu::AdapterType::IntegratedGPU},
+  {"cpu", wgpu::AdapterType::CPU},
+  {"unknown", wgpu::AdapterType::Unknown},
+};
+
+static std::string ToLower(const char* value)
+{
+  std::string result = value ? value : "";
+  std::transform(result.begin(), result.end(), result.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return result;
+}
+
+static bool HasAdapterFilter()
+{
+  return !gpuContext.adapterFilter.backend.empty()
+         || !gpuContext.adapterFilter.type.empty()
+         || !gpuContext.adapterFilter.name.empty();
+}
+
+static bool MatchesAdapterFilter(const wgpu::AdapterProperties& ap)
+{
+  const auto& filter = gpuContext.adapterFilter;
+  if (!filter.backend.empty()) {
+    bool match = false;
+    for (const auto& backend : kBackendTypeNames) {
+      match = match
+              || (filter.backend == backend.name
+                  && ap.backendType == backend.type);
+    }
+    if (!match) {
+      return false;
+    }
+  }
+  if (!filter.type.empty()) {
+    bool match = false;
+    for (const auto& type : kAdapterTypeNames) {
+      match = match
+              || (filter.type == type.name && ap.adapterType == type.type);
+    }
+    if (!match) {
+      return false;
+    }
+  }
+  return filter.name.empty()
+         || ToLower(ap.name).find(filter.name) != std::string::npos;
+}
+
+static bool SetAdapterFilter(const wgpu_adapter_filter_t* filter)
+{
+  gpuContext.adapterFilter.backend = ToLower(filter ? filter->backend : NULL);
+  gpuContext.adapterFilter.type    = ToLower(filter ? filter->type : NULL);
+  gpuContext.adapterFilter.name    = ToLower(filter ? filter->name : NULL);
+
+  bool valid = gpuContext.adapterFilter.backend.empty();
+  for (const auto& backend : kBackendTypeNames) {
+    valid = valid || gpuContext.adapterFilter.backend == backend.name;
+  }
+  if (!valid) {
+    fprintf(stderr, "Unknown backend type: %s\n", filter->backend);
+    return false;
+  }
+  valid = gpuContext.adapterFilter.type.empty();
+  for (const auto& type : kAdapterTypeNames) {
+    valid = valid || gpuContext.adapterFilter.type == type.name;
+  }
+  if (!valid) {
+    fprintf(stderr, "Unknown adapter type: %s\n", filter->type);
+    return false;
+  }
+  return true;
+}
+
 static WGPUAdapter RequestAdapter(WGPURequestAdapterOptions* options)
 {
   Initialize();
 
+  std::vector<dawn::native::Adapter> adapters
+    = gpuContext.dawn_native.instance->EnumerateAdapters();
+
+  // An explicit adapter filter overrides the power preference and the
+  // fallback adapter request
+  if (HasAdapterFilter()) {
+    for (const dawn::native::Adapter& adapter : adapters) {
+      wgpu::AdapterProperties ap;
+      adapter.GetProperties(&ap);
+      if (MatchesAdapterFilter(ap)) {
+        gpuContext.adapter.handle = adapter;
+        SetAdapterInfo(ap);
+        dlog("Selected adapter %s by filter (type=%s/%s)", ap.name,
+             gpuContext.adapter.info.typeName,
+             gpuContext.adapter.info.backendName);
+        return gpuContext.adapter.handle.Get();
+      }
+    }
+    fprintf(stderr, "No adapter matches backend=\"%s\" type=\"%s\" "
+                    "name=\"%s\"\n",
+            gpuContext.adapterFilter.backend.c_str(),
+            gpuContext.adapterFilter.type.c_str(),
+            gpuContext.adapterFilter.name.c_str());
+    return nullptr;
+  }
+
   WGPUPowerPreference powerPreference
     = options ?
         (options->powerPreference == WGPUPowerPreference_HighPerformance ?
@@ -120,8 +824,26 @@ static WGPUAdapter RequestAdapter(WGPURequestAdapterOptions* options)
     };
   }
 
-  std::vector<dawn::native::Adapter> adapters
-    = gpuContext.dawn_native.instance->EnumerateAdapters();
+  // Fallback adapter requested (headless runs): prefer Dawn's Null backend
+  // which does not execute any GPU work, then the CPU (SwiftShader) adapter
+  if (options && options->forceFallbackAdapter) {
+    for (const dawn::native::Adapter& adapter : adapters) {
+      wgpu::AdapterProperties ap;
+      adapter.GetProperties(&ap);
+      if (ap.backendType == wgpu::BackendType::Null) {
+        gpuContext.adapter.handle = adapter;
+        SetAdapterInfo(ap);
+        dlog("Selected fallback adapter %s (type=%s/%s)", ap.name,
+             gpuContext.adapter.info.typeName,
+             gpuContext.adapter.info.backendName);
+        return gpuContext.adapter.handle.Get();
+      }
+    }
+    typePriority = std::vector<wgpu::AdapterType>{
+      wgpu::AdapterType::CPU,
+    };
+  }
+
   for (auto reqType : typePriority) {
     for (const dawn::native::Adapter& adapter : adapters) {
       wgpu::AdapterProperties ap;
@@ -160,6 +882,67 @@ static void LogAvailableAdapters()
   }
 }
 
+static void ListAdapters()
+{
+  Initialize();
+
+  const std::vector<dawn::native::Adapter> adapters
+    = gpuContext.dawn_native.instance->EnumerateAdapters();
+  printf("Found %zu adapters\n", adapters.size());
+  for (const dawn::native::Adapter& adapter : adapters) {
+    wgpu::AdapterProperties p;
+    adapter.GetProperties(&p);
+    printf("\n%s (%s)\n", p.name, p.driverDescription);
+    printf("  Backend: %s, type: %s, vendorID=0x%x, deviceID=0x%x\n",
+           BackendTypeName(p.backendType), AdapterTypeName(p.adapterType),
+           p.vendorID, p.deviceID);
+
+    WGPUSupportedLimits supported = {};
+    if (adapter.GetLimits(&supported)) {
+      const WGPULimits& l = supported.limits;
+      printf("  Limits:\n");
+      printf("    maxTextureDimension1D/2D/3D: %u / %u / %u\n",
+             l.maxTextureDimension1D, l.maxTextureDimension2D,
+             l.maxTextureDimension3D);
+      printf("    maxTextureArrayLayers: %u\n", l.maxTextureArrayLayers);
+      printf("    maxBindGroups: %u\n", l.maxBindGroups);
+      printf("    maxDynamicUniform/StorageBuffersPerPipelineLayout: %u / %u\n",
+             l.maxDynamicUniformBuffersPerPipelineLayout,
+             l.maxDynamicStorageBuffersPerPipelineLayout);
+      printf("    maxSampledTextures/Samplers/StorageBuffers/StorageTextures/"
+             "UniformBuffersPerShaderStage: %u / %u / %u / %u / %u\n",
+             l.maxSampledTexturesPerShaderStage, l.maxSamplersPerShaderStage,
+             l.maxStorageBuffersPerShaderStage,
+             l.maxStorageTexturesPerShaderStage,
+             l.maxUniformBuffersPerShaderStage);
+      printf("    maxUniform/StorageBufferBindingSize: %llu / %llu\n",
+             static_cast<unsigned long long>(l.maxUniformBufferBindingSize),
+             static_cast<unsigned long long>(l.maxStorageBufferBindingSize));
+      printf("    minUniform/StorageBufferOffsetAlignment: %u / %u\n",
+             l.minUniformBufferOffsetAlignment,
+             l.minStorageBufferOffsetAlignment);
+      printf("    maxVertexBuffers/Attributes: %u / %u\n", l.maxVertexBuffers,
+             l.maxVertexAttributes);
+      printf("    maxBufferSize: %llu\n",
+             static_cast<unsigned long long>(l.maxBufferSize));
+      printf("    maxComputeWorkgroupStorageSize: %u\n",
+             l.maxComputeWorkgroupStorageSize);
+      printf("    maxComputeInvocationsPerWorkgroup: %u\n",
+             l.maxComputeInvocationsPerWorkgroup);
+      printf("    maxComputeWorkgroupSizeX/Y/Z: %u / %u / %u\n",
+             l.maxComputeWorkgroupSizeX, l.maxComputeWorkgroupSizeY,
+             l.maxComputeWorkgroupSizeZ);
+      printf("    maxComputeWorkgroupsPerDimension: %u\n",
+             l.maxComputeWorkgroupsPerDimension);
+    }
+
+    printf("  Features:\n");
+    for (const char* feature : adapter.GetSupportedFeatures()) {
+      printf("    %s\n", feature);
+    }
+  }
+}
+
 static void GetAdapterInfo(char (*adapter_info)[256])
 {
   strncpy(adapter_info[0], gpuContext.adapter.info.name, 256);
@@ -243,11 +1026,51 @@ static const char* AdapterTypeName(wgpu::AdapterType t)
 
 //******************************** Public API *********************************/
 
+int wgpu_enable_blob_cache(const char* directory, uint64_t max_size)
+{
+  return WGPUImpl::EnableBlobCache(directory, max_size) ? 1 : 0;
+}
+
+void wgpu_get_blob_cache_stats(wgpu_blob_cache_stats_t* stats)
+{
+  WGPUImpl::GetBlobCacheStats(stats);
+}
+
+int wgpu_set_backend_validation_level(wgpu_backend_validation_level_enum level)
+{
+  return WGPUImpl::SetBackendValidationLevel(level) ? 1 : 0;
+}
+
+wgpu_backend_validation_level_enum wgpu_get_backend_validation_level()
+{
+  return WGPUImpl::gpuContext.validationLevel;
+}
+
+void wgpu_set_trace_callbacks(const wgpu_trace_callbacks_t* callbacks)
+{
+  WGPUImpl::SetTraceCallbacks(callbacks);
+}
+
+void wgpu_get_worker_pool_stats(wgpu_worker_pool_stats_t* stats)
+{
+  WGPUImpl::GetWorkerPoolStats(stats);
+}
+
 void wgpu_log_available_adapters()
 {
   WGPUImpl::LogAvailableAdapters();
 }
 
+void wgpu_list_adapters()
+{
+  WGPUImpl::ListAdapters();
+}
+
+int wgpu_set_adapter_filter(const wgpu_adapter_filter_t* filter)
+{
+  return WGPUImpl::SetAdapterFilter(filter) ? 1 : 0;
+}
+
 void wgpu_get_adapter_info(char (*adapter_info)[256])
 {
   WGPUImpl::GetAdapterInfo(adapter_info);
@@ -1,12 +1,95 @@
 #ifndef WGPU_NATIVE_H
 #define WGPU_NATIVE_H
 
+#include <stdint.h>
+
 #include <dawn/webgpu.h>
 
+/* Default size limit of the on-disk blob cache */
+#define WGPU_BLOB_CACHE_DEFAULT_MAX_SIZE (256ull * 1024ull * 1024ull)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Dawn backend validation (e.g. Vulkan validation layers) */
+typedef enum wgpu_backend_validation_level_enum {
+  BackendValidationLevel_Off     = 0,
+  BackendValidationLevel_Partial = 1,
+  BackendValidationLevel_Full    = 2,
+} wgpu_backend_validation_level_enum;
+
+/**
+ * @brief Sets the backend validation level, has to be called before the first
+ * adapter request. Full validation is used by default.
+ * @return 1 if the level is in effect, 0 otherwise
+ */
+int wgpu_set_backend_validation_level(wgpu_backend_validation_level_enum level);
+wgpu_backend_validation_level_enum wgpu_get_backend_validation_level();
+
+typedef struct wgpu_blob_cache_stats_t {
+  uint32_t entry_count;  /* blobs stored in the cache directory */
+  uint64_t size;         /* bytes stored in the cache directory */
+  uint64_t load_hits;    /* blobs loaded by Dawn */
+  uint64_t load_misses;  /* lookups without a (valid) blob */
+  uint64_t load_bytes;   /* bytes loaded by Dawn */
+  uint64_t store_count;  /* blobs written by Dawn */
+  uint64_t store_bytes;  /* bytes written by Dawn */
+  uint64_t evict_count;  /* blobs removed to stay below the size limit */
+} wgpu_blob_cache_stats_t;
+
+/**
+ * @brief Enables Dawn's persistent blob cache (translated shaders, pipeline
+ * caches) in the given directory. Blobs are content-addressed by their cache
+ * key and the least recently used blobs are evicted above max_size bytes. Has
+ * to be called before the first adapter request.
+ * @return 1 if the cache is enabled, 0 otherwise
+ */
+int wgpu_enable_blob_cache(const char* directory, uint64_t max_size);
+void wgpu_get_blob_cache_stats(wgpu_blob_cache_stats_t* stats);
+
+/* Host trace functions Dawn's CPU trace events are forwarded to */
+typedef struct wgpu_trace_callbacks_t {
+  uint64_t (*get_time_ns)(void); /* monotonic clock of the host trace */
+  void (*record_span)(const char* name, uint64_t start_ns, uint64_t end_ns);
+  void (*set_thread_name)(const char* name); /* names Dawn's worker threads */
+} wgpu_trace_callbacks_t;
+
+/**
+ * @brief Forwards Dawn's CPU trace events (validation, command recording,
+ * shader translation, ...) as spans to the host trace, NULL stops forwarding.
+ * The clock has to be set before the first adapter request.
+ */
+void wgpu_set_trace_callbacks(const wgpu_trace_callbacks_t* callbacks);
+
+/* Dawn's background work (shader translation, async pipeline creation) */
+typedef struct wgpu_worker_pool_stats_t {
+  uint32_t thread_count; /* worker threads of all devices */
+  uint64_t task_count;   /* tasks completed by the worker threads */
+} wgpu_worker_pool_stats_t;
+
+void wgpu_get_worker_pool_stats(wgpu_worker_pool_stats_t* stats);
+
+/* Adapter selection, the filter fields are compared case-insensitively */
+typedef struct wgpu_adapter_filter_t {
+  const char* backend; /* null, webgpu, d3d11, d3d12, metal, vulkan, opengl,
+                          opengles, NULL matches all backends */
+  const char* type;    /* discrete, integrated, cpu, unknown, NULL matches all
+                          types */
+  const char* name;    /* adapter name substring, NULL matches all names */
+} wgpu_adapter_filter_t;
+
+/**
+ * @brief Restricts wgpu_request_adapter to the first adapter matching the
+ * filter, overriding the power preference and fallback adapter options. NULL
+ * restores the default selection.
+ * @return 1 if the filter is valid, 0 otherwise
+ */
+int wgpu_set_adapter_filter(const wgpu_adapter_filter_t* filter);
+
+/* Prints the adapters with their limits and features to stdout */
+void wgpu_list_adapters();
+
 void wgpu_log_available_adapters();
 void wgpu_get_adapter_info(char (*adapter_info)[256]);
 WGPUAdapter wgpu_request_adapter(WGPURequestAdapterOptions* options);
@@ -1,14 +1,18 @@
 #ifndef CORE_API_H
 #define CORE_API_H
 
+#include "benchmark.h"
 #include "camera.h"
 #include "file.h"
 #include "frustum.h"
 #include "input.h"
+#include "job_system.h"
 #include "log.h"
 #include "macro.h"
 #include "math.h"
+#include "mip_chain.h"
 #include "platform.h"
+#include "trace.h"
 #include "utils.h"
 #include "window.h"
 
@@ -0,0 +1,256 @@
+#include "benchmark.h"
+
+#include <cJSON.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+#include "log.h"
+#include "macro.h"
+
+/* Active benchmark run */
+static struct {
+  bool running;
+  char name[STRMAX];
+  benchmark_settings_t settings;
+  uint32_t frame_index; /* frames seen, including warmup frames */
+  struct {
+    float* data;
+    uint32_t count;
+  } frame_times;
+} benchmark = {0};
+
+void benchmark_start(const char* name, const benchmark_settings_t* settings)
+{
+  ASSERT(name && settings);
+
+  free(benchmark.frame_times.data);
+  memset(&benchmark, 0, sizeof(benchmark));
+
+  snprintf(benchmark.name, sizeof(benchmark.name), "%s", name);
+  benchmark.settings         = *settings;
+  benchmark.frame_times.data = (float*)calloc(
+    MAX(settings->measured_frames, 1u), sizeof(*benchmark.frame_times.data));
+  benchmark.running = true;
+}
+
+void benchmark_shutdown(void)
+{
+  free(benchmark.frame_times.data);
+  memset(&benchmark, 0, sizeof(benchmark));
+}
+
+static int compare_floats(const void* a, const void* b)
+{
+  const float fa = *(const float*)a, fb = *(const float*)b;
+  return (fa > fb) - (fa < fb);
+}
+
+/* Nearest-rank percentile of a sorted array */
+static double percentile(const float* sorted, uint32_t count, double p)
+{
+  uint32_t rank = (uint32_t)ceil(p / 100.0 * (double)count);
+  rank          = CLAMP(rank, 1u, count);
+  return (double)sorted[rank - 1];
+}
+
+void benchmark_stop(benchmark_stats_t* stats)
+{
+  benchmark.running = false;
+
+  if (stats == NULL) {
+    return;
+  }
+
+  memset(stats, 0, sizeof(*stats));
+  const uint32_t count = benchmark.frame_times.count;
+  if (count == 0) {
+    return;
+  }
+
+  float* sorted = (float*)malloc(count * sizeof(float));
+  memcpy(sorted, benchmark.frame_times.data, count * sizeof(float));
+  qsort(sorted, count, sizeof(float), compare_floats);
+
+  double sum = 0.0;
+  for (uint32_t i = 0; i < count; ++i) {
+    sum += sorted[i];
+  }
+
+  stats->frame_count = count;
+  stats->min         = sorted[0];
+  stats->mean        = sum / (double)count;
+  stats->p50         = percentile(sorted, count, 50.0);
+  stats->p95         = percentile(sorted, count, 95.0);
+  stats->p99         = percentile(sorted, count, 99.0);
+  stats->max         = sorted[count - 1];
+
+  free(sorted);
+}
+
+bool benchmark_is_running(void)
+{
+  return benchmark.running;
+}
+
+bool benchmark_is_finished(void)
+{
+  return benchmark.frame_index
+         >= benchmark.settings.warmup_frames
+              + benchmark.settings.measured_frames;
+}
+
+void benchmark_record_frame(float cpu_time_millis)
+{
+  if (!benchmark.running) {
+    return;
+  }
+
+  if (benchmark.frame_index >= benchmark.settings.warmup_frames
+      && benchmark.frame_times.count < benchmark.settings.measured_frames) {
+    benchmark.frame_times.data[benchmark.frame_times.count++]
+      = cpu_time_millis;
+  }
+  ++benchmark.frame_index;
+}
+
+int benchmark_write_csv(const char* filename)
+{
+  FILE* file = fopen(filename, "w");
+  if (file == NULL) {
+    log_error("Unable to open file '%s'\n", filename);
+    return -1;
+  }
+
+  fprintf(file, "frame,cpu_time_ms\n");
+  for (uint32_t i = 0; i < benchmark.frame_times.count; ++i) {
+    fprintf(file, "%u,%.4f\n", i, benchmark.frame_times.data[i]);
+  }
+  fclose(file);
+
+  return 0;
+}
+
+static cJSON* benchmark_stats_to_json(const benchmark_stats_t* stats)
+{
+  cJSON* json = cJSON_CreateObject();
+  cJSON_AddNumberToObject(json, "frames", stats->frame_count);
+  cJSON_AddNumberToObject(json, "min_ms", stats->min);
+  cJSON_AddNumberToObject(json, "mean_ms", stats->mean);
+  cJSON_AddNumberToObject(json, "p50_ms", stats->p50);
+  cJSON_AddNumberToObject(json, "p95_ms", stats->p95);
+  cJSON_AddNumberToObject(json, "p99_ms", stats->p99);
+  cJSON_AddNumberToObject(json, "max_ms", stats->max);
+  return json;
+}
+
+static int write_json_file(const char* filename, cJSON* json)
+{
+  int res      = -1;
+  char* string = cJSON_Print(json);
+  FILE* file   = fopen(filename, "w");
+  if (file == NULL) {
+    log_error("Unable to open file '%s'\n", filename);
+    goto write_json_end;
+  }
+  fprintf(file, "%s\n", string);
+  fclose(file);
+  res = 0;
+
+write_json_end:
+  cJSON_free(string);
+  return res;
+}
+
+int benchmark_write_json(const char* filename, const char* name,
+                         const benchmark_stats_t* stats)
+{
+  cJSON* json = benchmark_stats_to_json(stats);
+  cJSON_AddStringToObject(json, "example", name);
+  cJSON_AddNumberToObject(json, "warmup_frames",
+                          benchmark.settings.warmup_frames);
+
+  const int res = write_json_file(filename, json);
+  cJSON_Delete(json);
+  return res;
+}
+
+int benchmark_write_summary(const char* filename, const char** names,
+                            const benchmark_stats_t* stats, uint32_t count)
+{
+  cJSON* json     = cJSON_CreateObject();
+  cJSON* examples = cJSON_AddObjectToObject(json, "examples");
+  for (uint32_t i = 0; i < count; ++i) {
+    cJSON_AddItemToObject(examples, names[i],
+                          benchmark_stats_to_json(&stats[i]));
+  }
+
+  const int res = write_json_file(filename, json);
+  cJSON_Delete(json);
+  return res;
+}
+
+static bool exceeds_threshold(const char* name, const char* metric,
+                              double baseline, double current, float threshold)
+{
+  if (baseline <= 0.0) {
+    return false;
+  }
+  const double change = (current - baseline) / baseline * 100.0;
+  if (change > (double)threshold) {
+    log_warn("Regression in %s: %s %.3f ms -> %.3f ms (+%.1f%%)", name, metric,
+             baseline, current, change);
+    return true;
+  }
+  return false;
+}
+
+int benchmark_check_regression(const char* baseline_filename,
+                               const char* name,
+                               const benchmark_stats_t* stats,
+                               float threshold)
+{
+  if (!file_exists(baseline_filename)) {
+    log_error("Baseline file not found: %s", baseline_filename);
+    return -1;
+  }
+
+  file_read_result_t file_read_result = {0};
+  read_file(baseline_filename, &file_read_result, true);
+
+  int res     = -1;
+  cJSON* json = cJSON_Parse((const char*)file_read_result.data);
+  if (json == NULL) {
+    log_error("Invalid baseline file: %s", baseline_filename);
+    goto check_regression_end;
+  }
+
+  const cJSON* examples = cJSON_GetObjectItemCaseSensitive(json, "examples");
+  const cJSON* baseline = cJSON_GetObjectItemCaseSensitive(examples, name);
+  if (!cJSON_IsObject(baseline)) {
+    log_error("No baseline entry for %s in %s", name, baseline_filename);
+    goto check_regression_end;
+  }
+
+  const cJSON* mean = cJSON_GetObjectItemCaseSensitive(baseline, "mean_ms");
+  const cJSON* p95  = cJSON_GetObjectItemCaseSensitive(baseline, "p95_ms");
+  if (!cJSON_IsNumber(mean) || !cJSON_IsNumber(p95)) {
+    log_error("Baseline entry for %s in %s has no mean_ms / p95_ms", name,
+              baseline_filename);
+    goto check_regression_end;
+  }
+
+  bool regressed = false;
+  regressed |= exceeds_threshold(name, "mean", mean->valuedouble, stats->mean,
+                                 threshold);
+  regressed |= exceeds_threshold(name, "p95", p95->valuedouble, stats->p95,
+                                 threshold);
+  res = regressed ? 1 : 0;
+
+check_regression_end:
+  cJSON_Delete(json);
+  free(file_read_result.data);
+  return res;
+}
@@ -0,0 +1,67 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Benchmark run settings */
+typedef struct benchmark_settings_t {
+  uint32_t warmup_frames;   /* frames rendered before measuring */
+  uint32_t measured_frames; /* frames included in the statistics */
+} benchmark_settings_t;
+
+/* CPU frame time statistics (in milliseconds) */
+typedef struct benchmark_stats_t {
+  uint32_t frame_count;
+  double min;
+  double mean;
+  double p50;
+  double p95;
+  double p99;
+  double max;
+} benchmark_stats_t;
+
+/* Benchmark run control */
+void benchmark_start(const char* name, const benchmark_settings_t* settings);
+void benchmark_stop(benchmark_stats_t* stats);
+void benchmark_shutdown(void); /* frees the frame times of the last run */
+bool benchmark_is_running(void);
+bool benchmark_is_finished(void);
+void benchmark_record_frame(float cpu_time_millis);
+
+/* Benchmark results */
+
+/**
+ * @brief Writes the per-frame CPU times of the last benchmark run as CSV.
+ * @return 0 on success, otherwise -1
+ */
+int benchmark_write_csv(const char* filename);
+
+/**
+ * @brief Writes the statistics of a single benchmark run as JSON.
+ * @return 0 on success, otherwise -1
+ */
+int benchmark_write_json(const char* filename, const char* name,
+                         const benchmark_stats_t* stats);
+
+/**
+ * @brief Writes the statistics of all benchmark runs as JSON, the resulting
+ * file can be used as baseline for later runs.
+ * @return 0 on success, otherwise -1
+ */
+int benchmark_write_summary(const char* filename, const char** names,
+                            const benchmark_stats_t* stats, uint32_t count);
+
+/**
+ * @brief Compares the statistics with the entry for the same name in the
+ * baseline summary file.
+ * @param threshold maximum allowed slowdown of mean and p95 in percent
+ * @return 1 if the mean or p95 frame time regressed beyond the threshold, 0
+ * if not, -1 if the baseline file or its entry could not be loaded
+ */
+int benchmark_check_regression(const char* baseline_filename,
+                               const char* name,
+                               const benchmark_stats_t* stats,
+                               float threshold);
+
+#endif
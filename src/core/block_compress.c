@@ -0,0 +1,517 @@
+#include "block_compress.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "job_system.h"
+#include "macro.h"
+
+/* Blocks per parallel range, the rows of blocks are split accordingly */
+#define BLOCK_COMPRESS_BLOCKS_PER_RANGE 1024u
+
+/* Interpolation weights of the 4-bit BC7 indices, in 1/64 */
+static const int32_t bc7_weights[16] = {
+  0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64,
+};
+
+uint32_t block_compress_block_size(block_compress_format_enum format)
+{
+  return (format == BlockCompressFormat_BC1) ? 8u : 16u;
+}
+
+size_t block_compress_image_size(block_compress_format_enum format,
+                                 uint32_t width, uint32_t height)
+{
+  const size_t blocks_x = (width + 3) / 4;
+  const size_t blocks_y = (height + 3) / 4;
+  return blocks_x * blocks_y * block_compress_block_size(format);
+}
+
+bool block_compress_is_opaque(const uint8_t* pixels, uint32_t width,
+                              uint32_t height, uint32_t row_pitch)
+{
+  row_pitch = (row_pitch == 0) ? width * 4 : row_pitch;
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* row = pixels + (size_t)y * row_pitch;
+    for (uint32_t x = 0; x < width; ++x) {
+      if (row[x * 4 + 3] != 255) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Gathers the 4x4 block of RGBA8 pixels, row by row */
+static void block_compress_load_block(const block_compress_desc_t* desc,
+                                      uint32_t row_pitch, uint32_t bx,
+                                      uint32_t by, uint8_t block[64])
+{
+  for (uint32_t y = 0; y < 4; ++y) {
+    const uint32_t sy  = MIN(by * 4 + y, desc->height - 1);
+    const uint8_t* row = desc->pixels + (size_t)sy * row_pitch;
+    if (bx * 4 + 4 <= desc->width) {
+      memcpy(block + y * 16, row + bx * 16, 16);
+      continue;
+    }
+    for (uint32_t x = 0; x < 4; ++x) {
+      const uint32_t sx = MIN(bx * 4 + x, desc->width - 1);
+      memcpy(block + y * 16 + x * 4, row + sx * 4, 4);
+    }
+  }
+}
+
+/* Per channel minimum and maximum of the block */
+static void block_compress_bounds(const uint8_t block[64], uint8_t min[4],
+                                  uint8_t max[4])
+{
+#if defined(__SSE2__)
+  const __m128i r0 = _mm_loadu_si128((const __m128i*)(block + 0));
+  const __m128i r1 = _mm_loadu_si128((const __m128i*)(block + 16));
+  const __m128i r2 = _mm_loadu_si128((const __m128i*)(block + 32));
+  const __m128i r3 = _mm_loadu_si128((const __m128i*)(block + 48));
+  __m128i lo = _mm_min_epu8(_mm_min_epu8(r0, r1), _mm_min_epu8(r2, r3));
+  __m128i hi = _mm_max_epu8(_mm_max_epu8(r0, r1), _mm_max_epu8(r2, r3));
+  // Reduce the four pixels of a row to one
+  lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+  hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+  lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+  hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+  const uint32_t lo_rgba = (uint32_t)_mm_cvtsi128_si32(lo);
+  const uint32_t hi_rgba = (uint32_t)_mm_cvtsi128_si32(hi);
+  memcpy(min, &lo_rgba, 4);
+  memcpy(max, &hi_rgba, 4);
+#else
+  memcpy(min, block, 4);
+  memcpy(max, block, 4);
+  for (uint32_t i = 1; i < 16; ++i) {
+    for (uint32_t c = 0; c < 4; ++c) {
+      min[c] = MIN(min[c], block[i * 4 + c]);
+      max[c] = MAX(max[c], block[i * 4 + c]);
+    }
+  }
+#endif
+}
+
+/* The box diagonal from min to max fits channels that grow with green, the
+ * ends of a channel are swapped if it is negatively correlated with green */
+static void block_compress_select_diagonal(const uint8_t block[64],
+                                           uint8_t min[4], uint8_t max[4],
+                                           bool with_alpha)
+{
+  int32_t center[4];
+  for (uint32_t c = 0; c < 4; ++c) {
+    center[c] = (min[c] + max[c] + 1) >> 1;
+  }
+  int32_t cov_rg = 0, cov_bg = 0, cov_ag = 0;
+  for (uint32_t i = 0; i < 16; ++i) {
+    const int32_t dg = block[i * 4 + 1] - center[1];
+    cov_rg += (block[i * 4 + 0] - center[0]) * dg;
+    cov_bg += (block[i * 4 + 2] - center[2]) * dg;
+    cov_ag += (block[i * 4 + 3] - center[3]) * dg;
+  }
+  const bool swap[4] = {
+    cov_rg < 0,
+    false,
+    cov_bg < 0,
+    with_alpha && cov_ag < 0,
+  };
+  for (uint32_t c = 0; c < 4; ++c) {
+    if (swap[c]) {
+      const uint8_t tmp = min[c];
+      min[c]            = max[c];
+      max[c]            = tmp;
+    }
+  }
+}
+
+/* Dot products of the 16 pixels with the RGBA axis */
+static void block_compress_project(const uint8_t block[64],
+                                   const int32_t axis[4], int32_t dots[16])
+{
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i dir
+    = _mm_setr_epi16((int16_t)axis[0], (int16_t)axis[1], (int16_t)axis[2],
+                     (int16_t)axis[3], (int16_t)axis[0], (int16_t)axis[1],
+                     (int16_t)axis[2], (int16_t)axis[3]);
+  for (uint32_t i = 0; i < 4; ++i) {
+    const __m128i row = _mm_loadu_si128((const __m128i*)(block + i * 16));
+    // r * dr + g * dg and b * db + a * da, two pixels per register
+    const __m128i p01 = _mm_madd_epi16(_mm_unpacklo_epi8(row, zero), dir);
+    const __m128i p23 = _mm_madd_epi16(_mm_unpackhi_epi8(row, zero), dir);
+    const __m128i s01 = _mm_shuffle_epi32(p01, _MM_SHUFFLE(3, 1, 2, 0));
+    const __m128i s23 = _mm_shuffle_epi32(p23, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i*)(dots + i * 4),
+                     _mm_add_epi32(_mm_unpacklo_epi64(s01, s23),
+                                   _mm_unpackhi_epi64(s01, s23)));
+  }
+#else
+  for (uint32_t i = 0; i < 16; ++i) {
+    dots[i] = block[i * 4 + 0] * axis[0] + block[i * 4 + 1] * axis[1]
+              + block[i * 4 + 2] * axis[2] + block[i * 4 + 3] * axis[3];
+  }
+#endif
+}
+
+/* BC1 color block */
+
+static uint16_t bc1_pack_565(const int32_t color[3])
+{
+  const uint32_t r = (uint32_t)(color[0] * 31 + 127) / 255;
+  const uint32_t g = (uint32_t)(color[1] * 63 + 127) / 255;
+  const uint32_t b = (uint32_t)(color[2] * 31 + 127) / 255;
+  return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void bc1_unpack_565(uint16_t value, int32_t color[3])
+{
+  const int32_t r = (value >> 11) & 31;
+  const int32_t g = (value >> 5) & 63;
+  const int32_t b = value & 31;
+  color[0]        = (r << 3) | (r >> 2);
+  color[1]        = (g << 2) | (g >> 4);
+  color[2]        = (b << 3) | (b >> 2);
+}
+
+/* Four color block, also used by BC3 */
+static void bc1_encode_color(const uint8_t block[64], const uint8_t min[4],
+                             const uint8_t max[4], uint8_t* output)
+{
+  uint8_t lo[4], hi[4];
+  memcpy(lo, min, 4);
+  memcpy(hi, max, 4);
+  block_compress_select_diagonal(block, lo, hi, false);
+
+  // Inset the ends by 1/16 of the box, outliers are rarely hit exactly
+  int32_t ends[2][3];
+  for (uint32_t c = 0; c < 3; ++c) {
+    const int32_t inset = (hi[c] - lo[c]) / 16;
+    ends[0][c]          = hi[c] - inset;
+    ends[1][c]          = lo[c] + inset;
+  }
+
+  uint16_t c0      = bc1_pack_565(ends[0]);
+  uint16_t c1      = bc1_pack_565(ends[1]);
+  uint32_t indices = 0;
+  if (c0 != c1) {
+    int32_t palette[4][3];
+    bc1_unpack_565(c0, palette[0]);
+    bc1_unpack_565(c1, palette[1]);
+    for (uint32_t c = 0; c < 3; ++c) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    const int32_t axis[4] = {
+      palette[0][0] - palette[1][0],
+      palette[0][1] - palette[1][1],
+      palette[0][2] - palette[1][2],
+      0,
+    };
+    int32_t stops[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+      stops[i] = palette[i][0] * axis[0] + palette[i][1] * axis[1]
+                 + palette[i][2] * axis[2];
+    }
+    int32_t dots[16];
+    block_compress_project(block, axis, dots);
+
+    // Midpoints between the palette colors along the axis, which are ordered
+    // 1, 3, 2, 0, doubled to stay in integers
+    const int32_t mid13 = stops[1] + stops[3];
+    const int32_t mid32 = stops[3] + stops[2];
+    const int32_t mid20 = stops[2] + stops[0];
+    for (int32_t i = 15; i >= 0; --i) {
+      const int32_t dot    = dots[i] * 2;
+      const uint32_t index = (dot < mid32) ? (dot < mid13 ? 1u : 3u) :
+                                             (dot < mid20 ? 2u : 0u);
+      indices              = (indices << 2) | index;
+    }
+
+    // The four color mode requires c0 > c1
+    if (c0 < c1) {
+      const uint16_t tmp = c0;
+      c0                 = c1;
+      c1                 = tmp;
+      indices ^= 0x55555555u;
+    }
+  }
+
+  output[0] = (uint8_t)(c0 & 0xFF);
+  output[1] = (uint8_t)(c0 >> 8);
+  output[2] = (uint8_t)(c1 & 0xFF);
+  output[3] = (uint8_t)(c1 >> 8);
+  for (uint32_t i = 0; i < 4; ++i) {
+    output[4 + i] = (uint8_t)(indices >> (8 * i));
+  }
+}
+
+/* BC3 alpha block, eight interpolated values between the alpha bounds */
+static void bc3_encode_alpha(const uint8_t block[64], uint8_t min,
+                             uint8_t max, uint8_t* output)
+{
+  uint64_t indices    = 0;
+  const int32_t range = max - min;
+  if (range > 0) {
+    for (int32_t i = 15; i >= 0; --i) {
+      // Step from min (0) to max (7), stored as index 1, 7 ... 2, 0
+      const int32_t step = ((block[i * 4 + 3] - min) * 7 + range / 2) / range;
+      const uint64_t index
+        = (step == 7) ? 0u : (step == 0 ? 1u : (uint64_t)(8 - step));
+      indices = (indices << 3) | index;
+    }
+  }
+
+  output[0] = max;
+  output[1] = min;
+  for (uint32_t i = 0; i < 6; ++i) {
+    output[2 + i] = (uint8_t)(indices >> (8 * i));
+  }
+}
+
+/* BC7 mode 6: one subset, RGBA endpoints with 7 bits per channel and a p-bit
+ * per endpoint, 4-bit indices */
+
+typedef struct bc7_mode6_t {
+  uint8_t endpoints[2][4];
+  uint8_t pbits[2];
+  uint8_t indices[16];
+  uint32_t error;
+} bc7_mode6_t;
+
+/* Rounds the endpoint to 7 bits per channel, keeps the p-bit with the smaller
+ * error */
+static void bc7_quantize_endpoint(const float color[4], uint8_t endpoint[4],
+                                  uint8_t* pbit)
+{
+  uint32_t best_error = UINT32_MAX;
+  for (int32_t p = 0; p < 2; ++p) {
+    uint8_t quantized[4];
+    uint32_t error = 0;
+    for (uint32_t c = 0; c < 4; ++c) {
+      const float value = CLAMP(color[c], 0.0f, 255.0f);
+      const int32_t q   = CLAMP((int32_t)((value - p) * 0.5f + 0.5f), 0, 127);
+      const int32_t d   = ((q << 1) | p) - (int32_t)(value + 0.5f);
+      quantized[c]      = (uint8_t)q;
+      error += (uint32_t)(d * d);
+    }
+    if (error < best_error) {
+      best_error = error;
+      memcpy(endpoint, quantized, 4);
+      *pbit = (uint8_t)p;
+    }
+  }
+}
+
+/* Projects the pixels onto the endpoint axis, returns the squared error of
+ * the decoded block */
+static uint32_t bc7_assign_indices(const uint8_t block[64],
+                                   bc7_mode6_t* mode6)
+{
+  int32_t ends[2][4];
+  for (uint32_t e = 0; e < 2; ++e) {
+    for (uint32_t c = 0; c < 4; ++c) {
+      ends[e][c] = (mode6->endpoints[e][c] << 1) | mode6->pbits[e];
+    }
+  }
+  const int32_t axis[4] = {
+    ends[1][0] - ends[0][0],
+    ends[1][1] - ends[0][1],
+    ends[1][2] - ends[0][2],
+    ends[1][3] - ends[0][3],
+  };
+  const int32_t length = axis[0] * axis[0] + axis[1] * axis[1]
+                         + axis[2] * axis[2] + axis[3] * axis[3];
+  const int32_t base = ends[0][0] * axis[0] + ends[0][1] * axis[1]
+                       + ends[0][2] * axis[2] + ends[0][3] * axis[3];
+  int32_t dots[16];
+  block_compress_project(block, axis, dots);
+
+  uint32_t error = 0;
+  for (uint32_t i = 0; i < 16; ++i) {
+    int32_t index = 0;
+    if (length > 0) {
+      const float t = (float)(dots[i] - base) * 15.0f / (float)length;
+      index         = CLAMP((int32_t)(t + 0.5f), 0, 15);
+    }
+    mode6->indices[i] = (uint8_t)index;
+    const int32_t w   = bc7_weights[index];
+    for (uint32_t c = 0; c < 4; ++c) {
+      const int32_t value = ((64 - w) * ends[0][c] + w * ends[1][c] + 32) >> 6;
+      const int32_t d     = value - block[i * 4 + c];
+      error += (uint32_t)(d * d);
+    }
+  }
+  mode6->error = error;
+  return error;
+}
+
+/* Least squares endpoints for the current indices, false if all pixels use
+ * the same weight */
+static bool bc7_fit_endpoints(const uint8_t block[64],
+                              const bc7_mode6_t* mode6, float ends[2][4])
+{
+  float a = 0.0f, b = 0.0f, c = 0.0f;
+  float x[4] = {0}, y[4] = {0};
+  for (uint32_t i = 0; i < 16; ++i) {
+    const float w  = (float)bc7_weights[mode6->indices[i]] / 64.0f;
+    const float iw = 1.0f - w;
+    a += iw * iw;
+    b += iw * w;
+    c += w * w;
+    for (uint32_t ch = 0; ch < 4; ++ch) {
+      x[ch] += iw * block[i * 4 + ch];
+      y[ch] += w * block[i * 4 + ch];
+    }
+  }
+  const float det = a * c - b * b;
+  if (fabsf(det) < 1e-6f) {
+    return false;
+  }
+  for (uint32_t ch = 0; ch < 4; ++ch) {
+    ends[0][ch] = (c * x[ch] - b * y[ch]) / det;
+    ends[1][ch] = (a * y[ch] - b * x[ch]) / det;
+  }
+  return true;
+}
+
+static void bc7_write_bits(uint8_t* output, uint32_t* offset, uint32_t value,
+                           uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i, ++*offset) {
+    if ((value >> i) & 1u) {
+      output[*offset >> 3] |= (uint8_t)(1u << (*offset & 7));
+    }
+  }
+}
+
+static void bc7_encode(const uint8_t block[64], const uint8_t min[4],
+                       const uint8_t max[4], uint32_t quality,
+                       uint8_t* output)
+{
+  uint8_t lo[4], hi[4];
+  memcpy(lo, min, 4);
+  memcpy(hi, max, 4);
+  block_compress_select_diagonal(block, lo, hi, true);
+
+  float ends[2][4];
+  for (uint32_t c = 0; c < 4; ++c) {
+    ends[0][c] = lo[c];
+    ends[1][c] = hi[c];
+  }
+  bc7_mode6_t best;
+  bc7_quantize_endpoint(ends[0], best.endpoints[0], &best.pbits[0]);
+  bc7_quantize_endpoint(ends[1], best.endpoints[1], &best.pbits[1]);
+  bc7_assign_indices(block, &best);
+
+  // Every refinement refits the endpoints to the indices of the best result
+  for (uint32_t i = 0; i < quality && best.error > 0; ++i) {
+    if (!bc7_fit_endpoints(block, &best, ends)) {
+      break;
+    }
+    bc7_mode6_t candidate;
+    bc7_quantize_endpoint(ends[0], candidate.endpoints[0],
+                          &candidate.pbits[0]);
+    bc7_quantize_endpoint(ends[1], candidate.endpoints[1],
+                          &candidate.pbits[1]);
+    if (bc7_assign_indices(block, &candidate) >= best.error) {
+      break;
+    }
+    best = candidate;
+  }
+
+  // The most significant bit of the first index is implicitly zero
+  if (best.indices[0] & 8) {
+    for (uint32_t c = 0; c < 4; ++c) {
+      const uint8_t tmp    = best.endpoints[0][c];
+      best.endpoints[0][c] = best.endpoints[1][c];
+      best.endpoints[1][c] = tmp;
+    }
+    const uint8_t pbit = best.pbits[0];
+    best.pbits[0]      = best.pbits[1];
+    best.pbits[1]      = pbit;
+    for (uint32_t i = 0; i < 16; ++i) {
+      best.indices[i] = (uint8_t)(15 - best.indices[i]);
+    }
+  }
+
+  memset(output, 0, 16);
+  uint32_t offset = 0;
+  bc7_write_bits(output, &offset, 1u << 6, 7);
+  for (uint32_t c = 0; c < 4; ++c) {
+    bc7_write_bits(output, &offset, best.endpoints[0][c], 7);
+    bc7_write_bits(output, &offset, best.endpoints[1][c], 7);
+  }
+  bc7_write_bits(output, &offset, best.pbits[0], 1);
+  bc7_write_bits(output, &offset, best.pbits[1], 1);
+  bc7_write_bits(output, &offset, best.indices[0], 3);
+  for (uint32_t i = 1; i < 16; ++i) {
+    bc7_write_bits(output, &offset, best.indices[i], 4);
+  }
+}
+
+/* Compression of the rows of blocks [begin, end) */
+typedef struct block_compress_pass_t {
+  const block_compress_desc_t* desc;
+  uint32_t row_pitch;
+  uint32_t blocks_x;
+  uint32_t block_size;
+  uint32_t bc7_quality;
+  uint8_t* blocks;
+} block_compress_pass_t;
+
+static void block_compress_rows(uint32_t begin, uint32_t end, void* data)
+{
+  const block_compress_pass_t* pass = (const block_compress_pass_t*)data;
+  uint8_t block[64];
+  uint8_t min[4], max[4];
+  for (uint32_t by = begin; by < end; ++by) {
+    uint8_t* output
+      = pass->blocks + (size_t)by * pass->blocks_x * pass->block_size;
+    for (uint32_t bx = 0; bx < pass->blocks_x; ++bx) {
+      block_compress_load_block(pass->desc, pass->row_pitch, bx, by, block);
+      block_compress_bounds(block, min, max);
+      switch (pass->desc->format) {
+        case BlockCompressFormat_BC1:
+          bc1_encode_color(block, min, max, output);
+          break;
+        case BlockCompressFormat_BC3:
+          bc3_encode_alpha(block, min[3], max[3], output);
+          bc1_encode_color(block, min, max, output + 8);
+          break;
+        case BlockCompressFormat_BC7:
+          bc7_encode(block, min, max, pass->bc7_quality, output);
+          break;
+      }
+      output += pass->block_size;
+    }
+  }
+}
+
+void block_compress(const block_compress_desc_t* desc, uint8_t* blocks)
+{
+  ASSERT(desc && desc->pixels && blocks);
+  if (desc->width == 0 || desc->height == 0) {
+    return;
+  }
+
+  block_compress_pass_t pass = {
+    .desc       = desc,
+    .row_pitch  = (desc->row_pitch == 0) ? desc->width * 4 : desc->row_pitch,
+    .blocks_x   = (desc->width + 3) / 4,
+    .block_size = block_compress_block_size(desc->format),
+    .bc7_quality
+    = (desc->bc7_quality == 0) ?
+        BLOCK_COMPRESS_BC7_DEFAULT_QUALITY :
+        MIN(desc->bc7_quality, BLOCK_COMPRESS_BC7_MAX_QUALITY),
+    .blocks = blocks,
+  };
+  const uint32_t blocks_y = (desc->height + 3) / 4;
+  const uint32_t grain_size
+    = MAX(BLOCK_COMPRESS_BLOCKS_PER_RANGE / pass.blocks_x, 1u);
+  job_parallel_for(blocks_y, grain_size, block_compress_rows, &pass);
+}
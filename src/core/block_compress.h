@@ -0,0 +1,61 @@
+#ifndef BLOCK_COMPRESS_H
+#define BLOCK_COMPRESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Real-time BC1 / BC3 / BC7 encoder for RGBA8 images. The endpoints start at
+ * the bounding box of the 4x4 block and the indices are found by projecting
+ * the pixels onto the endpoint axis, BC7 blocks are encoded in mode 6 and
+ * refine their endpoints with least squares fits. The rows of blocks are split
+ * across the job system threads. Partial blocks at the right and bottom edge
+ * repeat the last column / row. */
+
+#define BLOCK_COMPRESS_BC7_DEFAULT_QUALITY 2u
+#define BLOCK_COMPRESS_BC7_MAX_QUALITY 4u
+
+typedef enum block_compress_format_enum {
+  BlockCompressFormat_BC1 = 0, /* opaque RGB, 8 bytes per block */
+  BlockCompressFormat_BC3 = 1, /* RGBA, 16 bytes per block */
+  BlockCompressFormat_BC7 = 2, /* RGBA, 16 bytes per block */
+} block_compress_format_enum;
+
+typedef struct block_compress_desc_t {
+  const uint8_t* pixels; /* RGBA8 */
+  uint32_t width;
+  uint32_t height;
+  uint32_t row_pitch; /* bytes per row of pixels, 0 for width * 4 */
+  block_compress_format_enum format;
+  /* Least squares refinements of BC7 blocks, 1 up to
+   * BLOCK_COMPRESS_BC7_MAX_QUALITY, 0 for the default */
+  uint32_t bc7_quality;
+} block_compress_desc_t;
+
+/**
+ * @brief Returns the number of bytes of a 4x4 block of the format.
+ */
+uint32_t block_compress_block_size(block_compress_format_enum format);
+
+/**
+ * @brief Returns the number of bytes of an image with tightly packed rows of
+ * blocks.
+ */
+size_t block_compress_image_size(block_compress_format_enum format,
+                                 uint32_t width, uint32_t height);
+
+/**
+ * @brief Returns true if all pixels of the RGBA8 image have an alpha of 255.
+ * @param row_pitch bytes per row of pixels, 0 for width * 4
+ */
+bool block_compress_is_opaque(const uint8_t* pixels, uint32_t width,
+                              uint32_t height, uint32_t row_pitch);
+
+/**
+ * @brief Compresses the image, waits for the job system while doing so.
+ * @param desc the source image and the target format
+ * @param blocks output of block_compress_image_size() bytes
+ */
+void block_compress(const block_compress_desc_t* desc, uint8_t* blocks);
+
+#endif
@@ -1,8 +1,18 @@
 #include "file.h"
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FILE_VIEW_HAS_MMAP 1
+#define FILE_HAS_POSIX_IO 1
+#endif
+
 #include "log.h"
 #include "macro.h"
 
@@ -52,3 +62,173 @@ void read_file(const char* filename, file_read_result_t* result,
     result->data[result->size] = 0;
   }
 }
+
+/* Fallback of file_view_open(), reads the file into a heap copy */
+static bool file_view_read(const char* filename, file_view_t* view)
+{
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (size < 0) {
+    fclose(file);
+    return false;
+  }
+
+  /* Always zero terminated, this also avoids malloc(0) for empty files */
+  uint8_t* data          = malloc((size_t)size + 1);
+  const size_t read_size = fread(data, 1, (size_t)size, file);
+  fclose(file);
+  if (read_size != (size_t)size) {
+    free(data);
+    return false;
+  }
+  data[size] = 0;
+
+  view->data = data;
+  view->size = (size_t)size;
+  return true;
+}
+
+bool file_view_open(const char* filename, uint32_t flags, file_view_t* view)
+{
+  ASSERT(filename && view);
+  memset(view, 0, sizeof(*view));
+
+#if defined(FILE_VIEW_HAS_MMAP)
+  const int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    log_error("Unable to open file '%s'\n", filename);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    log_error("Unable to stat file '%s'\n", filename);
+    return false;
+  }
+
+  /* The pages past the end of the file are zero filled, a text file only gets
+   * its terminating zero for free if it does not end on a page boundary */
+  const size_t size      = (size_t)st.st_size;
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  const bool needs_copy
+    = (size == 0)
+      || ((flags & FileViewFlags_Text) && (size % page_size) == 0);
+  if (!needs_copy) {
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      close(fd);
+      int advice = POSIX_MADV_NORMAL;
+      if (flags & FileViewFlags_Sequential) {
+        advice = POSIX_MADV_SEQUENTIAL;
+      }
+      else if (flags & FileViewFlags_Random) {
+        advice = POSIX_MADV_RANDOM;
+      }
+      if (advice != POSIX_MADV_NORMAL) {
+        posix_madvise(mapping, size, advice);
+      }
+      if (flags & FileViewFlags_WillNeed) {
+        posix_madvise(mapping, size, POSIX_MADV_WILLNEED);
+      }
+      view->data         = (const uint8_t*)mapping;
+      view->size         = size;
+      view->mapping      = mapping;
+      view->mapping_size = size;
+      return true;
+    }
+    log_debug("Unable to map file '%s', reading it instead\n", filename);
+  }
+  close(fd);
+#else
+  UNUSED_VAR(flags);
+#endif
+
+  if (!file_view_read(filename, view)) {
+    log_error("Unable to read file '%s'\n", filename);
+    return false;
+  }
+  return true;
+}
+
+void file_view_close(file_view_t* view)
+{
+  ASSERT(view);
+#if defined(FILE_VIEW_HAS_MMAP)
+  if (view->mapping != NULL) {
+    munmap(view->mapping, view->mapping_size);
+  }
+  else
+#endif
+  {
+    free((void*)view->data);
+  }
+  memset(view, 0, sizeof(*view));
+}
+
+bool file_create_directories(const char* path)
+{
+  ASSERT(path);
+#if defined(FILE_HAS_POSIX_IO)
+  char directory[STRMAX];
+  if (snprintf(directory, sizeof(directory), "%s", path)
+      >= (int)sizeof(directory)) {
+    return false;
+  }
+  /* Creates every parent directory in turn */
+  for (char* c = directory + 1;; ++c) {
+    if (*c != '/' && *c != '\0') {
+      continue;
+    }
+    const char separator = *c;
+    *c                   = '\0';
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+      log_error("Unable to create directory '%s'\n", directory);
+      return false;
+    }
+    if (separator == '\0') {
+      return true;
+    }
+    *c = separator;
+  }
+#else
+  return false;
+#endif
+}
+
+bool file_write_atomic(const char* filename, const void* data, size_t size)
+{
+  ASSERT(filename && (data || size == 0));
+
+  /* Unique per process and call, concurrent writers never share a file */
+  static uint32_t temp_counter = 0;
+  const uint32_t temp_index
+    = __atomic_add_fetch(&temp_counter, 1, __ATOMIC_RELAXED);
+#if defined(FILE_HAS_POSIX_IO)
+  const long process_id = (long)getpid();
+#else
+  const long process_id = 0;
+#endif
+  char temp_filename[STRMAX];
+  snprintf(temp_filename, sizeof(temp_filename), "%s.tmp%ld_%u", filename,
+           process_id, temp_index);
+
+  FILE* file = fopen(temp_filename, "wb");
+  if (file == NULL) {
+    log_error("Unable to create file '%s'\n", temp_filename);
+    return false;
+  }
+  const bool written = fwrite(data, 1, size, file) == size;
+  if (fclose(file) != 0 || !written
+      || rename(temp_filename, filename) != 0) {
+    log_error("Unable to write file '%s'\n", filename);
+    remove(temp_filename);
+    return false;
+  }
+  return true;
+}
@@ -1,6 +1,8 @@
 #ifndef FILE_H
 #define FILE_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct file_read_result_t {
@@ -8,6 +10,24 @@ typedef struct file_read_result_t {
   uint8_t* data;
 } file_read_result_t;
 
+/* Read-only view of the bytes of a file, memory-mapped where possible so that
+ * consumers can work on the file without copying it to the heap first */
+typedef struct file_view_t {
+  const uint8_t* data;
+  size_t size;
+  void* mapping;       /* start of the mapping, NULL if data is a heap copy */
+  size_t mapping_size; /* size of the mapping in bytes */
+} file_view_t;
+
+/* How the view is accessed, passed to the kernel as posix_madvise() hint */
+typedef enum file_view_flags_enum {
+  FileViewFlags_None       = 0x00000000,
+  FileViewFlags_Text       = 0x00000001, /* data is zero terminated */
+  FileViewFlags_Sequential = 0x00000002, /* read once from front to back */
+  FileViewFlags_Random     = 0x00000004, /* read in random order */
+  FileViewFlags_WillNeed   = 0x00000008, /* start reading ahead right away */
+} file_view_flags_enum;
+
 /**
  * @brief Check if a file exist using fopen() function.
  * @param filename the name of the file
@@ -39,4 +59,36 @@ int filename_has_extension(const char* filename, const char* extension);
 void read_file(const char* filename, file_read_result_t* result,
                int is_text_file);
 
+/**
+ * @brief Maps the file with the specified filename read-only into memory. Empty
+ * files and text files whose size is a multiple of the page size, which have
+ * no room for the terminating zero, are read into a heap copy instead.
+ * @param filename the name of the file
+ * @param flags combination of file_view_flags_enum values
+ * @param view the file view, zeroed if the file could not be opened
+ * @return true on success, otherwise false
+ */
+bool file_view_open(const char* filename, uint32_t flags, file_view_t* view);
+
+/**
+ * @brief Unmaps the file view, the bytes must not be used afterwards.
+ * @param view the file view, may be zeroed or already closed
+ */
+void file_view_close(file_view_t* view);
+
+/**
+ * @brief Creates the directory and its missing parent directories.
+ * @param path the directory path, '/' separated
+ * @return true if the directory exists afterwards, otherwise false
+ */
+bool file_create_directories(const char* path);
+
+/**
+ * @brief Writes the data to a temporary file next to the target and renames
+ * it, readers never observe a partially written file.
+ * @param filename the name of the target file, replaced if it exists
+ * @return true on success, otherwise false
+ */
+bool file_write_atomic(const char* filename, const void* data, size_t size);
+
 #endif
@@ -0,0 +1,723 @@
+#include "job_system.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "macro.h"
+#include "platform.h"
+#include "trace.h"
+
+/* Number of jobs per deque, must be a power of two. Jobs pushed to a full
+ * deque go to the shared queue. */
+#define JOB_DEQUE_CAPACITY 4096u
+#define JOB_MAX_THREADS 64u
+/* Failed attempts to find a job before a worker sleeps / a waiter yields */
+#define JOB_SPIN_COUNT 64u
+#define JOB_CACHE_LINE_SIZE 64u
+
+/* Continuation list node, the list of a finished job is closed */
+typedef struct job_link_t {
+  job_t* job;
+  struct job_link_t* next;
+} job_link_t;
+
+#define JOB_LINKS_CLOSED ((job_link_t*)&job_system.closed_link)
+
+/* Shared state of a parallel loop, lives on the stack of the calling thread */
+typedef struct job_loop_t {
+  job_range_func_t func;
+  void* data;
+  uint32_t grain_size;
+  uint32_t remaining; /* indices not processed yet */
+} job_loop_t;
+
+struct job_t {
+  job_func_t func;
+  void* data;
+  /* Range of a parallel loop, set instead of func */
+  job_loop_t* loop;
+  uint32_t begin;
+  uint32_t end;
+  uint32_t pending;   /* unfinished dependencies, +1 until submitted */
+  uint32_t ref_count; /* caller and scheduler references */
+  bool done;
+  job_link_t* continuations;
+  job_t* next; /* shared queue link */
+};
+
+/* Chase-Lev work-stealing deque: the owning thread pushes and pops at the
+ * bottom, other threads steal from the top */
+typedef struct job_deque_t {
+  int64_t top;
+  uint8_t padding0[JOB_CACHE_LINE_SIZE - sizeof(int64_t)];
+  int64_t bottom;
+  uint8_t padding1[JOB_CACHE_LINE_SIZE - sizeof(int64_t)];
+  job_t* jobs[JOB_DEQUE_CAPACITY];
+} job_deque_t;
+
+typedef struct job_thread_t {
+  job_deque_t deque;
+  pthread_t thread;
+  uint32_t index;
+  uint32_t random_state; /* victim selection */
+  uint64_t job_count;
+  uint64_t steal_count;
+} job_thread_t;
+
+/* Threads[0] is the main thread, the workers follow */
+static struct {
+  bool initialized;
+  bool stop;
+  uint32_t thread_count;
+  job_thread_t* threads;
+  pthread_key_t thread_key;
+  pthread_once_t thread_key_once;
+  job_link_t closed_link;
+  /* Jobs submitted by threads without deque */
+  struct {
+    pthread_mutex_t mutex;
+    job_t* head;
+    job_t* tail;
+    uint32_t size;
+  } queue;
+  /* Idle workers */
+  struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t count;
+  } sleeping;
+  /* Jobs executed by threads without deque */
+  uint64_t job_count;
+  uint64_t steal_count;
+} job_system = {
+  .thread_key_once = PTHREAD_ONCE_INIT,
+  .queue.mutex     = PTHREAD_MUTEX_INITIALIZER,
+  .sleeping.mutex  = PTHREAD_MUTEX_INITIALIZER,
+  .sleeping.cond   = PTHREAD_COND_INITIALIZER,
+};
+
+static void job_create_thread_key(void)
+{
+  pthread_key_create(&job_system.thread_key, NULL);
+}
+
+static job_thread_t* job_get_thread(void)
+{
+  pthread_once(&job_system.thread_key_once, job_create_thread_key);
+  return (job_thread_t*)pthread_getspecific(job_system.thread_key);
+}
+
+/* Work-stealing deque */
+
+static bool job_deque_push(job_deque_t* deque, job_t* job)
+{
+  const int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+  const int64_t top    = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  if (bottom - top >= (int64_t)JOB_DEQUE_CAPACITY) {
+    return false;
+  }
+  __atomic_store_n(&deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)], job,
+                   __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+static job_t* job_deque_pop(job_deque_t* deque)
+{
+  const int64_t bottom
+    = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+  __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  int64_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+  if (top > bottom) {
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return NULL;
+  }
+
+  job_t* job = __atomic_load_n(&deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)],
+                               __ATOMIC_RELAXED);
+  if (top == bottom) {
+    // Last job, races with the thieves
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+      job = NULL;
+    }
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+  }
+  return job;
+}
+
+static job_t* job_deque_steal(job_deque_t* deque)
+{
+  int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  const int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+  if (top >= bottom) {
+    return NULL;
+  }
+
+  job_t* job = __atomic_load_n(&deque->jobs[top & (JOB_DEQUE_CAPACITY - 1)],
+                               __ATOMIC_RELAXED);
+  if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false,
+                                   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    return NULL;
+  }
+  return job;
+}
+
+static bool job_deque_is_empty(job_deque_t* deque)
+{
+  return __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE)
+         >= __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+}
+
+/* Scheduling */
+
+static void job_wake_worker(void)
+{
+  // Pairs with the fence of a worker going to sleep, either the worker sees
+  // the new job or the job is seen with a sleeping worker
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&job_system.sleeping.count, __ATOMIC_RELAXED) > 0) {
+    pthread_mutex_lock(&job_system.sleeping.mutex);
+    pthread_cond_signal(&job_system.sleeping.cond);
+    pthread_mutex_unlock(&job_system.sleeping.mutex);
+  }
+}
+
+static void job_push(job_t* job)
+{
+  job_thread_t* self = job_get_thread();
+  if (self == NULL || !job_deque_push(&self->deque, job)) {
+    job->next = NULL;
+    pthread_mutex_lock(&job_system.queue.mutex);
+    if (job_system.queue.tail != NULL) {
+      job_system.queue.tail->next = job;
+    }
+    else {
+      job_system.queue.head = job;
+    }
+    job_system.queue.tail = job;
+    __atomic_add_fetch(&job_system.queue.size, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&job_system.queue.mutex);
+  }
+  job_wake_worker();
+}
+
+static job_t* job_queue_pop(void)
+{
+  if (__atomic_load_n(&job_system.queue.size, __ATOMIC_ACQUIRE) == 0) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&job_system.queue.mutex);
+  job_t* job = job_system.queue.head;
+  if (job != NULL) {
+    job_system.queue.head = job->next;
+    if (job_system.queue.head == NULL) {
+      job_system.queue.tail = NULL;
+    }
+    __atomic_sub_fetch(&job_system.queue.size, 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&job_system.queue.mutex);
+  return job;
+}
+
+/* Own deque first (most recent job, hot in cache), then the shared queue and
+ * then the oldest (largest) job of a random victim */
+static job_t* job_find(job_thread_t* self)
+{
+  job_t* job = NULL;
+  if (self != NULL && (job = job_deque_pop(&self->deque)) != NULL) {
+    return job;
+  }
+  if ((job = job_queue_pop()) != NULL) {
+    return job;
+  }
+  if (!job_system.initialized) {
+    return NULL;
+  }
+
+  const uint32_t count = job_system.thread_count + 1;
+  uint32_t start       = 0;
+  if (self != NULL) {
+    // xorshift32
+    self->random_state ^= self->random_state << 13;
+    self->random_state ^= self->random_state >> 17;
+    self->random_state ^= self->random_state << 5;
+    start = self->random_state % count;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    job_thread_t* victim = &job_system.threads[(start + i) % count];
+    if (victim != self && (job = job_deque_steal(&victim->deque)) != NULL) {
+      if (self != NULL) {
+        ++self->steal_count;
+      }
+      else {
+        __atomic_add_fetch(&job_system.steal_count, 1, __ATOMIC_RELAXED);
+      }
+      return job;
+    }
+  }
+  return NULL;
+}
+
+static bool job_has_work(void)
+{
+  if (__atomic_load_n(&job_system.queue.size, __ATOMIC_ACQUIRE) > 0) {
+    return true;
+  }
+  for (uint32_t i = 0; i <= job_system.thread_count; ++i) {
+    if (!job_deque_is_empty(&job_system.threads[i].deque)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Job execution */
+
+static void job_dependency_finished(job_t* job)
+{
+  if (__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+    job_push(job);
+  }
+}
+
+static void job_run_range(job_loop_t* loop, uint32_t begin, uint32_t end);
+
+static void job_execute(job_thread_t* self, job_t* job)
+{
+  if (job->loop != NULL) {
+    job_run_range(job->loop, job->begin, job->end);
+  }
+  else {
+    job->func(job->data);
+  }
+
+  __atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+  job_link_t* link = __atomic_exchange_n(&job->continuations, JOB_LINKS_CLOSED,
+                                         __ATOMIC_ACQ_REL);
+  while (link != NULL) {
+    job_link_t* next = link->next;
+    job_dependency_finished(link->job);
+    free(link);
+    link = next;
+  }
+  job_release(job);
+
+  if (self != NULL) {
+    ++self->job_count;
+  }
+  else {
+    __atomic_add_fetch(&job_system.job_count, 1, __ATOMIC_RELAXED);
+  }
+}
+
+/* Runs a single job or backs off if there is none */
+static void job_help(job_thread_t* self, uint32_t* idle_count)
+{
+  job_t* job = job_find(self);
+  if (job != NULL) {
+    job_execute(self, job);
+    *idle_count = 0;
+  }
+  else if (++(*idle_count) > JOB_SPIN_COUNT) {
+    sched_yield();
+  }
+}
+
+static void* job_worker_main(void* arg)
+{
+  job_thread_t* self = (job_thread_t*)arg;
+  pthread_setspecific(job_system.thread_key, self);
+
+  char thread_name[32];
+  snprintf(thread_name, sizeof(thread_name), "Job worker %u", self->index);
+  trace_set_thread_name(thread_name);
+
+  uint32_t idle_count = 0;
+  while (!__atomic_load_n(&job_system.stop, __ATOMIC_ACQUIRE)) {
+    job_t* job = job_find(self);
+    if (job != NULL) {
+      job_execute(self, job);
+      idle_count = 0;
+      continue;
+    }
+    if (++idle_count < JOB_SPIN_COUNT) {
+      continue;
+    }
+
+    pthread_mutex_lock(&job_system.sleeping.mutex);
+    __atomic_add_fetch(&job_system.sleeping.count, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&job_system.stop, __ATOMIC_ACQUIRE)
+        && !job_has_work()) {
+      pthread_cond_wait(&job_system.sleeping.cond,
+                        &job_system.sleeping.mutex);
+    }
+    __atomic_sub_fetch(&job_system.sleeping.count, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&job_system.sleeping.mutex);
+    idle_count = 0;
+  }
+
+  return NULL;
+}
+
+/* Job system control */
+
+void job_system_init(uint32_t thread_count)
+{
+  if (job_system.initialized) {
+    log_warn("Job system already initialized");
+    return;
+  }
+
+  if (thread_count == JOB_SYSTEM_AUTO_THREAD_COUNT) {
+    const long core_count = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count          = core_count > 1 ? (uint32_t)(core_count - 1) : 0;
+  }
+  thread_count = MIN(thread_count, JOB_MAX_THREADS - 1);
+
+  job_system.stop         = false;
+  job_system.thread_count = thread_count;
+  job_system.job_count    = 0;
+  job_system.steal_count  = 0;
+  job_system.threads
+    = (job_thread_t*)calloc(thread_count + 1, sizeof(job_thread_t));
+  for (uint32_t i = 0; i <= thread_count; ++i) {
+    job_system.threads[i].index        = i;
+    job_system.threads[i].random_state = 0x9E3779B9u * (i + 1);
+  }
+
+  // The calling thread owns deque 0
+  pthread_once(&job_system.thread_key_once, job_create_thread_key);
+  pthread_setspecific(job_system.thread_key, &job_system.threads[0]);
+  job_system.initialized = true;
+
+  for (uint32_t i = 1; i <= thread_count; ++i) {
+    if (pthread_create(&job_system.threads[i].thread, NULL, job_worker_main,
+                       &job_system.threads[i])
+        != 0) {
+      log_error("Unable to create job worker thread %u", i);
+      job_system.thread_count = i - 1;
+      break;
+    }
+  }
+}
+
+void job_system_shutdown(void)
+{
+  if (!job_system.initialized) {
+    return;
+  }
+
+  pthread_mutex_lock(&job_system.sleeping.mutex);
+  __atomic_store_n(&job_system.stop, true, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&job_system.sleeping.cond);
+  pthread_mutex_unlock(&job_system.sleeping.mutex);
+  for (uint32_t i = 1; i <= job_system.thread_count; ++i) {
+    pthread_join(job_system.threads[i].thread, NULL);
+  }
+
+  job_system.initialized = false;
+  pthread_setspecific(job_system.thread_key, NULL);
+  free(job_system.threads);
+  job_system.threads      = NULL;
+  job_system.thread_count = 0;
+}
+
+bool job_system_is_initialized(void)
+{
+  return job_system.initialized;
+}
+
+uint32_t job_system_get_thread_count(void)
+{
+  return job_system.thread_count;
+}
+
+void job_system_get_stats(job_system_stats_t* stats)
+{
+  stats->thread_count = job_system.thread_count;
+  stats->job_count
+    = __atomic_load_n(&job_system.job_count, __ATOMIC_RELAXED);
+  stats->steal_count
+    = __atomic_load_n(&job_system.steal_count, __ATOMIC_RELAXED);
+  if (job_system.initialized) {
+    for (uint32_t i = 0; i <= job_system.thread_count; ++i) {
+      const job_thread_t* thread = &job_system.threads[i];
+      stats->job_count
+        += __atomic_load_n(&thread->job_count, __ATOMIC_RELAXED);
+      stats->steal_count
+        += __atomic_load_n(&thread->steal_count, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/* Jobs */
+
+job_t* job_create(job_func_t func, void* data)
+{
+  job_t* job     = (job_t*)calloc(1, sizeof(job_t));
+  job->func      = func;
+  job->data      = data;
+  job->pending   = 1;
+  job->ref_count = 2;
+  return job;
+}
+
+void job_add_dependency(job_t* job, job_t* dependency)
+{
+  job_link_t* link = (job_link_t*)malloc(sizeof(job_link_t));
+  link->job        = job;
+  __atomic_add_fetch(&job->pending, 1, __ATOMIC_RELAXED);
+
+  link->next = __atomic_load_n(&dependency->continuations, __ATOMIC_ACQUIRE);
+  do {
+    if (link->next == JOB_LINKS_CLOSED) {
+      // Already finished
+      free(link);
+      __atomic_sub_fetch(&job->pending, 1, __ATOMIC_RELAXED);
+      return;
+    }
+  } while (!__atomic_compare_exchange_n(&dependency->continuations,
+                                        &link->next, link, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+void job_submit(job_t* job)
+{
+  job_dependency_finished(job);
+}
+
+job_t* job_then(job_t* job, job_func_t func, void* data)
+{
+  job_t* continuation = job_create(func, data);
+  job_add_dependency(continuation, job);
+  job_submit(continuation);
+  return continuation;
+}
+
+bool job_is_done(job_t* job)
+{
+  return __atomic_load_n(&job->done, __ATOMIC_ACQUIRE);
+}
+
+void job_wait(job_t* job)
+{
+  job_thread_t* self  = job_get_thread();
+  uint32_t idle_count = 0;
+  while (!job_is_done(job)) {
+    job_help(self, &idle_count);
+  }
+}
+
+void job_release(job_t* job)
+{
+  if (__atomic_sub_fetch(&job->ref_count, 1, __ATOMIC_ACQ_REL) == 0) {
+    free(job);
+  }
+}
+
+void job_run(job_t* job)
+{
+  job_submit(job);
+  job_wait(job);
+  job_release(job);
+}
+
+/* Parallel loops */
+
+/* Splits off the upper halves as stealable jobs and processes the remaining
+ * range on the calling thread */
+static void job_run_range(job_loop_t* loop, uint32_t begin, uint32_t end)
+{
+  while (end - begin > loop->grain_size) {
+    const uint32_t middle = begin + (end - begin) / 2;
+    job_t* job            = (job_t*)calloc(1, sizeof(job_t));
+    job->loop             = loop;
+    job->begin            = middle;
+    job->end              = end;
+    job->ref_count        = 1;
+    job_push(job);
+    end = middle;
+  }
+
+  loop->func(begin, end, loop->data);
+  // The loop may be gone once the last range is finished
+  __atomic_sub_fetch(&loop->remaining, end - begin, __ATOMIC_RELEASE);
+}
+
+void job_parallel_for(uint32_t count, uint32_t grain_size,
+                      job_range_func_t func, void* data)
+{
+  if (count == 0) {
+    return;
+  }
+  if (grain_size == 0) {
+    // About four ranges per thread leave room for load balancing
+    grain_size = MAX(count / ((job_system.thread_count + 1) * 4), 1u);
+  }
+  if (job_system.thread_count == 0 || count <= grain_size) {
+    func(0, count, data);
+    return;
+  }
+
+  job_loop_t loop = {
+    .func       = func,
+    .data       = data,
+    .grain_size = grain_size,
+    .remaining  = count,
+  };
+  job_run_range(&loop, 0, count);
+
+  job_thread_t* self  = job_get_thread();
+  uint32_t idle_count = 0;
+  while (__atomic_load_n(&loop.remaining, __ATOMIC_ACQUIRE) != 0) {
+    job_help(self, &idle_count);
+  }
+}
+
+/* Job system microbenchmarks */
+
+#define JOB_BENCHMARK_JOB_COUNT 100000u
+#define JOB_BENCHMARK_CHAIN_LENGTH 10000u
+#define JOB_BENCHMARK_LOOP_SIZE (1u << 22)
+
+static void job_benchmark_empty_job(void* data)
+{
+  UNUSED_VAR(data);
+}
+
+static void job_benchmark_empty_range(uint32_t begin, uint32_t end, void* data)
+{
+  UNUSED_VAR(begin);
+  UNUSED_VAR(end);
+  UNUSED_VAR(data);
+}
+
+/* Compute-bound loop body, a few transcendental functions per element */
+static void job_benchmark_compute_range(uint32_t begin, uint32_t end,
+                                        void* data)
+{
+  float* values = (float*)data;
+  for (uint32_t i = begin; i < end; ++i) {
+    float x = (float)i * 0.001f;
+    for (uint32_t j = 0; j < 8; ++j) {
+      x = sqrtf(fabsf(sinf(x) * 2.0f + cosf(x * 0.5f))) + x * 0.25f;
+    }
+    values[i] = x;
+  }
+}
+
+static double job_benchmark_elapsed_ns(uint64_t start_ns)
+{
+  return (double)(platform_get_time_ns() - start_ns);
+}
+
+/* Scheduling overhead per job / index on the initialized job system */
+static void job_benchmark_overhead(void)
+{
+  job_t** jobs = (job_t**)malloc(JOB_BENCHMARK_JOB_COUNT * sizeof(job_t*));
+
+  // Independent empty jobs submitted from the main thread
+  uint64_t start = platform_get_time_ns();
+  for (uint32_t i = 0; i < JOB_BENCHMARK_JOB_COUNT; ++i) {
+    jobs[i] = job_create(job_benchmark_empty_job, NULL);
+    job_submit(jobs[i]);
+  }
+  for (uint32_t i = 0; i < JOB_BENCHMARK_JOB_COUNT; ++i) {
+    job_wait(jobs[i]);
+    job_release(jobs[i]);
+  }
+  printf("    empty jobs:          %8.1f ns/job\n",
+         job_benchmark_elapsed_ns(start) / JOB_BENCHMARK_JOB_COUNT);
+
+  // Chain of continuations, every job waits for its predecessor
+  start        = platform_get_time_ns();
+  job_t* first = job_create(job_benchmark_empty_job, NULL);
+  job_t* last  = first;
+  job_t* job   = first;
+  for (uint32_t i = 1; i < JOB_BENCHMARK_CHAIN_LENGTH; ++i) {
+    last = job_then(job, job_benchmark_empty_job, NULL);
+    if (job != first) {
+      job_release(job);
+    }
+    job = last;
+  }
+  job_run(first);
+  job_wait(last);
+  job_release(last);
+  printf("    continuation chain:  %8.1f ns/job\n",
+         job_benchmark_elapsed_ns(start) / JOB_BENCHMARK_CHAIN_LENGTH);
+
+  // Parallel loop split down to single indices
+  start = platform_get_time_ns();
+  job_parallel_for(JOB_BENCHMARK_JOB_COUNT, 1, job_benchmark_empty_range, NULL);
+  printf("    parallel_for grain 1: %7.1f ns/index\n",
+         job_benchmark_elapsed_ns(start) / JOB_BENCHMARK_JOB_COUNT);
+
+  free(jobs);
+}
+
+void job_system_benchmark(uint32_t max_thread_count)
+{
+  if (max_thread_count == 0) {
+    const long core_count = sysconf(_SC_NPROCESSORS_ONLN);
+    max_thread_count      = core_count > 0 ? (uint32_t)core_count : 1;
+  }
+
+  // Restarted for every thread count, the previous state is restored at the
+  // end
+  const bool was_initialized       = job_system_is_initialized();
+  const uint32_t prev_thread_count = job_system_get_thread_count();
+  if (was_initialized) {
+    job_system_shutdown();
+  }
+
+  float* values = (float*)malloc(JOB_BENCHMARK_LOOP_SIZE * sizeof(float));
+  double single_thread_ms = 0.0;
+  for (uint32_t thread_count = 1; thread_count <= max_thread_count;
+       thread_count          = MIN(thread_count * 2, max_thread_count)) {
+    job_system_init(thread_count - 1);
+    printf("Job system with %u thread(s):\n", thread_count);
+    job_benchmark_overhead();
+
+    // Best of three runs of the compute-bound loop
+    double best_ms = 0.0;
+    for (uint32_t run = 0; run < 3; ++run) {
+      const uint64_t start = platform_get_time_ns();
+      job_parallel_for(JOB_BENCHMARK_LOOP_SIZE, 0, job_benchmark_compute_range,
+                       values);
+      const double ms = job_benchmark_elapsed_ns(start) / 1e6;
+      best_ms         = (run == 0) ? ms : MIN(best_ms, ms);
+    }
+    if (thread_count == 1) {
+      single_thread_ms = best_ms;
+    }
+    job_system_stats_t stats = {0};
+    job_system_get_stats(&stats);
+    printf("    compute loop:        %8.2f ms, speedup %.2fx (%llu jobs, %llu "
+           "steals)\n",
+           best_ms, single_thread_ms / best_ms,
+           (unsigned long long)stats.job_count,
+           (unsigned long long)stats.steal_count);
+    job_system_shutdown();
+
+    if (thread_count == max_thread_count) {
+      break;
+    }
+  }
+  free(values);
+
+  if (was_initialized) {
+    job_system_init(prev_thread_count);
+  }
+}
@@ -0,0 +1,105 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Work-stealing job system: every worker thread and the thread that
+ * initialized the job system own a deque of jobs, idle threads steal from the
+ * other deques. Jobs submitted by other threads go through a shared queue. */
+
+typedef struct job_t job_t;
+
+/* One worker thread per core, except the main thread's core */
+#define JOB_SYSTEM_AUTO_THREAD_COUNT UINT32_MAX
+
+typedef void (*job_func_t)(void* data);
+/* Processes the indices [begin, end) of a parallel loop */
+typedef void (*job_range_func_t)(uint32_t begin, uint32_t end, void* data);
+
+/* Job system statistics */
+typedef struct job_system_stats_t {
+  uint32_t thread_count; /* worker threads, the main thread is not included */
+  uint64_t job_count;    /* jobs executed */
+  uint64_t steal_count;  /* jobs taken from another thread's deque */
+} job_system_stats_t;
+
+/* Job system control */
+
+/**
+ * @brief Starts the worker threads and registers the calling thread as main
+ * thread, which executes jobs while it waits for them.
+ * @param thread_count number of worker threads or
+ * JOB_SYSTEM_AUTO_THREAD_COUNT, without workers jobs run on the main thread
+ */
+void job_system_init(uint32_t thread_count);
+
+/**
+ * @brief Stops the worker threads, all submitted jobs must be finished.
+ */
+void job_system_shutdown(void);
+
+bool job_system_is_initialized(void);
+uint32_t job_system_get_thread_count(void);
+void job_system_get_stats(job_system_stats_t* stats);
+
+/* Jobs */
+
+/**
+ * @brief Creates a job, it runs once it is submitted and all its dependencies
+ * are finished. Without initialized job system jobs run on the thread that
+ * waits for them.
+ * @return a job reference the caller releases with job_release()
+ */
+job_t* job_create(job_func_t func, void* data);
+
+/**
+ * @brief Delays the job until the dependency is finished, must be called
+ * before the job is submitted.
+ */
+void job_add_dependency(job_t* job, job_t* dependency);
+
+void job_submit(job_t* job);
+
+/**
+ * @brief Creates and submits a continuation that runs after the job.
+ * @return a job reference the caller releases with job_release()
+ */
+job_t* job_then(job_t* job, job_func_t func, void* data);
+
+bool job_is_done(job_t* job);
+
+/**
+ * @brief Waits until the job is finished, the calling thread executes other
+ * jobs in the meantime ("help while waiting").
+ */
+void job_wait(job_t* job);
+
+void job_release(job_t* job);
+
+/* Convenience function, submits, waits for and releases the job */
+void job_run(job_t* job);
+
+/**
+ * @brief Processes [0, count) in parallel, ranges larger than the grain size
+ * are split in halves that idle threads steal. Returns when all indices are
+ * processed, the calling thread takes part in the loop.
+ * @param grain_size the smallest range processed by a single call, 0 picks a
+ * size based on the thread count
+ */
+void job_parallel_for(uint32_t count, uint32_t grain_size,
+                      job_range_func_t func, void* data);
+
+/* Job system microbenchmarks */
+
+/**
+ * @brief Measures the scheduling overhead of the job system (empty jobs,
+ * continuation chains, fine-grained parallel loops) and the scaling of a
+ * compute-bound parallel loop from one thread up to max_thread_count threads,
+ * the results are printed to stdout.
+ * @param max_thread_count highest number of threads including the main
+ * thread, 0 uses the number of cores
+ */
+void job_system_benchmark(uint32_t max_thread_count);
+
+#endif
@@ -0,0 +1,244 @@
+#include "ktx2.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "macro.h"
+
+/* Header and index of the file, followed by the level index */
+#define KTX2_HEADER_SIZE 80u
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24u
+
+static const uint8_t ktx2_identifier[KTX2_IDENTIFIER_SIZE] = {
+  0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A,
+};
+
+/* Basic data format descriptor: total size, block header and one sample per
+ * channel */
+#define KTX2_DFD_BLOCK_HEADER_SIZE 24u
+#define KTX2_DFD_SAMPLE_SIZE 16u
+
+/* Khronos Data Format values of the block compressed formats the writer
+ * supports, see khr_df.h */
+#define KTX2_DF_MODEL_BC1A 128u
+#define KTX2_DF_MODEL_BC3 130u
+#define KTX2_DF_MODEL_BC7 135u
+#define KTX2_DF_PRIMARIES_BT709 1u
+#define KTX2_DF_TRANSFER_LINEAR 1u
+#define KTX2_DF_TRANSFER_SRGB 2u
+#define KTX2_DF_CHANNEL_COLOR 0u
+#define KTX2_DF_CHANNEL_BC3_ALPHA 15u
+#define KTX2_DF_SAMPLE_LINEAR 0x10u
+
+typedef struct ktx2_dfd_format_t {
+  uint32_t vk_format;
+  uint32_t color_model;
+  uint32_t transfer;
+  uint32_t block_size; /* bytes per 4x4 block */
+} ktx2_dfd_format_t;
+
+static const ktx2_dfd_format_t ktx2_dfd_formats[] = {
+  // clang-format off
+  {131, KTX2_DF_MODEL_BC1A, KTX2_DF_TRANSFER_LINEAR, 8},  /* BC1_RGB_UNORM */
+  {132, KTX2_DF_MODEL_BC1A, KTX2_DF_TRANSFER_SRGB,   8},  /* BC1_RGB_SRGB */
+  {137, KTX2_DF_MODEL_BC3,  KTX2_DF_TRANSFER_LINEAR, 16}, /* BC3_UNORM */
+  {138, KTX2_DF_MODEL_BC3,  KTX2_DF_TRANSFER_SRGB,   16}, /* BC3_SRGB */
+  {145, KTX2_DF_MODEL_BC7,  KTX2_DF_TRANSFER_LINEAR, 16}, /* BC7_UNORM */
+  {146, KTX2_DF_MODEL_BC7,  KTX2_DF_TRANSFER_SRGB,   16}, /* BC7_SRGB */
+  // clang-format on
+};
+
+/* KTX 2.0 files are little endian, as are the supported platforms */
+static uint32_t ktx2_read_u32(const uint8_t* data)
+{
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static uint64_t ktx2_read_u64(const uint8_t* data)
+{
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static void ktx2_write_u32(uint8_t* data, uint32_t value)
+{
+  memcpy(data, &value, sizeof(value));
+}
+
+static void ktx2_write_u64(uint8_t* data, uint64_t value)
+{
+  memcpy(data, &value, sizeof(value));
+}
+
+bool ktx2_has_identifier(const void* data, size_t size)
+{
+  return size >= KTX2_IDENTIFIER_SIZE
+         && memcmp(data, ktx2_identifier, KTX2_IDENTIFIER_SIZE) == 0;
+}
+
+bool ktx2_parse(const void* data, size_t size, ktx2_texture_t* texture)
+{
+  memset(texture, 0, sizeof(*texture));
+  if (size < KTX2_HEADER_SIZE || !ktx2_has_identifier(data, size)) {
+    log_error("Not a KTX 2.0 file");
+    return false;
+  }
+
+  const uint8_t* header = (const uint8_t*)data + KTX2_IDENTIFIER_SIZE;
+
+  texture->vk_format               = ktx2_read_u32(header + 0);
+  texture->type_size               = ktx2_read_u32(header + 4);
+  texture->width                   = ktx2_read_u32(header + 8);
+  texture->height                  = ktx2_read_u32(header + 12);
+  texture->depth                   = ktx2_read_u32(header + 16);
+  texture->layer_count             = ktx2_read_u32(header + 20);
+  texture->face_count              = ktx2_read_u32(header + 24);
+  texture->level_count             = ktx2_read_u32(header + 28);
+  texture->supercompression_scheme = ktx2_read_u32(header + 32);
+
+  /* A level count of 0 asks the loader to generate the mip chain */
+  if (texture->level_count == 0) {
+    texture->level_count = 1;
+  }
+  if (texture->width == 0 || texture->level_count > KTX2_MAX_LEVELS
+      || (texture->face_count != 1 && texture->face_count != 6)) {
+    log_error("Unsupported KTX 2.0 texture (%ux%u, %u faces, %u levels)",
+              texture->width, texture->height, texture->face_count,
+              texture->level_count);
+    return false;
+  }
+
+  const size_t level_index_size
+    = (size_t)texture->level_count * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+  if (size < KTX2_HEADER_SIZE + level_index_size) {
+    log_error("Truncated KTX 2.0 level index");
+    return false;
+  }
+
+  const uint8_t* level_index = (const uint8_t*)data + KTX2_HEADER_SIZE;
+  for (uint32_t level = 0; level < texture->level_count; ++level) {
+    const uint8_t* entry   = level_index + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+    const uint64_t offset  = ktx2_read_u64(entry + 0);
+    const uint64_t length  = ktx2_read_u64(entry + 8);
+    if (offset > size || length > size - offset) {
+      log_error("KTX 2.0 level %u is out of bounds", level);
+      return false;
+    }
+    texture->levels[level] = (ktx2_level_t){
+      .offset = offset,
+      .size   = length,
+    };
+  }
+
+  return true;
+}
+
+/* Writes the sample of the channel, covering bit_length bits of the block */
+static uint8_t* ktx2_write_dfd_sample(uint8_t* sample, uint32_t channel,
+                                      uint32_t bit_offset, uint32_t bit_length)
+{
+  ktx2_write_u32(sample + 0,
+                 bit_offset | ((bit_length - 1) << 16) | (channel << 24));
+  ktx2_write_u32(sample + 4, 0);           /* sample position */
+  ktx2_write_u32(sample + 8, 0);           /* sample lower */
+  ktx2_write_u32(sample + 12, UINT32_MAX); /* sample upper */
+  return sample + KTX2_DFD_SAMPLE_SIZE;
+}
+
+bool ktx2_write(const ktx2_write_desc_t* desc, uint8_t** data, size_t* size)
+{
+  *data = NULL;
+  *size = 0;
+
+  const ktx2_dfd_format_t* format = NULL;
+  for (uint32_t i = 0; i < ARRAY_SIZE(ktx2_dfd_formats); ++i) {
+    if (ktx2_dfd_formats[i].vk_format == desc->vk_format) {
+      format = &ktx2_dfd_formats[i];
+    }
+  }
+  if (format == NULL || desc->level_count == 0
+      || desc->level_count > KTX2_MAX_LEVELS) {
+    log_error("Unsupported KTX 2.0 texture (vkFormat %u, %u levels)",
+              desc->vk_format, desc->level_count);
+    return false;
+  }
+
+  // BC3 blocks hold the alpha block followed by the color block
+  const bool bc3              = format->color_model == KTX2_DF_MODEL_BC3;
+  const uint32_t sample_count = bc3 ? 2u : 1u;
+  const uint32_t dfd_offset
+    = KTX2_HEADER_SIZE + desc->level_count * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+  const uint32_t dfd_size
+    = 4 + KTX2_DFD_BLOCK_HEADER_SIZE + sample_count * KTX2_DFD_SAMPLE_SIZE;
+
+  // Levels are aligned to the block size, which is a multiple of 4
+  size_t level_offsets[KTX2_MAX_LEVELS];
+  size_t file_size = dfd_offset + dfd_size;
+  for (int32_t level = (int32_t)desc->level_count - 1; level >= 0; --level) {
+    file_size = (file_size + format->block_size - 1)
+                & ~(size_t)(format->block_size - 1);
+    level_offsets[level] = file_size;
+    file_size += desc->levels[level].size;
+  }
+
+  uint8_t* file = (uint8_t*)calloc(1, file_size);
+  if (file == NULL) {
+    return false;
+  }
+
+  // Header
+  memcpy(file, ktx2_identifier, KTX2_IDENTIFIER_SIZE);
+  uint8_t* header = file + KTX2_IDENTIFIER_SIZE;
+  ktx2_write_u32(header + 0, desc->vk_format);
+  ktx2_write_u32(header + 4, 1); /* typeSize of block compressed formats */
+  ktx2_write_u32(header + 8, desc->width);
+  ktx2_write_u32(header + 12, desc->height);
+  ktx2_write_u32(header + 24, 1); /* faceCount */
+  ktx2_write_u32(header + 28, desc->level_count);
+  ktx2_write_u32(header + 36, dfd_offset);
+  ktx2_write_u32(header + 40, dfd_size);
+
+  // Level index and level data
+  for (uint32_t level = 0; level < desc->level_count; ++level) {
+    uint8_t* entry
+      = file + KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+    ktx2_write_u64(entry + 0, level_offsets[level]);
+    ktx2_write_u64(entry + 8, desc->levels[level].size);
+    ktx2_write_u64(entry + 16, desc->levels[level].size);
+    memcpy(file + level_offsets[level], desc->levels[level].data,
+           desc->levels[level].size);
+  }
+
+  // Basic data format descriptor of 4x4 blocks
+  uint8_t* dfd = file + dfd_offset;
+  ktx2_write_u32(dfd + 0, dfd_size);
+  ktx2_write_u32(dfd + 4, 0); /* Khronos vendor, basic descriptor type */
+  ktx2_write_u32(dfd + 8, 2 | ((dfd_size - 4) << 16)); /* version 1.3 */
+  ktx2_write_u32(dfd + 12, format->color_model
+                             | (KTX2_DF_PRIMARIES_BT709 << 8)
+                             | (format->transfer << 16));
+  ktx2_write_u32(dfd + 16, 3 | (3 << 8)); /* texel block dimensions - 1 */
+  ktx2_write_u32(dfd + 20, format->block_size); /* bytesPlane0 */
+  uint8_t* sample = dfd + 4 + KTX2_DFD_BLOCK_HEADER_SIZE;
+  if (bc3) {
+    // Alpha is always linear
+    const uint32_t alpha_channel
+      = KTX2_DF_CHANNEL_BC3_ALPHA
+        | (format->transfer == KTX2_DF_TRANSFER_SRGB ? KTX2_DF_SAMPLE_LINEAR :
+                                                       0u);
+    sample = ktx2_write_dfd_sample(sample, alpha_channel, 0, 64);
+    ktx2_write_dfd_sample(sample, KTX2_DF_CHANNEL_COLOR, 64, 64);
+  }
+  else {
+    ktx2_write_dfd_sample(sample, KTX2_DF_CHANNEL_COLOR, 0,
+                          format->block_size * 8);
+  }
+
+  *data = file;
+  *size = file_size;
+  return true;
+}
@@ -0,0 +1,70 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* KTX 2.0 container without supercompression. The image data is referenced in
+ * place, the rows of every image are tightly packed (compressed formats store
+ * rows of blocks). Within a level the images are ordered by layer, then face.
+ * @ref https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html */
+
+#define KTX2_MAX_LEVELS 16u
+#define KTX2_IDENTIFIER_SIZE 12u
+
+typedef struct ktx2_level_t {
+  uint64_t offset; /* byte offset of the level in the file */
+  uint64_t size;   /* bytes of all layers and faces of the level */
+} ktx2_level_t;
+
+typedef struct ktx2_texture_t {
+  uint32_t vk_format; /* VkFormat of the image data */
+  uint32_t type_size;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;       /* 0 for 1D and 2D textures */
+  uint32_t layer_count; /* 0 for non-array textures */
+  uint32_t face_count;  /* 6 for cube maps, 1 otherwise */
+  uint32_t level_count; /* at least 1 */
+  uint32_t supercompression_scheme;
+  ktx2_level_t levels[KTX2_MAX_LEVELS];
+} ktx2_texture_t;
+
+/**
+ * @brief Returns true if the data starts with the KTX 2.0 file identifier.
+ */
+bool ktx2_has_identifier(const void* data, size_t size);
+
+/**
+ * @brief Reads the header and the level index of a KTX 2.0 file.
+ * @param data the file contents
+ * @param texture the texture description, the level ranges are validated
+ * against the file size
+ * @return true on success, otherwise false
+ */
+bool ktx2_parse(const void* data, size_t size, ktx2_texture_t* texture);
+
+/* 2D texture to be written, the rows of blocks of every level are tightly
+ * packed */
+typedef struct ktx2_write_desc_t {
+  uint32_t vk_format; /* BC1 RGB, BC3 or BC7, UNORM or SRGB */
+  uint32_t width;
+  uint32_t height;
+  uint32_t level_count;
+  struct {
+    const void* data;
+    size_t size;
+  } levels[KTX2_MAX_LEVELS]; /* levels[0] is the base level */
+} ktx2_write_desc_t;
+
+/**
+ * @brief Serializes the texture into a KTX 2.0 file in memory, with a basic
+ * data format descriptor and without key/value data. The level data is stored
+ * from the smallest to the largest level as the format requires.
+ * @param data the file contents, released with free()
+ * @return true on success, false for unsupported formats
+ */
+bool ktx2_write(const ktx2_write_desc_t* desc, uint8_t** data, size_t* size);
+
+#endif
@@ -0,0 +1,421 @@
+#include "mip_chain.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "job_system.h"
+#include "macro.h"
+#include "platform.h"
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize.h"
+
+/* Rows per parallel range are chosen so that a range covers about this many
+ * bytes of the destination level */
+#define MIP_CHAIN_BYTES_PER_RANGE (64u * 1024u)
+
+/* sRGB <-> linear conversion tables, linear values are 16-bit */
+static struct {
+  pthread_once_t once;
+  uint16_t srgb_to_linear[256];
+  uint8_t linear_to_srgb[65536];
+} mip_chain_tables = {
+  .once = PTHREAD_ONCE_INIT,
+};
+
+static void mip_chain_init_tables(void)
+{
+  for (uint32_t i = 0; i < 256; ++i) {
+    const float c = (float)i / 255.0f;
+    const float l
+      = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    mip_chain_tables.srgb_to_linear[i] = (uint16_t)(l * 65535.0f + 0.5f);
+  }
+  for (uint32_t i = 0; i < 65536; ++i) {
+    const float l = (float)i / 65535.0f;
+    const float c
+      = (l <= 0.0031308f) ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+    mip_chain_tables.linear_to_srgb[i]
+      = (uint8_t)(CLAMP(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+  }
+}
+
+uint32_t mip_chain_full_level_count(uint32_t width, uint32_t height)
+{
+  uint32_t size        = MAX(width, height);
+  uint32_t level_count = 1;
+  while (size > 1) {
+    size >>= 1;
+    ++level_count;
+  }
+  return level_count;
+}
+
+/* Downsampling of one level into the next */
+typedef struct mip_chain_pass_t {
+  const mip_chain_level_t* src_level;
+  const mip_chain_level_t* dst_level;
+  uint8_t* data;
+} mip_chain_pass_t;
+
+/* Source rows of a destination row, an odd source height folds the last row
+ * into the last destination row (row2 is NULL otherwise) */
+typedef struct mip_chain_src_rows_t {
+  const uint8_t* rows[3];
+  uint32_t count;
+} mip_chain_src_rows_t;
+
+/* Number of source columns of the texel x, starting at 2 * x. An odd source
+ * width folds the last column into the last texel. */
+static inline uint32_t mip_chain_column_count(uint32_t x, uint32_t width,
+                                              uint32_t src_width)
+{
+  if (src_width == 1) {
+    return 1;
+  }
+  return ((src_width & 1) != 0 && x == width - 1) ? 3 : 2;
+}
+
+/* Sum of a channel over the source texels of a destination texel */
+static inline uint32_t mip_chain_sum_channel(const mip_chain_src_rows_t* src,
+                                             uint32_t x0, uint32_t x_count,
+                                             uint32_t c,
+                                             const uint16_t* to_linear)
+{
+  uint32_t sum = 0;
+  for (uint32_t r = 0; r < src->count; ++r) {
+    for (uint32_t i = 0; i < x_count; ++i) {
+      const uint8_t value = src->rows[r][(x0 + i) * 4 + c];
+      sum += (to_linear != NULL) ? to_linear[value] : value;
+    }
+  }
+  return sum;
+}
+
+/* Box filter of the columns [x, width) of a row, 2x2 texels or up to 3x3 at
+ * the odd edges */
+static void mip_chain_downsample_row_linear(const mip_chain_src_rows_t* src,
+                                            uint8_t* dst, uint32_t x,
+                                            uint32_t width, uint32_t src_width)
+{
+  for (; x < width; ++x) {
+    const uint32_t x0      = 2 * x;
+    const uint32_t x_count = mip_chain_column_count(x, width, src_width);
+    const uint32_t taps    = x_count * src->count;
+    for (uint32_t c = 0; c < 4; ++c) {
+      const uint32_t sum = mip_chain_sum_channel(src, x0, x_count, c, NULL);
+      dst[x * 4 + c]     = (uint8_t)((sum + taps / 2) / taps);
+    }
+  }
+}
+
+#if defined(__SSE2__)
+/* Four destination pixels per iteration, the remainder and the odd edges are
+ * filtered by the scalar path */
+static void mip_chain_downsample_row_sse2(const mip_chain_src_rows_t* src,
+                                          uint8_t* dst, uint32_t width,
+                                          uint32_t src_width)
+{
+  const uint8_t* row0 = src->rows[0];
+  const uint8_t* row1 = src->rows[1];
+  const __m128i zero  = _mm_setzero_si128();
+  const __m128i two   = _mm_set1_epi16(2);
+
+  /* The last texel of an odd source width covers three columns */
+  const uint32_t box_width = width - (src_width & 1);
+  uint32_t x               = 0;
+  if (src_width >= 2 && src->count == 2) {
+    for (; x + 4 <= box_width; x += 4) {
+      const __m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+      const __m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+      const __m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+      const __m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+      // Vertical sums, two source pixels per register
+      const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero),
+                                       _mm_unpacklo_epi8(b0, zero));
+      const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero),
+                                       _mm_unpackhi_epi8(b0, zero));
+      const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero),
+                                       _mm_unpacklo_epi8(b1, zero));
+      const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero),
+                                       _mm_unpackhi_epi8(b1, zero));
+      // Horizontal sums of the pixel pairs, rounded average
+      __m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1),
+                                 _mm_unpackhi_epi64(s0, s1));
+      __m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3),
+                                 _mm_unpackhi_epi64(s2, s3));
+      h0 = _mm_srli_epi16(_mm_add_epi16(h0, two), 2);
+      h1 = _mm_srli_epi16(_mm_add_epi16(h1, two), 2);
+      _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(h0, h1));
+    }
+  }
+  mip_chain_downsample_row_linear(src, dst, x, width, src_width);
+}
+#endif
+
+/* Color channels are converted to linear space before they are averaged */
+static void mip_chain_downsample_row_srgb(const mip_chain_src_rows_t* src,
+                                          uint8_t* dst, uint32_t width,
+                                          uint32_t src_width)
+{
+  const uint16_t* to_linear = mip_chain_tables.srgb_to_linear;
+  const uint8_t* to_srgb    = mip_chain_tables.linear_to_srgb;
+  for (uint32_t x = 0; x < width; ++x) {
+    const uint32_t x0      = 2 * x;
+    const uint32_t x_count = mip_chain_column_count(x, width, src_width);
+    const uint32_t taps    = x_count * src->count;
+    for (uint32_t c = 0; c < 3; ++c) {
+      const uint32_t sum
+        = mip_chain_sum_channel(src, x0, x_count, c, to_linear);
+      dst[x * 4 + c] = to_srgb[(sum + taps / 2) / taps];
+    }
+    const uint32_t alpha = mip_chain_sum_channel(src, x0, x_count, 3, NULL);
+    dst[x * 4 + 3]       = (uint8_t)((alpha + taps / 2) / taps);
+  }
+}
+
+static void mip_chain_downsample_rows(uint32_t begin, uint32_t end,
+                                      void* data, bool srgb)
+{
+  const mip_chain_pass_t* pass = (const mip_chain_pass_t*)data;
+  const mip_chain_level_t* src = pass->src_level;
+  const mip_chain_level_t* dst = pass->dst_level;
+  const uint8_t* src_data      = pass->data + src->offset;
+  for (uint32_t y = begin; y < end; ++y) {
+    // Single source rows are repeated, an odd source height folds the last
+    // row into the last destination row
+    const uint32_t y1             = MIN(2 * y + 1, src->height - 1);
+    mip_chain_src_rows_t src_rows = {
+      .rows  = {src_data + (size_t)(2 * y) * src->row_pitch,
+                src_data + (size_t)y1 * src->row_pitch},
+      .count = 2,
+    };
+    if (src->height > 1 && (src->height & 1) != 0 && y == dst->height - 1) {
+      src_rows.rows[2] = src_data + (size_t)(2 * y + 2) * src->row_pitch;
+      src_rows.count   = 3;
+    }
+    uint8_t* dst_row = pass->data + dst->offset + (size_t)y * dst->row_pitch;
+    if (srgb) {
+      mip_chain_downsample_row_srgb(&src_rows, dst_row, dst->width,
+                                    src->width);
+    }
+    else {
+#if defined(__SSE2__)
+      mip_chain_downsample_row_sse2(&src_rows, dst_row, dst->width,
+                                    src->width);
+#else
+      mip_chain_downsample_row_linear(&src_rows, dst_row, 0, dst->width,
+                                      src->width);
+#endif
+    }
+  }
+}
+
+static void mip_chain_downsample_rows_linear(uint32_t begin, uint32_t end,
+                                             void* data)
+{
+  mip_chain_downsample_rows(begin, end, data, false);
+}
+
+static void mip_chain_downsample_rows_srgb(uint32_t begin, uint32_t end,
+                                           void* data)
+{
+  mip_chain_downsample_rows(begin, end, data, true);
+}
+
+bool mip_chain_create(const mip_chain_desc_t* desc, mip_chain_t* mip_chain)
+{
+  ASSERT(desc && mip_chain);
+  memset(mip_chain, 0, sizeof(*mip_chain));
+  if (desc->pixels == NULL || desc->width == 0 || desc->height == 0) {
+    return false;
+  }
+
+  const uint32_t row_alignment = MAX(desc->row_alignment, 1u);
+  ASSERT((row_alignment & (row_alignment - 1)) == 0);
+  const uint32_t full_level_count
+    = MIN(mip_chain_full_level_count(desc->width, desc->height),
+          MIP_CHAIN_MAX_LEVELS);
+  const uint32_t level_count
+    = (desc->level_count == 0) ? full_level_count :
+                                 MIN(desc->level_count, full_level_count);
+
+  // Layout of the levels, every level starts at a row boundary
+  size_t size = 0;
+  for (uint32_t i = 0; i < level_count; ++i) {
+    mip_chain_level_t* level = &mip_chain->levels[i];
+    level->width             = MAX(desc->width >> i, 1u);
+    level->height            = MAX(desc->height >> i, 1u);
+    level->row_pitch
+      = (level->width * 4 + row_alignment - 1) & ~(row_alignment - 1);
+    level->offset = size;
+    size += (size_t)level->row_pitch * level->height;
+  }
+
+  // Padding bytes are zeroed for deterministic uploads
+  uint8_t* data = (row_alignment > 1) ? calloc(1, size) : malloc(size);
+  if (data == NULL) {
+    return false;
+  }
+  mip_chain->data        = data;
+  mip_chain->size        = size;
+  mip_chain->level_count = level_count;
+
+  // Level 0
+  const uint32_t src_row_pitch
+    = (desc->row_pitch == 0) ? desc->width * 4 : desc->row_pitch;
+  for (uint32_t y = 0; y < desc->height; ++y) {
+    memcpy(data + (size_t)y * mip_chain->levels[0].row_pitch,
+           desc->pixels + (size_t)y * src_row_pitch, desc->width * 4);
+  }
+
+  // Every level is filtered from the previous one
+  const bool srgb = (desc->color_space == MipChainColorSpace_Srgb);
+  if (srgb) {
+    pthread_once(&mip_chain_tables.once, mip_chain_init_tables);
+  }
+  for (uint32_t i = 1; i < level_count; ++i) {
+    mip_chain_pass_t pass = {
+      .src_level = &mip_chain->levels[i - 1],
+      .dst_level = &mip_chain->levels[i],
+      .data      = data,
+    };
+    const uint32_t grain_size
+      = MAX(MIP_CHAIN_BYTES_PER_RANGE / pass.dst_level->row_pitch, 1u);
+    job_parallel_for(pass.dst_level->height, grain_size,
+                     srgb ? mip_chain_downsample_rows_srgb :
+                            mip_chain_downsample_rows_linear,
+                     &pass);
+  }
+
+  return true;
+}
+
+void mip_chain_destroy(mip_chain_t* mip_chain)
+{
+  if (mip_chain == NULL) {
+    return;
+  }
+  free(mip_chain->data);
+  memset(mip_chain, 0, sizeof(*mip_chain));
+}
+
+/* CPU mip chain benchmark */
+
+#define MIP_CHAIN_BENCHMARK_SIZE 2048u
+#define MIP_CHAIN_BENCHMARK_RUNS 5u
+
+/* Previous path: every level is resized from level 0 by stb_image_resize,
+ * one allocation per level */
+static void mip_chain_benchmark_stbir(const uint8_t* pixels, uint32_t size)
+{
+  const uint32_t level_count = mip_chain_full_level_count(size, size);
+  uint8_t** levels = (uint8_t**)malloc(level_count * sizeof(uint8_t*));
+  for (uint32_t i = 0; i < level_count; ++i) {
+    const int level_size = (int)MAX(size >> i, 1u);
+    levels[i]            = (uint8_t*)malloc(level_size * level_size * 4);
+    stbir_resize_uint8(pixels, (int)size, (int)size, 0, levels[i], level_size,
+                       level_size, 0, 4);
+  }
+  for (uint32_t i = 0; i < level_count; ++i) {
+    free(levels[i]);
+  }
+  free(levels);
+}
+
+static void mip_chain_benchmark_create(const uint8_t* pixels, uint32_t size,
+                                       mip_chain_color_space_enum color_space)
+{
+  mip_chain_t mip_chain = {0};
+  mip_chain_create(
+    &(mip_chain_desc_t){
+      .pixels        = pixels,
+      .width         = size,
+      .height        = size,
+      .row_alignment = 256,
+      .color_space   = color_space,
+    },
+    &mip_chain);
+  mip_chain_destroy(&mip_chain);
+}
+
+/* Best of MIP_CHAIN_BENCHMARK_RUNS runs in milliseconds, a negative path runs
+ * the stb_image_resize path, otherwise the color space of the mip chain */
+static double mip_chain_benchmark_run(const uint8_t* pixels, uint32_t size,
+                                      int path)
+{
+  double best_ms = 0.0;
+  for (uint32_t run = 0; run < MIP_CHAIN_BENCHMARK_RUNS; ++run) {
+    const uint64_t start = platform_get_time_ns();
+    if (path < 0) {
+      mip_chain_benchmark_stbir(pixels, size);
+    }
+    else {
+      mip_chain_benchmark_create(pixels, size,
+                                 (mip_chain_color_space_enum)path);
+    }
+    const double ms = (double)(platform_get_time_ns() - start) / 1e6;
+    best_ms         = (run == 0) ? ms : MIN(best_ms, ms);
+  }
+  return best_ms;
+}
+
+void mip_chain_benchmark(uint32_t size)
+{
+  if (size == 0) {
+    size = MIP_CHAIN_BENCHMARK_SIZE;
+  }
+
+  // Noise with a gradient, the content does not change the cost of any path
+  uint8_t* pixels = (uint8_t*)malloc((size_t)size * size * 4);
+  uint32_t state  = 0x12345678u;
+  for (size_t i = 0; i < (size_t)size * size * 4; ++i) {
+    state     = state * 1664525u + 1013904223u;
+    pixels[i] = (uint8_t)((state >> 24) / 2 + (i / 4 % size) * 127 / size);
+  }
+
+  // The single-threaded runs restart the job system without workers
+  const bool was_initialized    = job_system_is_initialized();
+  const uint32_t thread_count   = job_system_get_thread_count();
+  const uint32_t parallel_count = was_initialized ?
+                                    thread_count :
+                                    JOB_SYSTEM_AUTO_THREAD_COUNT;
+  if (was_initialized) {
+    job_system_shutdown();
+  }
+
+  printf("Mip chain of a %ux%u RGBA8 image (%u levels):\n", size, size,
+         mip_chain_full_level_count(size, size));
+  const double stbir_ms = mip_chain_benchmark_run(pixels, size, -1);
+  printf("    stbir per level:      %8.2f ms\n", stbir_ms);
+
+  job_system_init(0);
+  double ms = mip_chain_benchmark_run(pixels, size, MipChainColorSpace_Linear);
+  printf("    box, 1 thread:        %8.2f ms, speedup %.2fx\n", ms,
+         stbir_ms / ms);
+  ms = mip_chain_benchmark_run(pixels, size, MipChainColorSpace_Srgb);
+  printf("    box sRGB, 1 thread:   %8.2f ms, speedup %.2fx\n", ms,
+         stbir_ms / ms);
+  job_system_shutdown();
+
+  job_system_init(parallel_count);
+  const uint32_t total_count = job_system_get_thread_count() + 1;
+  ms = mip_chain_benchmark_run(pixels, size, MipChainColorSpace_Linear);
+  printf("    box, %2u threads:      %8.2f ms, speedup %.2fx\n", total_count,
+         ms, stbir_ms / ms);
+  ms = mip_chain_benchmark_run(pixels, size, MipChainColorSpace_Srgb);
+  printf("    box sRGB, %2u threads: %8.2f ms, speedup %.2fx\n", total_count,
+         ms, stbir_ms / ms);
+  if (!was_initialized) {
+    job_system_shutdown();
+  }
+
+  free(pixels);
+}
@@ -0,0 +1,72 @@
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* CPU mip chain of an RGBA8 image: every level is downsampled from the
+ * previous one with a 2x2 box filter, the rows of a level are split across
+ * the job system threads. The last texel of an odd source row or column
+ * averages three source texels, so the odd edge is not dropped. All levels
+ * live in one allocation. */
+
+#define MIP_CHAIN_MAX_LEVELS 16u
+
+typedef enum mip_chain_color_space_enum {
+  MipChainColorSpace_Linear = 0,
+  /* The color channels are averaged in linear space, alpha stays linear */
+  MipChainColorSpace_Srgb = 1,
+} mip_chain_color_space_enum;
+
+typedef struct mip_chain_level_t {
+  uint32_t width;
+  uint32_t height;
+  size_t offset;      /* byte offset of the level in the data */
+  uint32_t row_pitch; /* bytes per row, a multiple of the row alignment */
+} mip_chain_level_t;
+
+typedef struct mip_chain_t {
+  uint8_t* data;
+  size_t size;
+  uint32_t level_count;
+  mip_chain_level_t levels[MIP_CHAIN_MAX_LEVELS];
+} mip_chain_t;
+
+typedef struct mip_chain_desc_t {
+  const uint8_t* pixels; /* level 0, RGBA8 */
+  uint32_t width;
+  uint32_t height;
+  uint32_t row_pitch;     /* bytes per row of pixels, 0 for width * 4 */
+  uint32_t level_count;   /* 0 for the full chain down to 1x1 */
+  uint32_t row_alignment; /* power of two, 0 for tightly packed rows */
+  mip_chain_color_space_enum color_space;
+} mip_chain_desc_t;
+
+/**
+ * @brief Returns the number of levels of a full mip chain down to 1x1.
+ */
+uint32_t mip_chain_full_level_count(uint32_t width, uint32_t height);
+
+/**
+ * @brief Copies the level 0 pixels into a new allocation and generates the
+ * remaining levels from them.
+ * @param desc the source image and the layout of the chain
+ * @param mip_chain the generated mip chain, released with mip_chain_destroy()
+ * @return true on success, otherwise false
+ */
+bool mip_chain_create(const mip_chain_desc_t* desc, mip_chain_t* mip_chain);
+
+void mip_chain_destroy(mip_chain_t* mip_chain);
+
+/* CPU mip chain benchmark */
+
+/**
+ * @brief Compares the generation of a full mip chain of a square RGBA8 image
+ * with stb_image_resize per level against the 2x2 box filter mip chain on one
+ * thread and on all job system threads, the results are printed to stdout.
+ * @param size width and height of level 0, 0 uses 2048
+ */
+void mip_chain_benchmark(uint32_t size);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef PLATFORM_H
 #define PLATFORM_H
 
+#include <stdint.h>
+
 /* date class */
 typedef struct date_t {
   int msec;
@@ -19,5 +21,7 @@ void initialize_default_path(void);
 /* misc platform functions */
 void get_local_time(date_t* current_date);
 float platform_get_time(void);
+/* monotonic clock in nanoseconds, use for time differences */
+uint64_t platform_get_time_ns(void);
 
 #endif
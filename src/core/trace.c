@@ -0,0 +1,337 @@
+#include "trace.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "macro.h"
+#include "platform.h"
+
+/* Number of events per thread buffer, must be a power of two */
+#define TRACE_BUFFER_CAPACITY 16384u
+#define TRACE_THREAD_NAME_SIZE 64u
+/* Interval of the writer thread emptying the thread buffers */
+#define TRACE_FLUSH_INTERVAL_MS 250u
+
+typedef struct trace_event_t {
+  const char* name;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+} trace_event_t;
+
+/* Single producer / single consumer ring buffer: only the owning thread
+ * advances head, only trace_flush advances tail */
+typedef struct trace_buffer_t {
+  trace_event_t events[TRACE_BUFFER_CAPACITY];
+  uint32_t head;
+  uint32_t tail;
+  uint32_t dropped;
+  uint32_t tid;
+  char thread_name[TRACE_THREAD_NAME_SIZE];
+  bool thread_name_written;
+  struct trace_buffer_t* next;
+} trace_buffer_t;
+
+/* Buffers are registered once per thread and reused by later traces */
+static struct {
+  bool enabled;
+  FILE* file;
+  char filename[STRMAX];
+  int pid;
+  uint32_t event_count;
+  uint32_t thread_count;
+  trace_buffer_t* buffers;
+  pthread_key_t buffer_key;
+  pthread_once_t buffer_key_once;
+  pthread_mutex_t mutex; /* guards the file and the buffer list */
+  struct {
+    pthread_t thread;
+    pthread_cond_t cond; /* wakes the writer thread up to stop */
+    bool running;
+  } writer;
+} trace = {
+  .buffer_key_once = PTHREAD_ONCE_INIT,
+  .mutex           = PTHREAD_MUTEX_INITIALIZER,
+  .writer.cond     = PTHREAD_COND_INITIALIZER,
+};
+
+static void trace_create_buffer_key(void)
+{
+  pthread_key_create(&trace.buffer_key, NULL);
+}
+
+static trace_buffer_t* trace_get_thread_buffer(void)
+{
+  pthread_once(&trace.buffer_key_once, trace_create_buffer_key);
+
+  trace_buffer_t* buffer
+    = (trace_buffer_t*)pthread_getspecific(trace.buffer_key);
+  if (buffer == NULL) {
+    buffer = (trace_buffer_t*)calloc(1, sizeof(trace_buffer_t));
+    pthread_mutex_lock(&trace.mutex);
+    buffer->tid   = ++trace.thread_count;
+    buffer->next  = trace.buffers;
+    trace.buffers = buffer;
+    pthread_mutex_unlock(&trace.mutex);
+    pthread_setspecific(trace.buffer_key, buffer);
+  }
+  return buffer;
+}
+
+/* Writes an event separator, trace.mutex must be held */
+static void trace_write_separator(void)
+{
+  if (trace.event_count++ > 0) {
+    fputs(",\n", trace.file);
+  }
+}
+
+/* Writes the string as JSON string literal, trace.mutex must be held */
+static void trace_write_string(const char* string)
+{
+  fputc('"', trace.file);
+  for (const char* c = string; *c != '\0'; ++c) {
+    switch (*c) {
+      case '"':
+        fputs("\\\"", trace.file);
+        break;
+      case '\\':
+        fputs("\\\\", trace.file);
+        break;
+      case '\n':
+        fputs("\\n", trace.file);
+        break;
+      case '\t':
+        fputs("\\t", trace.file);
+        break;
+      default:
+        if ((unsigned char)*c < 0x20) {
+          fprintf(trace.file, "\\u%04x", (unsigned int)(unsigned char)*c);
+        }
+        else {
+          fputc(*c, trace.file);
+        }
+        break;
+    }
+  }
+  fputc('"', trace.file);
+}
+
+/* Writes the pending events of a thread buffer, trace.mutex must be held */
+static void trace_write_buffer(trace_buffer_t* buffer)
+{
+  if (!buffer->thread_name_written && buffer->thread_name[0] != '\0') {
+    trace_write_separator();
+    fprintf(trace.file,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+            "\"args\":{\"name\":",
+            trace.pid, buffer->tid);
+    trace_write_string(buffer->thread_name);
+    fputs("}}", trace.file);
+    buffer->thread_name_written = true;
+  }
+
+  const uint32_t head = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+  uint32_t tail       = buffer->tail;
+  for (; tail != head; ++tail) {
+    const trace_event_t* event
+      = &buffer->events[tail & (TRACE_BUFFER_CAPACITY - 1)];
+    // Timestamps are in microseconds, keep the nanoseconds as fraction
+    trace_write_separator();
+    fputs("{\"name\":", trace.file);
+    trace_write_string(event->name);
+    fprintf(trace.file,
+            ",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+            "\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64 ".%03u}",
+            trace.pid, buffer->tid, event->start_ns / 1000,
+            (uint32_t)(event->start_ns % 1000), event->duration_ns / 1000,
+            (uint32_t)(event->duration_ns % 1000));
+  }
+  __atomic_store_n(&buffer->tail, tail, __ATOMIC_RELEASE);
+}
+
+/* Writes the pending events of all threads, trace.mutex must be held */
+static void trace_write_buffers(void)
+{
+  for (trace_buffer_t* buffer = trace.buffers; buffer != NULL;
+       buffer                 = buffer->next) {
+    trace_write_buffer(buffer);
+  }
+  fflush(trace.file);
+}
+
+/* Empties the thread buffers periodically, so that the file I/O does not
+ * stall the traced threads */
+static void* trace_writer_thread(void* arg)
+{
+  UNUSED_VAR(arg);
+
+  pthread_mutex_lock(&trace.mutex);
+  while (trace.writer.running) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)TRACE_FLUSH_INTERVAL_MS * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait(&trace.writer.cond, &trace.mutex, &deadline);
+    trace_write_buffers();
+  }
+  pthread_mutex_unlock(&trace.mutex);
+  return NULL;
+}
+
+int trace_start(const char* filename)
+{
+  int res = -1;
+  pthread_mutex_lock(&trace.mutex);
+
+  if (trace.file != NULL) {
+    log_warn("Tracing already started, writing to %s", trace.filename);
+    goto trace_start_end;
+  }
+
+  trace.file = fopen(filename, "w");
+  if (trace.file == NULL) {
+    log_error("Unable to open file '%s'\n", filename);
+    goto trace_start_end;
+  }
+  snprintf(trace.filename, sizeof(trace.filename), "%s", filename);
+  fputs("{\"traceEvents\":[\n", trace.file);
+  trace.pid         = (int)getpid();
+  trace.event_count = 0;
+
+  // Discard events left over from a previous trace
+  for (trace_buffer_t* buffer = trace.buffers; buffer != NULL;
+       buffer                 = buffer->next) {
+    buffer->tail = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&buffer->dropped, 0, __ATOMIC_RELAXED);
+    buffer->thread_name_written = false;
+  }
+  __atomic_store_n(&trace.enabled, true, __ATOMIC_RELEASE);
+  res = 0;
+
+  trace.writer.running = true;
+  if (pthread_create(&trace.writer.thread, NULL, trace_writer_thread, NULL)
+      != 0) {
+    log_warn("Unable to start the trace writer thread, events are written "
+             "when the trace stops");
+    trace.writer.running = false;
+  }
+
+trace_start_end:
+  pthread_mutex_unlock(&trace.mutex);
+  if (res == 0) {
+    trace_set_thread_name("Main thread");
+  }
+  return res;
+}
+
+void trace_stop(void)
+{
+  __atomic_store_n(&trace.enabled, false, __ATOMIC_RELEASE);
+
+  pthread_mutex_lock(&trace.mutex);
+  if (trace.file == NULL) {
+    pthread_mutex_unlock(&trace.mutex);
+    return;
+  }
+
+  if (trace.writer.running) {
+    trace.writer.running = false;
+    pthread_cond_signal(&trace.writer.cond);
+    pthread_mutex_unlock(&trace.mutex);
+    pthread_join(trace.writer.thread, NULL);
+    pthread_mutex_lock(&trace.mutex);
+  }
+
+  uint32_t dropped = 0;
+  for (trace_buffer_t* buffer = trace.buffers; buffer != NULL;
+       buffer                 = buffer->next) {
+    trace_write_buffer(buffer);
+    dropped += __atomic_load_n(&buffer->dropped, __ATOMIC_RELAXED);
+  }
+  fputs("\n],\"displayTimeUnit\":\"ms\"}\n", trace.file);
+  fclose(trace.file);
+  trace.file = NULL;
+
+  log_info("Trace with %u events written to %s", trace.event_count,
+           trace.filename);
+  if (dropped > 0) {
+    log_warn("Dropped %u trace events, the trace buffers were full", dropped);
+  }
+  pthread_mutex_unlock(&trace.mutex);
+}
+
+bool trace_is_enabled(void)
+{
+  return __atomic_load_n(&trace.enabled, __ATOMIC_ACQUIRE);
+}
+
+void trace_flush(void)
+{
+  pthread_mutex_lock(&trace.mutex);
+  if (trace.file != NULL) {
+    trace_write_buffers();
+  }
+  pthread_mutex_unlock(&trace.mutex);
+}
+
+void trace_set_thread_name(const char* name)
+{
+  trace_buffer_t* buffer = trace_get_thread_buffer();
+
+  pthread_mutex_lock(&trace.mutex);
+  snprintf(buffer->thread_name, sizeof(buffer->thread_name), "%s", name);
+  buffer->thread_name_written = false;
+  pthread_mutex_unlock(&trace.mutex);
+}
+
+trace_span_t trace_span_begin(const char* name)
+{
+  trace_span_t span = {0};
+  if (trace_is_enabled()) {
+    span.name     = name;
+    span.start_ns = platform_get_time_ns();
+  }
+  return span;
+}
+
+/* Appends an event to the buffer of the calling thread */
+static void trace_push_event(const char* name, uint64_t start_ns,
+                             uint64_t end_ns)
+{
+  trace_buffer_t* buffer = trace_get_thread_buffer();
+  const uint32_t head    = buffer->head;
+  const uint32_t tail = __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= TRACE_BUFFER_CAPACITY) {
+    __atomic_fetch_add(&buffer->dropped, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  trace_event_t* event = &buffer->events[head & (TRACE_BUFFER_CAPACITY - 1)];
+  event->name          = name;
+  event->start_ns      = start_ns;
+  event->duration_ns   = (end_ns > start_ns) ? end_ns - start_ns : 0;
+  __atomic_store_n(&buffer->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void trace_span_end(trace_span_t span)
+{
+  if (span.name == NULL) {
+    return;
+  }
+
+  trace_push_event(span.name, span.start_ns, platform_get_time_ns());
+}
+
+void trace_record_span(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+  if (trace_is_enabled()) {
+    trace_push_event(name, start_ns, end_ns);
+  }
+}
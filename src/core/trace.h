@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Span of CPU work on the calling thread */
+typedef struct trace_span_t {
+  const char* name;
+  uint64_t start_ns;
+} trace_span_t;
+
+/* Tracing control */
+
+/**
+ * @brief Starts recording spans, the trace is written to the given file in the
+ * Chrome trace event format (chrome://tracing, https://ui.perfetto.dev).
+ * @param filename the name of the trace file
+ * @return 0 on success, otherwise -1
+ */
+int trace_start(const char* filename);
+
+/**
+ * @brief Writes the remaining events and closes the trace file.
+ */
+void trace_stop(void);
+
+bool trace_is_enabled(void);
+
+/**
+ * @brief Writes the events recorded so far by all threads to the trace file.
+ * A writer thread started by trace_start() does this periodically, events
+ * recorded while the per-thread buffer is full are dropped.
+ */
+void trace_flush(void);
+
+/**
+ * @brief Sets the name of the calling thread shown in the trace viewer.
+ */
+void trace_set_thread_name(const char* name);
+
+/* Spans */
+
+/**
+ * @brief Begins a span on the calling thread, returns an empty span if tracing
+ * is disabled.
+ * @param name the span name, must stay valid until the trace is flushed
+ * (string literal)
+ */
+trace_span_t trace_span_begin(const char* name);
+
+/**
+ * @brief Ends the span and records it in the per-thread buffer (lock-free).
+ */
+void trace_span_end(trace_span_t span);
+
+/**
+ * @brief Records a span measured elsewhere (e.g. forwarded by Dawn) on the
+ * calling thread, the timestamps are platform_get_time_ns() values.
+ */
+void trace_record_span(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+#endif
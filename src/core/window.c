@@ -18,6 +18,7 @@
 #include <string.h>
 
 #include "macro.h"
+#include "trace.h"
 
 #include "../../lib/wgpu_native/wgpu_native.h"
 
@@ -177,7 +178,9 @@ void window_get_aspect_ratio(window_t* window, float* aspect_ratio)
 
 void input_poll_events(void)
 {
+  const trace_span_t span = trace_span_begin("input_poll_events");
   glfwPollEvents();
+  trace_span_end(span);
 }
 
 void input_query_cursor(window_t* window, float* xpos, float* ypos)
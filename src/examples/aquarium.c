@@ -2782,6 +2782,7 @@ static void buffer_manager_flush(buffer_manager_t* this)
   WGPUCommandBuffer copy = wgpuCommandEncoderFinish(this->encoder, NULL);
   ASSERT(copy != NULL);
   WGPU_RELEASE_RESOURCE(CommandEncoder, this->encoder)
+  wgpu_flush_queue_writes(this->wgpu_context);
   wgpuQueueSubmit(this->wgpu_context->queue, 1, &copy);
 
   /* Async function */
@@ -3674,6 +3675,7 @@ context_create_buffer_uint16(context_t* this, int32_t num_components,
 static void context_flush(context_t* this)
 {
   /* Submit to the queue */
+  wgpu_flush_queue_writes(this->wgpu_context);
   wgpuQueueSubmit(this->wgpu_context->queue,
                   sc_array_size(&this->command_buffers),
                   this->command_buffers.elems);
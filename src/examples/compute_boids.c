@@ -2,6 +2,7 @@
 
 #include <string.h>
 
+#include "../webgpu/gpu_profiler.h"
 #include "../webgpu/imgui_overlay.h"
 
 /* -------------------------------------------------------------------------- *
@@ -444,6 +445,8 @@ static WGPUCommandBuffer build_command_buffer(wgpu_example_context_t* context)
 
   // Compute pass
   {
+    const int32_t profiler_scope = gpu_profiler_begin_scope(
+      wgpu_context->profiler, wgpu_context->cmd_enc, "Boids compute pass");
     wgpu_context->cpass_enc
       = wgpuCommandEncoderBeginComputePass(wgpu_context->cmd_enc, NULL);
     wgpuComputePassEncoderSetPipeline(wgpu_context->cpass_enc,
@@ -455,10 +458,14 @@ static WGPUCommandBuffer build_command_buffer(wgpu_example_context_t* context)
                                              work_group_count, 1, 1);
     wgpuComputePassEncoderEnd(wgpu_context->cpass_enc);
     WGPU_RELEASE_RESOURCE(ComputePassEncoder, wgpu_context->cpass_enc)
+    gpu_profiler_end_scope(wgpu_context->profiler, wgpu_context->cmd_enc,
+                           profiler_scope);
   }
 
   // Render pass
   {
+    const int32_t profiler_scope = gpu_profiler_begin_scope(
+      wgpu_context->profiler, wgpu_context->cmd_enc, "Boids render pass");
     wgpu_context->rpass_enc = wgpuCommandEncoderBeginRenderPass(
       wgpu_context->cmd_enc, &render_pass.descriptor);
     wgpuRenderPassEncoderSetPipeline(wgpu_context->rpass_enc, render_pipeline);
@@ -472,6 +479,8 @@ static WGPUCommandBuffer build_command_buffer(wgpu_example_context_t* context)
     wgpuRenderPassEncoderDraw(wgpu_context->rpass_enc, 3, NUM_PARTICLES, 0, 0);
     wgpuRenderPassEncoderEnd(wgpu_context->rpass_enc);
     WGPU_RELEASE_RESOURCE(RenderPassEncoder, wgpu_context->rpass_enc)
+    gpu_profiler_end_scope(wgpu_context->profiler, wgpu_context->cmd_enc,
+                           profiler_scope);
   }
 
   // Draw ui overlay
@@ -2086,13 +2086,14 @@ static void point_lights_init(point_lights_t* this)
         = "shaders/compute_metaballs/update_point_lights_compute_shader.wgsl",
         .entry = "main",
       });
-    this->update_compute_pipeline = wgpuDeviceCreateComputePipeline(
-      wgpu_context->device,
+    wgpu_create_compute_pipeline_async(
+      wgpu_context,
       &(WGPUComputePipelineDescriptor){
         .label   = "point light update compute pipeline",
         .layout  = this->update_compute_pipeline_layout,
         .compute = comp_shader.programmable_stage_descriptor,
-      });
+      },
+      &this->update_compute_pipeline);
     wgpu_shader_release(&comp_shader);
   }
 }
@@ -2825,18 +2826,18 @@ static void box_outline_init(box_outline_t* this)
         });
 
     // Create rendering pipeline using the specified states
-    this->render_pipeline
-      = wgpuDeviceCreateRenderPipeline(this->renderer->wgpu_context->device,
-                                       &(WGPURenderPipelineDescriptor){
-                                         .label = "box outline render pipeline",
-                                         .layout       = this->pipeline_layout,
-                                         .primitive    = primitive_state,
-                                         .vertex       = vertex_state,
-                                         .fragment     = &fragment_state,
-                                         .depthStencil = &depth_stencil_state,
-                                         .multisample  = multisample_state,
-                                       });
-    ASSERT(this->render_pipeline != NULL);
+    wgpu_create_render_pipeline_async(
+      this->renderer->wgpu_context,
+      &(WGPURenderPipelineDescriptor){
+        .label        = "box outline render pipeline",
+        .layout       = this->pipeline_layout,
+        .primitive    = primitive_state,
+        .vertex       = vertex_state,
+        .fragment     = &fragment_state,
+        .depthStencil = &depth_stencil_state,
+        .multisample  = multisample_state,
+      },
+      &this->render_pipeline);
 
     // Partial cleanup
     WGPU_RELEASE_RESOURCE(ShaderModule, vertex_state.module);
@@ -3203,8 +3204,8 @@ static void ground_init(ground_t* this)
         });
 
     // Create rendering pipeline using the specified states
-    this->render_pipelines.render_pipeline = wgpuDeviceCreateRenderPipeline(
-      this->renderer->wgpu_context->device,
+    wgpu_create_render_pipeline_async(
+      this->renderer->wgpu_context,
       &(WGPURenderPipelineDescriptor){
         .label        = "ground render pipeline",
         .layout       = this->pipeline_layouts.render_pipeline,
@@ -3213,7 +3214,8 @@ static void ground_init(ground_t* this)
         .fragment     = &fragment_state,
         .depthStencil = &depth_stencil_state,
         .multisample  = multisample_state,
-      });
+      },
+      &this->render_pipelines.render_pipeline);
     ASSERT(this->pipeline_layouts.render_pipeline != NULL);
 
     // Partial cleanup
@@ -3304,18 +3306,18 @@ static void ground_init(ground_t* this)
         });
 
     // Create rendering pipeline using the specified states
-    this->render_pipelines.render_shadow_pipeline
-      = wgpuDeviceCreateRenderPipeline(
-        this->renderer->wgpu_context->device,
-        &(WGPURenderPipelineDescriptor){
-          .label        = "ground render pipeline",
-          .layout       = this->pipeline_layouts.render_shadow_pipeline,
-          .primitive    = primitive_state,
-          .vertex       = vertex_state,
-          .fragment     = NULL,
-          .depthStencil = &depth_stencil_state,
-          .multisample  = multisample_state,
-        });
+    wgpu_create_render_pipeline_async(
+      this->renderer->wgpu_context,
+      &(WGPURenderPipelineDescriptor){
+        .label        = "ground render pipeline",
+        .layout       = this->pipeline_layouts.render_shadow_pipeline,
+        .primitive    = primitive_state,
+        .vertex       = vertex_state,
+        .fragment     = NULL,
+        .depthStencil = &depth_stencil_state,
+        .multisample  = multisample_state,
+      },
+      &this->render_pipelines.render_shadow_pipeline);
     ASSERT(this->pipeline_layouts.render_shadow_pipeline != NULL);
 
     // Partial cleanup
@@ -3696,8 +3698,8 @@ static void metaballs_init(metaballs_t* this)
         });
 
     // Create rendering pipeline using the specified states
-    this->render_pipelines.render_pipeline = wgpuDeviceCreateRenderPipeline(
-      this->renderer->wgpu_context->device,
+    wgpu_create_render_pipeline_async(
+      this->renderer->wgpu_context,
       &(WGPURenderPipelineDescriptor){
         .label        = "metaball rendering pipeline",
         .layout       = this->pipeline_layouts.render_pipeline,
@@ -3706,7 +3708,8 @@ static void metaballs_init(metaballs_t* this)
         .fragment     = &fragment_state,
         .depthStencil = &depth_stencil_state,
         .multisample  = multisample_state,
-      });
+      },
+      &this->render_pipelines.render_pipeline);
     ASSERT(this->pipeline_layouts.render_pipeline != NULL);
 
     // Partial cleanup
@@ -3783,18 +3786,18 @@ static void metaballs_init(metaballs_t* this)
         });
 
     // Create rendering pipeline using the specified states
-    this->render_pipelines.render_shadow_pipeline
-      = wgpuDeviceCreateRenderPipeline(
-        this->renderer->wgpu_context->device,
-        &(WGPURenderPipelineDescriptor){
-          .label        = "metaballs shadow rendering pipeline",
-          .layout       = this->pipeline_layouts.render_shadow_pipeline,
-          .primitive    = primitive_state,
-          .vertex       = vertex_state,
-          .fragment     = NULL,
-          .depthStencil = &depth_stencil_state,
-          .multisample  = multisample_state,
-        });
+    wgpu_create_render_pipeline_async(
+      this->renderer->wgpu_context,
+      &(WGPURenderPipelineDescriptor){
+        .label        = "metaballs shadow rendering pipeline",
+        .layout       = this->pipeline_layouts.render_shadow_pipeline,
+        .primitive    = primitive_state,
+        .vertex       = vertex_state,
+        .fragment     = NULL,
+        .depthStencil = &depth_stencil_state,
+        .multisample  = multisample_state,
+      },
+      &this->render_pipelines.render_shadow_pipeline);
     ASSERT(this->pipeline_layouts.render_shadow_pipeline != NULL);
 
     // Partial cleanup
@@ -4095,18 +4098,18 @@ static void particles_init(particles_t* this)
         });
 
     // Create rendering pipeline using the specified states
-    this->render_pipeline
-      = wgpuDeviceCreateRenderPipeline(this->renderer->wgpu_context->device,
-                                       &(WGPURenderPipelineDescriptor){
-                                         .label  = "particles render pipeline",
-                                         .layout = this->pipeline_layout,
-                                         .primitive    = primitive_state,
-                                         .vertex       = vertex_state,
-                                         .fragment     = &fragment_state,
-                                         .depthStencil = &depth_stencil_state,
-                                         .multisample  = multisample_state,
-                                       });
-    ASSERT(this->render_pipeline != NULL);
+    wgpu_create_render_pipeline_async(
+      this->renderer->wgpu_context,
+      &(WGPURenderPipelineDescriptor){
+        .label        = "particles render pipeline",
+        .layout       = this->pipeline_layout,
+        .primitive    = primitive_state,
+        .vertex       = vertex_state,
+        .fragment     = &fragment_state,
+        .depthStencil = &depth_stencil_state,
+        .multisample  = multisample_state,
+      },
+      &this->render_pipeline);
 
     // Partial cleanup
     WGPU_RELEASE_RESOURCE(ShaderModule, vertex_state.module);
@@ -4306,16 +4309,17 @@ static void effect_init(effect_t* this, const char* fragment_shader_file,
         });
 
     // Create rendering pipeline using the specified states
-    this->render_pipeline = wgpuDeviceCreateRenderPipeline(
-      this->renderer->wgpu_context->device, &(WGPURenderPipelineDescriptor){
-                                              .label  = label,
-                                              .layout = this->pipeline_layout,
-                                              .primitive   = primitive_state,
-                                              .vertex      = vertex_state,
-                                              .fragment    = &fragment_state,
-                                              .multisample = multisample_state,
-                                            });
-    ASSERT(this->render_pipeline != NULL);
+    wgpu_create_render_pipeline_async(
+      this->renderer->wgpu_context,
+      &(WGPURenderPipelineDescriptor){
+        .label       = label,
+        .layout      = this->pipeline_layout,
+        .primitive   = primitive_state,
+        .vertex      = vertex_state,
+        .fragment    = &fragment_state,
+        .multisample = multisample_state,
+      },
+      &this->render_pipeline);
 
     // Partial cleanup
     WGPU_RELEASE_RESOURCE(ShaderModule, vertex_state.module);
@@ -4686,13 +4690,14 @@ static void bloom_pass_init_compute_pipeline(bloom_pass_t* this)
         .file  = "shaders/compute_metaballs/bloom_blur_compute_shader.wgsl",
         .entry = "main",
       });
-    this->blur_pipeline = wgpuDeviceCreateComputePipeline(
-      wgpu_context->device,
+    wgpu_create_compute_pipeline_async(
+      wgpu_context,
       &(WGPUComputePipelineDescriptor){
         .label   = "bloom pass blur pipeline",
         .layout  = this->blur_pipeline_layout,
         .compute = comp_shader.programmable_stage_descriptor,
-      });
+      },
+      &this->blur_pipeline);
     wgpu_shader_release(&comp_shader);
   }
 
@@ -540,6 +540,7 @@ static void generate_probability_map(wgpu_context_t* wgpu_context)
     WGPU_RELEASE_RESOURCE(CommandEncoder, wgpu_context->cmd_enc)
 
     /* Sumbit commmand buffer and cleanup */
+    wgpu_flush_queue_writes(wgpu_context);
     wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
     WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
 
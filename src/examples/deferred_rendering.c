@@ -1185,9 +1185,9 @@ static void update_uniform_buffers(wgpu_example_context_t* context)
 static int example_initialize(wgpu_example_context_t* context)
 {
   if (context) {
-    stanford_dragon_mesh_init(&stanford_dragon_mesh);
-    prepare_vertex_and_index_buffers(context->wgpu_context,
-                                     &stanford_dragon_mesh);
+    // Parse the dragon mesh on a job worker while the pipelines are created
+    wgpu_asset_t* dragon_mesh_asset = stanford_dragon_mesh_init_async(
+      context->wgpu_context, &stanford_dragon_mesh);
     prepare_gbuffer_texture_render_targets(context->wgpu_context);
     prepare_bind_group_layouts(context->wgpu_context);
     prepare_render_pipeline_layouts(context->wgpu_context);
@@ -1200,6 +1200,10 @@ static int example_initialize(wgpu_example_context_t* context)
     prepare_light_update_compute_pipeline(context->wgpu_context);
     prepare_lights(context->wgpu_context);
     prepare_view_matrices(context->wgpu_context);
+    wgpu_asset_wait(dragon_mesh_asset);
+    wgpu_asset_release(dragon_mesh_asset);
+    prepare_vertex_and_index_buffers(context->wgpu_context,
+                                     &stanford_dragon_mesh);
     prepared = true;
     return 0;
   }
@@ -10,6 +10,8 @@
  * Dynamic buffer offset can largely improve performance of the application.
  * Comparing to creating many binding goups and set every group for each object,
  * only one binding group will be created and buffer offset is dynamically set.
+ * The per-object matrices are allocated from the per-frame uniform arena of the
+ * WebGPU context, which uploads them with a single write per frame.
  *
  * Ref:
  * https://github.com/gpuweb/gpuweb/issues/116
@@ -28,7 +30,6 @@ static const char* fragment_shader_wgsl;
  * -------------------------------------------------------------------------- */
 
 #define OBJECT_INSTANCES 125u
-#define ALIGNMENT 256u // 256-byte alignment
 
 // Vertex layout for this example
 typedef struct {
@@ -45,9 +46,8 @@ static wgpu_buffer_t indices = {0};
 static struct {
   struct wgpu_buffer_t view;
   struct {
-    WGPUBuffer buffer;
-    uint64_t buffer_size;
     uint64_t model_size;
+    uint32_t offsets[OBJECT_INSTANCES]; /* dynamic offsets of this frame */
   } dynamic;
 } uniform_buffers = {0};
 
@@ -60,19 +60,16 @@ static struct {
 static vec3 rotations[OBJECT_INSTANCES]       = {0};
 static vec3 rotation_speeds[OBJECT_INSTANCES] = {0};
 
-// One big uniform buffer that contains all matrices
-static struct {
-  mat4 model;
-  uint8_t padding[192];
-} ubo_data_dynamic[OBJECT_INSTANCES] = {0};
+// Per-object model matrices, copied into the frame uniform arena each frame
+static mat4 model_matrices[OBJECT_INSTANCES] = {0};
 
 // Pipeline
 static WGPUPipelineLayout pipeline_layout = NULL;
 static WGPURenderPipeline pipeline        = NULL;
 
-// Bindings
-static WGPUBindGroupLayout bind_group_layout = NULL;
-static WGPUBindGroup bind_group              = NULL;
+// Bindings, one bind group per frame slot as each slot owns a uniform buffer
+static WGPUBindGroupLayout bind_group_layout                = NULL;
+static WGPUBindGroup bind_groups[WGPU_MAX_FRAMES_IN_FLIGHT] = {0};
 
 // Render pass descriptor for frame buffer writes
 static struct {
@@ -80,8 +77,11 @@ static struct {
   WGPURenderPassDescriptor descriptor;
 } render_pass = {0};
 
-// Render bundle
-static WGPURenderBundle render_bundle = NULL;
+// Render bundles per frame slot, recorded with the dynamic offsets of the slot
+static struct {
+  WGPURenderBundle bundle;
+  uint32_t base_offset;
+} render_bundle_slots[WGPU_MAX_FRAMES_IN_FLIGHT] = {0};
 
 // Render bundle setting & animation timer
 static bool render_bundles   = true;
@@ -192,31 +192,33 @@ static void setup_pipeline_layout(wgpu_context_t* wgpu_context)
 
 static void setup_bind_groups(wgpu_context_t* wgpu_context)
 {
-  // Bind Group
-  WGPUBindGroupEntry bg_entries[2] = {
-    [0] = (WGPUBindGroupEntry) {
-      // Binding 0 : Projection/View matrix uniform buffer
-      .binding = 0,
-      .buffer  = uniform_buffers.view.buffer,
-      .offset  = 0,
-      .size    = uniform_buffers.view.size,
-    },
-    [1] = (WGPUBindGroupEntry) {
-      // Binding 1 : Instance matrix as dynamic uniform buffer
-      .binding = 1,
-      .buffer  = uniform_buffers.dynamic.buffer,
-      .offset  = 0,
-      .size    = uniform_buffers.dynamic.model_size,
-    }
-  };
-  WGPUBindGroupDescriptor bg_desc = {
-    .label      = "Bind group",
-    .layout     = bind_group_layout,
-    .entryCount = (uint32_t)ARRAY_SIZE(bg_entries),
-    .entries    = bg_entries,
-  };
-  bind_group = wgpuDeviceCreateBindGroup(wgpu_context->device, &bg_desc);
-  ASSERT(bind_group != NULL);
+  for (uint32_t i = 0; i < wgpu_context->frames.count; ++i) {
+    // Bind Group
+    WGPUBindGroupEntry bg_entries[2] = {
+      [0] = (WGPUBindGroupEntry) {
+        // Binding 0 : Projection/View matrix uniform buffer
+        .binding = 0,
+        .buffer  = uniform_buffers.view.buffer,
+        .offset  = 0,
+        .size    = uniform_buffers.view.size,
+      },
+      [1] = (WGPUBindGroupEntry) {
+        // Binding 1 : Instance matrix as dynamic uniform buffer
+        .binding = 1,
+        .buffer  = wgpu_frame_get_uniform_buffer(wgpu_context, i),
+        .offset  = 0,
+        .size    = uniform_buffers.dynamic.model_size,
+      }
+    };
+    WGPUBindGroupDescriptor bg_desc = {
+      .label      = "Bind group",
+      .layout     = bind_group_layout,
+      .entryCount = (uint32_t)ARRAY_SIZE(bg_entries),
+      .entries    = bg_entries,
+    };
+    bind_groups[i] = wgpuDeviceCreateBindGroup(wgpu_context->device, &bg_desc);
+    ASSERT(bind_groups[i] != NULL);
+  }
 }
 
 static void prepare_pipeline(wgpu_context_t* wgpu_context)
@@ -329,7 +331,7 @@ static void setup_render_pass(wgpu_context_t* wgpu_context)
   };
 }
 
-#define RECORD_RENDER_PASS(Type, rpass_enc)                                    \
+#define RECORD_RENDER_PASS(Type, rpass_enc, bind_group)                        \
   if (rpass_enc) {                                                             \
     wgpu##Type##SetPipeline(rpass_enc, pipeline);                              \
     wgpu##Type##SetVertexBuffer(rpass_enc, 0, vertices.buffer, 0,              \
@@ -339,16 +341,17 @@ static void setup_render_pass(wgpu_context_t* wgpu_context)
     /* Render multiple objects using different model matrices by dynamically   \
      * offsetting into one uniform buffer */                                   \
     for (uint32_t i = 0; i < OBJECT_INSTANCES; ++i) {                          \
-      /* One dynamic offset per dynamic bind group to offset into the ubo      \
-       * containing all model matrices*/                                       \
-      uint32_t dynamic_offset = i * ALIGNMENT;                                 \
+      /* One dynamic offset per dynamic bind group to offset into the frame    \
+       * uniform buffer containing all model matrices */                       \
+      const uint32_t* dynamic_offset = &uniform_buffers.dynamic.offsets[i];    \
       /* Bind the bind group for rendering a mesh using the dynamic offset */  \
-      wgpu##Type##SetBindGroup(rpass_enc, 0, bind_group, 1, &dynamic_offset);  \
+      wgpu##Type##SetBindGroup(rpass_enc, 0, bind_group, 1, dynamic_offset);   \
       wgpu##Type##DrawIndexed(rpass_enc, indices.count, 1, 0, 0, 0);           \
     }                                                                          \
   }
 
-static void prepare_render_bundle_encoder(wgpu_context_t* wgpu_context)
+static WGPURenderBundle prepare_render_bundle(wgpu_context_t* wgpu_context,
+                                              WGPUBindGroup bind_group)
 {
   WGPUTextureFormat color_formats[1] = {wgpu_context->swap_chain.format};
   WGPURenderBundleEncoder render_bundle_encoder
@@ -361,10 +364,29 @@ static void prepare_render_bundle_encoder(wgpu_context_t* wgpu_context)
         .depthStencilFormat = WGPUTextureFormat_Depth24PlusStencil8,
         .sampleCount        = 1,
       });
-  RECORD_RENDER_PASS(RenderBundleEncoder, render_bundle_encoder)
-  render_bundle = wgpuRenderBundleEncoderFinish(render_bundle_encoder, NULL);
+  RECORD_RENDER_PASS(RenderBundleEncoder, render_bundle_encoder, bind_group)
+  WGPURenderBundle render_bundle
+    = wgpuRenderBundleEncoderFinish(render_bundle_encoder, NULL);
 
   WGPU_RELEASE_RESOURCE(RenderBundleEncoder, render_bundle_encoder)
+
+  return render_bundle;
+}
+
+/* Render bundles bake the dynamic offsets, the bundle of a frame slot is only
+ * recorded again when the arena offsets of the slot changed */
+static WGPURenderBundle get_render_bundle(wgpu_context_t* wgpu_context)
+{
+  const uint32_t slot = wgpu_context->frames.index;
+  const uint32_t base = uniform_buffers.dynamic.offsets[0];
+  if (render_bundle_slots[slot].bundle == NULL
+      || render_bundle_slots[slot].base_offset != base) {
+    WGPU_RELEASE_RESOURCE(RenderBundle, render_bundle_slots[slot].bundle)
+    render_bundle_slots[slot].bundle
+      = prepare_render_bundle(wgpu_context, bind_groups[slot]);
+    render_bundle_slots[slot].base_offset = base;
+  }
+  return render_bundle_slots[slot].bundle;
 }
 
 static void update_uniform_buffers(wgpu_example_context_t* context)
@@ -401,7 +423,7 @@ static void update_dynamic_uniform_buffer(wgpu_example_context_t* context,
         uint32_t index = x * dim * dim + y * dim + z;
 
         // Model
-        mat4* modelMat = &ubo_data_dynamic[index].model;
+        mat4* modelMat = &model_matrices[index];
 
         // Update rotations
         glm_vec3_scale(rotation_speeds[index], animation_timer,
@@ -424,11 +446,18 @@ static void update_dynamic_uniform_buffer(wgpu_example_context_t* context,
   }
 
   animation_timer = 0.0f;
+}
 
-  // Update buffer
-  wgpu_queue_write_buffer(context->wgpu_context, uniform_buffers.dynamic.buffer,
-                          0, &ubo_data_dynamic,
-                          uniform_buffers.dynamic.buffer_size);
+// Copies the model matrices into the uniform arena of the current frame slot
+static void push_dynamic_uniforms(wgpu_context_t* wgpu_context)
+{
+  for (uint32_t i = 0; i < OBJECT_INSTANCES; ++i) {
+    if (!wgpu_frame_push_uniform(wgpu_context, &model_matrices[i],
+                                 sizeof(mat4),
+                                 &uniform_buffers.dynamic.offsets[i])) {
+      uniform_buffers.dynamic.offsets[i] = 0;
+    }
+  }
 }
 
 // Prepare and initialize uniform buffer containing shader uniforms
@@ -444,16 +473,8 @@ static void prepare_uniform_buffers(wgpu_example_context_t* context)
       .size  = sizeof(ubo_vs),
     });
 
-  // Uniform buffer object with per-object matrices
+  // Per-object matrices are allocated from the frame uniform arena
   uniform_buffers.dynamic.model_size = sizeof(mat4);
-  uniform_buffers.dynamic.buffer_size
-    = calc_constant_buffer_byte_size(sizeof(ubo_data_dynamic));
-  uniform_buffers.dynamic.buffer = wgpuDeviceCreateBuffer(
-    context->wgpu_context->device,
-    &(WGPUBufferDescriptor){
-      .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
-      .size  = uniform_buffers.dynamic.buffer_size,
-    });
 
   // Prepare per-object matrices with offsets and random rotations
   for (uint32_t i = 0; i < OBJECT_INSTANCES; ++i) {
@@ -488,7 +509,6 @@ static int example_initialize(wgpu_example_context_t* context)
     prepare_pipeline(context->wgpu_context);
     setup_bind_groups(context->wgpu_context);
     setup_render_pass(context->wgpu_context);
-    prepare_render_bundle_encoder(context->wgpu_context);
     prepared = true;
     return 0;
   }
@@ -516,12 +536,17 @@ static WGPUCommandBuffer build_command_buffer(wgpu_context_t* wgpu_context)
   wgpu_context->rpass_enc = wgpuCommandEncoderBeginRenderPass(
     wgpu_context->cmd_enc, &render_pass.descriptor);
 
+  // Per-object uniforms cost a copy into the arena plus a dynamic offset
+  push_dynamic_uniforms(wgpu_context);
+
   if (render_bundles) {
+    WGPURenderBundle render_bundle = get_render_bundle(wgpu_context);
     wgpuRenderPassEncoderExecuteBundles(wgpu_context->rpass_enc, 1,
                                         &render_bundle);
   }
   else {
-    RECORD_RENDER_PASS(RenderPassEncoder, wgpu_context->rpass_enc)
+    RECORD_RENDER_PASS(RenderPassEncoder, wgpu_context->rpass_enc,
+                       bind_groups[wgpu_context->frames.index])
   }
 
   // End render pass
@@ -582,12 +607,13 @@ static void example_destroy(wgpu_example_context_t* context)
   WGPU_RELEASE_RESOURCE(Buffer, vertices.buffer)
   WGPU_RELEASE_RESOURCE(Buffer, indices.buffer)
   WGPU_RELEASE_RESOURCE(Buffer, uniform_buffers.view.buffer)
-  WGPU_RELEASE_RESOURCE(Buffer, uniform_buffers.dynamic.buffer)
   WGPU_RELEASE_RESOURCE(PipelineLayout, pipeline_layout)
   WGPU_RELEASE_RESOURCE(RenderPipeline, pipeline)
   WGPU_RELEASE_RESOURCE(BindGroupLayout, bind_group_layout)
-  WGPU_RELEASE_RESOURCE(BindGroup, bind_group)
-  WGPU_RELEASE_RESOURCE(RenderBundle, render_bundle)
+  for (uint32_t i = 0; i < WGPU_MAX_FRAMES_IN_FLIGHT; ++i) {
+    WGPU_RELEASE_RESOURCE(BindGroup, bind_groups[i])
+    WGPU_RELEASE_RESOURCE(RenderBundle, render_bundle_slots[i].bundle)
+  }
 }
 
 void example_dynamic_uniform_buffer(int argc, char* argv[])
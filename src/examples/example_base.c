@@ -1,8 +1,11 @@
 #include "example_base.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#include "../../lib/wgpu_native/wgpu_native.h"
 #include "../core/argparse.h"
+#include "../webgpu/gpu_profiler.h"
 #include "../webgpu/imgui_overlay.h"
 
 #ifdef __GNUC__
@@ -21,6 +24,11 @@ static const char* const WINDOW_TITLE = "WebGPU Example";
 static const uint32_t WINDOW_WIDTH    = 1280;
 static const uint32_t WINDOW_HEIGHT   = 720;
 
+/* headless mode defaults */
+
+static const uint32_t HEADLESS_FRAME_COUNT  = 600;
+static const float HEADLESS_TIMESTEP_MILLIS = 1000.0f / 60.0f;
+
 typedef struct {
   bool window_resized;
   bool view_updated;
@@ -230,14 +238,41 @@ notify_key_input_state(record_t* record,
 static void parse_example_arguments(int argc, char* argv[],
                                     refexport_t* ref_export)
 {
-  char* filters_short[2]           = {"-w", "-h"};
-  char* filters_eq[2]              = {"--width=", "--height="};
-  char* filtered_argv[1 + (2 * 2)] = {0};
-  char** argvc                     = (char**)argv;
-  int fargc                        = 1;
+  char* filters_short[14] = {"-w",
+                             "-h",
+                             "--frames",
+                             "--timestep",
+                             "--gpu-profile",
+                             "--trace",
+                             "--blob-cache",
+                             "--texture-compression",
+                             "--bc7-quality",
+                             "--validation",
+                             "--toggles",
+                             "--adapter-backend",
+                             "--adapter-type",
+                             "--adapter-name"};
+  char* filters_eq[14]    = {"--width=",
+                             "--height=",
+                             "--frames=",
+                             "--timestep=",
+                             "--gpu-profile=",
+                             "--trace=",
+                             "--blob-cache=",
+                             "--texture-compression=",
+                             "--bc7-quality=",
+                             "--validation=",
+                             "--toggles=",
+                             "--adapter-backend=",
+                             "--adapter-type=",
+                             "--adapter-name="};
+  char* filters_flag[2]                 = {"--headless", "--batch-writes"};
+  char* filtered_argv[1 + (14 * 2) + 2] = {0};
+  char** argvc                          = (char**)argv;
+  int fargc                             = 1;
   for (int32_t i = 0; i < argc; ++i) {
     for (uint32_t j = 0; j < (uint32_t)ARRAY_SIZE(filters_short); ++j) {
-      if (strcmp(argvc[i], filters_short[j]) == 0) {
+      if (strcmp(argvc[i], filters_short[j]) == 0 && i + 1 < argc) {
         filtered_argv[fargc++] = filters_short[j];
         filtered_argv[fargc++] = argvc[++i];
       }
@@ -247,12 +282,52 @@ static void parse_example_arguments(int argc, char* argv[],
         filtered_argv[fargc++] = argvc[i];
       }
     }
+    for (uint32_t j = 0; j < (uint32_t)ARRAY_SIZE(filters_flag); ++j) {
+      if (strcmp(argvc[i], filters_flag[j]) == 0) {
+        filtered_argv[fargc++] = filters_flag[j];
+      }
+    }
   }
 
-  int window_width = 0, window_height = 0;
+  int window_width = 0, window_height = 0, headless = 0, frame_count = 0;
+  int batch_writes                 = 0;
+  int bc7_quality                  = 0;
+  float timestep_millis            = 0.0f;
+  const char* gpu_profile_file     = NULL;
+  const char* trace_file           = NULL;
+  const char* blob_cache_dir       = NULL;
+  const char* texture_compression  = NULL;
+  const char* validation           = NULL;
+  const char* toggles              = NULL;
+  const char* adapter_backend      = NULL;
+  const char* adapter_type         = NULL;
+  const char* adapter_name         = NULL;
   struct argparse_option options[] = {
     OPT_INTEGER('w', "width", &window_width, "window width", NULL, 0, 0),
     OPT_INTEGER('h', "height", &window_height, "window height", NULL, 0, 0),
+    OPT_BOOLEAN(0, "headless", &headless, "headless mode", NULL, 0, 0),
+    OPT_INTEGER(0, "frames", &frame_count, "headless frame count", NULL, 0, 0),
+    OPT_FLOAT(0, "timestep", &timestep_millis, "headless timestep (ms)", NULL,
+              0, 0),
+    OPT_STRING(0, "gpu-profile", &gpu_profile_file, "GPU profile output file",
+               NULL, 0, 0),
+    OPT_STRING(0, "trace", &trace_file, "CPU trace output file", NULL, 0, 0),
+    OPT_BOOLEAN(0, "batch-writes", &batch_writes, "batch queue writes", NULL,
+                0, 0),
+    OPT_STRING(0, "blob-cache", &blob_cache_dir, "blob cache directory", NULL,
+               0, 0),
+    OPT_STRING(0, "texture-compression", &texture_compression,
+               "texture compression mode", NULL, 0, 0),
+    OPT_INTEGER(0, "bc7-quality", &bc7_quality, "BC7 encoder quality", NULL,
+                0, 0),
+    OPT_STRING(0, "validation", &validation, "backend validation level", NULL,
+               0, 0),
+    OPT_STRING(0, "toggles", &toggles, "Dawn device toggles", NULL, 0, 0),
+    OPT_STRING(0, "adapter-backend", &adapter_backend, "adapter backend type",
+               NULL, 0, 0),
+    OPT_STRING(0, "adapter-type", &adapter_type, "adapter type", NULL, 0, 0),
+    OPT_STRING(0, "adapter-name", &adapter_name, "adapter name substring",
+               NULL, 0, 0),
     OPT_END(),
   };
   struct argparse argparse;
@@ -267,6 +342,92 @@ static void parse_example_arguments(int argc, char* argv[],
   if (window_height > 100) {
     ref_export->example_window_config.height = window_height;
   }
+
+  // Override headless mode settings
+  wgpu_example_settings_t* settings = &ref_export->example_settings;
+  if (headless != 0) {
+    settings->headless.enabled = true;
+  }
+  if (frame_count > 0) {
+    settings->headless.frame_count = (uint32_t)frame_count;
+  }
+  if (timestep_millis > 0.0f) {
+    settings->headless.timestep_millis = timestep_millis;
+  }
+
+  // GPU profiler output
+  if (gpu_profile_file != NULL) {
+    settings->gpu_profile_file = gpu_profile_file;
+  }
+
+  // CPU trace output
+  if (trace_file != NULL) {
+    settings->trace_file = trace_file;
+  }
+
+  // Queue write batching
+  if (batch_writes != 0) {
+    settings->batch_queue_writes = true;
+  }
+
+  // Persistent blob cache
+  if (blob_cache_dir != NULL) {
+    settings->blob_cache_dir = blob_cache_dir;
+  }
+
+  // Texture compression
+  if (texture_compression != NULL) {
+    settings->texture_compression = texture_compression;
+  }
+  if (bc7_quality > 0) {
+    settings->bc7_quality = (uint32_t)bc7_quality;
+  }
+
+  // Dawn configuration
+  if (validation != NULL) {
+    settings->validation = validation;
+  }
+  if (toggles != NULL) {
+    settings->toggles = toggles;
+  }
+
+  // Adapter selection
+  if (adapter_backend != NULL) {
+    settings->adapter.backend = adapter_backend;
+  }
+  if (adapter_type != NULL) {
+    settings->adapter.type = adapter_type;
+  }
+  if (adapter_name != NULL) {
+    settings->adapter.name = adapter_name;
+  }
+}
+
+/* Resolves the blob cache directory, the default location is the user cache
+ * directory. Returns false if the cache is disabled. */
+static bool get_blob_cache_dir(const char* blob_cache_dir, char* path,
+                               size_t path_size)
+{
+  if (blob_cache_dir != NULL) {
+    if (strcmp(blob_cache_dir, "off") == 0) {
+      return false;
+    }
+    snprintf(path, path_size, "%s", blob_cache_dir);
+    return true;
+  }
+
+  const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+  const char* home           = getenv("HOME");
+  if (xdg_cache_home != NULL && xdg_cache_home[0] != '\0') {
+    snprintf(path, path_size, "%s/webgpu-native-examples", xdg_cache_home);
+  }
+  else if (home != NULL && home[0] != '\0') {
+    snprintf(path, path_size, "%s/.cache/webgpu-native-examples", home);
+  }
+  else {
+    snprintf(path, path_size, ".cache/webgpu-native-examples");
+  }
+  return true;
 }
 
 static void
@@ -293,6 +454,18 @@ intialize_wgpu_example_context(wgpu_example_context_t* context,
   context->timer_speed = 0.25f;
   context->paused      = false;
 
+  // Headless mode
+  context->headless.enabled = example_settings->headless.enabled;
+  context->headless.frame_count
+    = example_settings->headless.frame_count > 0 ?
+        example_settings->headless.frame_count :
+        HEADLESS_FRAME_COUNT;
+  context->headless.timestep
+    = (example_settings->headless.timestep_millis > 0.0f ?
+         example_settings->headless.timestep_millis :
+         HEADLESS_TIMESTEP_MILLIS)
+      / 1000.0f;
+
   // Input
   glm_vec2_zero(context->mouse_position);
   context->mouse_buttons.left    = false;
@@ -330,17 +503,69 @@ static void setup_window(wgpu_example_context_t* context,
   input_set_callbacks(context->window, context->callbacks);
 }
 
-static void intialize_webgpu(wgpu_example_context_t* context)
+static void setup_headless(wgpu_example_context_t* context,
+                           window_config_t* windows_config)
+{
+  // No window is created in headless mode, only its dimensions are used
+  context->window = NULL;
+  context->window_size.width
+    = windows_config->width > 0 ? windows_config->width : WINDOW_WIDTH;
+  context->window_size.height
+    = windows_config->height > 0 ? windows_config->height : WINDOW_HEIGHT;
+  context->window_size.aspect_ratio = (float)context->window_size.width
+                                      / (float)context->window_size.height;
+}
+
+/* Returns false if the adapter options select no adapter */
+static bool intialize_webgpu(wgpu_example_context_t* context,
+                             wgpu_example_settings_t* example_settings)
 {
+  char blob_cache_dir[STRMAX] = {0};
+  const bool blob_cache_enabled = get_blob_cache_dir(
+    example_settings->blob_cache_dir, blob_cache_dir, sizeof(blob_cache_dir));
+  // Compressed textures are cached next to the blobs
+  char texture_cache_dir[STRMAX + 16] = {0};
+  snprintf(texture_cache_dir, sizeof(texture_cache_dir), "%s/textures",
+           blob_cache_dir);
   context->wgpu_context = wgpu_context_create(&(wgpu_context_create_options_t){
-    .vsync = context->vsync,
+    .vsync               = context->vsync,
+    .offscreen           = context->headless.enabled,
+    .frames_in_flight    = example_settings->frames_in_flight,
+    .batch_queue_writes  = example_settings->batch_queue_writes,
+    .blob_cache_dir      = blob_cache_enabled ? blob_cache_dir : NULL,
+    .texture_compression = example_settings->texture_compression,
+    .bc7_quality         = example_settings->bc7_quality,
+    .texture_cache_dir   = blob_cache_enabled ? texture_cache_dir : NULL,
+    .validation          = example_settings->validation,
+    .toggles             = example_settings->toggles,
+    .adapter_backend     = example_settings->adapter.backend,
+    .adapter_type        = example_settings->adapter.type,
+    .adapter_name        = example_settings->adapter.name,
   });
+  if (context->wgpu_context == NULL) {
+    return false;
+  }
   context->wgpu_context->context = context;
 
-  wgpu_create_device_and_queue(context->wgpu_context);
-  wgpu_setup_window_surface(context->wgpu_context, context->window);
-  wgpu_setup_swap_chain(context->wgpu_context);
+  if (!wgpu_create_device_and_queue(context->wgpu_context)) {
+    wgpu_context_release(context->wgpu_context);
+    context->wgpu_context = NULL;
+    return false;
+  }
+  if (context->headless.enabled) {
+    wgpu_setup_offscreen_target(context->wgpu_context,
+                                context->window_size.width,
+                                context->window_size.height);
+  }
+  else {
+    wgpu_setup_window_surface(context->wgpu_context, context->window);
+    wgpu_setup_swap_chain(context->wgpu_context);
+  }
+  wgpu_setup_frames(context->wgpu_context);
+  context->wgpu_context->profiler = gpu_profiler_create(context->wgpu_context);
   wgpu_get_context_info(context->adapter_info);
+
+  return true;
 }
 
 static void intialize_imgui(wgpu_example_context_t* context,
@@ -390,8 +615,85 @@ update_overlay(wgpu_example_context_t* context,
   igTextUnformatted(context->example_title, NULL);
   igTextUnformatted(context->adapter_info[0], NULL);
   igText("%s backend - %s", context->adapter_info[2], context->adapter_info[1]);
+  igText("Validation: %s, toggles: %s",
+         context->wgpu_context->dawn_config.validation,
+         context->wgpu_context->dawn_config.toggles[0] != '\0' ?
+           context->wgpu_context->dawn_config.toggles :
+           "none");
   igText("%.2f ms/frame (%.1d fps)", (1000.0f / context->last_fps),
          context->last_fps);
+  gpu_profiler_t* profiler = context->wgpu_context->profiler;
+  if (profiler != NULL && gpu_profiler_get_scope_count(profiler) > 0) {
+    const char* timing = gpu_profiler_has_gpu_timing(profiler) ? "GPU" : "CPU";
+    gpu_profiler_scope_stats_t stats = {0};
+    for (uint32_t i = 0; i < gpu_profiler_get_scope_count(profiler); ++i) {
+      gpu_profiler_get_scope_stats(profiler, i, &stats);
+      igText("%s: %.3f ms (%s)", stats.name, stats.average, timing);
+    }
+  }
+  wgpu_pipeline_cache_t* pipeline_cache = context->wgpu_context->pipeline_cache;
+  if (pipeline_cache != NULL) {
+    wgpu_pipeline_cache_stats_t stats = {0};
+    wgpu_pipeline_cache_get_stats(pipeline_cache, &stats);
+    if (stats.hit_count > 0) {
+      igText("Pipeline cache: %llu hits, %llu misses (%.1f ms saved)",
+             (unsigned long long)stats.hit_count,
+             (unsigned long long)stats.miss_count, stats.saved_time_ms);
+    }
+  }
+  wgpu_shader_cache_t* shader_cache = context->wgpu_context->shader_cache;
+  if (shader_cache != NULL) {
+    wgpu_shader_cache_stats_t stats = {0};
+    wgpu_shader_cache_get_stats(shader_cache, &stats);
+    if (stats.hit_count > 0) {
+      igText("Shader cache: %llu hits, %llu misses (%.1f ms saved)",
+             (unsigned long long)stats.hit_count,
+             (unsigned long long)stats.miss_count, stats.saved_time_ms);
+    }
+  }
+  wgpu_blob_cache_stats_t blob_cache_stats = {0};
+  wgpu_get_blob_cache_stats(&blob_cache_stats);
+  igText("Startup: %.1f ms (blob cache: %llu hits, %llu stores)",
+         context->startup_time_millis,
+         (unsigned long long)blob_cache_stats.load_hits,
+         (unsigned long long)blob_cache_stats.store_count);
+  if (context->wgpu_context->async_pipelines.pending_count > 0) {
+    igText("First frame: %.1f ms, %u pipelines pending",
+           context->first_frame_millis,
+           context->wgpu_context->async_pipelines.pending_count);
+  }
+  else if (context->wgpu_context->async_assets.pending_count > 0) {
+    igText("First frame: %.1f ms, %u assets loading",
+           context->first_frame_millis,
+           context->wgpu_context->async_assets.pending_count);
+  }
+  else if (context->wgpu_context->async_pipelines.ready_count > 0
+           || context->wgpu_context->async_assets.ready_count > 0) {
+    igText("First frame: %.1f ms, full quality: %.1f ms",
+           context->first_frame_millis, context->full_quality_millis);
+  }
+  wgpu_worker_pool_stats_t worker_pool_stats = {0};
+  wgpu_get_worker_pool_stats(&worker_pool_stats);
+  if (worker_pool_stats.task_count > 0) {
+    igText("Dawn workers: %u threads, %llu tasks",
+           worker_pool_stats.thread_count,
+           (unsigned long long)worker_pool_stats.task_count);
+  }
+  job_system_stats_t job_stats = {0};
+  job_system_get_stats(&job_stats);
+  if (job_stats.job_count > 0) {
+    igText("Job workers: %u threads, %llu jobs, %llu steals",
+           job_stats.thread_count, (unsigned long long)job_stats.job_count,
+           (unsigned long long)job_stats.steal_count);
+  }
+  wgpu_write_batcher_t* batcher = context->wgpu_context->queue_writes.batcher;
+  if (batcher != NULL) {
+    wgpu_write_batcher_stats_t stats = {0};
+    wgpu_write_batcher_get_stats(batcher, &stats);
+    igText("Queue writes: %llu -> %llu copies",
+           (unsigned long long)stats.write_count,
+           (unsigned long long)stats.copy_count);
+  }
   if (example_on_update_ui_overlay_func) {
     igPushItemWidth(110.0f * imgui_overlay_get_scale(context->imgui_overlay));
     example_on_update_ui_overlay_func(context);
@@ -402,39 +704,117 @@ update_overlay(wgpu_example_context_t* context,
   imgui_overlay_render(context->imgui_overlay);
 }
 
+static bool render_loop_should_exit(wgpu_example_context_t* context)
+{
+  if (benchmark_is_running() && benchmark_is_finished()) {
+    return true;
+  }
+  if (context->headless.enabled) {
+    return context->frame.index >= context->headless.frame_count;
+  }
+  return window_should_close(context->window);
+}
+
+/* Time to first frame versus time to full quality, pipelines created with
+ * wgpu_create_*_pipeline_async and assets loaded with the *_async loaders may
+ * still be pending after the first frame */
+static void update_startup_times(wgpu_example_context_t* context)
+{
+  if (context->full_quality_millis > 0.0f) {
+    return;
+  }
+
+  const double now_millis
+    = (double)(platform_get_time_ns() - context->startup_start_ns) / 1e6;
+  if (context->first_frame_millis <= 0.0f) {
+    context->first_frame_millis = (float)now_millis;
+  }
+  wgpu_context_t* wgpu_context = context->wgpu_context;
+  if (!wgpu_async_pipelines_ready(wgpu_context)
+      || !wgpu_async_assets_ready(wgpu_context)) {
+    return;
+  }
+
+  /* The last pipeline became ready while the device was ticked, the last
+   * asset while the completion queue was drained */
+  const uint64_t last_ready_ns
+    = MAX(wgpu_context->async_pipelines.last_ready_ns,
+          wgpu_context->async_assets.last_ready_ns);
+  context->full_quality_millis
+    = (last_ready_ns > context->startup_start_ns) ?
+        (float)((double)(last_ready_ns - context->startup_start_ns) / 1e6) :
+        context->first_frame_millis;
+  context->full_quality_millis
+    = MAX(context->full_quality_millis, context->first_frame_millis);
+  log_info("First frame after %.2f ms, full quality after %.2f ms (%u async "
+           "pipelines, %u failed, %u async assets, %u failed)",
+           context->first_frame_millis, context->full_quality_millis,
+           wgpu_context->async_pipelines.ready_count,
+           wgpu_context->async_pipelines.failed_count,
+           wgpu_context->async_assets.ready_count,
+           wgpu_context->async_assets.failed_count);
+}
+
 static void render_loop(wgpu_example_context_t* context,
                         renderfunc_t* render_func,
                         onviewchangedfunc_t* view_changed_func,
                         onkeypressedfunc_t* example_on_key_pressed_func)
 {
+  const bool headless = context->headless.enabled;
+
   record_t record;
   memset(&record, 0, sizeof(record_t));
-  window_set_userdata(context->window, &record);
+  if (!headless) {
+    window_set_userdata(context->window, &record);
+  }
 
   float time_start, time_end, time_diff, fps_timer;
-  record.last_timestamp = platform_get_time();
-  while (!window_should_close(context->window)) {
-    time_start                      = platform_get_time();
-    context->frame.timestamp_millis = time_start * 1000.0f;
+  const float loop_start = platform_get_time();
+  record.last_timestamp  = loop_start;
+  while (!render_loop_should_exit(context)) {
+    const trace_span_t frame_span = trace_span_begin("Frame");
+    const uint64_t frame_start_ns = platform_get_time_ns();
+    time_start                    = platform_get_time();
+    // Headless runs advance a simulated clock by a fixed timestep
+    context->frame.timestamp_millis
+      = headless ? context->run_time * 1000.0f : time_start * 1000.0f;
     if (record.view_updated) {
       record.mouse_scrolled = 0;
       record.wheel_delta    = 0;
       record.view_updated   = false;
     }
-    input_poll_events();
+    if (!headless) {
+      input_poll_events();
+    }
     // update_window_size(context, &record);
+    // Record the next frame while the GPU may still execute previous ones
+    trace_span_t span = trace_span_begin("wgpu_frame_begin");
+    wgpu_frame_begin(context->wgpu_context);
+    trace_span_end(span);
+    gpu_profiler_begin_frame(context->wgpu_context->profiler);
+    span = trace_span_begin("render");
     render_func(context);
+    trace_span_end(span);
+    gpu_profiler_end_frame(context->wgpu_context->profiler);
+    wgpu_frame_end(context->wgpu_context);
+    update_startup_times(context);
     ++record.frame_counter;
     ++context->frame.index;
-    time_end             = platform_get_time();
-    time_diff            = (time_end - time_start) * 1000.0f;
-    record.frame_timer   = time_diff / 1000.0f;
+    time_end = platform_get_time();
+    // Nanosecond clock, the float clock loses precision in long runs
+    time_diff
+      = (float)((double)(platform_get_time_ns() - frame_start_ns) / 1e6);
+    benchmark_record_frame(time_diff);
+    record.frame_timer
+      = headless ? context->headless.timestep : time_diff / 1000.0f;
     context->frame_timer = record.frame_timer;
     context->run_time += context->frame_timer;
-    update_camera(context, &record);
-    update_input_state(context, &record);
-    if (example_on_key_pressed_func) {
-      notify_key_input_state(&record, example_on_key_pressed_func);
+    if (!headless) {
+      update_camera(context, &record);
+      update_input_state(context, &record);
+      if (example_on_key_pressed_func) {
+        notify_key_input_state(&record, example_on_key_pressed_func);
+      }
     }
     // Convert to clamped timer value
     if (!context->paused) {
@@ -454,6 +834,16 @@ static void render_loop(wgpu_example_context_t* context,
       record.last_timestamp = time_end;
     }
     context->frame_counter = record.frame_counter;
+    trace_span_end(frame_span);
+  }
+
+  if (headless) {
+    const float loop_time_millis = (platform_get_time() - loop_start) * 1000.0f;
+    const uint32_t frame_count   = (uint32_t)context->frame.index;
+    log_info("Headless run: %u frames in %.2f ms (%.3f ms/frame, %.1f fps)",
+             frame_count, loop_time_millis,
+             loop_time_millis / (float)MAX(frame_count, 1u),
+             (float)frame_count * 1000.0f / MAX(loop_time_millis, EPSILON));
   }
 }
 
@@ -478,11 +868,14 @@ void prepare_frame(wgpu_example_context_t* context)
 void submit_command_buffers(wgpu_example_context_t* context)
 {
   wgpu_context_t* wgpu_context = context->wgpu_context;
+  const trace_span_t span      = trace_span_begin("submit_command_buffers");
 
   // Submit command buffer(s) to the queue
   wgpu_flush_command_buffers(wgpu_context,
                              wgpu_context->submit_info.command_buffers,
                              wgpu_context->submit_info.command_buffer_count);
+
+  trace_span_end(span);
 }
 
 void submit_frame(wgpu_example_context_t* context)
@@ -491,28 +884,78 @@ void submit_frame(wgpu_example_context_t* context)
   wgpu_swap_chain_present(context->wgpu_context);
 }
 
+/* Reports the startup time together with the blob cache activity, warm
+ * launches load the translated shaders and pipelines instead of storing them */
+static void log_startup_time(wgpu_example_context_t* context)
+{
+  wgpu_blob_cache_stats_t stats = {0};
+  wgpu_get_blob_cache_stats(&stats);
+  log_info("Startup: %.2f ms (blob cache: %llu hits, %llu misses, %llu "
+           "stores, %u blobs, %.1f MB)",
+           context->startup_time_millis, (unsigned long long)stats.load_hits,
+           (unsigned long long)stats.load_misses,
+           (unsigned long long)stats.store_count, stats.entry_count,
+           (double)stats.size / (1024.0 * 1024.0));
+}
+
 void example_run(int argc, char* argv[], refexport_t* ref_export)
 {
   // Parse the example arguments
   parse_example_arguments(argc, argv, ref_export);
+  // Start recording the CPU trace
+  if (ref_export->example_settings.trace_file != NULL) {
+    trace_start(ref_export->example_settings.trace_file);
+  }
+  // Start the worker threads for CPU-side parallelism
+  job_system_init(JOB_SYSTEM_AUTO_THREAD_COUNT);
   // Initialize WebGPU example context
   wgpu_example_context_t context;
   intialize_wgpu_example_context(&context, &ref_export->example_settings);
-  // Setup Window
-  setup_window(&context, &ref_export->example_window_config);
+  // Setup Window (or only its dimensions in headless mode)
+  if (context.headless.enabled) {
+    setup_headless(&context, &ref_export->example_window_config);
+  }
+  else {
+    setup_window(&context, &ref_export->example_window_config);
+  }
   // Intialize WebGPU
-  intialize_webgpu(&context);
+  context.startup_start_ns        = platform_get_time_ns();
+  const trace_span_t startup_span = trace_span_begin("startup");
+  if (!intialize_webgpu(&context, &ref_export->example_settings)) {
+    trace_span_end(startup_span);
+    if (context.window != NULL) {
+      window_destroy(context.window);
+    }
+    job_system_shutdown();
+    trace_stop();
+    exit(EXIT_FAILURE);
+  }
   // Intialize ImGui
   intialize_imgui(&context, &ref_export->example_settings);
   // Intialize example
   ref_export->example_initialize_func(&context);
+  trace_span_end(startup_span);
+  context.startup_time_millis
+    = (float)((double)(platform_get_time_ns() - context.startup_start_ns)
+              / 1e6);
+  log_startup_time(&context);
   // Render loop
   render_loop(&context, ref_export->example_render_func,
               ref_export->example_on_view_changed_func,
               ref_export->example_on_key_pressed_func);
-  // Cleanup
+  // Write GPU profiler results
+  if (ref_export->example_settings.gpu_profile_file != NULL) {
+    gpu_profiler_write_json(context.wgpu_context->profiler,
+                            ref_export->example_settings.gpu_profile_file);
+  }
+  // Cleanup, resources may only be released once the GPU is idle
+  wgpu_wait_for_idle(context.wgpu_context);
   ref_export->example_destroy_func(&context);
   release_imgui(&context);
   release_webgpu(&context);
-  window_destroy(context.window);
+  if (context.window != NULL) {
+    window_destroy(context.window);
+  }
+  job_system_shutdown();
+  trace_stop();
 }
@@ -34,6 +34,13 @@ typedef struct {
   void* imgui_overlay;
   // Time the example has been running (in seconds)
   float run_time;
+  // Startup timings (in ms), measured from the WebGPU initialization until
+  // the example is initialized, the first frame is submitted and all
+  // asynchronously created pipelines are ready (full quality)
+  uint64_t startup_start_ns;
+  float startup_time_millis;
+  float first_frame_millis;
+  float full_quality_millis;
   // Last frame time measured using a high performance timer (if available)
   float frame_timer;
   // Defines a frame rate independent timer value clamped from -1.0...1.0
@@ -42,6 +49,12 @@ typedef struct {
   // Multiplier for speeding up (or slowing down) the global timer
   float timer_speed;
   bool paused;
+  // Headless mode: offscreen rendering with a fixed simulated timestep
+  struct {
+    bool enabled;
+    uint32_t frame_count;
+    float timestep;
+  } headless;
   camera_t* camera;
   // Input
   vec2 mouse_position;
@@ -63,6 +76,41 @@ typedef struct {
   WGPUTextureFormat overlay_deph_stencil_format;
   /** @brief Create texture client */
   bool create_texture_client;
+  /** @brief Number of frames the CPU may record ahead of the GPU (2-3) */
+  uint32_t frames_in_flight;
+  /** @brief File the GPU profiler results are written to at exit (JSON) */
+  const char* gpu_profile_file;
+  /** @brief File the CPU trace is written to (Chrome trace event format) */
+  const char* trace_file;
+  /** @brief Coalesce queue buffer writes until the frame is submitted */
+  bool batch_queue_writes;
+  /** @brief Directory of the persistent blob cache, "off" disables it */
+  const char* blob_cache_dir;
+  /** @brief Compression of jpg / png textures (off, bc1, bc3, bc7, auto) */
+  const char* texture_compression;
+  /** @brief BC7 encoder quality, 1 (fastest) up to 4 */
+  uint32_t bc7_quality;
+  /** @brief Dawn backend validation level (off, partial, full) */
+  const char* validation;
+  /** @brief Comma separated Dawn device toggles, "-name" disables a toggle */
+  const char* toggles;
+  /** @brief Adapter selection, unset fields match any adapter */
+  struct {
+    /** @brief Backend type, e.g. vulkan, d3d12, metal, opengl, null */
+    const char* backend;
+    /** @brief Adapter type: discrete, integrated or cpu */
+    const char* type;
+    /** @brief Adapter name substring */
+    const char* name;
+  } adapter;
+  /** @brief Headless mode, renders offscreen without window and swapchain */
+  struct {
+    bool enabled;
+    /** @brief Number of frames to render before exiting */
+    uint32_t frame_count;
+    /** @brief Fixed simulated timestep in milliseconds */
+    float timestep_millis;
+  } headless;
 } wgpu_example_settings_t;
 
 typedef void* surface_t;
@@ -399,8 +399,9 @@ static void prepare_pipelines(wgpu_context_t* wgpu_context)
     .multisample  = multisample_state,
   };
 
-  // Instead of using a few fixed pipelines, we create one pipeline for each
-  // material using the properties of that material
+  // Instead of using a few fixed pipelines, we request one pipeline for each
+  // material using the properties of that material, materials with the same
+  // properties share a pipeline through the pipeline cache
   wgpu_gltf_materials_t materials = wgpu_gltf_model_get_materials(gltf_model);
   for (uint32_t i = 0; i < materials.material_count; ++i) {
     wgpu_gltf_material_t* material = &materials.materials[i];
@@ -408,8 +409,8 @@ static void prepare_pipelines(wgpu_context_t* wgpu_context)
     WGPUPrimitiveState* primitive_desc = &render_pipeline_descriptor.primitive;
     primitive_desc->cullMode
       = material->double_sided ? WGPUCullMode_None : WGPUCullMode_Back;
-    material->pipeline = wgpuDeviceCreateRenderPipeline(
-      wgpu_context->device, &render_pipeline_descriptor);
+    material->pipeline = wgpu_pipeline_cache_get_render_pipeline(
+      wgpu_context->pipeline_cache, &render_pipeline_descriptor);
     ASSERT(material->pipeline != NULL)
   }
 
@@ -7,6 +7,7 @@
 #include "../core/file.h"
 #include "../core/macro.h"
 #include "../core/math.h"
+#include "../webgpu/asset_loader.h"
 
 /* -------------------------------------------------------------------------- *
  * Plane mesh
@@ -466,6 +467,40 @@ int stanford_dragon_mesh_init(stanford_dragon_mesh_t* stanford_dragon_mesh)
   return EXIT_SUCCESS;
 }
 
+static void* stanford_dragon_mesh_decode(void* user_data)
+{
+  stanford_dragon_mesh_t* stanford_dragon_mesh
+    = (stanford_dragon_mesh_t*)user_data;
+  return stanford_dragon_mesh_init(stanford_dragon_mesh) == EXIT_SUCCESS ?
+           stanford_dragon_mesh :
+           NULL;
+}
+
+static bool stanford_dragon_mesh_upload(struct wgpu_context_t* wgpu_context,
+                                        void* decoded, void* user_data)
+{
+  UNUSED_VAR(wgpu_context);
+  UNUSED_VAR(user_data);
+
+  // The mesh only holds CPU data, the examples create the buffers
+  return decoded != NULL;
+}
+
+struct wgpu_asset_t*
+stanford_dragon_mesh_init_async(struct wgpu_context_t* wgpu_context,
+                                stanford_dragon_mesh_t* stanford_dragon_mesh)
+{
+  ASSERT(stanford_dragon_mesh)
+
+  wgpu_asset_desc_t asset_desc = {
+    .label     = "meshes/dragon_vrip_res4.ply",
+    .decode    = stanford_dragon_mesh_decode,
+    .upload    = stanford_dragon_mesh_upload,
+    .user_data = stanford_dragon_mesh,
+  };
+  return wgpu_load_asset_async(wgpu_context, &asset_desc);
+}
+
 void stanford_dragon_mesh_compute_normals(
   stanford_dragon_mesh_t* stanford_dragon_mesh)
 {
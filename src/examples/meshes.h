@@ -3,6 +3,10 @@
 
 #include <stdint.h>
 
+/* Forward declarations */
+struct wgpu_asset_t;
+struct wgpu_context_t;
+
 /* -------------------------------------------------------------------------- *
  * Plane mesh
  * -------------------------------------------------------------------------- */
@@ -139,6 +143,15 @@ typedef struct stanford_dragon_mesh_t {
  */
 int stanford_dragon_mesh_init(stanford_dragon_mesh_t* stanford_dragon_mesh);
 
+/**
+ * @brief Loads the 'stanford-dragon' PLY file on a job worker, the mesh must
+ * stay valid until the returned asset is ready.
+ * @return an asset handle the caller releases with wgpu_asset_release
+ */
+struct wgpu_asset_t*
+stanford_dragon_mesh_init_async(struct wgpu_context_t* wgpu_context,
+                                stanford_dragon_mesh_t* stanford_dragon_mesh);
+
 typedef enum projected_plane_enum {
   ProjectedPlane_XY = 0,
   ProjectedPlane_XZ = 1,
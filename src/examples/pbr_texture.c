@@ -125,25 +125,45 @@ static void setup_camera(wgpu_example_context_t* context)
 
 static void load_assets(wgpu_context_t* wgpu_context)
 {
+  // The models and textures are decoded on the job workers while the main
+  // thread loads the cube map
+  wgpu_asset_t* assets[7] = {0};
+  uint32_t asset_count    = 0;
+
   // Load glTF models
   const uint32_t gltf_loading_flags
     = WGPU_GLTF_FileLoadingFlags_PreTransformVertices
       | WGPU_GLTF_FileLoadingFlags_PreMultiplyVertexColors
       | WGPU_GLTF_FileLoadingFlags_DontLoadImages;
   // Skybox
-  models.skybox
-    = wgpu_gltf_model_load_from_file(&(wgpu_gltf_model_load_options_t){
+  assets[asset_count++] = wgpu_gltf_model_load_from_file_async(
+    &(wgpu_gltf_model_load_options_t){
       .wgpu_context       = wgpu_context,
       .filename           = "models/cube.gltf",
       .file_loading_flags = gltf_loading_flags,
-    });
+    },
+    &models.skybox);
   // Object
-  models.object
-    = wgpu_gltf_model_load_from_file(&(wgpu_gltf_model_load_options_t){
+  assets[asset_count++] = wgpu_gltf_model_load_from_file_async(
+    &(wgpu_gltf_model_load_options_t){
       .wgpu_context       = wgpu_context,
       .filename           = "models/Cerberus/cerberus.gltf",
       .file_loading_flags = gltf_loading_flags,
-    });
+    },
+    &models.object);
+  // Model textures
+  assets[asset_count++] = wgpu_create_texture_from_file_async(
+    wgpu_context, "models/Cerberus/albedo.png", NULL, &textures.albedo_map);
+  assets[asset_count++] = wgpu_create_texture_from_file_async(
+    wgpu_context, "models/Cerberus/normal.png", NULL, &textures.normal_map);
+  assets[asset_count++] = wgpu_create_texture_from_file_async(
+    wgpu_context, "models/Cerberus/ao.png", NULL, &textures.ao_map);
+  assets[asset_count++] = wgpu_create_texture_from_file_async(
+    wgpu_context, "models/Cerberus/metallic.png", NULL,
+    &textures.metallic_map);
+  assets[asset_count++] = wgpu_create_texture_from_file_async(
+    wgpu_context, "models/Cerberus/roughness.png", NULL,
+    &textures.roughness_map);
   // Cube map
   static const char* cubemap[6] = {
     "textures/cubemaps/gcanyon_cube_px.png", // Right
@@ -158,17 +178,11 @@ static void load_assets(wgpu_context_t* wgpu_context)
     &(struct wgpu_texture_load_options_t){
       .flip_y = true, // Flip y to match gcanyon.ktx hdr cubemap
     });
-  // Model textures
-  textures.albedo_map = wgpu_create_texture_from_file(
-    wgpu_context, "models/Cerberus/albedo.png", NULL);
-  textures.normal_map = wgpu_create_texture_from_file(
-    wgpu_context, "models/Cerberus/normal.png", NULL);
-  textures.ao_map = wgpu_create_texture_from_file(
-    wgpu_context, "models/Cerberus/ao.png", NULL);
-  textures.metallic_map = wgpu_create_texture_from_file(
-    wgpu_context, "models/Cerberus/metallic.png", NULL);
-  textures.roughness_map = wgpu_create_texture_from_file(
-    wgpu_context, "models/Cerberus/roughness.png", NULL);
+  // The environment cubes are generated with the skybox model
+  wgpu_wait_for_async_assets(wgpu_context);
+  for (uint32_t i = 0; i < asset_count; ++i) {
+    wgpu_asset_release(assets[i]);
+  }
 }
 
 static void setup_bind_group_layouts(wgpu_context_t* wgpu_context)
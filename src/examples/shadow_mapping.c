@@ -860,9 +860,9 @@ static void prepare_color_rendering_pipeline(wgpu_context_t* wgpu_context)
 static int example_initialize(wgpu_example_context_t* context)
 {
   if (context) {
-    stanford_dragon_mesh_init(&stanford_dragon_mesh);
-    prepare_vertex_and_index_buffers(context->wgpu_context,
-                                     &stanford_dragon_mesh);
+    // Parse the dragon mesh on a job worker while the pipelines are created
+    wgpu_asset_t* dragon_mesh_asset = stanford_dragon_mesh_init_async(
+      context->wgpu_context, &stanford_dragon_mesh);
     prepare_texture(context->wgpu_context);
     prepare_sampler(context->wgpu_context);
     setup_pipeline_layout(context->wgpu_context);
@@ -871,6 +871,10 @@ static int example_initialize(wgpu_example_context_t* context)
     prepare_uniform_buffers(context->wgpu_context);
     prepare_view_matrices(context->wgpu_context);
     setup_render_pass(context->wgpu_context);
+    wgpu_asset_wait(dragon_mesh_asset);
+    wgpu_asset_release(dragon_mesh_asset);
+    prepare_vertex_and_index_buffers(context->wgpu_context,
+                                     &stanford_dragon_mesh);
     prepared = true;
     return 0;
   }
@@ -182,6 +182,7 @@ static void load_texture(wgpu_context_t* wgpu_context, const char* filename,
   ASSERT(command_buffer != NULL)
 
   // Submit to the queue
+  wgpu_flush_queue_writes(wgpu_context);
   wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
 
   // Release command buffer
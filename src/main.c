@@ -3,28 +3,276 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
+#include "../lib/wgpu_native/wgpu_native.h"
 #include "core/api.h"
 #include "core/argparse.h"
 #include "examples/examples.h"
+#include "webgpu/api.h"
+
+/* Benchmark mode */
+
+typedef struct {
+  const char* filter;
+  int warmup_frames;
+  int measured_frames;
+  const char* output_dir;
+  const char* baseline;
+  float threshold;
+} benchmark_options_t;
+
+/* Paths given on the command line are relative to the launch directory */
+static void resolve_path(const char* launch_dir, const char* path,
+                         char* result)
+{
+  if (path[0] == '/') {
+    snprintf(result, STRMAX, "%s", path);
+  }
+  else {
+    snprintf(result, STRMAX, "%s/%s", launch_dir, path);
+  }
+}
+
+/* The filter is a comma separated list of example name substrings */
+static bool example_matches_filter(const char* example_name,
+                                   const char* filter)
+{
+  if (filter == NULL || filter[0] == '\0') {
+    return true;
+  }
+
+  char filters[STRMAX];
+  snprintf(filters, sizeof(filters), "%s", filter);
+  for (char* token = strtok(filters, ","); token != NULL;
+       token       = strtok(NULL, ",")) {
+    if (strstr(example_name, token) != NULL) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int run_benchmark(int argc, char* argv[], const char* launch_dir,
+                         const benchmark_options_t* options)
+{
+  examplecase_t* examples = get_examples();
+  uint32_t example_count  = get_number_of_examples();
+
+  const char** names = (const char**)calloc(example_count, sizeof(char*));
+  benchmark_stats_t* results
+    = (benchmark_stats_t*)calloc(example_count, sizeof(benchmark_stats_t));
+  uint32_t result_count = 0;
+
+  const benchmark_settings_t settings = {
+    .warmup_frames   = (uint32_t)MAX(options->warmup_frames, 0),
+    .measured_frames = (uint32_t)MAX(options->measured_frames, 1),
+  };
+
+  char output_dir[STRMAX], filename[STRMAX + LINE_SIZE];
+  resolve_path(launch_dir,
+               options->output_dir != NULL ? options->output_dir : ".",
+               output_dir);
+
+  int regressions = 0, baseline_errors = 0;
+  for (uint32_t i = 0; i < example_count; ++i) {
+    const char* name = examples[i].example_name;
+    if (!example_matches_filter(name, options->filter)) {
+      continue;
+    }
+
+    printf("Benchmarking example: %s (%u warmup frames, %u measured frames)\n",
+           name, settings.warmup_frames, settings.measured_frames);
+    benchmark_start(name, &settings);
+    examples[i].example_func(argc, argv);
+    benchmark_stop(&results[result_count]);
+    names[result_count] = name;
+
+    const benchmark_stats_t* stats = &results[result_count++];
+    printf("  CPU frame time (ms): min %.3f, mean %.3f, p50 %.3f, p95 %.3f, "
+           "p99 %.3f, max %.3f\n",
+           stats->min, stats->mean, stats->p50, stats->p95, stats->p99,
+           stats->max);
+
+    snprintf(filename, sizeof(filename), "%s/%s.json", output_dir, name);
+    benchmark_write_json(filename, name, stats);
+    snprintf(filename, sizeof(filename), "%s/%s.csv", output_dir, name);
+    benchmark_write_csv(filename);
+
+    if (options->baseline != NULL) {
+      resolve_path(launch_dir, options->baseline, filename);
+      const int res = benchmark_check_regression(filename, name, stats,
+                                                 options->threshold);
+      if (res > 0) {
+        ++regressions;
+      }
+      else if (res < 0) {
+        ++baseline_errors;
+      }
+    }
+  }
+
+  snprintf(filename, sizeof(filename), "%s/benchmark_summary.json",
+           output_dir);
+  benchmark_write_summary(filename, names, results, result_count);
+  printf("Benchmarked %u examples, results written to %s\n", result_count,
+         output_dir);
+
+  benchmark_shutdown();
+  free(names);
+  free(results);
+
+  if (baseline_errors > 0) {
+    fprintf(stderr,
+            "Could not compare %d example(s) against the baseline %s\n",
+            baseline_errors, options->baseline);
+  }
+  if (regressions > 0) {
+    fprintf(stderr, "Found %d performance regression(s) (threshold %.1f%%)\n",
+            regressions, options->threshold);
+  }
+  if (baseline_errors > 0 || regressions > 0) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
 
 int main(int argc, char* argv[])
 {
   srand((unsigned int)time(NULL));
+
+  char launch_dir[STRMAX] = ".";
+  if (getcwd(launch_dir, sizeof(launch_dir)) == NULL) {
+    snprintf(launch_dir, sizeof(launch_dir), ".");
+  }
   initialize_default_path();
 
-  const char* example_name = NULL;
-  int demo_mode = 0, window_width = 0, window_height = 0;
+  const char* example_name    = NULL;
+  const char* validation      = NULL;
+  const char* toggles         = NULL;
+  const char* adapter_backend = NULL;
+  const char* adapter_type    = NULL;
+  const char* adapter_name    = NULL;
+  int demo_mode               = 0;
+  int headless                = 0;
+  int list_adapters           = 0;
+  int benchmark_mode          = 0;
+  int job_benchmark           = 0;
+  int mip_benchmark           = 0;
+  int mipmap_benchmark        = 0;
+  int staging_stress          = 0;
+
+  benchmark_options_t benchmark_options = {
+    .warmup_frames   = 60,
+    .measured_frames = 600,
+    .threshold       = 10.0f,
+  };
+  /* Options without a value pointer are parsed by the examples, they are only
+   * listed for the help message */
   struct argparse_option options[] = {
     OPT_BOOLEAN('?', "help", NULL, "show this help message and exit",
                 argparse_help_cb, 0, OPT_NONEG),
     OPT_GROUP("Options"),
     OPT_STRING('s', "sample", &example_name, "sample to launch", NULL, 0, 0),
-    OPT_INTEGER('w', "width", &window_width, "window width", NULL, 0, 0),
-    OPT_INTEGER('h', "height", &window_height, "window height", NULL, 0, 0),
+    OPT_INTEGER('w', "width", NULL, "window width", NULL, 0, 0),
+    OPT_INTEGER('h', "height", NULL, "window height", NULL, 0, 0),
     OPT_BOOLEAN('d', "demo-mode", &demo_mode,
                 "demo mode, this mode runs every example for 10 seconds", NULL,
                 0, 0),
+    OPT_GROUP("Headless mode"),
+    OPT_BOOLEAN(0, "headless", &headless,
+                "render offscreen without window using the Null or CPU adapter",
+                NULL, 0, 0),
+    OPT_INTEGER(0, "frames", NULL,
+                "number of frames to render in headless mode (default 600)",
+                NULL, 0, 0),
+    OPT_FLOAT(0, "timestep", NULL,
+              "fixed simulated timestep in ms in headless mode (default 16.67)",
+              NULL, 0, 0),
+    OPT_GROUP("Profiling"),
+    OPT_STRING(0, "gpu-profile", NULL,
+               "write GPU pass timings (JSON) to this file at exit", NULL, 0,
+               0),
+    OPT_STRING(0, "trace", NULL,
+               "write a CPU trace (Chrome trace event JSON) to this file",
+               NULL, 0, 0),
+    OPT_BOOLEAN(0, "batch-writes", NULL,
+                "coalesce queue buffer writes into fewer copies per frame",
+                NULL, 0, 0),
+    OPT_GROUP("Caching"),
+    OPT_STRING(0, "blob-cache", NULL,
+               "directory of the persistent shader/pipeline cache, \"off\" "
+               "disables it (default ~/.cache/webgpu-native-examples)",
+               NULL, 0, 0),
+    OPT_STRING(0, "texture-compression", NULL,
+               "compress jpg/png textures at load time: off, bc1, bc3, bc7 "
+               "or auto, cached in the blob cache directory (default off, env "
+               "WGPU_TEXTURE_COMPRESSION)",
+               NULL, 0, 0),
+    OPT_INTEGER(0, "bc7-quality", NULL,
+                "BC7 encoder quality from 1 (fastest) to 4 (default 2)", NULL,
+                0, 0),
+    OPT_GROUP("Dawn configuration"),
+    OPT_STRING(0, "validation", &validation,
+               "backend validation level: off, partial or full (default full "
+               "in debug and off in release builds, env WGPU_VALIDATION)",
+               NULL, 0, 0),
+    OPT_STRING(0, "toggles", &toggles,
+               "comma separated device toggles, e.g. skip_validation,"
+               "turn_off_vsync,-lazy_clear_resource_on_first_use (env "
+               "WGPU_TOGGLES)",
+               NULL, 0, 0),
+    OPT_GROUP("Adapter selection"),
+    OPT_STRING(0, "adapter-backend", &adapter_backend,
+               "backend type: vulkan, d3d12, d3d11, metal, opengl, opengles, "
+               "webgpu or null (env WGPU_ADAPTER_BACKEND)",
+               NULL, 0, 0),
+    OPT_STRING(0, "adapter-type", &adapter_type,
+               "adapter type: discrete, integrated or cpu (env "
+               "WGPU_ADAPTER_TYPE)",
+               NULL, 0, 0),
+    OPT_STRING(0, "adapter-name", &adapter_name,
+               "case-insensitive adapter name substring (env "
+               "WGPU_ADAPTER_NAME)",
+               NULL, 0, 0),
+    OPT_BOOLEAN(0, "list-adapters", &list_adapters,
+                "list the adapters with their limits and features and exit",
+                NULL, 0, 0),
+    OPT_GROUP("Benchmark mode"),
+    OPT_BOOLEAN('b', "benchmark", &benchmark_mode,
+                "benchmark mode, runs the examples for a fixed number of "
+                "frames and writes CPU frame time statistics",
+                NULL, 0, 0),
+    OPT_STRING(0, "filter", &benchmark_options.filter,
+               "comma separated example name filters", NULL, 0, 0),
+    OPT_INTEGER(0, "warmup-frames", &benchmark_options.warmup_frames,
+                "frames rendered before measuring (default 60)", NULL, 0, 0),
+    OPT_INTEGER(0, "measured-frames", &benchmark_options.measured_frames,
+                "frames included in the statistics (default 600)", NULL, 0,
+                0),
+    OPT_STRING(0, "output", &benchmark_options.output_dir,
+               "directory for the JSON/CSV results (default launch dir)",
+               NULL, 0, 0),
+    OPT_STRING(0, "baseline", &benchmark_options.baseline,
+               "benchmark summary to compare the results against", NULL, 0,
+               0),
+    OPT_FLOAT(0, "threshold", &benchmark_options.threshold,
+              "allowed slowdown in percent before failing (default 10)", NULL,
+              0, 0),
+    OPT_BOOLEAN(0, "job-benchmark", &job_benchmark,
+                "run the job system microbenchmarks (scheduling overhead and "
+                "scaling across core counts) and exit",
+                NULL, 0, 0),
+    OPT_BOOLEAN(0, "mip-benchmark", &mip_benchmark,
+                "compare the CPU mip chain generators and exit", NULL, 0, 0),
+    OPT_BOOLEAN(0, "mipmap-benchmark", &mipmap_benchmark,
+                "compare the render pass and compute GPU mipmap generators "
+                "and exit",
+                NULL, 0, 0),
+    OPT_BOOLEAN(0, "staging-stress", &staging_stress,
+                "stress test the staging belt with thousands of small uploads "
+                "per frame (use --adapter-backend=null) and exit",
+                NULL, 0, 0),
     OPT_END(),
   };
 
@@ -42,6 +290,56 @@ int main(int argc, char* argv[])
   int argparse_argc = argparse_parse(&argparse, argc, (const char**)argv_cpy);
   free(argv_cpy);
 
+  if (list_adapters != 0) {
+    wgpu_list_adapters();
+    return EXIT_SUCCESS;
+  }
+
+  if (job_benchmark != 0) {
+    job_system_benchmark(0);
+    return EXIT_SUCCESS;
+  }
+
+  if (mip_benchmark != 0) {
+    mip_chain_benchmark(0);
+    return EXIT_SUCCESS;
+  }
+
+  if (mipmap_benchmark != 0 || staging_stress != 0) {
+    wgpu_context_t* wgpu_context
+      = wgpu_context_create(&(wgpu_context_create_options_t){
+        .offscreen       = headless != 0,
+        .validation      = validation,
+        .toggles         = toggles,
+        .adapter_backend = adapter_backend,
+        .adapter_type    = adapter_type,
+        .adapter_name    = adapter_name,
+      });
+    if (wgpu_context == NULL) {
+      return EXIT_FAILURE;
+    }
+    if (!wgpu_create_device_and_queue(wgpu_context)) {
+      wgpu_context_release(wgpu_context);
+      return EXIT_FAILURE;
+    }
+    bool passed = true;
+    if (mipmap_benchmark != 0) {
+      wgpu_mipmap_generator_benchmark(wgpu_context);
+    }
+    if (staging_stress != 0) {
+      passed = wgpu_staging_belt_stress_test(wgpu_context);
+    }
+    wgpu_context_release(wgpu_context);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (benchmark_mode != 0) {
+    if (benchmark_options.filter == NULL) {
+      benchmark_options.filter = example_name;
+    }
+    return run_benchmark(argc, argv, launch_dir, &benchmark_options);
+  }
+
   if (argc == 0) {
     examplecase_t* example = get_random_example();
     printf("Randomly selected example: %s\n", example->example_name);
@@ -65,3 +65,10 @@ float platform_get_time(void)
   }
   return (float)(get_native_time() - initial);
 }
+
+uint64_t platform_get_time_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
@@ -3,9 +3,15 @@
 
 #include <dawn/webgpu.h>
 
+#include "asset_loader.h"
+#include "async_pipeline.h"
 #include "buffer.h"
+#include "buffer_heap.h"
 #include "context.h"
+#include "pipeline_cache.h"
 #include "shader.h"
+#include "staging_belt.h"
 #include "texture.h"
+#include "write_batcher.h"
 
 #endif
@@ -0,0 +1,185 @@
+#include "asset_loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/job_system.h"
+#include "../core/log.h"
+#include "../core/macro.h"
+#include "../core/platform.h"
+#include "../core/trace.h"
+
+#include "context.h"
+
+struct wgpu_asset_t {
+  wgpu_context_t* wgpu_context;
+  wgpu_asset_desc_t desc;
+  char label[STRMAX];
+  job_t* job;
+  void* decoded;
+  uint32_t state;     /* wgpu_asset_state_enum */
+  uint32_t ref_count; /* caller and loader references */
+  uint64_t decode_time_ns;
+  struct wgpu_asset_t* next_completed; /* completion queue link */
+  struct wgpu_asset_t* next_in_flight; /* main thread only */
+};
+
+/* Asset lifetime */
+
+static void asset_release(wgpu_asset_t* asset)
+{
+  if (__atomic_sub_fetch(&asset->ref_count, 1, __ATOMIC_ACQ_REL) == 0) {
+    job_release(asset->job);
+    free(asset);
+  }
+}
+
+static void asset_remove_in_flight(wgpu_asset_t* asset)
+{
+  wgpu_asset_t** link = &asset->wgpu_context->async_assets.in_flight;
+  while (*link != NULL && *link != asset) {
+    link = &(*link)->next_in_flight;
+  }
+  if (*link != NULL) {
+    *link = asset->next_in_flight;
+  }
+}
+
+/* Worker thread side */
+
+static void asset_decode_job(void* data)
+{
+  wgpu_asset_t* asset = (wgpu_asset_t*)data;
+
+  const trace_span_t span = trace_span_begin("asset_decode");
+  const uint64_t start_ns = platform_get_time_ns();
+  asset->decoded          = asset->desc.decode(asset->desc.user_data);
+  asset->decode_time_ns   = platform_get_time_ns() - start_ns;
+  trace_span_end(span);
+
+  /* Lock-free push onto the completion queue drained by the main thread */
+  wgpu_context_t* wgpu_context = asset->wgpu_context;
+  __atomic_store_n(&asset->state, AssetState_Decoded, __ATOMIC_RELEASE);
+  asset->next_completed
+    = __atomic_load_n(&wgpu_context->async_assets.completed, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&wgpu_context->async_assets.completed,
+                                      &asset->next_completed, asset, true,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+  }
+}
+
+/* Main thread side */
+
+wgpu_asset_t* wgpu_load_asset_async(wgpu_context_t* wgpu_context,
+                                    const wgpu_asset_desc_t* desc)
+{
+  wgpu_asset_t* asset = (wgpu_asset_t*)calloc(1, sizeof(wgpu_asset_t));
+  asset->wgpu_context = wgpu_context;
+  asset->desc         = *desc;
+  asset->state        = AssetState_Decoding;
+  asset->ref_count    = 2;
+  snprintf(asset->label, sizeof(asset->label), "%s",
+           desc->label ? desc->label : "");
+  asset->desc.label = asset->label;
+
+  asset->next_in_flight                = wgpu_context->async_assets.in_flight;
+  wgpu_context->async_assets.in_flight = asset;
+  ++wgpu_context->async_assets.pending_count;
+
+  asset->job = job_create(asset_decode_job, asset);
+  job_submit(asset->job);
+  return asset;
+}
+
+static void asset_upload(wgpu_asset_t* asset)
+{
+  wgpu_context_t* wgpu_context = asset->wgpu_context;
+
+  const trace_span_t span = trace_span_begin("asset_upload");
+  const uint64_t start_ns = platform_get_time_ns();
+  const bool ready
+    = asset->desc.upload(wgpu_context, asset->decoded, asset->desc.user_data);
+  const uint64_t upload_time_ns = platform_get_time_ns() - start_ns;
+  trace_span_end(span);
+  asset->decoded = NULL;
+
+  asset_remove_in_flight(asset);
+  --wgpu_context->async_assets.pending_count;
+  if (ready) {
+    ++wgpu_context->async_assets.ready_count;
+    wgpu_context->async_assets.last_ready_ns = platform_get_time_ns();
+    log_debug("Loaded asset %s (decode %.2f ms, upload %.2f ms)", asset->label,
+              asset->decode_time_ns / 1e6, upload_time_ns / 1e6);
+  }
+  else {
+    ++wgpu_context->async_assets.failed_count;
+    log_error("Unable to load asset %s", asset->label);
+  }
+  __atomic_store_n(&asset->state, ready ? AssetState_Ready : AssetState_Failed,
+                   __ATOMIC_RELEASE);
+  asset_release(asset);
+}
+
+uint32_t wgpu_process_async_assets(wgpu_context_t* wgpu_context)
+{
+  wgpu_asset_t* completed = __atomic_exchange_n(
+    &wgpu_context->async_assets.completed, NULL, __ATOMIC_ACQUIRE);
+
+  /* The queue is a stack, upload in completion order */
+  wgpu_asset_t* reversed = NULL;
+  while (completed != NULL) {
+    wgpu_asset_t* next        = completed->next_completed;
+    completed->next_completed = reversed;
+    reversed                  = completed;
+    completed                 = next;
+  }
+
+  uint32_t upload_count = 0;
+  while (reversed != NULL) {
+    wgpu_asset_t* next = reversed->next_completed;
+    asset_upload(reversed);
+    reversed = next;
+    ++upload_count;
+  }
+  return upload_count;
+}
+
+wgpu_asset_state_enum wgpu_asset_get_state(wgpu_asset_t* asset)
+{
+  return (wgpu_asset_state_enum)__atomic_load_n(&asset->state,
+                                                __ATOMIC_ACQUIRE);
+}
+
+bool wgpu_asset_is_ready(wgpu_asset_t* asset)
+{
+  return wgpu_asset_get_state(asset) == AssetState_Ready;
+}
+
+bool wgpu_asset_wait(wgpu_asset_t* asset)
+{
+  job_wait(asset->job);
+  if (wgpu_asset_get_state(asset) == AssetState_Decoded) {
+    wgpu_process_async_assets(asset->wgpu_context);
+  }
+  return wgpu_asset_is_ready(asset);
+}
+
+void wgpu_asset_release(wgpu_asset_t* asset)
+{
+  if (asset != NULL) {
+    asset_release(asset);
+  }
+}
+
+bool wgpu_async_assets_ready(wgpu_context_t* wgpu_context)
+{
+  return wgpu_context->async_assets.pending_count == 0;
+}
+
+void wgpu_wait_for_async_assets(wgpu_context_t* wgpu_context)
+{
+  while (wgpu_context->async_assets.in_flight != NULL) {
+    job_wait(wgpu_context->async_assets.in_flight->job);
+    wgpu_process_async_assets(wgpu_context);
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Forward declarations */
+struct wgpu_context_t;
+
+/* Asynchronously loaded asset, the file is read and decoded by a job on a
+ * worker thread, the GPU resources are created on the main thread */
+typedef struct wgpu_asset_t wgpu_asset_t;
+
+typedef enum wgpu_asset_state_enum {
+  AssetState_Decoding = 0, /* queued or decoding on a worker thread */
+  AssetState_Decoded  = 1, /* waiting for the upload on the main thread */
+  AssetState_Ready    = 2,
+  AssetState_Failed   = 3,
+} wgpu_asset_state_enum;
+
+typedef struct wgpu_asset_desc_t {
+  /* Name used in log messages and trace spans (file name) */
+  const char* label;
+  /* Runs on a worker thread, returns the decoded data or NULL on failure */
+  void* (*decode)(void* user_data);
+  /* Runs on the main thread with the decoded data (NULL if decoding failed)
+   * and returns true if the asset is ready. Owns the decoded and user data. */
+  bool (*upload)(struct wgpu_context_t* wgpu_context, void* decoded,
+                 void* user_data);
+  void* user_data;
+} wgpu_asset_desc_t;
+
+/**
+ * @brief Starts loading an asset. The upload runs while the main thread drains
+ * the completion queue, which happens at the start of every frame and in
+ * wgpu_asset_wait / wgpu_wait_for_async_assets.
+ * @return an asset handle the caller releases with wgpu_asset_release
+ */
+wgpu_asset_t* wgpu_load_asset_async(struct wgpu_context_t* wgpu_context,
+                                    const wgpu_asset_desc_t* desc);
+
+wgpu_asset_state_enum wgpu_asset_get_state(wgpu_asset_t* asset);
+
+/* Returns true once the GPU resources of the asset are created */
+bool wgpu_asset_is_ready(wgpu_asset_t* asset);
+
+/**
+ * @brief Blocks until the asset is uploaded, the calling thread decodes other
+ * jobs in the meantime. Must be called from the main thread.
+ * @return true if the asset is ready, false if loading failed
+ */
+bool wgpu_asset_wait(wgpu_asset_t* asset);
+
+/* The asset keeps loading if it is released before it is uploaded */
+void wgpu_asset_release(wgpu_asset_t* asset);
+
+/**
+ * @brief Drains the completion queue and uploads the decoded assets.
+ * @return the number of uploaded assets
+ */
+uint32_t wgpu_process_async_assets(struct wgpu_context_t* wgpu_context);
+
+/* Returns true when no asset is loading */
+bool wgpu_async_assets_ready(struct wgpu_context_t* wgpu_context);
+
+/* Blocks until all pending assets are uploaded */
+void wgpu_wait_for_async_assets(struct wgpu_context_t* wgpu_context);
+
+#endif
@@ -0,0 +1,116 @@
+#include "async_pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/log.h"
+#include "../core/macro.h"
+#include "../core/platform.h"
+
+#include "context.h"
+
+/* Pending request, passed as userdata to the creation callback */
+typedef struct async_pipeline_request_t {
+  wgpu_context_t* wgpu_context;
+  WGPURenderPipeline* render_pipeline;
+  WGPUComputePipeline* compute_pipeline;
+  char label[64];
+} async_pipeline_request_t;
+
+static async_pipeline_request_t*
+async_pipeline_request_create(wgpu_context_t* wgpu_context, const char* label)
+{
+  async_pipeline_request_t* request
+    = (async_pipeline_request_t*)calloc(1, sizeof(async_pipeline_request_t));
+  request->wgpu_context = wgpu_context;
+  snprintf(request->label, sizeof(request->label), "%s", label ? label : "");
+
+  ++wgpu_context->async_pipelines.pending_count;
+  return request;
+}
+
+static void async_pipeline_request_complete(async_pipeline_request_t* request,
+                                            WGPUCreatePipelineAsyncStatus status,
+                                            char const* message)
+{
+  wgpu_context_t* wgpu_context = request->wgpu_context;
+  --wgpu_context->async_pipelines.pending_count;
+  if (status == WGPUCreatePipelineAsyncStatus_Success) {
+    ++wgpu_context->async_pipelines.ready_count;
+    wgpu_context->async_pipelines.last_ready_ns = platform_get_time_ns();
+  }
+  else {
+    ++wgpu_context->async_pipelines.failed_count;
+    log_error("Unable to create pipeline \"%s\": %s", request->label,
+              message ? message : "");
+  }
+  free(request);
+}
+
+static void async_pipeline_render_callback(WGPUCreatePipelineAsyncStatus status,
+                                           WGPURenderPipeline pipeline,
+                                           char const* message, void* userdata)
+{
+  async_pipeline_request_t* request = (async_pipeline_request_t*)userdata;
+  if (status == WGPUCreatePipelineAsyncStatus_Success && pipeline != NULL) {
+    /* Replaces the fallback pipeline, if any */
+    WGPU_RELEASE_RESOURCE(RenderPipeline, *request->render_pipeline)
+    *request->render_pipeline = pipeline;
+  }
+  else {
+    WGPU_RELEASE_RESOURCE(RenderPipeline, pipeline)
+  }
+  async_pipeline_request_complete(request, status, message);
+}
+
+static void
+async_pipeline_compute_callback(WGPUCreatePipelineAsyncStatus status,
+                                WGPUComputePipeline pipeline,
+                                char const* message, void* userdata)
+{
+  async_pipeline_request_t* request = (async_pipeline_request_t*)userdata;
+  if (status == WGPUCreatePipelineAsyncStatus_Success && pipeline != NULL) {
+    /* Replaces the fallback pipeline, if any */
+    WGPU_RELEASE_RESOURCE(ComputePipeline, *request->compute_pipeline)
+    *request->compute_pipeline = pipeline;
+  }
+  else {
+    WGPU_RELEASE_RESOURCE(ComputePipeline, pipeline)
+  }
+  async_pipeline_request_complete(request, status, message);
+}
+
+void wgpu_create_render_pipeline_async(
+  wgpu_context_t* wgpu_context, const WGPURenderPipelineDescriptor* descriptor,
+  WGPURenderPipeline* pipeline)
+{
+  async_pipeline_request_t* request
+    = async_pipeline_request_create(wgpu_context, descriptor->label);
+  request->render_pipeline = pipeline;
+  wgpuDeviceCreateRenderPipelineAsync(wgpu_context->device, descriptor,
+                                      async_pipeline_render_callback, request);
+}
+
+void wgpu_create_compute_pipeline_async(
+  wgpu_context_t* wgpu_context, const WGPUComputePipelineDescriptor* descriptor,
+  WGPUComputePipeline* pipeline)
+{
+  async_pipeline_request_t* request
+    = async_pipeline_request_create(wgpu_context, descriptor->label);
+  request->compute_pipeline = pipeline;
+  wgpuDeviceCreateComputePipelineAsync(wgpu_context->device, descriptor,
+                                       async_pipeline_compute_callback,
+                                       request);
+}
+
+bool wgpu_async_pipelines_ready(wgpu_context_t* wgpu_context)
+{
+  return wgpu_context->async_pipelines.pending_count == 0;
+}
+
+void wgpu_wait_for_async_pipelines(wgpu_context_t* wgpu_context)
+{
+  while (wgpu_context->async_pipelines.pending_count > 0) {
+    wgpuDeviceTick(wgpu_context->device);
+  }
+}
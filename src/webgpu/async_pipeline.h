@@ -0,0 +1,36 @@
+#ifndef ASYNC_PIPELINE_H
+#define ASYNC_PIPELINE_H
+
+#include <stdbool.h>
+
+#include <dawn/webgpu.h>
+
+/* Forward declarations */
+struct wgpu_context_t;
+
+/**
+ * @brief Creates a render pipeline on Dawn's worker threads. The pipeline is
+ * stored in *pipeline once it is ready, which happens while the device is
+ * ticked at the start of a frame. Until then *pipeline keeps its value, so the
+ * caller either skips the draws using it (NULL) or keeps rendering with a
+ * fallback pipeline. A fallback pipeline is released when it gets replaced.
+ * @param pipeline has to stay valid until the request completed, see
+ * wgpu_wait_for_async_pipelines
+ */
+void wgpu_create_render_pipeline_async(
+  struct wgpu_context_t* wgpu_context,
+  const WGPURenderPipelineDescriptor* descriptor, WGPURenderPipeline* pipeline);
+
+/* Compute pipeline variant of wgpu_create_render_pipeline_async */
+void wgpu_create_compute_pipeline_async(
+  struct wgpu_context_t* wgpu_context,
+  const WGPUComputePipelineDescriptor* descriptor,
+  WGPUComputePipeline* pipeline);
+
+/* Returns true when no pipeline creation is pending */
+bool wgpu_async_pipelines_ready(struct wgpu_context_t* wgpu_context);
+
+/* Blocks until all pending pipeline creations completed */
+void wgpu_wait_for_async_pipelines(struct wgpu_context_t* wgpu_context);
+
+#endif
@@ -1,10 +1,50 @@
 #include "buffer.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "../core/macro.h"
 
+#include "buffer_heap.h"
 #include "context.h"
+#include "staging_belt.h"
+
+/* Sub-allocates the buffer from the heap, the heap owns the WebGPU buffer */
+static void wgpu_create_heap_buffer(wgpu_context_t* wgpu_context,
+                                    const wgpu_buffer_desc_t* desc,
+                                    wgpu_buffer_t* wgpu_buffer)
+{
+  ASSERT((wgpu_buffer_heap_get_usage(desc->heap) & desc->usage)
+         == desc->usage);
+
+  wgpu_buffer->allocation
+    = wgpu_buffer_heap_allocate(desc->heap, wgpu_buffer->size);
+  ASSERT(wgpu_buffer->allocation != NULL);
+  if (wgpu_buffer->allocation == NULL) {
+    return;
+  }
+  wgpu_buffer->buffer = wgpu_buffer->allocation->buffer;
+  wgpu_buffer->offset = wgpu_buffer->allocation->offset;
+
+  const uint32_t initial_size
+    = (desc->initial.size == 0) ? desc->size : desc->initial.size;
+  if (desc->initial.data && initial_size > 0 && initial_size <= desc->size) {
+    /* Queue writes have to be a multiple of 4 bytes */
+    const uint32_t write_size = (initial_size + 3) & ~3;
+    if (write_size == initial_size) {
+      wgpu_queue_write_buffer(wgpu_context, wgpu_buffer->buffer,
+                              wgpu_buffer->offset, desc->initial.data,
+                              write_size);
+    }
+    else {
+      void* padded = calloc(1, write_size);
+      memcpy(padded, desc->initial.data, initial_size);
+      wgpu_queue_write_buffer(wgpu_context, wgpu_buffer->buffer,
+                              wgpu_buffer->offset, padded, write_size);
+      free(padded);
+    }
+  }
+}
 
 wgpu_buffer_t wgpu_create_buffer(struct wgpu_context_t* wgpu_context,
                                  const wgpu_buffer_desc_t* desc)
@@ -18,6 +58,11 @@ wgpu_buffer_t wgpu_create_buffer(struct wgpu_context_t* wgpu_context,
     .count = desc->count,
   };
 
+  if (desc->heap != NULL) {
+    wgpu_create_heap_buffer(wgpu_context, desc, &wgpu_buffer);
+    return wgpu_buffer;
+  }
+
   WGPUBufferDescriptor buffer_desc = {
     .label            = desc->label,
     .usage            = desc->usage,
@@ -50,9 +95,28 @@ wgpu_buffer_t wgpu_create_buffer(struct wgpu_context_t* wgpu_context,
 void wgpu_destroy_buffer(wgpu_buffer_t* buffer)
 {
   ASSERT(buffer->buffer);
+  if (buffer->allocation != NULL) {
+    wgpu_buffer_heap_free(buffer->allocation);
+    buffer->allocation = NULL;
+    buffer->buffer     = NULL;
+    buffer->offset     = 0;
+    return;
+  }
   WGPU_RELEASE_RESOURCE(Buffer, buffer->buffer)
 }
 
+bool wgpu_buffer_update_location(wgpu_buffer_t* buffer)
+{
+  if (buffer->allocation == NULL
+      || (buffer->buffer == buffer->allocation->buffer
+          && buffer->offset == buffer->allocation->offset)) {
+    return false;
+  }
+  buffer->buffer = buffer->allocation->buffer;
+  buffer->offset = buffer->allocation->offset;
+  return true;
+}
+
 void wgpu_record_copy_data_to_buffer(struct wgpu_context_t* wgpu_context,
                                      wgpu_buffer_t* buff, uint32_t buff_offset,
                                      uint32_t buff_size, const void* data,
@@ -65,23 +129,11 @@ void wgpu_record_copy_data_to_buffer(struct wgpu_context_t* wgpu_context,
     && (buff->usage & (WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc)));*/
   ASSERT(buff_size % 4 == 0);
 
-  WGPUBufferDescriptor staging_buffer_desc = {
-    .usage            = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc,
-    .size             = buff_size,
-    .mappedAtCreation = true,
-  };
-
-  WGPUBuffer staging
-    = wgpuDeviceCreateBuffer(wgpu_context->device, &staging_buffer_desc);
-  ASSERT(staging != NULL);
-  void* mapping = wgpuBufferGetMappedRange(staging, 0, buff_size);
-  ASSERT(mapping != NULL);
-  memcpy(mapping, data, data_size);
-  wgpuBufferUnmap(staging);
-
-  wgpuCommandEncoderCopyBufferToBuffer(wgpu_context->cmd_enc, staging, 0,
-                                       buff->buffer, buff_offset, buff_size);
-  WGPU_RELEASE_RESOURCE(Buffer, staging);
+  /* Heap allocated buffers start at an offset into the shared heap page */
+  wgpu_staging_belt_write_buffer(wgpu_context->staging_belt,
+                                 wgpu_context->cmd_enc, buff->buffer,
+                                 buff->offset + buff_offset, buff_size, data,
+                                 data_size);
 }
 
 WGPUCommandBuffer wgpu_copy_buffer_to_texture(
@@ -1,12 +1,15 @@
 #ifndef BUFFER_H_
 #define BUFFER_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <dawn/webgpu.h>
 
 /* Forward declarations */
 struct wgpu_context_t;
+struct wgpu_buffer_heap_t;
+struct wgpu_buffer_heap_allocation_t;
 
 /* WebGPU buffer */
 typedef struct wgpu_buffer_desc_t {
@@ -18,6 +21,9 @@ typedef struct wgpu_buffer_desc_t {
     const void* data;
     uint32_t size;
   } initial;
+  /* Sub-allocate the buffer from the heap instead of creating a buffer
+   * (optional), the heap usage has to include the buffer usage */
+  struct wgpu_buffer_heap_t* heap;
 } wgpu_buffer_desc_t;
 
 typedef struct wgpu_buffer_t {
@@ -25,6 +31,8 @@ typedef struct wgpu_buffer_t {
   WGPUBufferUsage usage;
   uint32_t size;
   uint32_t count; /* numer of elements in the buffer (optional) */
+  uint64_t offset; /* offset into buffer, non-zero for heap allocations */
+  struct wgpu_buffer_heap_allocation_t* allocation;
 } wgpu_buffer_t;
 
 /* WebGPU buffer creating  / destroy */
@@ -33,8 +41,14 @@ wgpu_buffer_t wgpu_create_buffer(struct wgpu_context_t* wgpu_context,
 void wgpu_destroy_buffer(wgpu_buffer_t* buffer);
 
 /*
- * Copies data into buff.buffer via a temporary staging buffer, doesn't submit
- * the resulting command
+ * Refreshes buffer and offset of a heap allocated buffer after the heap was
+ * defragmented, returns true if the location changed
+ */
+bool wgpu_buffer_update_location(wgpu_buffer_t* buffer);
+
+/*
+ * Copies data into buff.buffer via the staging belt of the context, doesn't
+ * submit the resulting command
  */
 void wgpu_record_copy_data_to_buffer(struct wgpu_context_t* wgpu_context,
                                      wgpu_buffer_t* buff, uint32_t buff_offset,
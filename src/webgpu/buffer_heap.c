@@ -0,0 +1,524 @@
+#include "buffer_heap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/log.h"
+#include "../core/macro.h"
+
+#include "context.h"
+
+/* Unused range of a heap page */
+typedef struct free_block_t {
+  uint64_t offset;
+  uint64_t size;
+} free_block_t;
+
+/* Heap page, the free blocks are sorted by offset and never adjacent */
+typedef struct buffer_heap_page_t {
+  wgpu_buffer_heap_t* heap;
+  WGPUBuffer buffer;
+  uint64_t size;
+  uint64_t used;
+  bool dedicated; /* holds a single allocation larger than the page size */
+  struct {
+    free_block_t* data;
+    uint32_t count;
+    uint32_t capacity;
+  } free_blocks;
+  wgpu_buffer_heap_allocation_t* allocations;
+  uint32_t allocation_count;
+} buffer_heap_page_t;
+
+struct wgpu_buffer_heap_t {
+  wgpu_context_t* wgpu_context;
+  char label[STRMAX];
+  WGPUBufferUsage usage;
+  uint64_t page_size;
+  uint64_t alignment;
+  uint32_t generation; /* incremented when allocations moved */
+  struct {
+    buffer_heap_page_t** data;
+    uint32_t count;
+    uint32_t capacity;
+  } pages;
+};
+
+static uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/* Free block list */
+
+static void page_insert_free_block(buffer_heap_page_t* page, uint32_t index,
+                                   uint64_t offset, uint64_t size)
+{
+  if (page->free_blocks.count == page->free_blocks.capacity) {
+    page->free_blocks.capacity = MAX(page->free_blocks.capacity * 2, 8u);
+    page->free_blocks.data     = (free_block_t*)realloc(
+      page->free_blocks.data, page->free_blocks.capacity * sizeof(free_block_t));
+  }
+
+  free_block_t* blocks = page->free_blocks.data;
+  memmove(&blocks[index + 1], &blocks[index],
+          (page->free_blocks.count - index) * sizeof(free_block_t));
+  blocks[index] = (free_block_t){
+    .offset = offset,
+    .size   = size,
+  };
+  ++page->free_blocks.count;
+}
+
+static void page_remove_free_block(buffer_heap_page_t* page, uint32_t index)
+{
+  free_block_t* blocks = page->free_blocks.data;
+  memmove(&blocks[index], &blocks[index + 1],
+          (page->free_blocks.count - index - 1) * sizeof(free_block_t));
+  --page->free_blocks.count;
+}
+
+/* Pages */
+
+static buffer_heap_page_t* buffer_heap_create_page(wgpu_buffer_heap_t* heap,
+                                                   uint64_t size)
+{
+  /* Copy usages are needed for uploads and defragmentation */
+  WGPUBufferDescriptor buffer_desc = {
+    .label = heap->label,
+    .usage = heap->usage | WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst,
+    .size  = size,
+  };
+  WGPUBuffer buffer
+    = wgpuDeviceCreateBuffer(heap->wgpu_context->device, &buffer_desc);
+  if (buffer == NULL) {
+    log_error("Unable to create buffer heap page (%llu bytes)",
+              (unsigned long long)size);
+    return NULL;
+  }
+
+  buffer_heap_page_t* page
+    = (buffer_heap_page_t*)calloc(1, sizeof(buffer_heap_page_t));
+  page->heap      = heap;
+  page->buffer    = buffer;
+  page->size      = size;
+  page->dedicated = size > heap->page_size;
+  page_insert_free_block(page, 0, 0, size);
+
+  if (heap->pages.count == heap->pages.capacity) {
+    heap->pages.capacity = MAX(heap->pages.capacity * 2, 4u);
+    heap->pages.data     = (buffer_heap_page_t**)realloc(
+      heap->pages.data, heap->pages.capacity * sizeof(buffer_heap_page_t*));
+  }
+  heap->pages.data[heap->pages.count++] = page;
+
+  return page;
+}
+
+/* Releases the page, the page has to be removed from the page list before */
+static void buffer_heap_release_page(buffer_heap_page_t* page)
+{
+  wgpu_buffer_heap_allocation_t* allocation = page->allocations;
+  while (allocation != NULL) {
+    wgpu_buffer_heap_allocation_t* next = allocation->next;
+    free(allocation);
+    allocation = next;
+  }
+
+  WGPU_RELEASE_RESOURCE(Buffer, page->buffer)
+  free(page->free_blocks.data);
+  free(page);
+}
+
+static void buffer_heap_remove_page(wgpu_buffer_heap_t* heap,
+                                    buffer_heap_page_t* page)
+{
+  for (uint32_t i = 0; i < heap->pages.count; ++i) {
+    if (heap->pages.data[i] == page) {
+      memmove(&heap->pages.data[i], &heap->pages.data[i + 1],
+              (heap->pages.count - i - 1) * sizeof(buffer_heap_page_t*));
+      --heap->pages.count;
+      return;
+    }
+  }
+}
+
+static void page_link_allocation(buffer_heap_page_t* page,
+                                 wgpu_buffer_heap_allocation_t* allocation)
+{
+  allocation->buffer = page->buffer;
+  allocation->page   = page;
+  allocation->prev   = NULL;
+  allocation->next   = page->allocations;
+  if (page->allocations != NULL) {
+    page->allocations->prev = allocation;
+  }
+  page->allocations = allocation;
+  page->used += allocation->size;
+  ++page->allocation_count;
+}
+
+static void page_unlink_allocation(buffer_heap_page_t* page,
+                                   wgpu_buffer_heap_allocation_t* allocation)
+{
+  if (allocation->prev != NULL) {
+    allocation->prev->next = allocation->next;
+  }
+  else {
+    page->allocations = allocation->next;
+  }
+  if (allocation->next != NULL) {
+    allocation->next->prev = allocation->prev;
+  }
+  page->used -= allocation->size;
+  --page->allocation_count;
+}
+
+/* Buffer heap creating/releasing */
+
+wgpu_buffer_heap_t*
+wgpu_buffer_heap_create(struct wgpu_context_t* wgpu_context,
+                        const wgpu_buffer_heap_desc_t* desc)
+{
+  wgpu_buffer_heap_t* heap
+    = (wgpu_buffer_heap_t*)calloc(1, sizeof(wgpu_buffer_heap_t));
+  heap->wgpu_context = wgpu_context;
+  heap->usage        = desc->usage;
+  snprintf(heap->label, sizeof(heap->label), "%s",
+           desc->label ? desc->label : "Buffer heap page");
+
+  const bool binding
+    = (desc->usage & (WGPUBufferUsage_Uniform | WGPUBufferUsage_Storage)) != 0;
+  heap->alignment
+    = (desc->alignment > 0) ? MAX(desc->alignment, 4u) :
+                              (binding ? WGPU_BUFFER_HEAP_BINDING_ALIGNMENT : 4u);
+  ASSERT((heap->alignment & (heap->alignment - 1)) == 0);
+  heap->page_size = align_up(
+    (desc->page_size > 0) ? desc->page_size : WGPU_BUFFER_HEAP_PAGE_SIZE,
+    heap->alignment);
+
+  return heap;
+}
+
+void wgpu_buffer_heap_destroy(wgpu_buffer_heap_t* heap)
+{
+  if (heap == NULL) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < heap->pages.count; ++i) {
+    buffer_heap_release_page(heap->pages.data[i]);
+  }
+  free(heap->pages.data);
+  free(heap);
+}
+
+/* Allocation */
+
+wgpu_buffer_heap_allocation_t*
+wgpu_buffer_heap_allocate(wgpu_buffer_heap_t* heap, uint64_t size)
+{
+  size = align_up(MAX(size, 4u), 4u);
+
+  /* Best fit over the free blocks of all pages */
+  buffer_heap_page_t* best_page = NULL;
+  uint32_t best_block           = 0;
+  uint64_t best_offset = 0, best_waste = UINT64_MAX;
+  for (uint32_t i = 0; i < heap->pages.count && best_waste > 0; ++i) {
+    buffer_heap_page_t* page = heap->pages.data[i];
+    if (page->dedicated || page->size - page->used < size) {
+      continue;
+    }
+    for (uint32_t j = 0; j < page->free_blocks.count; ++j) {
+      const free_block_t* block = &page->free_blocks.data[j];
+      const uint64_t offset     = align_up(block->offset, heap->alignment);
+      if (offset + size > block->offset + block->size) {
+        continue;
+      }
+      const uint64_t waste = block->size - size;
+      if (waste < best_waste) {
+        best_page   = page;
+        best_block  = j;
+        best_offset = offset;
+        best_waste  = waste;
+        if (waste == 0) {
+          break;
+        }
+      }
+    }
+  }
+
+  if (best_page == NULL) {
+    best_page = buffer_heap_create_page(
+      heap, size > heap->page_size ? size : heap->page_size);
+    if (best_page == NULL) {
+      return NULL;
+    }
+    best_block  = 0;
+    best_offset = 0;
+  }
+
+  /* Split the free block, keeping the alignment padding and the tail free */
+  const free_block_t block = best_page->free_blocks.data[best_block];
+  const uint64_t head      = best_offset - block.offset;
+  const uint64_t tail      = block.offset + block.size - (best_offset + size);
+  page_remove_free_block(best_page, best_block);
+  if (tail > 0) {
+    page_insert_free_block(best_page, best_block, best_offset + size, tail);
+  }
+  if (head > 0) {
+    page_insert_free_block(best_page, best_block, block.offset, head);
+  }
+
+  wgpu_buffer_heap_allocation_t* allocation
+    = (wgpu_buffer_heap_allocation_t*)calloc(
+      1, sizeof(wgpu_buffer_heap_allocation_t));
+  allocation->offset = best_offset;
+  allocation->size   = size;
+  page_link_allocation(best_page, allocation);
+
+  return allocation;
+}
+
+void wgpu_buffer_heap_free(wgpu_buffer_heap_allocation_t* allocation)
+{
+  if (allocation == NULL) {
+    return;
+  }
+
+  buffer_heap_page_t* page = allocation->page;
+  page_unlink_allocation(page, allocation);
+
+  uint64_t offset = allocation->offset;
+  uint64_t size   = allocation->size;
+  free(allocation);
+
+  if (page->dedicated) {
+    buffer_heap_remove_page(page->heap, page);
+    WGPU_DEFER_RELEASE(page->heap->wgpu_context, Buffer, page->buffer)
+    buffer_heap_release_page(page);
+    return;
+  }
+
+  /* Insert the range sorted by offset and merge it with its neighbors */
+  free_block_t* blocks = page->free_blocks.data;
+  uint32_t lo = 0, hi = page->free_blocks.count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (blocks[mid].offset < offset) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  if (lo < page->free_blocks.count && offset + size == blocks[lo].offset) {
+    size += blocks[lo].size;
+    page_remove_free_block(page, lo);
+  }
+  if (lo > 0 && blocks[lo - 1].offset + blocks[lo - 1].size == offset) {
+    blocks[lo - 1].size += size;
+  }
+  else {
+    page_insert_free_block(page, lo, offset, size);
+  }
+}
+
+/* Defragmentation */
+
+static int compare_allocation_offsets(const void* a, const void* b)
+{
+  const wgpu_buffer_heap_allocation_t* aa
+    = *(wgpu_buffer_heap_allocation_t* const*)a;
+  const wgpu_buffer_heap_allocation_t* ab
+    = *(wgpu_buffer_heap_allocation_t* const*)b;
+  return (aa->offset > ab->offset) - (aa->offset < ab->offset);
+}
+
+/* Plans the linear packing of the allocations into new pages, keeping their
+ * order. Returns the number of pages needed. */
+static uint32_t buffer_heap_plan_packing(
+  const wgpu_buffer_heap_t* heap, wgpu_buffer_heap_allocation_t** allocations,
+  uint32_t count, uint32_t* page_indices, uint64_t* offsets)
+{
+  uint32_t page_count = 0;
+  uint64_t end        = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint64_t offset = align_up(end, heap->alignment);
+    if (page_count == 0 || offset + allocations[i]->size > heap->page_size) {
+      ++page_count;
+      offset = 0;
+    }
+    page_indices[i] = page_count - 1;
+    offsets[i]      = offset;
+    end             = offset + allocations[i]->size;
+  }
+  return page_count;
+}
+
+/* Appends the range to the free list of a page that is filled from the start,
+ * so the list stays sorted by offset */
+static void page_append_free_block(buffer_heap_page_t* page, uint64_t offset,
+                                   uint64_t size)
+{
+  if (size > 0) {
+    page_insert_free_block(page, page->free_blocks.count, offset, size);
+  }
+}
+
+uint32_t wgpu_buffer_heap_defragment(wgpu_buffer_heap_t* heap)
+{
+  /* Collect the allocations of the regular pages, dedicated pages stay */
+  uint32_t old_page_count = 0, count = 0;
+  for (uint32_t i = 0; i < heap->pages.count; ++i) {
+    const buffer_heap_page_t* page = heap->pages.data[i];
+    if (!page->dedicated) {
+      ++old_page_count;
+      count += page->allocation_count;
+    }
+  }
+  if (old_page_count < 2) {
+    return 0;
+  }
+
+  buffer_heap_page_t** old_pages
+    = (buffer_heap_page_t**)malloc(old_page_count * sizeof(*old_pages));
+  wgpu_buffer_heap_allocation_t** allocations
+    = (wgpu_buffer_heap_allocation_t**)malloc(MAX(count, 1u) * sizeof(void*));
+  uint32_t* page_indices = (uint32_t*)malloc(MAX(count, 1u) * sizeof(uint32_t));
+  uint64_t* offsets      = (uint64_t*)malloc(MAX(count, 1u) * sizeof(uint64_t));
+  old_page_count         = 0;
+  count                  = 0;
+  for (uint32_t i = 0; i < heap->pages.count; ++i) {
+    buffer_heap_page_t* page = heap->pages.data[i];
+    if (page->dedicated) {
+      continue;
+    }
+    old_pages[old_page_count++] = page;
+    const uint32_t first        = count;
+    for (wgpu_buffer_heap_allocation_t* a = page->allocations; a != NULL;
+         a                                = a->next) {
+      allocations[count++] = a;
+    }
+    qsort(allocations + first, count - first, sizeof(*allocations),
+          compare_allocation_offsets);
+  }
+
+  /* Only compact if it frees at least one page */
+  const uint32_t new_page_count = buffer_heap_plan_packing(
+    heap, allocations, count, page_indices, offsets);
+  buffer_heap_page_t** new_pages = NULL;
+  if (new_page_count < old_page_count) {
+    new_pages = (buffer_heap_page_t**)calloc(MAX(new_page_count, 1u),
+                                             sizeof(*new_pages));
+    for (uint32_t i = 0; i < new_page_count; ++i) {
+      new_pages[i] = buffer_heap_create_page(heap, heap->page_size);
+      if (new_pages[i] == NULL) {
+        for (uint32_t j = 0; j < i; ++j) {
+          buffer_heap_remove_page(heap, new_pages[j]);
+          buffer_heap_release_page(new_pages[j]);
+        }
+        free(new_pages);
+        new_pages = NULL;
+        break;
+      }
+      new_pages[i]->free_blocks.count = 0;
+    }
+  }
+  if (new_pages == NULL) {
+    free(old_pages);
+    free(allocations);
+    free(page_indices);
+    free(offsets);
+    return 0;
+  }
+
+  /* The copies are ordered after the writes already recorded into the frame
+   * encoder, outside of a frame they are submitted right away */
+  wgpu_context_t* wgpu_context = heap->wgpu_context;
+  WGPUCommandEncoder cmd_encoder
+    = wgpu_context->cmd_enc ?
+        wgpu_context->cmd_enc :
+        wgpuDeviceCreateCommandEncoder(wgpu_context->device, NULL);
+
+  uint64_t end = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    wgpu_buffer_heap_allocation_t* allocation = allocations[i];
+    buffer_heap_page_t* target                = new_pages[page_indices[i]];
+    if (i > 0 && page_indices[i] != page_indices[i - 1]) {
+      buffer_heap_page_t* prev = new_pages[page_indices[i - 1]];
+      page_append_free_block(prev, end, prev->size - end);
+      end = 0;
+    }
+    /* Alignment padding between packed allocations stays allocatable */
+    page_append_free_block(target, end, offsets[i] - end);
+
+    wgpuCommandEncoderCopyBufferToBuffer(cmd_encoder, allocation->page->buffer,
+                                         allocation->offset, target->buffer,
+                                         offsets[i], allocation->size);
+    page_unlink_allocation(allocation->page, allocation);
+    allocation->offset = offsets[i];
+    page_link_allocation(target, allocation);
+    end = offsets[i] + allocation->size;
+  }
+  if (new_page_count > 0) {
+    buffer_heap_page_t* last = new_pages[new_page_count - 1];
+    page_append_free_block(last, end, last->size - end);
+  }
+
+  if (cmd_encoder != wgpu_context->cmd_enc) {
+    WGPUCommandBuffer command_buffer
+      = wgpuCommandEncoderFinish(cmd_encoder, NULL);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
+    wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
+  }
+
+  /* The copies out of the old pages are still pending on the GPU */
+  for (uint32_t i = 0; i < old_page_count; ++i) {
+    buffer_heap_remove_page(heap, old_pages[i]);
+    WGPU_DEFER_RELEASE(wgpu_context, Buffer, old_pages[i]->buffer)
+    buffer_heap_release_page(old_pages[i]);
+  }
+  free(old_pages);
+  free(new_pages);
+  free(allocations);
+  free(page_indices);
+  free(offsets);
+
+  if (count > 0) {
+    ++heap->generation;
+  }
+  return count;
+}
+
+/* Buffer heap info */
+
+uint32_t wgpu_buffer_heap_get_generation(wgpu_buffer_heap_t* heap)
+{
+  return heap->generation;
+}
+
+WGPUBufferUsage wgpu_buffer_heap_get_usage(wgpu_buffer_heap_t* heap)
+{
+  return heap->usage;
+}
+
+void wgpu_buffer_heap_get_stats(wgpu_buffer_heap_t* heap,
+                                wgpu_buffer_heap_stats_t* stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  stats->page_count = heap->pages.count;
+  for (uint32_t i = 0; i < heap->pages.count; ++i) {
+    const buffer_heap_page_t* page = heap->pages.data[i];
+    stats->allocation_count += page->allocation_count;
+    stats->free_block_count += page->free_blocks.count;
+    stats->total_size += page->size;
+    stats->used_size += page->used;
+    for (uint32_t j = 0; j < page->free_blocks.count; ++j) {
+      const uint64_t size = page->free_blocks.data[j].size;
+      stats->free_size += size;
+      stats->largest_free_block = MAX(stats->largest_free_block, size);
+    }
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef BUFFER_HEAP_H
+#define BUFFER_HEAP_H
+
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+/* Default size of the heap pages, larger allocations get a dedicated page */
+#define WGPU_BUFFER_HEAP_PAGE_SIZE (4u * 1024u * 1024u)
+/* Offset alignment of uniform and storage buffer bindings */
+#define WGPU_BUFFER_HEAP_BINDING_ALIGNMENT 256u
+
+/* Forward declarations */
+struct wgpu_context_t;
+struct buffer_heap_page_t;
+
+typedef struct wgpu_buffer_heap_t wgpu_buffer_heap_t;
+
+typedef struct wgpu_buffer_heap_desc_t {
+  const char* label;
+  WGPUBufferUsage usage;
+  uint64_t page_size; /* defaults to WGPU_BUFFER_HEAP_PAGE_SIZE */
+  uint64_t alignment; /* defaults to 256 for uniform / storage, else 4 */
+} wgpu_buffer_heap_desc_t;
+
+/* Sub-allocation, buffer and offset change when the heap is defragmented */
+typedef struct wgpu_buffer_heap_allocation_t {
+  WGPUBuffer buffer;
+  uint64_t offset;
+  uint64_t size;
+  /* Internal */
+  struct buffer_heap_page_t* page;
+  struct wgpu_buffer_heap_allocation_t* prev;
+  struct wgpu_buffer_heap_allocation_t* next;
+} wgpu_buffer_heap_allocation_t;
+
+typedef struct wgpu_buffer_heap_stats_t {
+  uint32_t page_count;
+  uint32_t allocation_count;
+  uint32_t free_block_count;
+  uint64_t total_size;
+  uint64_t used_size; /* bytes of the live allocations */
+  uint64_t free_size; /* including the alignment padding between allocations */
+  uint64_t largest_free_block;
+} wgpu_buffer_heap_stats_t;
+
+/* Buffer heap creating/releasing */
+wgpu_buffer_heap_t*
+wgpu_buffer_heap_create(struct wgpu_context_t* wgpu_context,
+                        const wgpu_buffer_heap_desc_t* desc);
+void wgpu_buffer_heap_destroy(wgpu_buffer_heap_t* heap);
+
+/**
+ * @brief Sub-allocates a range of one of the heap pages (best fit).
+ * @param size the allocation size, rounded up to a multiple of 4
+ * @return the allocation or NULL if no page could be created
+ */
+wgpu_buffer_heap_allocation_t*
+wgpu_buffer_heap_allocate(wgpu_buffer_heap_t* heap, uint64_t size);
+void wgpu_buffer_heap_free(wgpu_buffer_heap_allocation_t* allocation);
+
+/**
+ * @brief Compacts the live allocations into as few pages as possible. The data
+ * is moved with buffer copies, recorded into the frame encoder when one is
+ * open and submitted right away otherwise. Bind groups referencing moved
+ * allocations have to be recreated.
+ * @return number of moved allocations
+ */
+uint32_t wgpu_buffer_heap_defragment(wgpu_buffer_heap_t* heap);
+
+/**
+ * @brief Returns a counter that is incremented each time allocations moved.
+ */
+uint32_t wgpu_buffer_heap_get_generation(wgpu_buffer_heap_t* heap);
+
+WGPUBufferUsage wgpu_buffer_heap_get_usage(wgpu_buffer_heap_t* heap);
+
+void wgpu_buffer_heap_get_stats(wgpu_buffer_heap_t* heap,
+                                wgpu_buffer_heap_stats_t* stats);
+
+#endif
@@ -1,16 +1,150 @@
 #include "context.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../core/log.h"
 #include "../core/macro.h"
+#include "../core/platform.h"
+#include "../core/trace.h"
 #include "../core/window.h"
 
+#include "../webgpu/asset_loader.h"
+#include "../webgpu/async_pipeline.h"
+#include "../webgpu/gpu_profiler.h"
+#include "../webgpu/pipeline_cache.h"
+#include "../webgpu/shader.h"
+#include "../webgpu/staging_belt.h"
 #include "../webgpu/texture.h"
+#include "../webgpu/write_batcher.h"
 
 #include "../../lib/wgpu_native/wgpu_native.h"
 
+/* Forward declarations */
+static void wgpu_release_deferred(wgpu_context_t* wgpu_context,
+                                  uint64_t serial);
+
+/* Dawn configuration defaults, release builds trade validation for speed */
+#ifdef NDEBUG
+#define WGPU_DEFAULT_VALIDATION "off"
+#define WGPU_DEFAULT_TOGGLES "skip_validation"
+#else
+#define WGPU_DEFAULT_VALIDATION "full"
+#define WGPU_DEFAULT_TOGGLES ""
+#endif
+
+/* Resolves the Dawn configuration: create option, environment, default.
+ * Returns false if the adapter filter is invalid. */
+static bool wgpu_configure_dawn(wgpu_context_t* wgpu_context,
+                                wgpu_context_create_options_t* options)
+{
+  const char* validation = options ? options->validation : NULL;
+  const char* toggles    = options ? options->toggles : NULL;
+  validation = validation ? validation : getenv("WGPU_VALIDATION");
+  validation = validation ? validation : WGPU_DEFAULT_VALIDATION;
+  toggles    = toggles ? toggles : getenv("WGPU_TOGGLES");
+  toggles    = toggles ? toggles : WGPU_DEFAULT_TOGGLES;
+
+  static const struct {
+    const char* name;
+    wgpu_backend_validation_level_enum level;
+  } validation_levels[3] = {
+    {"off", BackendValidationLevel_Off},
+    {"partial", BackendValidationLevel_Partial},
+    {"full", BackendValidationLevel_Full},
+  };
+  uint32_t level = 0;
+  while (level < ARRAY_SIZE(validation_levels)
+         && strcmp(validation, validation_levels[level].name) != 0) {
+    ++level;
+  }
+  if (level == ARRAY_SIZE(validation_levels)) {
+    log_warn("Unknown validation level \"%s\", using \"%s\"", validation,
+             WGPU_DEFAULT_VALIDATION);
+    validation = WGPU_DEFAULT_VALIDATION;
+    level      = 0;
+    while (strcmp(validation, validation_levels[level].name) != 0) {
+      ++level;
+    }
+  }
+  wgpu_set_backend_validation_level(validation_levels[level].level);
+
+  /* The level is fixed once the Dawn instance exists */
+  const wgpu_backend_validation_level_enum active_level
+    = wgpu_get_backend_validation_level();
+  for (uint32_t i = 0; i < ARRAY_SIZE(validation_levels); ++i) {
+    if (validation_levels[i].level == active_level) {
+      wgpu_context->dawn_config.validation = validation_levels[i].name;
+    }
+  }
+  snprintf(wgpu_context->dawn_config.toggles,
+           sizeof(wgpu_context->dawn_config.toggles), "%s", toggles);
+
+  /* Adapter selection, an invalid filter fails the context creation */
+  wgpu_adapter_filter_t adapter_filter = {
+    .backend = options ? options->adapter_backend : NULL,
+    .type    = options ? options->adapter_type : NULL,
+    .name    = options ? options->adapter_name : NULL,
+  };
+  adapter_filter.backend = adapter_filter.backend ?
+                             adapter_filter.backend :
+                             getenv("WGPU_ADAPTER_BACKEND");
+  adapter_filter.type
+    = adapter_filter.type ? adapter_filter.type : getenv("WGPU_ADAPTER_TYPE");
+  adapter_filter.name
+    = adapter_filter.name ? adapter_filter.name : getenv("WGPU_ADAPTER_NAME");
+  if (!wgpu_set_adapter_filter(&adapter_filter)) {
+    log_error("Invalid adapter filter (backend: %s, type: %s, name: %s)",
+              adapter_filter.backend ? adapter_filter.backend : "any",
+              adapter_filter.type ? adapter_filter.type : "any",
+              adapter_filter.name ? adapter_filter.name : "any");
+    wgpu_log_available_adapters();
+    return false;
+  }
+
+  return true;
+}
+
+/* Resolves the texture compression: create option, environment, "off" */
+static void
+wgpu_configure_texture_compression(wgpu_context_t* wgpu_context,
+                                   wgpu_context_create_options_t* options)
+{
+  const char* mode = options ? options->texture_compression : NULL;
+  mode             = mode ? mode : getenv("WGPU_TEXTURE_COMPRESSION");
+  mode             = mode ? mode : "off";
+
+  static const struct {
+    const char* name;
+    wgpu_texture_compression_enum mode;
+  } compression_modes[5] = {
+    {"off", TextureCompression_Off}, {"bc1", TextureCompression_BC1},
+    {"bc3", TextureCompression_BC3}, {"bc7", TextureCompression_BC7},
+    {"auto", TextureCompression_Auto},
+  };
+  wgpu_context->texture_compression.mode = TextureCompression_Off;
+  uint32_t i                             = 0;
+  while (i < ARRAY_SIZE(compression_modes)
+         && strcmp(mode, compression_modes[i].name) != 0) {
+    ++i;
+  }
+  if (i < ARRAY_SIZE(compression_modes)) {
+    wgpu_context->texture_compression.mode = compression_modes[i].mode;
+  }
+  else {
+    log_warn("Unknown texture compression \"%s\", using \"off\"", mode);
+  }
+
+  wgpu_context->texture_compression.bc7_quality
+    = options ? options->bc7_quality : 0;
+  if (options && options->texture_cache_dir != NULL) {
+    snprintf(wgpu_context->texture_compression.cache_dir,
+             sizeof(wgpu_context->texture_compression.cache_dir), "%s",
+             options->texture_cache_dir);
+  }
+}
+
 /* WebGPU context creating/releasing */
 wgpu_context_t* wgpu_context_create(wgpu_context_create_options_t* options)
 {
@@ -21,19 +155,76 @@ wgpu_context_t* wgpu_context_create(wgpu_context_create_options_t* options)
     = options ?
         (options->vsync ? WGPUPresentMode_Fifo : WGPUPresentMode_Mailbox) :
         WGPUPresentMode_Mailbox;
+  context->offscreen.enabled = options ? options->offscreen : false;
+  context->frames.count
+    = (options && options->frames_in_flight > 0) ?
+        MIN(options->frames_in_flight, WGPU_MAX_FRAMES_IN_FLIGHT) :
+        WGPU_DEFAULT_FRAMES_IN_FLIGHT;
+  context->queue_writes.enabled = options ? options->batch_queue_writes : false;
+  if (!wgpu_configure_dawn(context, options)) {
+    free(context);
+    return NULL;
+  }
+  wgpu_configure_texture_compression(context, options);
+
+  /* Dawn shares the trace clock, its CPU events are recorded while tracing */
+  wgpu_set_trace_callbacks(&(wgpu_trace_callbacks_t){
+    .get_time_ns     = platform_get_time_ns,
+    .record_span     = trace_is_enabled() ? trace_record_span : NULL,
+    .set_thread_name = trace_set_thread_name,
+  });
+
+  /* Translated shaders and pipeline caches persist across launches */
+  if (options && options->blob_cache_dir != NULL) {
+    wgpu_enable_blob_cache(options->blob_cache_dir,
+                           WGPU_BLOB_CACHE_DEFAULT_MAX_SIZE);
+  }
 
   return context;
 }
 
 void wgpu_context_release(wgpu_context_t* wgpu_context)
 {
+  /* Asset jobs still in flight decode with the texture client */
+  wgpu_wait_for_idle(wgpu_context);
   if (wgpu_context->texture_client != NULL) {
     wgpu_texture_client_destroy(wgpu_context->texture_client);
     wgpu_context->texture_client = NULL;
   }
+  wgpu_release_deferred(wgpu_context, UINT64_MAX);
+  free(wgpu_context->deferred_release.entries);
+  wgpu_context->deferred_release.entries = NULL;
+  if (wgpu_context->profiler != NULL) {
+    gpu_profiler_destroy(wgpu_context->profiler);
+    wgpu_context->profiler = NULL;
+  }
+  if (wgpu_context->staging_belt != NULL) {
+    wgpu_staging_belt_destroy(wgpu_context->staging_belt);
+    wgpu_context->staging_belt = NULL;
+  }
+  if (wgpu_context->queue_writes.batcher != NULL) {
+    wgpu_write_batcher_destroy(wgpu_context->queue_writes.batcher);
+    wgpu_context->queue_writes.batcher = NULL;
+  }
+  if (wgpu_context->pipeline_cache != NULL) {
+    wgpu_pipeline_cache_destroy(wgpu_context->pipeline_cache);
+    wgpu_context->pipeline_cache = NULL;
+  }
+  if (wgpu_context->shader_cache != NULL) {
+    wgpu_shader_cache_destroy(wgpu_context->shader_cache);
+    wgpu_context->shader_cache = NULL;
+  }
+  for (uint32_t i = 0; i < wgpu_context->frames.count; ++i) {
+    wgpu_frame_context_t* frame = &wgpu_context->frames.slots[i];
+    WGPU_RELEASE_RESOURCE(Buffer, frame->uniform.buffer);
+    free(frame->uniform.data);
+    frame->uniform.data = NULL;
+  }
 
   WGPU_RELEASE_RESOURCE(TextureView, wgpu_context->depth_stencil.texture_view);
   WGPU_RELEASE_RESOURCE(Texture, wgpu_context->depth_stencil.texture);
+  WGPU_RELEASE_RESOURCE(TextureView, wgpu_context->offscreen.texture_view);
+  WGPU_RELEASE_RESOURCE(Texture, wgpu_context->offscreen.texture);
   WGPU_RELEASE_RESOURCE(SwapChain, wgpu_context->swap_chain.instance);
   WGPU_RELEASE_RESOURCE(Queue, wgpu_context->queue);
   WGPU_RELEASE_RESOURCE(Device, wgpu_context->device);
@@ -62,26 +253,79 @@ WGPUBuffer wgpu_create_buffer_from_data(wgpu_context_t* wgpu_context,
   return buffer;
 }
 
-void wgpu_create_device_and_queue(wgpu_context_t* wgpu_context)
+bool wgpu_create_device_and_queue(wgpu_context_t* wgpu_context)
 {
   wgpu_log_available_adapters();
 
-  /* WebGPU adapter creation */
-  wgpu_context->adapter = wgpu_request_adapter(&(WGPURequestAdapterOptions){
+  /* WebGPU adapter creation, headless runs prefer the Null or CPU adapter */
+  WGPURequestAdapterOptions adapter_options = {
     .powerPreference = WGPUPowerPreference_HighPerformance,
-  });
+  };
+  if (wgpu_context->offscreen.enabled) {
+    adapter_options.forceFallbackAdapter = true;
+  }
+  wgpu_context->adapter = wgpu_request_adapter(&adapter_options);
+  if (wgpu_context->adapter == NULL) {
+    log_error("No suitable adapter found, see the available adapters above");
+    return false;
+  }
 
   /* WebGPU device creation */
-  WGPUFeatureName required_features[2] = {
+  WGPUFeatureName required_features[5] = {
     WGPUFeatureName_TextureCompressionBC,
     WGPUFeatureName_BGRA8UnormStorage,
   };
+  uint32_t required_feature_count = 2;
+  /* Optional features, ETC2 and ASTC textures are uploaded in their own format
+   * when supported */
+  static const WGPUFeatureName optional_features[3] = {
+    WGPUFeatureName_TimestampQuery,
+    WGPUFeatureName_TextureCompressionETC2,
+    WGPUFeatureName_TextureCompressionASTC,
+  };
+  for (uint32_t i = 0; i < (uint32_t)ARRAY_SIZE(optional_features); ++i) {
+    if (wgpuAdapterHasFeature(wgpu_context->adapter, optional_features[i])) {
+      required_features[required_feature_count++] = optional_features[i];
+    }
+  }
+  /* Dawn device toggles, a leading '-' disables the toggle */
+  char toggles[sizeof(wgpu_context->dawn_config.toggles)];
+  const char* enabled_toggles[WGPU_MAX_DEVICE_TOGGLES];
+  const char* disabled_toggles[WGPU_MAX_DEVICE_TOGGLES];
+  size_t enabled_toggle_count = 0, disabled_toggle_count = 0;
+  snprintf(toggles, sizeof(toggles), "%s", wgpu_context->dawn_config.toggles);
+  for (char* toggle = strtok(toggles, ", "); toggle != NULL;
+       toggle       = strtok(NULL, ", ")) {
+    if (toggle[0] == '-' && disabled_toggle_count < WGPU_MAX_DEVICE_TOGGLES) {
+      disabled_toggles[disabled_toggle_count++] = toggle + 1;
+    }
+    else if (toggle[0] != '-'
+             && enabled_toggle_count < WGPU_MAX_DEVICE_TOGGLES) {
+      enabled_toggles[enabled_toggle_count++] = toggle;
+    }
+  }
+  WGPUDawnTogglesDescriptor toggles_desc = {
+    .chain.sType          = WGPUSType_DawnTogglesDescriptor,
+    .enabledTogglesCount  = enabled_toggle_count,
+    .enabledToggles       = enabled_toggles,
+    .disabledTogglesCount = disabled_toggle_count,
+    .disabledToggles      = disabled_toggles,
+  };
+
   WGPUDeviceDescriptor deviceDescriptor = {
-    .requiredFeatureCount = (uint32_t)ARRAY_SIZE(required_features),
+    .nextInChain = (enabled_toggle_count + disabled_toggle_count > 0) ?
+                     &toggles_desc.chain :
+                     NULL,
+    .requiredFeatureCount = required_feature_count,
     .requiredFeatures     = required_features,
   };
   wgpu_context->device
     = wgpuAdapterCreateDevice(wgpu_context->adapter, &deviceDescriptor);
+  log_info("Backend validation: %s, device toggles: %s",
+           wgpu_context->dawn_config.validation,
+           wgpu_context->dawn_config.toggles[0] != '\0' ?
+             wgpu_context->dawn_config.toggles :
+             "none");
   wgpuDeviceSetUncapturedErrorCallback(
     wgpu_context->device, &wgpu_error_callback, (void*)wgpu_context);
 
@@ -107,6 +351,23 @@ void wgpu_create_device_and_queue(wgpu_context_t* wgpu_context)
 
   /* Get the default queue from the device */
   wgpu_context->queue = wgpuDeviceGetQueue(wgpu_context->device);
+
+  /* Staging memory for buffer and texture uploads */
+  wgpu_context->staging_belt
+    = wgpu_staging_belt_create(wgpu_context, WGPU_STAGING_BELT_CHUNK_SIZE);
+
+  /* Shader modules with identical sources are shared */
+  wgpu_context->shader_cache = wgpu_shader_cache_create();
+
+  /* Render pipelines with identical descriptors are shared */
+  wgpu_context->pipeline_cache = wgpu_pipeline_cache_create(wgpu_context);
+
+  /* Queue writes are collected until the next submission */
+  if (wgpu_context->queue_writes.enabled) {
+    wgpu_context->queue_writes.batcher = wgpu_write_batcher_create(wgpu_context);
+  }
+
+  return true;
 }
 
 bool wgpu_has_feature(wgpu_context_t* wgpu_context,
@@ -210,6 +471,40 @@ void wgpu_setup_swap_chain(wgpu_context_t* wgpu_context)
   wgpu_context->swap_chain.format = swap_chain_descriptor.format;
 }
 
+void wgpu_setup_offscreen_target(wgpu_context_t* wgpu_context, uint32_t width,
+                                 uint32_t height)
+{
+  wgpu_context->surface.width  = width;
+  wgpu_context->surface.height = height;
+
+  /* Use the swap chain format so that example pipelines remain compatible */
+  WGPUTextureDescriptor color_texture_desc = {
+    .label         = "Offscreen color target",
+    .usage         = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc
+             | WGPUTextureUsage_TextureBinding,
+    .format        = WGPUTextureFormat_BGRA8Unorm,
+    .dimension     = WGPUTextureDimension_2D,
+    .mipLevelCount = 1,
+    .sampleCount   = 1,
+    .size          = (WGPUExtent3D) {
+      .width               = width,
+      .height              = height,
+      .depthOrArrayLayers  = 1,
+     },
+  };
+  WGPU_RELEASE_RESOURCE(TextureView, wgpu_context->offscreen.texture_view);
+  WGPU_RELEASE_RESOURCE(Texture, wgpu_context->offscreen.texture);
+  wgpu_context->offscreen.texture
+    = wgpuDeviceCreateTexture(wgpu_context->device, &color_texture_desc);
+  ASSERT(wgpu_context->offscreen.texture);
+
+  wgpu_context->offscreen.texture_view
+    = wgpuTextureCreateView(wgpu_context->offscreen.texture, NULL);
+  ASSERT(wgpu_context->offscreen.texture_view);
+
+  wgpu_context->swap_chain.format = color_texture_desc.format;
+}
+
 void wgpu_error_callback(WGPUErrorType error_type, char const* message,
                          void* userdata)
 {
@@ -236,14 +531,280 @@ void wgpu_error_callback(WGPUErrorType error_type, char const* message,
   log_error("Error(%d) %s: %s", (int)error_type, error_type_name, message);
 }
 
+/* Frames in flight */
+void wgpu_setup_frames(wgpu_context_t* wgpu_context)
+{
+  for (uint32_t i = 0; i < wgpu_context->frames.count; ++i) {
+    wgpu_frame_context_t* frame = &wgpu_context->frames.slots[i];
+    frame->wgpu_context         = wgpu_context;
+    frame->index                = i;
+    frame->begin_serial         = 0;
+    frame->in_flight            = false;
+    frame->uniform.size         = WGPU_FRAME_UNIFORM_BUFFER_SIZE;
+    frame->uniform.used         = 0;
+    frame->uniform.flushed      = 0;
+    frame->uniform.buffer       = wgpuDeviceCreateBuffer(
+      wgpu_context->device, &(WGPUBufferDescriptor){
+                              .label = "Frame uniform buffer",
+                              .usage = WGPUBufferUsage_Uniform
+                                       | WGPUBufferUsage_CopyDst,
+                              .size  = frame->uniform.size,
+                            });
+    ASSERT(frame->uniform.buffer != NULL);
+    frame->uniform.data = (uint8_t*)calloc(1, frame->uniform.size);
+  }
+  wgpu_context->frames.index = 0;
+}
+
+static void wgpu_frame_work_done_callback(WGPUQueueWorkDoneStatus status,
+                                          void* userdata)
+{
+  UNUSED_VAR(status);
+
+  /* The completed serial is advanced by the callback of each submission */
+  wgpu_frame_context_t* frame = (wgpu_frame_context_t*)userdata;
+  frame->in_flight            = false;
+}
+
+/* Waits until the GPU finished the previous frame that used the next slot */
+wgpu_frame_context_t* wgpu_frame_begin(wgpu_context_t* wgpu_context)
+{
+  wgpu_frame_context_t* frame
+    = &wgpu_context->frames.slots[wgpu_context->frames.index];
+
+  /* Process pending queue callbacks, block only if the slot is still busy */
+  wgpuDeviceTick(wgpu_context->device);
+  while (frame->in_flight) {
+    wgpuDeviceTick(wgpu_context->device);
+  }
+  wgpu_release_completed_resources(wgpu_context);
+
+  /* Upload the assets decoded by the worker threads since the last frame */
+  wgpu_process_async_assets(wgpu_context);
+
+  frame->begin_serial    = wgpu_context->serial.submitted;
+  frame->uniform.used    = 0;
+  frame->uniform.flushed = 0;
+  return frame;
+}
+
+/* Tracks completion of all work submitted for this frame */
+void wgpu_frame_end(wgpu_context_t* wgpu_context)
+{
+  wgpu_frame_context_t* frame = wgpu_get_current_frame(wgpu_context);
+  if (frame->wgpu_context == NULL) {
+    return; /* frames not set up */
+  }
+
+  /* A frame without submissions has no GPU work to wait for */
+  if (wgpu_context->serial.submitted > frame->begin_serial) {
+    frame->in_flight = true;
+    wgpuQueueOnSubmittedWorkDone(wgpu_context->queue, 0,
+                                 wgpu_frame_work_done_callback, frame);
+  }
+
+  wgpu_context->frames.index
+    = (wgpu_context->frames.index + 1) % wgpu_context->frames.count;
+}
+
+wgpu_frame_context_t* wgpu_get_current_frame(wgpu_context_t* wgpu_context)
+{
+  return &wgpu_context->frames.slots[wgpu_context->frames.index];
+}
+
+/* Deferred release queue */
+void wgpu_defer_release(wgpu_context_t* wgpu_context,
+                        wgpu_release_type_enum type, void* object)
+{
+  if (object == NULL) {
+    return;
+  }
+
+  wgpu_deferred_release_queue_t* queue = &wgpu_context->deferred_release;
+  if (queue->count == queue->capacity) {
+    /* Drop the released entries before growing */
+    if (queue->head > 0) {
+      memmove(queue->entries, queue->entries + queue->head,
+              (queue->count - queue->head) * sizeof(wgpu_deferred_release_t));
+      queue->count -= queue->head;
+      queue->head = 0;
+    }
+    if (queue->count == queue->capacity) {
+      queue->capacity = MAX(queue->capacity * 2, 64u);
+      queue->entries  = (wgpu_deferred_release_t*)realloc(
+        queue->entries, queue->capacity * sizeof(wgpu_deferred_release_t));
+    }
+  }
+
+  /* The object may be used by the next submission, which is recorded now */
+  queue->entries[queue->count++] = (wgpu_deferred_release_t){
+    .type   = type,
+    .object = object,
+    .serial = wgpu_context->serial.submitted + 1,
+  };
+}
+
+static void wgpu_release_object(wgpu_release_type_enum type, void* object)
+{
+  switch (type) {
+    case ReleaseType_BindGroup:
+      wgpuBindGroupRelease((WGPUBindGroup)object);
+      break;
+    case ReleaseType_Buffer:
+      wgpuBufferRelease((WGPUBuffer)object);
+      break;
+    case ReleaseType_CommandBuffer:
+      wgpuCommandBufferRelease((WGPUCommandBuffer)object);
+      break;
+    case ReleaseType_QuerySet:
+      wgpuQuerySetRelease((WGPUQuerySet)object);
+      break;
+    case ReleaseType_RenderBundle:
+      wgpuRenderBundleRelease((WGPURenderBundle)object);
+      break;
+    case ReleaseType_Sampler:
+      wgpuSamplerRelease((WGPUSampler)object);
+      break;
+    case ReleaseType_Texture:
+      wgpuTextureRelease((WGPUTexture)object);
+      break;
+    case ReleaseType_TextureView:
+      wgpuTextureViewRelease((WGPUTextureView)object);
+      break;
+  }
+}
+
+/* Releases the queued objects up to the given serial in one batch */
+static void wgpu_release_deferred(wgpu_context_t* wgpu_context,
+                                  uint64_t serial)
+{
+  wgpu_deferred_release_queue_t* queue = &wgpu_context->deferred_release;
+  for (; queue->head < queue->count
+         && queue->entries[queue->head].serial <= serial;
+       ++queue->head) {
+    wgpu_release_object(queue->entries[queue->head].type,
+                        queue->entries[queue->head].object);
+    ++queue->released_count;
+  }
+
+  if (queue->head == queue->count) {
+    queue->head  = 0;
+    queue->count = 0;
+  }
+}
+
+void wgpu_release_completed_resources(wgpu_context_t* wgpu_context)
+{
+  wgpu_release_deferred(wgpu_context, wgpu_context->serial.completed);
+}
+
+/* Bump allocates aligned uniform memory from the current frame slot */
+bool wgpu_frame_allocate_uniform(wgpu_context_t* wgpu_context, uint64_t size,
+                                 wgpu_uniform_allocation_t* allocation)
+{
+  wgpu_frame_context_t* frame = wgpu_get_current_frame(wgpu_context);
+  if (frame->uniform.data == NULL) {
+    return false; /* frames not set up */
+  }
+
+  const uint64_t offset
+    = (frame->uniform.used + WGPU_FRAME_UNIFORM_ALIGNMENT - 1)
+      & ~(uint64_t)(WGPU_FRAME_UNIFORM_ALIGNMENT - 1);
+  if (offset + size > frame->uniform.size) {
+    log_error("Frame uniform buffer exhausted (%llu of %llu bytes used)",
+              (unsigned long long)frame->uniform.used,
+              (unsigned long long)frame->uniform.size);
+    return false;
+  }
+  frame->uniform.used = offset + size;
+
+  allocation->buffer = frame->uniform.buffer;
+  allocation->offset = (uint32_t)offset;
+  allocation->data   = frame->uniform.data + offset;
+  return true;
+}
+
+bool wgpu_frame_push_uniform(wgpu_context_t* wgpu_context, const void* data,
+                             uint64_t size, uint32_t* dynamic_offset)
+{
+  wgpu_uniform_allocation_t allocation = {0};
+  if (!wgpu_frame_allocate_uniform(wgpu_context, size, &allocation)) {
+    return false;
+  }
+  memcpy(allocation.data, data, size);
+  *dynamic_offset = allocation.offset;
+  return true;
+}
+
+/* Each frame slot has its own buffer, bind groups are created per slot */
+WGPUBuffer wgpu_frame_get_uniform_buffer(wgpu_context_t* wgpu_context,
+                                         uint32_t frame_index)
+{
+  return (frame_index < wgpu_context->frames.count) ?
+           wgpu_context->frames.slots[frame_index].uniform.buffer :
+           NULL;
+}
+
+void wgpu_wait_for_idle(wgpu_context_t* wgpu_context)
+{
+  if (wgpu_context->device == NULL) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < wgpu_context->frames.count; ++i) {
+    while (wgpu_context->frames.slots[i].in_flight) {
+      wgpuDeviceTick(wgpu_context->device);
+    }
+  }
+  /* Pipeline creation callbacks and asset uploads write into the memory of
+   * their requester */
+  wgpu_wait_for_async_pipelines(wgpu_context);
+  wgpu_wait_for_async_assets(wgpu_context);
+  /* The work done callbacks of the submissions refer to the context */
+  while (wgpu_context->serial.completed < wgpu_context->serial.submitted) {
+    wgpuDeviceTick(wgpu_context->device);
+  }
+}
+
+/* Uploads the uniform data allocated in the current frame slot since the
+ * last submission with a single queue write */
+static void wgpu_frame_flush_uniforms(wgpu_context_t* wgpu_context)
+{
+  wgpu_frame_context_t* frame = wgpu_get_current_frame(wgpu_context);
+  if (frame->uniform.buffer == NULL
+      || frame->uniform.used <= frame->uniform.flushed) {
+    return;
+  }
+
+  const uint64_t end  = MIN((frame->uniform.used + 3) & ~3ull,
+                            frame->uniform.size);
+  const uint64_t size = end - frame->uniform.flushed;
+  wgpuQueueWriteBuffer(wgpu_context->queue, frame->uniform.buffer,
+                       frame->uniform.flushed,
+                       frame->uniform.data + frame->uniform.flushed, size);
+  frame->uniform.flushed = end;
+}
+
 /* Methods of Queue */
 void wgpu_queue_write_buffer(wgpu_context_t* wgpu_context, WGPUBuffer buffer,
                              uint64_t buffer_offset, void const* data,
                              size_t size)
 {
+  if (wgpu_context->queue_writes.batcher != NULL) {
+    wgpu_write_batcher_write(wgpu_context->queue_writes.batcher, buffer,
+                             buffer_offset, data, size);
+    return;
+  }
   wgpuQueueWriteBuffer(wgpu_context->queue, buffer, buffer_offset, data, size);
 }
 
+void wgpu_flush_queue_writes(wgpu_context_t* wgpu_context)
+{
+  if (wgpu_context->queue_writes.batcher != NULL) {
+    wgpu_write_batcher_flush(wgpu_context->queue_writes.batcher);
+  }
+}
+
 /* Render helper functions */
 
 /* Get a new command buffer */
@@ -254,11 +815,36 @@ WGPUCommandBuffer wgpu_get_command_buffer(WGPUCommandEncoder cmd_encoder)
 
 WGPUTextureView wgpu_swap_chain_get_current_image(wgpu_context_t* wgpu_context)
 {
+  if (wgpu_context->offscreen.enabled) {
+    /* The frame buffer reference is dropped again in the present call */
+    wgpuTextureViewReference(wgpu_context->offscreen.texture_view);
+    wgpu_context->swap_chain.frame_buffer = wgpu_context->offscreen.texture_view;
+    return wgpu_context->swap_chain.frame_buffer;
+  }
+
   wgpu_context->swap_chain.frame_buffer
     = wgpuSwapChainGetCurrentTextureView(wgpu_context->swap_chain.instance);
   return wgpu_context->swap_chain.frame_buffer;
 }
 
+/* Completion of a single queue submission */
+typedef struct wgpu_submit_work_done_t {
+  wgpu_context_t* wgpu_context;
+  uint64_t serial;
+} wgpu_submit_work_done_t;
+
+static void wgpu_submit_work_done_callback(WGPUQueueWorkDoneStatus status,
+                                           void* userdata)
+{
+  UNUSED_VAR(status);
+
+  wgpu_submit_work_done_t* work_done = (wgpu_submit_work_done_t*)userdata;
+  wgpu_context_t* wgpu_context       = work_done->wgpu_context;
+  wgpu_context->serial.completed
+    = MAX(wgpu_context->serial.completed, work_done->serial);
+  free(work_done);
+}
+
 /* End the command buffers and submit it to the queue */
 void wgpu_flush_command_buffers(wgpu_context_t* wgpu_context,
                                 WGPUCommandBuffer* command_buffers,
@@ -266,8 +852,37 @@ void wgpu_flush_command_buffers(wgpu_context_t* wgpu_context,
 {
   ASSERT(command_buffers != NULL)
 
+  /* Frame slot uniforms and batched writes must be visible to this
+   * submission */
+  wgpu_frame_flush_uniforms(wgpu_context);
+  wgpu_flush_queue_writes(wgpu_context);
+
+  /* Staging chunks have to be unmapped before the copies are submitted, the
+   * frame command encoder may still be recording if this is a nested
+   * submission, it is released before the frame is submitted */
+  if (wgpu_context->staging_belt != NULL) {
+    wgpu_staging_belt_finish_all(wgpu_context->staging_belt,
+                                 wgpu_context->cmd_enc);
+  }
+
   /* Submit to the queue */
   wgpuQueueSubmit(wgpu_context->queue, command_buffer_count, command_buffers);
+  ++wgpu_context->serial.submitted;
+
+  /* Every submission reports its serial, so deferred releases also drain
+   * for submissions made outside of the frame loop */
+  wgpu_submit_work_done_t* work_done
+    = (wgpu_submit_work_done_t*)malloc(sizeof(wgpu_submit_work_done_t));
+  work_done->wgpu_context = wgpu_context;
+  work_done->serial       = wgpu_context->serial.submitted;
+  wgpuQueueOnSubmittedWorkDone(wgpu_context->queue, 0,
+                               wgpu_submit_work_done_callback, work_done);
+  wgpu_release_completed_resources(wgpu_context);
+
+  /* Reuse the staging chunks once the GPU executed the copies */
+  if (wgpu_context->staging_belt != NULL) {
+    wgpu_staging_belt_recall(wgpu_context->staging_belt);
+  }
 
   /* Release command buffer */
   for (uint32_t i = 0; i < command_buffer_count; ++i) {
@@ -277,9 +892,17 @@ void wgpu_flush_command_buffers(wgpu_context_t* wgpu_context,
 
 void wgpu_swap_chain_present(wgpu_context_t* wgpu_context)
 {
-  wgpuSwapChainPresent(wgpu_context->swap_chain.instance);
+  const trace_span_t span = trace_span_begin("wgpu_swap_chain_present");
+
+  if (!wgpu_context->offscreen.enabled) {
+    wgpuSwapChainPresent(wgpu_context->swap_chain.instance);
+  }
+
+  /* The view may still be used by the frame the GPU is working on */
+  WGPU_DEFER_RELEASE(wgpu_context, TextureView,
+                     wgpu_context->swap_chain.frame_buffer)
 
-  WGPU_RELEASE_RESOURCE(TextureView, wgpu_context->swap_chain.frame_buffer)
+  trace_span_end(span);
 }
 
 /* Texture client creation */
@@ -10,6 +10,13 @@
     Name = NULL;                                                               \
   }
 
+/* Releases the object once the GPU finished the submission being recorded */
+#define WGPU_DEFER_RELEASE(Context, Type, Name)                                \
+  if (Name) {                                                                  \
+    wgpu_defer_release(Context, ReleaseType_##Type, Name);                     \
+    Name = NULL;                                                               \
+  }
+
 #define WGPU_VERTATTR_DESC(l, f, o)                                            \
   (WGPUVertexAttribute)                                                        \
   {                                                                            \
@@ -43,18 +50,106 @@
 
 #define MAX_COMMAND_BUFFER_COUNT 256
 #define WGPU_FEATURE_COUNT 12u
+#define WGPU_MAX_FRAMES_IN_FLIGHT 3u
+#define WGPU_DEFAULT_FRAMES_IN_FLIGHT 2u
+#define WGPU_FRAME_UNIFORM_BUFFER_SIZE (256u * 1024u)
+#define WGPU_FRAME_UNIFORM_ALIGNMENT 256u /* dynamic offset alignment */
+#define WGPU_MAX_DEVICE_TOGGLES 16u
 
 /* Initializers */
 
 /* Forward declarations */
 struct wgpu_buffer_t;
 struct wgpu_texture_client_t;
+struct gpu_profiler_t;
+struct wgpu_staging_belt_t;
+struct wgpu_write_batcher_t;
+struct wgpu_pipeline_cache_t;
+struct wgpu_shader_cache_t;
+struct wgpu_asset_t;
+
+/* Load-time block compression of jpg and png textures, see texture.h */
+typedef enum wgpu_texture_compression_enum {
+  TextureCompression_Off  = 0,
+  TextureCompression_BC1  = 1,
+  TextureCompression_BC3  = 2,
+  TextureCompression_BC7  = 3,
+  TextureCompression_Auto = 4, /* BC1 for opaque images, BC3 otherwise */
+} wgpu_texture_compression_enum;
 
 /* WebGPU context create options */
 typedef struct wgpu_context_create_options_t {
   bool vsync;
+  bool offscreen; /* render into an offscreen target instead of a swap chain */
+  uint32_t frames_in_flight; /* 1 up to WGPU_MAX_FRAMES_IN_FLIGHT */
+  bool batch_queue_writes;   /* coalesce queue writes until submission */
+  const char* blob_cache_dir; /* persistent Dawn blob cache, NULL disables */
+  /* Texture compression: "off", "bc1", "bc3", "bc7" or "auto", NULL falls
+   * back to the WGPU_TEXTURE_COMPRESSION environment variable and then to
+   * "off". The compressed textures are cached in texture_cache_dir. */
+  const char* texture_compression;
+  uint32_t bc7_quality;          /* 1 (fastest) up to 4, 0 for the default */
+  const char* texture_cache_dir; /* compressed textures, NULL disables */
+  /* Dawn configuration, NULL falls back to the WGPU_VALIDATION and
+   * WGPU_TOGGLES environment variables and then to the build defaults */
+  const char* validation; /* backend validation: "off", "partial" or "full" */
+  const char* toggles; /* comma separated device toggles, "-name" disables */
+  /* Adapter selection, NULL falls back to the WGPU_ADAPTER_BACKEND,
+   * WGPU_ADAPTER_TYPE and WGPU_ADAPTER_NAME environment variables */
+  const char* adapter_backend; /* e.g. "vulkan", "d3d12", "metal", "null" */
+  const char* adapter_type;    /* "discrete", "integrated", "cpu" */
+  const char* adapter_name;    /* adapter name substring */
 } wgpu_context_create_options_t;
 
+/* Object types supported by the deferred release queue */
+typedef enum wgpu_release_type_enum {
+  ReleaseType_BindGroup     = 0,
+  ReleaseType_Buffer        = 1,
+  ReleaseType_CommandBuffer = 2,
+  ReleaseType_QuerySet      = 3,
+  ReleaseType_RenderBundle  = 4,
+  ReleaseType_Sampler       = 5,
+  ReleaseType_Texture       = 6,
+  ReleaseType_TextureView   = 7,
+} wgpu_release_type_enum;
+
+/* Object waiting in the deferred release queue */
+typedef struct wgpu_deferred_release_t {
+  wgpu_release_type_enum type;
+  void* object;
+  uint64_t serial; /* released once this submission completed */
+} wgpu_deferred_release_t;
+
+typedef struct wgpu_deferred_release_queue_t {
+  wgpu_deferred_release_t* entries; /* ordered by serial */
+  uint32_t head;                    /* first pending entry */
+  uint32_t count;                   /* end of the pending entries */
+  uint32_t capacity;
+  uint64_t released_count;
+} wgpu_deferred_release_queue_t;
+
+/* Frame context, one per frame in flight */
+typedef struct wgpu_frame_context_t {
+  struct wgpu_context_t* wgpu_context;
+  uint32_t index;        /* frame slot index */
+  uint64_t begin_serial; /* submission serial when the frame began */
+  bool in_flight;        /* true until the GPU finished the work of this slot */
+  struct {
+    WGPUBuffer buffer; /* uniform memory owned by this frame slot */
+    uint8_t* data;     /* CPU copy, uploaded when the frame is submitted */
+    uint64_t size;
+    uint64_t used;    /* bytes allocated this frame */
+    uint64_t flushed; /* bytes already uploaded this frame */
+  } uniform;
+} wgpu_frame_context_t;
+
+/* Uniform memory of the current frame slot */
+typedef struct wgpu_uniform_allocation_t {
+  WGPUBuffer buffer; /* uniform buffer of the frame slot */
+  uint32_t offset;   /* dynamic offset into buffer */
+  void* data;        /* CPU memory, uploaded when the frame is submitted */
+} wgpu_uniform_allocation_t;
+
 /* WebGPU context */
 typedef struct wgpu_context_t {
   void* context;
@@ -77,6 +172,11 @@ typedef struct wgpu_context_t {
     WGPUTextureView frame_buffer;
     WGPUPresentMode present_mode;
   } swap_chain;
+  struct {
+    bool enabled;
+    WGPUTexture texture;
+    WGPUTextureView texture_view;
+  } offscreen; /* color target used instead of the swap chain (headless) */
   WGPUCommandEncoder cmd_enc;       /* Command encoder */
   WGPURenderPassEncoder rpass_enc;  /* Render pass encoder */
   WGPUComputePassEncoder cpass_enc; /* Compute pass encoder */
@@ -89,10 +189,52 @@ typedef struct wgpu_context_t {
     uint32_t command_buffer_count;
     WGPUCommandBuffer command_buffers[MAX_COMMAND_BUFFER_COUNT];
   } submit_info;
+  struct {
+    uint64_t submitted; /* serial of the last queue submission */
+    uint64_t completed; /* serial of the last completed submission */
+  } serial;
+  struct {
+    uint32_t count; /* number of frames in flight */
+    uint32_t index; /* current frame slot */
+    wgpu_frame_context_t slots[WGPU_MAX_FRAMES_IN_FLIGHT];
+  } frames;
   struct wgpu_texture_client_t* texture_client;
+  struct gpu_profiler_t* profiler;
+  struct wgpu_staging_belt_t* staging_belt; /* shared by all upload paths */
+  struct wgpu_pipeline_cache_t* pipeline_cache; /* shared render pipelines */
+  struct wgpu_shader_cache_t* shader_cache;     /* shared shader modules */
+  struct {
+    bool enabled;
+    struct wgpu_write_batcher_t* batcher;
+  } queue_writes; /* optional batching of wgpu_queue_write_buffer */
+  struct {
+    uint32_t pending_count; /* requests waiting for their callback */
+    uint32_t ready_count;
+    uint32_t failed_count;
+    uint64_t last_ready_ns; /* completion time of the latest pipeline */
+  } async_pipelines;        /* see async_pipeline.h */
+  struct {
+    uint32_t pending_count; /* requested assets not uploaded yet */
+    uint32_t ready_count;
+    uint32_t failed_count;
+    uint64_t last_ready_ns;         /* upload time of the latest asset */
+    struct wgpu_asset_t* completed; /* decoded assets, pushed by workers */
+    struct wgpu_asset_t* in_flight; /* pending assets, main thread only */
+  } async_assets;                   /* see asset_loader.h */
+  wgpu_deferred_release_queue_t deferred_release;
+  struct {
+    const char* validation; /* active backend validation level */
+    char toggles[512];      /* requested device toggles */
+  } dawn_config;
+  struct {
+    wgpu_texture_compression_enum mode;
+    uint32_t bc7_quality;
+    char cache_dir[512]; /* empty if the cache is disabled */
+  } texture_compression;
 } wgpu_context_t;
 
-/* WebGPU context creating/releasing */
+/* WebGPU context creating/releasing, returns NULL if the adapter filter is
+ * invalid */
 wgpu_context_t* wgpu_context_create(wgpu_context_create_options_t* options);
 void wgpu_context_release(wgpu_context_t* wgpu_context);
 
@@ -110,19 +252,44 @@ typedef struct deph_stencil_texture_creation_options_t {
 WGPUBuffer wgpu_create_buffer_from_data(wgpu_context_t* wgpu_context,
                                         const void* data, size_t size,
                                         WGPUBufferUsage usage);
-void wgpu_create_device_and_queue(wgpu_context_t* wgpu_context);
+/* Returns false if no adapter is available or matches the adapter filter */
+bool wgpu_create_device_and_queue(wgpu_context_t* wgpu_context);
 void wgpu_setup_window_surface(wgpu_context_t* wgpu_context, void* window);
 void wgpu_setup_deph_stencil(
   wgpu_context_t* wgpu_context,
   struct deph_stencil_texture_creation_options_t* options);
 void wgpu_setup_swap_chain(wgpu_context_t* wgpu_context);
+void wgpu_setup_offscreen_target(wgpu_context_t* wgpu_context, uint32_t width,
+                                 uint32_t height);
 void wgpu_error_callback(WGPUErrorType type, char const* message,
                          void* userdata);
 
+/* Frames in flight */
+void wgpu_setup_frames(wgpu_context_t* wgpu_context);
+wgpu_frame_context_t* wgpu_frame_begin(wgpu_context_t* wgpu_context);
+void wgpu_frame_end(wgpu_context_t* wgpu_context);
+wgpu_frame_context_t* wgpu_get_current_frame(wgpu_context_t* wgpu_context);
+void wgpu_wait_for_idle(wgpu_context_t* wgpu_context);
+
+/* Deferred release queue, processed at the beginning of each frame */
+void wgpu_defer_release(wgpu_context_t* wgpu_context,
+                        wgpu_release_type_enum type, void* object);
+void wgpu_release_completed_resources(wgpu_context_t* wgpu_context);
+
+/* Per-frame uniform arena, allocations are valid until the frame ends */
+bool wgpu_frame_allocate_uniform(wgpu_context_t* wgpu_context, uint64_t size,
+                                 wgpu_uniform_allocation_t* allocation);
+bool wgpu_frame_push_uniform(wgpu_context_t* wgpu_context, const void* data,
+                             uint64_t size, uint32_t* dynamic_offset);
+WGPUBuffer wgpu_frame_get_uniform_buffer(wgpu_context_t* wgpu_context,
+                                         uint32_t frame_index);
+
 /* Methods of Queue */
 void wgpu_queue_write_buffer(wgpu_context_t* wgpu_context, WGPUBuffer buffer,
                              uint64_t buffer_offset, void const* data,
                              size_t size);
+/* Applies the batched queue writes, needed before submitting directly */
+void wgpu_flush_queue_writes(wgpu_context_t* wgpu_context);
 
 /* Render helper functions */
 WGPUCommandBuffer wgpu_get_command_buffer(WGPUCommandEncoder cmd_encoder);
@@ -7,6 +7,7 @@
 #include <cgltf.h>
 
 #include "../core/file.h"
+#include "../core/job_system.h"
 #include "../core/log.h"
 #include "../core/macro.h"
 
@@ -164,12 +165,23 @@ static void get_relative_file_path(const char* base_path, const char* new_path,
   snprintf(insert_point, strlen(new_path) + 1, "%s", new_path);
 }
 
-static void gltf_texture_from_gltf_image(const char* model_uri,
-                                         gltf_texture_t* texture,
-                                         cgltf_image* gltf_image)
+/* Images referenced by file are mipmapped, embedded images are used as is */
+static struct wgpu_texture_load_options_t gltf_image_file_load_options = {
+  .generate_mipmaps = true,
+  .address_mode     = WGPUAddressMode_Repeat,
+};
+
+static struct wgpu_texture_load_options_t*
+gltf_image_get_load_options(cgltf_image* gltf_image)
 {
-  ASSERT(texture && texture->wgpu_context != NULL);
+  return gltf_image->uri != NULL ? &gltf_image_file_load_options : NULL;
+}
 
+/* Decodes the image data, can be called from worker threads */
+static wgpu_texture_data_t* gltf_image_decode(wgpu_context_t* wgpu_context,
+                                              const char* model_uri,
+                                              cgltf_image* gltf_image)
+{
   if (gltf_image->uri != NULL) {
     /* Load image data from file */
     char image_uri[STRMAX];
@@ -177,21 +189,30 @@ static void gltf_texture_from_gltf_image(const char* model_uri,
     if (filename_has_extension(image_uri, "jpg")
         || filename_has_extension(image_uri, "png")
         || filename_has_extension(image_uri, "ktx")) {
-      texture->wgpu_texture = wgpu_create_texture_from_file(
-        texture->wgpu_context, image_uri,
-        &(struct wgpu_texture_load_options_t){
-          .generate_mipmaps = true,
-          .address_mode     = WGPUAddressMode_Repeat,
-        });
+      return wgpu_texture_data_load_from_file(
+        wgpu_context, image_uri, gltf_image_get_load_options(gltf_image));
     }
   }
   else if (gltf_image->buffer_view) {
     /* Load image data from memory */
-    texture->wgpu_texture = wgpu_create_texture_from_memory(
-      texture->wgpu_context,
-      (void*)((uint8_t*)gltf_image->buffer_view->buffer->data
-              + gltf_image->buffer_view->offset),
-      gltf_image->buffer_view->size, NULL);
+    return wgpu_texture_data_load_from_memory(
+      (uint8_t*)gltf_image->buffer_view->buffer->data
+        + gltf_image->buffer_view->offset,
+      gltf_image->buffer_view->size, gltf_image_get_load_options(gltf_image));
+  }
+  return NULL;
+}
+
+static void gltf_texture_from_gltf_image(gltf_texture_t* texture,
+                                         cgltf_image* gltf_image,
+                                         wgpu_texture_data_t* image_data)
+{
+  ASSERT(texture && texture->wgpu_context != NULL);
+
+  if (image_data != NULL) {
+    texture->wgpu_texture = wgpu_create_texture_from_data(
+      texture->wgpu_context, image_data,
+      gltf_image_get_load_options(gltf_image));
   }
 }
 
@@ -297,7 +318,7 @@ typedef struct gltf_mesh_t {
 } gltf_mesh_t;
 
 static void gltf_mesh_init(gltf_mesh_t* mesh, wgpu_context_t* wgpu_context,
-                           mat4 matrix)
+                           wgpu_buffer_heap_t* uniform_heap, mat4 matrix)
 {
   memset(mesh, 0, sizeof(gltf_mesh_t));
 
@@ -309,6 +330,7 @@ static void gltf_mesh_init(gltf_mesh_t* mesh, wgpu_context_t* wgpu_context,
                     .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform,
                     .size  = sizeof(mesh->uniform_block),
                     .initial.data = &mesh->uniform_block,
+                    .heap         = uniform_heap,
                   });
 }
 
@@ -484,13 +506,16 @@ static void gltf_node_update(wgpu_context_t* wgpu_context, gltf_node_t* node)
         glm_mat4_copy(joint_mat, node->mesh->uniform_block.joint_matrix[i]);
       }
       node->mesh->uniform_block.joint_count = (float)skin->joint_count;
-      wgpu_queue_write_buffer(
-        wgpu_context, node->mesh->uniform_buffer.buffer.buffer, 0,
-        &node->mesh->uniform_block, sizeof(node->mesh->uniform_buffer));
+      wgpu_queue_write_buffer(wgpu_context,
+                              node->mesh->uniform_buffer.buffer.buffer,
+                              node->mesh->uniform_buffer.buffer.offset,
+                              &node->mesh->uniform_block,
+                              sizeof(node->mesh->uniform_block));
     }
     else {
       wgpu_queue_write_buffer(wgpu_context,
-                              node->mesh->uniform_buffer.buffer.buffer, 0, &m,
+                              node->mesh->uniform_buffer.buffer.buffer,
+                              node->mesh->uniform_buffer.buffer.offset, &m,
                               sizeof(mat4));
     }
   }
@@ -680,6 +705,11 @@ typedef struct gltf_model_t {
 
   gltf_mesh_t* meshes;
   uint32_t mesh_count;
+  /* Mesh uniform buffers are sub-allocated from a shared heap, the node bind
+   * groups are rebuilt when the heap generation changed */
+  wgpu_buffer_heap_t* uniform_heap;
+  uint32_t uniform_heap_generation;
+  WGPUBindGroupLayout node_bind_group_layout;
 
   gltf_animation_t* animations;
   uint32_t animation_count;
@@ -752,6 +782,14 @@ static void gltf_model_init(gltf_model_t* model,
   model->meshes     = NULL;
   model->mesh_count = 0;
 
+  model->uniform_heap = wgpu_buffer_heap_create(
+    model->wgpu_context, &(wgpu_buffer_heap_desc_t){
+                           .label = "glTF mesh uniform buffer heap",
+                           .usage = WGPUBufferUsage_CopyDst
+                                    | WGPUBufferUsage_Uniform,
+                           .page_size = 256u * 1024u,
+                         });
+
   model->animations      = NULL;
   model->animation_count = 0;
 
@@ -791,6 +829,8 @@ void wgpu_gltf_model_destroy(gltf_model_t* model)
     gltf_mesh_destroy(&model->meshes[i]);
   }
   free(model->meshes);
+  wgpu_buffer_heap_destroy(model->uniform_heap);
+  WGPU_RELEASE_RESOURCE(BindGroupLayout, model->node_bind_group_layout)
 
   for (uint32_t i = 0; i < model->node_count; ++i) {
     gltf_node_destroy(&model->nodes[i]);
@@ -858,7 +898,8 @@ static void gltf_model_load_node(gltf_model_t* model, cgltf_node* parent,
   if (node->mesh != NULL) {
     cgltf_mesh* mesh      = node->mesh;
     gltf_mesh_t* new_mesh = &model->meshes[node->mesh - data->meshes];
-    gltf_mesh_init(new_mesh, model->wgpu_context, new_node->matrix);
+    gltf_mesh_init(new_mesh, model->wgpu_context, model->uniform_heap,
+                   new_node->matrix);
     if (mesh->name) {
       snprintf(new_mesh->name, strlen(mesh->name) + 1, "%s", mesh->name);
     }
@@ -1171,7 +1212,8 @@ static void gltf_model_load_skins(gltf_model_t* model, cgltf_data* data)
   }
 }
 
-static void gltf_model_load_images(gltf_model_t* model, cgltf_data* data)
+static void gltf_model_load_images(gltf_model_t* model, cgltf_data* data,
+                                   wgpu_texture_data_t** image_data)
 {
   model->texture_count = (uint32_t)data->images_count;
   model->textures      = model->texture_count > 0 ?
@@ -1181,7 +1223,8 @@ static void gltf_model_load_images(gltf_model_t* model, cgltf_data* data)
     cgltf_image* image      = &data->images[i];
     gltf_texture_t* texture = &model->textures[i];
     gltf_texture_init(texture, model->wgpu_context);
-    gltf_texture_from_gltf_image(model->uri, texture, image);
+    gltf_texture_from_gltf_image(texture, image, image_data[i]);
+    image_data[i] = NULL;
   }
   // Create an empty texture to be used for empty material images
   gltf_model_create_empty_texture(model);
@@ -1428,98 +1471,225 @@ static void gltf_model_load_animations(gltf_model_t* model, cgltf_data* data)
   }
 }
 
-gltf_model_t* wgpu_gltf_model_load_from_file(
-  struct wgpu_gltf_model_load_options_t* load_options)
+/*
+ * Memory-mapped glTF files, cgltf parses the mapped .gltf/.glb file and reads
+ * the vertex and index data straight from the mapped .bin files
+ */
+typedef struct gltf_file_views_t {
+  file_view_t* views;
+  uint32_t count;
+} gltf_file_views_t;
+
+static cgltf_result
+gltf_file_read(const struct cgltf_memory_options* memory_options,
+               const struct cgltf_file_options* file_options, const char* path,
+               cgltf_size* size, void** data)
 {
-  uint32_t file_loading_flags = load_options->file_loading_flags;
+  UNUSED_VAR(memory_options);
+
+  gltf_file_views_t* file_views = (gltf_file_views_t*)file_options->user_data;
+  file_view_t view              = {0};
+  if (!file_view_open(path, FileViewFlags_WillNeed, &view)) {
+    return cgltf_result_file_not_found;
+  }
+  if (*size > view.size) {
+    file_view_close(&view);
+    return cgltf_result_data_too_short;
+  }
+
+  file_views->views = realloc(file_views->views,
+                              (file_views->count + 1) * sizeof(file_view_t));
+  file_views->views[file_views->count++] = view;
+
+  if (*size == 0) {
+    *size = view.size;
+  }
+  *data = (void*)view.data;
+  return cgltf_result_success;
+}
 
-  gltf_model_t* gltf_model = NULL;
+static void gltf_file_release(const struct cgltf_memory_options* memory_options,
+                              const struct cgltf_file_options* file_options,
+                              void* data)
+{
+  UNUSED_VAR(memory_options);
+
+  gltf_file_views_t* file_views = (gltf_file_views_t*)file_options->user_data;
+  for (uint32_t i = 0; i < file_views->count; ++i) {
+    if (file_views->views[i].data == data) {
+      file_view_close(&file_views->views[i]);
+      file_views->views[i] = file_views->views[--file_views->count];
+      return;
+    }
+  }
+}
 
-  cgltf_options options = {0};
+/*
+ * Parsed glTF file with decoded images, the file is read and the images are
+ * decoded without touching the GPU so that this can run on a worker thread
+ */
+typedef struct gltf_model_data_t {
+  wgpu_context_t* wgpu_context;
+  char uri[STRMAX];
+  gltf_file_views_t file_views; /* referenced by gltf_data until freed */
+  cgltf_data* gltf_data;
+  wgpu_texture_data_t** images; /* one entry per glTF image, may be NULL */
+} gltf_model_data_t;
+
+static void gltf_model_data_destroy(gltf_model_data_t* model_data)
+{
+  if (model_data == NULL) {
+    return;
+  }
+
+  if (model_data->images != NULL) {
+    for (cgltf_size i = 0; i < model_data->gltf_data->images_count; ++i) {
+      wgpu_texture_data_destroy(model_data->images[i]);
+    }
+    free(model_data->images);
+  }
+  cgltf_free(model_data->gltf_data);
+  ASSERT(model_data->file_views.count == 0);
+  free(model_data->file_views.views);
+  free(model_data);
+}
+
+static void gltf_model_data_decode_images(uint32_t begin, uint32_t end,
+                                          void* data)
+{
+  gltf_model_data_t* model_data = (gltf_model_data_t*)data;
+  for (uint32_t i = begin; i < end; ++i) {
+    model_data->images[i]
+      = gltf_image_decode(model_data->wgpu_context, model_data->uri,
+                          &model_data->gltf_data->images[i]);
+  }
+}
+
+static gltf_model_data_t* gltf_model_data_load_from_file(
+  struct wgpu_gltf_model_load_options_t* load_options)
+{
+  gltf_model_data_t* model_data = calloc(1, sizeof(gltf_model_data_t));
+  model_data->wgpu_context      = load_options->wgpu_context;
+  snprintf(model_data->uri, sizeof(model_data->uri), "%s",
+           load_options->filename);
+
+  cgltf_options options = {
+    .file = {
+      .read      = gltf_file_read,
+      .release   = gltf_file_release,
+      .user_data = &model_data->file_views,
+    },
+  };
   cgltf_data* gltf_data = NULL;
   cgltf_result result
     = cgltf_parse_file(&options, load_options->filename, &gltf_data);
+  if (result == cgltf_result_success) {
+    result = cgltf_load_buffers(&options, gltf_data, load_options->filename);
+    if (result != cgltf_result_success) {
+      cgltf_free(gltf_data);
+    }
+  }
+  if (result != cgltf_result_success) {
+    log_error("Could not load gltf file: %s, error: %d\n",
+              load_options->filename, result);
+    free(model_data->file_views.views);
+    free(model_data);
+    return NULL;
+  }
+  model_data->gltf_data = gltf_data;
+
+  // Decode the images in parallel, they are independent of each other
+  if (!(load_options->file_loading_flags
+        & WGPU_GLTF_FileLoadingFlags_DontLoadImages)
+      && gltf_data->images_count > 0) {
+    model_data->images
+      = calloc(gltf_data->images_count, sizeof(wgpu_texture_data_t*));
+    job_parallel_for((uint32_t)gltf_data->images_count, 1,
+                     gltf_model_data_decode_images, model_data);
+  }
+
+  return model_data;
+}
+
+static gltf_model_t* gltf_model_create_from_data(
+  struct wgpu_gltf_model_load_options_t* load_options,
+  gltf_model_data_t* model_data)
+{
+  if (model_data == NULL) {
+    return NULL;
+  }
+
+  uint32_t file_loading_flags = load_options->file_loading_flags;
+  cgltf_data* gltf_data       = model_data->gltf_data;
+
+  gltf_model_t* gltf_model = calloc(1, sizeof(gltf_model_t));
+  gltf_model_init(gltf_model, load_options);
 
   // Vertex buffer & Index buffer
   gltf_vertex_t* vertices = NULL;
   uint32_t* indices       = NULL;
 
-  if (result == cgltf_result_success) {
-    cgltf_result buffers_result
-      = cgltf_load_buffers(&options, gltf_data, load_options->filename);
-
-    if (buffers_result == cgltf_result_success) {
-      gltf_model = calloc(1, sizeof(gltf_model_t));
-      gltf_model_init(gltf_model, load_options);
-
-      // Load samplers and images
-      if (!(file_loading_flags & WGPU_GLTF_FileLoadingFlags_DontLoadImages)) {
-        gltf_model_load_texture_samplers(gltf_model, gltf_data);
-        gltf_model_load_images(gltf_model, gltf_data);
-      }
+  // Load samplers and images
+  if (!(file_loading_flags & WGPU_GLTF_FileLoadingFlags_DontLoadImages)) {
+    gltf_model_load_texture_samplers(gltf_model, gltf_data);
+    gltf_model_load_images(gltf_model, gltf_data, model_data->images);
+  }
 
-      // Load materials
-      gltf_model_load_materials(gltf_model, gltf_data);
+  // Load materials
+  gltf_model_load_materials(gltf_model, gltf_data);
 
-      // If there is no default scene specified, then the default is the first
-      // one. It is not an error for a glTF file to have zero scenes.
-      const cgltf_scene* scene
-        = gltf_data->scene ? gltf_data->scene : gltf_data->scenes;
-      if (!scene) {
-        return NULL;
-      }
+  // If there is no default scene specified, then the default is the first
+  // one. It is not an error for a glTF file to have zero scenes.
+  const cgltf_scene* scene
+    = gltf_data->scene ? gltf_data->scene : gltf_data->scenes;
+  if (!scene) {
+    wgpu_gltf_model_destroy(gltf_model);
+    gltf_model_data_destroy(model_data);
+    return NULL;
+  }
 
-      // Vertex buffer & Index buffer
-      gltf_model->vertices.count = 0;
-      gltf_model->indices.count  = 0;
+  // Vertex buffer & Index buffer
+  gltf_model->vertices.count = 0;
+  gltf_model->indices.count  = 0;
 
-      // Nodes and meshes
-      gltf_model->node_count = (uint32_t)gltf_data->nodes_count;
-      gltf_model->nodes = calloc(gltf_model->node_count, sizeof(gltf_node_t));
+  // Nodes and meshes
+  gltf_model->node_count = (uint32_t)gltf_data->nodes_count;
+  gltf_model->nodes = calloc(gltf_model->node_count, sizeof(gltf_node_t));
 
-      gltf_model->linear_nodes
-        = calloc(gltf_model->node_count, sizeof(gltf_node_t*));
+  gltf_model->linear_nodes
+    = calloc(gltf_model->node_count, sizeof(gltf_node_t*));
 
-      gltf_model->mesh_count = (uint32_t)gltf_data->meshes_count;
-      gltf_model->meshes = calloc(gltf_model->mesh_count, sizeof(gltf_mesh_t));
+  gltf_model->mesh_count = (uint32_t)gltf_data->meshes_count;
+  gltf_model->meshes = calloc(gltf_model->mesh_count, sizeof(gltf_mesh_t));
 
-      // Recursively create all nodes.
-      for (cgltf_size i = 0, len = scene->nodes_count; i < len; ++i) {
-        gltf_model_load_node(gltf_model, NULL, scene->nodes[i], gltf_data,
-                             &vertices, &gltf_model->vertices.count, &indices,
-                             &gltf_model->indices.count, load_options->scale);
-      }
+  // Recursively create all nodes.
+  for (cgltf_size i = 0, len = scene->nodes_count; i < len; ++i) {
+    gltf_model_load_node(gltf_model, NULL, scene->nodes[i], gltf_data,
+                         &vertices, &gltf_model->vertices.count, &indices,
+                         &gltf_model->indices.count, load_options->scale);
+  }
 
-      // Load animations
-      if (gltf_data->animations_count > 0) {
-        gltf_model_load_animations(gltf_model, gltf_data);
-      }
+  // Load animations
+  if (gltf_data->animations_count > 0) {
+    gltf_model_load_animations(gltf_model, gltf_data);
+  }
 
-      // Load skins
-      gltf_model_load_skins(gltf_model, gltf_data);
+  // Load skins
+  gltf_model_load_skins(gltf_model, gltf_data);
 
-      // Assign skins and initial pose
-      for (uint32_t i = 0; i < gltf_model->linear_node_count; ++i) {
-        gltf_node_t* node = gltf_model->linear_nodes[i];
-        // Assign skins
-        if (node->skin_index > -1) {
-          node->skin = &gltf_model->skins[(uint32_t)node->skin_index];
-        }
-        // Initial pose
-        if (node->mesh != NULL) {
-          gltf_node_update(gltf_model->wgpu_context, node);
-        }
-      }
+  // Assign skins and initial pose
+  for (uint32_t i = 0; i < gltf_model->linear_node_count; ++i) {
+    gltf_node_t* node = gltf_model->linear_nodes[i];
+    // Assign skins
+    if (node->skin_index > -1) {
+      node->skin = &gltf_model->skins[(uint32_t)node->skin_index];
+    }
+    // Initial pose
+    if (node->mesh != NULL) {
+      gltf_node_update(gltf_model->wgpu_context, node);
     }
-  }
-  else {
-    log_error("Could not load gltf file: %s, error: %d\n",
-              load_options->filename, result);
-    return NULL;
   }
 
-  ASSERT(gltf_model != NULL);
-
   // Pre-Calculations for requested features
   if ((file_loading_flags & WGPU_GLTF_FileLoadingFlags_PreTransformVertices)
       || (file_loading_flags
@@ -1597,11 +1767,98 @@ gltf_model_t* wgpu_gltf_model_load_from_file(
   gltf_model_get_scene_dimensions(gltf_model);
 
   // Cleanup
-  cgltf_free(gltf_data);
+  gltf_model_data_destroy(model_data);
 
   return gltf_model;
 }
 
+gltf_model_t* wgpu_gltf_model_load_from_file(
+  struct wgpu_gltf_model_load_options_t* load_options)
+{
+  // The image decoding reads the supported formats of the texture client
+  if (load_options->wgpu_context->texture_client == NULL) {
+    wgpu_create_texture_client(load_options->wgpu_context);
+  }
+
+  return gltf_model_create_from_data(
+    load_options, gltf_model_data_load_from_file(load_options));
+}
+
+/* Asynchronous glTF model loading */
+
+typedef struct {
+  struct wgpu_gltf_model_load_options_t load_options;
+  char filename[STRMAX];
+  gltf_model_t** model;
+} gltf_model_async_load_t;
+
+static void* gltf_model_async_decode(void* user_data)
+{
+  gltf_model_async_load_t* load = (gltf_model_async_load_t*)user_data;
+  return gltf_model_data_load_from_file(&load->load_options);
+}
+
+static bool gltf_model_async_upload(wgpu_context_t* wgpu_context,
+                                    void* decoded, void* user_data)
+{
+  UNUSED_VAR(wgpu_context);
+
+  gltf_model_async_load_t* load = (gltf_model_async_load_t*)user_data;
+  gltf_model_data_t* model_data = (gltf_model_data_t*)decoded;
+
+  *load->model = gltf_model_create_from_data(&load->load_options, model_data);
+  const bool ready = *load->model != NULL;
+  free(load);
+  return ready;
+}
+
+wgpu_asset_t* wgpu_gltf_model_load_from_file_async(
+  struct wgpu_gltf_model_load_options_t* load_options,
+  struct gltf_model_t** model)
+{
+  wgpu_context_t* wgpu_context = load_options->wgpu_context;
+  if (wgpu_context->texture_client == NULL) {
+    wgpu_create_texture_client(wgpu_context);
+  }
+
+  gltf_model_async_load_t* load = calloc(1, sizeof(gltf_model_async_load_t));
+  load->load_options            = *load_options;
+  load->model                   = model;
+  snprintf(load->filename, sizeof(load->filename), "%s",
+           load_options->filename);
+  load->load_options.filename = load->filename;
+
+  wgpu_asset_desc_t asset_desc = {
+    .label     = load_options->filename,
+    .decode    = gltf_model_async_decode,
+    .upload    = gltf_model_async_upload,
+    .user_data = load,
+  };
+  return wgpu_load_asset_async(wgpu_context, &asset_desc);
+}
+
+/*
+ * Picks up the new locations of the mesh uniform buffers after the uniform
+ * heap was defragmented and rebuilds the node bind groups referencing them
+ */
+static void gltf_model_update_uniform_locations(gltf_model_t* model)
+{
+  const uint32_t generation
+    = wgpu_buffer_heap_get_generation(model->uniform_heap);
+  if (generation == model->uniform_heap_generation) {
+    return;
+  }
+  model->uniform_heap_generation = generation;
+
+  for (uint32_t i = 0; i < model->mesh_count; ++i) {
+    wgpu_buffer_update_location(&model->meshes[i].uniform_buffer.buffer);
+  }
+  if (model->node_bind_group_layout != NULL) {
+    wgpu_gltf_model_prepare_nodes_bind_group(model,
+                                             model->node_bind_group_layout);
+  }
+}
+
 static void gltf_model_bind_buffers(gltf_model_t* model)
 {
   wgpu_context_t* wgpu_context = model->wgpu_context;
@@ -1665,6 +1922,7 @@ gltf_model_draw_node(gltf_model_t* model, gltf_node_t* node,
 void wgpu_gltf_model_draw(gltf_model_t* model,
                           wgpu_gltf_model_render_options_t render_options)
 {
+  gltf_model_update_uniform_locations(model);
   if (!model->buffers_bound) {
     // All vertices and indices are stored in single buffers, so we only need to
     // bind once
@@ -1695,10 +1953,11 @@ gltf_model_prepare_node_bind_group(gltf_model_t* model, gltf_node_t* node,
       .entries    = &(WGPUBindGroupEntry) {
         .binding = 0,
         .buffer  = node->mesh->uniform_buffer.buffer.buffer,
-        .offset  = 0,
+        .offset  = node->mesh->uniform_buffer.buffer.offset,
         .size    =  node->mesh->uniform_buffer.buffer.size,
       },
     };
+    WGPU_RELEASE_RESOURCE(BindGroup, node->mesh->uniform_buffer.bind_group)
     node->mesh->uniform_buffer.bind_group
       = wgpuDeviceCreateBindGroup(model->wgpu_context->device, &bg_desc);
     ASSERT(node->mesh->uniform_buffer.bind_group != NULL)
@@ -1712,6 +1971,12 @@ gltf_model_prepare_node_bind_group(gltf_model_t* model, gltf_node_t* node,
 void wgpu_gltf_model_prepare_nodes_bind_group(
   gltf_model_t* model, WGPUBindGroupLayout bind_group_layout)
 {
+  // The layout is kept to rebuild the bind groups after a defragmentation
+  if (model->node_bind_group_layout != bind_group_layout) {
+    wgpuBindGroupLayoutReference(bind_group_layout);
+    WGPU_RELEASE_RESOURCE(BindGroupLayout, model->node_bind_group_layout)
+    model->node_bind_group_layout = bind_group_layout;
+  }
   for (uint32_t i = 0; i < model->node_count; ++i) {
     gltf_model_prepare_node_bind_group(model, &model->nodes[i],
                                        bind_group_layout);
@@ -1874,6 +2139,7 @@ void gltf_model_update_animation(gltf_model_t* model, uint32_t index,
     }
   }
   if (updated) {
+    gltf_model_update_uniform_locations(model);
     for (uint32_t i = 0; i < model->node_count; ++i) {
       gltf_node_update(model->wgpu_context, &model->nodes[i]);
     }
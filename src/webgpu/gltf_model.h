@@ -132,6 +132,15 @@ struct gltf_model_t* wgpu_gltf_model_load_from_file(
   struct wgpu_gltf_model_load_options_t* load_options);
 void wgpu_gltf_model_destroy(struct gltf_model_t* model);
 
+/**
+ * @brief Parses the file and decodes the images on a job worker, the model is
+ * created on the main thread and written to *model once the asset is ready.
+ * @return an asset handle the caller releases with wgpu_asset_release
+ */
+wgpu_asset_t* wgpu_gltf_model_load_from_file_async(
+  struct wgpu_gltf_model_load_options_t* load_options,
+  struct gltf_model_t** model);
+
 /**
  * @brief Returns the vertex attribute description for the given shader location
  * and component.
@@ -0,0 +1,414 @@
+#include "gpu_profiler.h"
+
+#include <cJSON.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/log.h"
+#include "../core/macro.h"
+#include "../core/platform.h"
+
+/* Number of query frames that can be recorded or read back concurrently */
+#define GPU_PROFILER_QUERY_FRAME_COUNT (WGPU_MAX_FRAMES_IN_FLIGHT + 1u)
+#define GPU_PROFILER_QUERY_COUNT (GPU_PROFILER_MAX_SCOPES * 2u)
+#define GPU_PROFILER_SCOPE_NAME_LENGTH 64u
+
+typedef enum query_frame_state_enum {
+  QueryFrameState_Idle      = 0,
+  QueryFrameState_Recording = 1,
+  QueryFrameState_Mapping   = 2,
+} query_frame_state_enum;
+
+/* Timestamp queries of a single frame */
+typedef struct query_frame_t {
+  gpu_profiler_t* profiler;
+  query_frame_state_enum state;
+  WGPUQuerySet query_set;
+  WGPUBuffer resolve_buffer;
+  WGPUBuffer readback_buffer;
+  struct {
+    uint32_t scope;        /* named scope the timestamp pair belongs to */
+    uint64_t cpu_begin_ns; /* CPU timing fallback */
+    bool ended;
+  } entries[GPU_PROFILER_MAX_SCOPES];
+  uint32_t entry_count;
+} query_frame_t;
+
+/* Named scope with its timing history */
+typedef struct profiler_scope_t {
+  char name[GPU_PROFILER_SCOPE_NAME_LENGTH];
+  float history[GPU_PROFILER_HISTORY_SIZE];
+  uint32_t history_index;
+  uint32_t sample_count;
+  float last;
+  float min;
+  float max;
+} profiler_scope_t;
+
+struct gpu_profiler_t {
+  wgpu_context_t* wgpu_context;
+  bool gpu_timing;
+  query_frame_t query_frames[GPU_PROFILER_QUERY_FRAME_COUNT];
+  query_frame_t* current;
+  profiler_scope_t scopes[GPU_PROFILER_MAX_SCOPES];
+  uint32_t scope_count;
+};
+
+static bool gpu_profiler_supports_gpu_timing(wgpu_context_t* wgpu_context)
+{
+  if (!wgpu_has_feature(wgpu_context, WGPUFeatureName_TimestampQuery)) {
+    return false;
+  }
+
+  /* The Null backend does not execute any work, timestamps are meaningless */
+  WGPUAdapterProperties properties = {0};
+  wgpuAdapterGetProperties(wgpu_context->adapter, &properties);
+  return properties.backendType != WGPUBackendType_Null;
+}
+
+gpu_profiler_t* gpu_profiler_create(wgpu_context_t* wgpu_context)
+{
+  gpu_profiler_t* profiler = (gpu_profiler_t*)calloc(1, sizeof(*profiler));
+  profiler->wgpu_context   = wgpu_context;
+  profiler->gpu_timing     = gpu_profiler_supports_gpu_timing(wgpu_context);
+
+  if (!profiler->gpu_timing) {
+    log_info("GPU timestamp queries not available, using CPU timing");
+    return profiler;
+  }
+
+  const uint64_t buffer_size = GPU_PROFILER_QUERY_COUNT * sizeof(uint64_t);
+  for (uint32_t i = 0; i < GPU_PROFILER_QUERY_FRAME_COUNT; ++i) {
+    query_frame_t* frame = &profiler->query_frames[i];
+    frame->profiler      = profiler;
+    frame->state         = QueryFrameState_Idle;
+    frame->query_set     = wgpuDeviceCreateQuerySet(
+      wgpu_context->device, &(WGPUQuerySetDescriptor){
+                              .label = "Profiler timestamp query set",
+                              .type  = WGPUQueryType_Timestamp,
+                              .count = GPU_PROFILER_QUERY_COUNT,
+                            });
+    frame->resolve_buffer = wgpuDeviceCreateBuffer(
+      wgpu_context->device,
+      &(WGPUBufferDescriptor){
+        .label = "Profiler resolve buffer",
+        .usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc,
+        .size  = buffer_size,
+      });
+    frame->readback_buffer = wgpuDeviceCreateBuffer(
+      wgpu_context->device,
+      &(WGPUBufferDescriptor){
+        .label = "Profiler readback buffer",
+        .usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst,
+        .size  = buffer_size,
+      });
+    ASSERT(frame->query_set && frame->resolve_buffer
+           && frame->readback_buffer);
+  }
+
+  return profiler;
+}
+
+void gpu_profiler_destroy(gpu_profiler_t* profiler)
+{
+  if (profiler == NULL) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < GPU_PROFILER_QUERY_FRAME_COUNT; ++i) {
+    query_frame_t* frame = &profiler->query_frames[i];
+    /* The readback callback references the query frame */
+    while (frame->state == QueryFrameState_Mapping) {
+      wgpuDeviceTick(profiler->wgpu_context->device);
+    }
+    WGPU_RELEASE_RESOURCE(QuerySet, frame->query_set)
+    WGPU_RELEASE_RESOURCE(Buffer, frame->resolve_buffer)
+    WGPU_RELEASE_RESOURCE(Buffer, frame->readback_buffer)
+  }
+
+  free(profiler);
+}
+
+bool gpu_profiler_has_gpu_timing(gpu_profiler_t* profiler)
+{
+  return profiler->gpu_timing;
+}
+
+static uint32_t gpu_profiler_find_scope(gpu_profiler_t* profiler,
+                                        const char* name)
+{
+  for (uint32_t i = 0; i < profiler->scope_count; ++i) {
+    if (strcmp(profiler->scopes[i].name, name) == 0) {
+      return i;
+    }
+  }
+
+  if (profiler->scope_count >= GPU_PROFILER_MAX_SCOPES) {
+    return GPU_PROFILER_MAX_SCOPES;
+  }
+
+  profiler_scope_t* scope = &profiler->scopes[profiler->scope_count];
+  memset(scope, 0, sizeof(*scope));
+  snprintf(scope->name, sizeof(scope->name), "%s", name);
+  return profiler->scope_count++;
+}
+
+static void gpu_profiler_add_sample(gpu_profiler_t* profiler, uint32_t index,
+                                    float duration_ms)
+{
+  profiler_scope_t* scope              = &profiler->scopes[index];
+  scope->history[scope->history_index] = duration_ms;
+  scope->history_index
+    = (scope->history_index + 1) % GPU_PROFILER_HISTORY_SIZE;
+  if (scope->sample_count == 0) {
+    scope->min = duration_ms;
+    scope->max = duration_ms;
+  }
+  else {
+    scope->min = MIN(scope->min, duration_ms);
+    scope->max = MAX(scope->max, duration_ms);
+  }
+  scope->last = duration_ms;
+  ++scope->sample_count;
+}
+
+void gpu_profiler_begin_frame(gpu_profiler_t* profiler)
+{
+  if (profiler == NULL) {
+    return;
+  }
+
+  profiler->current = NULL;
+  if (!profiler->gpu_timing) {
+    /* The CPU timing fallback samples its scopes when they end */
+    profiler->query_frames[0].entry_count = 0;
+    return;
+  }
+
+  /* Skip profiling this frame rather than waiting for a pending readback */
+  for (uint32_t i = 0; i < GPU_PROFILER_QUERY_FRAME_COUNT; ++i) {
+    query_frame_t* frame = &profiler->query_frames[i];
+    if (frame->state == QueryFrameState_Idle) {
+      frame->state       = QueryFrameState_Recording;
+      frame->entry_count = 0;
+      profiler->current  = frame;
+      break;
+    }
+  }
+}
+
+static void gpu_profiler_readback_callback(WGPUBufferMapAsyncStatus status,
+                                           void* user_data)
+{
+  query_frame_t* frame     = (query_frame_t*)user_data;
+  gpu_profiler_t* profiler = frame->profiler;
+
+  if (status == WGPUBufferMapAsyncStatus_Success) {
+    const uint64_t* timestamps
+      = (const uint64_t*)wgpuBufferGetConstMappedRange(
+        frame->readback_buffer, 0, frame->entry_count * 2 * sizeof(uint64_t));
+    ASSERT(timestamps != NULL);
+    for (uint32_t i = 0; timestamps != NULL && i < frame->entry_count; ++i) {
+      const uint64_t begin = timestamps[i * 2], end = timestamps[i * 2 + 1];
+      if (frame->entries[i].ended && end >= begin) {
+        /* Timestamps are converted to nanoseconds by Dawn */
+        gpu_profiler_add_sample(profiler, frame->entries[i].scope,
+                                (float)((double)(end - begin) / MILLION));
+      }
+    }
+    wgpuBufferUnmap(frame->readback_buffer);
+  }
+
+  frame->state = QueryFrameState_Idle;
+}
+
+void gpu_profiler_end_frame(gpu_profiler_t* profiler)
+{
+  if (profiler == NULL) {
+    return;
+  }
+
+  query_frame_t* frame = profiler->current;
+  profiler->current    = NULL;
+  if (frame == NULL) {
+    return;
+  }
+
+  if (frame->entry_count == 0) {
+    frame->state = QueryFrameState_Idle;
+    return;
+  }
+
+  /* Resolve the queries of this frame and copy them into a mappable buffer */
+  wgpu_context_t* wgpu_context = profiler->wgpu_context;
+  const uint32_t query_count   = frame->entry_count * 2;
+  const uint64_t size          = query_count * sizeof(uint64_t);
+
+  WGPUCommandEncoder cmd_enc
+    = wgpuDeviceCreateCommandEncoder(wgpu_context->device, NULL);
+  wgpuCommandEncoderResolveQuerySet(cmd_enc, frame->query_set, 0, query_count,
+                                    frame->resolve_buffer, 0);
+  wgpuCommandEncoderCopyBufferToBuffer(cmd_enc, frame->resolve_buffer, 0,
+                                       frame->readback_buffer, 0, size);
+  WGPUCommandBuffer command_buffer = wgpu_get_command_buffer(cmd_enc);
+  WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_enc)
+  wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
+
+  frame->state = QueryFrameState_Mapping;
+  wgpuBufferMapAsync(frame->readback_buffer, WGPUMapMode_Read, 0, size,
+                     gpu_profiler_readback_callback, frame);
+}
+
+int32_t gpu_profiler_begin_scope(gpu_profiler_t* profiler,
+                                 WGPUCommandEncoder cmd_enc, const char* name)
+{
+  if (profiler == NULL) {
+    return -1;
+  }
+
+  const uint32_t scope = gpu_profiler_find_scope(profiler, name);
+  if (scope >= GPU_PROFILER_MAX_SCOPES) {
+    return -1;
+  }
+
+  if (!profiler->gpu_timing) {
+    /* CPU timing fallback: time spent encoding the scope, scopes beyond the
+     * table size are dropped as they would overwrite open ones */
+    query_frame_t* frame = &profiler->query_frames[0];
+    if (frame->entry_count >= GPU_PROFILER_MAX_SCOPES) {
+      return -1;
+    }
+    const uint32_t entry               = frame->entry_count++;
+    frame->entries[entry].scope        = scope;
+    frame->entries[entry].cpu_begin_ns = platform_get_time_ns();
+    frame->entries[entry].ended        = false;
+    return (int32_t)entry;
+  }
+
+  query_frame_t* frame = profiler->current;
+  if (frame == NULL || frame->entry_count >= GPU_PROFILER_MAX_SCOPES) {
+    return -1;
+  }
+
+  const uint32_t entry        = frame->entry_count++;
+  frame->entries[entry].scope = scope;
+  frame->entries[entry].ended = false;
+  wgpuCommandEncoderWriteTimestamp(cmd_enc, frame->query_set, entry * 2);
+  return (int32_t)entry;
+}
+
+void gpu_profiler_end_scope(gpu_profiler_t* profiler,
+                            WGPUCommandEncoder cmd_enc, int32_t scope)
+{
+  if (profiler == NULL || scope < 0) {
+    return;
+  }
+
+  if (!profiler->gpu_timing) {
+    query_frame_t* frame = &profiler->query_frames[0];
+    if ((uint32_t)scope >= frame->entry_count || frame->entries[scope].ended) {
+      return;
+    }
+    const uint64_t begin_ns = frame->entries[scope].cpu_begin_ns;
+    const float duration_ms
+      = (float)((double)(platform_get_time_ns() - begin_ns) / MILLION);
+    frame->entries[scope].ended = true;
+    gpu_profiler_add_sample(profiler, frame->entries[scope].scope,
+                            duration_ms);
+    return;
+  }
+
+  query_frame_t* frame = profiler->current;
+  if (frame == NULL || (uint32_t)scope >= frame->entry_count) {
+    return;
+  }
+
+  wgpuCommandEncoderWriteTimestamp(cmd_enc, frame->query_set,
+                                   (uint32_t)scope * 2 + 1);
+  frame->entries[scope].ended = true;
+}
+
+uint32_t gpu_profiler_get_scope_count(gpu_profiler_t* profiler)
+{
+  return profiler->scope_count;
+}
+
+void gpu_profiler_get_scope_stats(gpu_profiler_t* profiler, uint32_t index,
+                                  gpu_profiler_scope_stats_t* stats)
+{
+  ASSERT(index < profiler->scope_count);
+
+  profiler_scope_t* scope = &profiler->scopes[index];
+  const uint32_t count = MIN(scope->sample_count, GPU_PROFILER_HISTORY_SIZE);
+  float sum            = 0.0f;
+  for (uint32_t i = 0; i < count; ++i) {
+    sum += scope->history[i];
+  }
+
+  stats->name         = scope->name;
+  stats->sample_count = scope->sample_count;
+  stats->last         = scope->last;
+  stats->average      = count > 0 ? sum / (float)count : 0.0f;
+  stats->min          = scope->min;
+  stats->max          = scope->max;
+}
+
+uint32_t gpu_profiler_get_scope_history(gpu_profiler_t* profiler,
+                                        uint32_t index, float* values,
+                                        uint32_t max_count)
+{
+  ASSERT(index < profiler->scope_count);
+
+  /* Copy the history ring buffer from the oldest to the newest sample */
+  profiler_scope_t* scope = &profiler->scopes[index];
+  const uint32_t count
+    = MIN(MIN(scope->sample_count, GPU_PROFILER_HISTORY_SIZE), max_count);
+  const uint32_t first = (scope->history_index + GPU_PROFILER_HISTORY_SIZE
+                          - count)
+                         % GPU_PROFILER_HISTORY_SIZE;
+  for (uint32_t i = 0; i < count; ++i) {
+    values[i] = scope->history[(first + i) % GPU_PROFILER_HISTORY_SIZE];
+  }
+  return count;
+}
+
+int gpu_profiler_write_json(gpu_profiler_t* profiler, const char* filename)
+{
+  cJSON* json = cJSON_CreateObject();
+  cJSON_AddBoolToObject(json, "gpu_timing", profiler->gpu_timing);
+  cJSON* scopes = cJSON_AddArrayToObject(json, "scopes");
+
+  float history[GPU_PROFILER_HISTORY_SIZE];
+  for (uint32_t i = 0; i < profiler->scope_count; ++i) {
+    gpu_profiler_scope_stats_t stats = {0};
+    gpu_profiler_get_scope_stats(profiler, i, &stats);
+    const uint32_t history_count = gpu_profiler_get_scope_history(
+      profiler, i, history, GPU_PROFILER_HISTORY_SIZE);
+
+    cJSON* scope = cJSON_CreateObject();
+    cJSON_AddStringToObject(scope, "name", stats.name);
+    cJSON_AddNumberToObject(scope, "samples", stats.sample_count);
+    cJSON_AddNumberToObject(scope, "average_ms", stats.average);
+    cJSON_AddNumberToObject(scope, "min_ms", stats.min);
+    cJSON_AddNumberToObject(scope, "max_ms", stats.max);
+    cJSON_AddItemToObject(scope, "history_ms",
+                          cJSON_CreateFloatArray(history, (int)history_count));
+    cJSON_AddItemToArray(scopes, scope);
+  }
+
+  int res      = -1;
+  char* string = cJSON_Print(json);
+  FILE* file   = fopen(filename, "w");
+  if (file != NULL) {
+    fprintf(file, "%s\n", string);
+    fclose(file);
+    res = 0;
+  }
+  else {
+    log_error("Unable to open file '%s'\n", filename);
+  }
+
+  cJSON_free(string);
+  cJSON_Delete(json);
+  return res;
+}
@@ -0,0 +1,47 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include "context.h"
+
+#define GPU_PROFILER_MAX_SCOPES 32u
+#define GPU_PROFILER_HISTORY_SIZE 128u
+
+typedef struct gpu_profiler_t gpu_profiler_t;
+
+/* Timing statistics of a named profiler scope (in milliseconds) */
+typedef struct gpu_profiler_scope_stats_t {
+  const char* name;
+  uint32_t sample_count;
+  float last;
+  float average;
+  float min;
+  float max;
+} gpu_profiler_scope_stats_t;
+
+/* GPU profiler creating/releasing */
+gpu_profiler_t* gpu_profiler_create(wgpu_context_t* wgpu_context);
+void gpu_profiler_destroy(gpu_profiler_t* profiler);
+
+/* Returns false if the profiler fell back to CPU timing */
+bool gpu_profiler_has_gpu_timing(gpu_profiler_t* profiler);
+
+/* Frame handling, resolved timestamps are read back asynchronously */
+void gpu_profiler_begin_frame(gpu_profiler_t* profiler);
+void gpu_profiler_end_frame(gpu_profiler_t* profiler);
+
+/* Named scopes, recorded on the encoder outside of render / compute passes */
+int32_t gpu_profiler_begin_scope(gpu_profiler_t* profiler,
+                                 WGPUCommandEncoder cmd_enc, const char* name);
+void gpu_profiler_end_scope(gpu_profiler_t* profiler,
+                            WGPUCommandEncoder cmd_enc, int32_t scope);
+
+/* Profiler results */
+uint32_t gpu_profiler_get_scope_count(gpu_profiler_t* profiler);
+void gpu_profiler_get_scope_stats(gpu_profiler_t* profiler, uint32_t index,
+                                  gpu_profiler_scope_stats_t* stats);
+uint32_t gpu_profiler_get_scope_history(gpu_profiler_t* profiler,
+                                        uint32_t index, float* values,
+                                        uint32_t max_count);
+int gpu_profiler_write_json(gpu_profiler_t* profiler, const char* filename);
+
+#endif
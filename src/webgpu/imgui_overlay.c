@@ -15,6 +15,7 @@
 #define ImDrawCallback_ResetRenderState (ImDrawCallback)(-1)
 
 #include "../core/macro.h"
+#include "gpu_profiler.h"
 #include "shader.h"
 
 #define _IMGUI_MAX_VERTEX_DATA_SIZE_DEFAULT 40000
@@ -185,11 +186,10 @@ static void imgui_overlay_create_fonts_texture(imgui_overlay_t* imgui_overlay)
 
     WGPUCommandBuffer copy_command = wgpu_copy_buffer_to_texture(
       wgpu_context, &buffer_copy_view, &texture_copy_view, &texture_size);
-    // Submit to the queue
-    wgpuQueueSubmit(wgpu_context->queue, 1, &copy_command);
+    // Submit to the queue, this releases the command buffer
+    wgpu_flush_command_buffers(wgpu_context, &copy_command, 1);
 
-    // Release command buffer and staging buffer
-    WGPU_RELEASE_RESOURCE(CommandBuffer, copy_command)
+    // Release staging buffer
     wgpu_destroy_buffer(&gpu_buffer);
 
     // Create texture view
@@ -562,6 +562,9 @@ void imgui_overlay_draw_frame(imgui_overlay_t* imgui_overlay,
 
   // Set texture view
   imgui_overlay->rp_color_att_descriptors[0].view = view;
+  const int32_t profiler_scope = gpu_profiler_begin_scope(
+    imgui_overlay->wgpu_context->profiler, imgui_overlay->wgpu_context->cmd_enc,
+    "ImGui overlay");
   imgui_overlay->wgpu_context->rpass_enc = wgpuCommandEncoderBeginRenderPass(
     imgui_overlay->wgpu_context->cmd_enc, &imgui_overlay->render_pass_desc);
   WGPURenderPassEncoder rpass_enc = imgui_overlay->wgpu_context->rpass_enc;
@@ -614,6 +617,8 @@ void imgui_overlay_draw_frame(imgui_overlay_t* imgui_overlay,
 
   wgpuRenderPassEncoderEnd(rpass_enc);
   WGPU_RELEASE_RESOURCE(RenderPassEncoder, rpass_enc)
+  gpu_profiler_end_scope(imgui_overlay->wgpu_context->profiler,
+                         imgui_overlay->wgpu_context->cmd_enc, profiler_scope);
 }
 
 // Update vertex and index buffer containing the imGui elements when required
@@ -452,8 +452,7 @@ texture_t pbr_generate_brdf_lut(wgpu_context_t* wgpu_context)
     WGPU_RELEASE_RESOURCE(CommandEncoder, wgpu_context->cmd_enc)
 
     // Sumbit commmand buffer and cleanup
-    wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
-    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
+    wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
   }
 
   /* Cleanup */
@@ -1045,8 +1044,7 @@ texture_t pbr_generate_cubemap(wgpu_context_t* wgpu_context,
     WGPU_RELEASE_RESOURCE(CommandEncoder, wgpu_context->cmd_enc)
 
     // Sumbit commmand buffer and cleanup
-    wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
-    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
+    wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
   }
 
   // Cleanup
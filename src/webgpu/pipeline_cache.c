@@ -0,0 +1,327 @@
+#include "pipeline_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/hashmap.h"
+#include "../core/log.h"
+#include "../core/macro.h"
+#include "../core/platform.h"
+
+#include "context.h"
+
+/* Serialized descriptor, the key of the cached pipelines */
+typedef struct pipeline_key_t {
+  uint8_t* data;
+  size_t size;
+  size_t capacity;
+} pipeline_key_t;
+
+/* Hash map item, the objects referenced by the key are kept alive so their
+ * handles cannot be reused by other objects */
+typedef struct pipeline_cache_entry_t {
+  uint64_t hash;
+  pipeline_key_t key;
+  WGPURenderPipeline pipeline;
+  WGPUPipelineLayout layout;
+  WGPUShaderModule vertex_module;
+  WGPUShaderModule fragment_module;
+  uint64_t creation_time_ns;
+  uint32_t hit_count;
+} pipeline_cache_entry_t;
+
+struct wgpu_pipeline_cache_t {
+  wgpu_context_t* wgpu_context;
+  struct hashmap* entries;
+  wgpu_pipeline_cache_stats_t stats;
+};
+
+/* Key serialization */
+
+static void key_write(pipeline_key_t* key, const void* data, size_t size)
+{
+  if (key->size + size > key->capacity) {
+    key->capacity = MAX(key->capacity * 2, key->size + size);
+    key->data     = (uint8_t*)realloc(key->data, key->capacity);
+  }
+  memcpy(key->data + key->size, data, size);
+  key->size += size;
+}
+
+static void key_write_u32(pipeline_key_t* key, uint32_t value)
+{
+  key_write(key, &value, sizeof(value));
+}
+
+static void key_write_u64(pipeline_key_t* key, uint64_t value)
+{
+  key_write(key, &value, sizeof(value));
+}
+
+static void key_write_ptr(pipeline_key_t* key, const void* value)
+{
+  key_write(key, &value, sizeof(value));
+}
+
+static void key_write_string(pipeline_key_t* key, const char* value)
+{
+  const uint32_t length = value ? (uint32_t)strlen(value) : UINT32_MAX;
+  key_write_u32(key, length);
+  if (value != NULL) {
+    key_write(key, value, length);
+  }
+}
+
+static void key_write_constants(pipeline_key_t* key,
+                                const WGPUConstantEntry* constants,
+                                size_t count)
+{
+  key_write_u32(key, (uint32_t)count);
+  for (size_t i = 0; i < count; ++i) {
+    key_write_string(key, constants[i].key);
+    key_write(key, &constants[i].value, sizeof(constants[i].value));
+  }
+}
+
+static void key_write_stencil_face(pipeline_key_t* key,
+                                   const WGPUStencilFaceState* state)
+{
+  key_write_u32(key, (uint32_t)state->compare);
+  key_write_u32(key, (uint32_t)state->failOp);
+  key_write_u32(key, (uint32_t)state->depthFailOp);
+  key_write_u32(key, (uint32_t)state->passOp);
+}
+
+static void key_write_blend_component(pipeline_key_t* key,
+                                      const WGPUBlendComponent* component)
+{
+  key_write_u32(key, (uint32_t)component->operation);
+  key_write_u32(key, (uint32_t)component->srcFactor);
+  key_write_u32(key, (uint32_t)component->dstFactor);
+}
+
+/* Returns false for descriptors with chained structs, they are not cached */
+static bool key_write_descriptor(pipeline_key_t* key,
+                                 const WGPURenderPipelineDescriptor* desc)
+{
+  if (desc->nextInChain || desc->primitive.nextInChain
+      || desc->vertex.nextInChain || desc->multisample.nextInChain
+      || (desc->depthStencil && desc->depthStencil->nextInChain)
+      || (desc->fragment && desc->fragment->nextInChain)) {
+    return false;
+  }
+
+  key_write_ptr(key, desc->layout);
+
+  /* Primitive state */
+  key_write_u32(key, (uint32_t)desc->primitive.topology);
+  key_write_u32(key, (uint32_t)desc->primitive.stripIndexFormat);
+  key_write_u32(key, (uint32_t)desc->primitive.frontFace);
+  key_write_u32(key, (uint32_t)desc->primitive.cullMode);
+
+  /* Vertex state */
+  const WGPUVertexState* vertex = &desc->vertex;
+  key_write_ptr(key, vertex->module);
+  key_write_string(key, vertex->entryPoint);
+  key_write_constants(key, vertex->constants, vertex->constantCount);
+  key_write_u32(key, (uint32_t)vertex->bufferCount);
+  for (size_t i = 0; i < vertex->bufferCount; ++i) {
+    const WGPUVertexBufferLayout* layout = &vertex->buffers[i];
+    key_write_u64(key, layout->arrayStride);
+    key_write_u32(key, (uint32_t)layout->stepMode);
+    key_write_u32(key, (uint32_t)layout->attributeCount);
+    for (size_t j = 0; j < layout->attributeCount; ++j) {
+      key_write_u32(key, (uint32_t)layout->attributes[j].format);
+      key_write_u64(key, layout->attributes[j].offset);
+      key_write_u32(key, layout->attributes[j].shaderLocation);
+    }
+  }
+
+  /* Depth stencil state */
+  const WGPUDepthStencilState* depth_stencil = desc->depthStencil;
+  key_write_u32(key, depth_stencil != NULL);
+  if (depth_stencil != NULL) {
+    key_write_u32(key, (uint32_t)depth_stencil->format);
+    key_write_u32(key, depth_stencil->depthWriteEnabled);
+    key_write_u32(key, (uint32_t)depth_stencil->depthCompare);
+    key_write_stencil_face(key, &depth_stencil->stencilFront);
+    key_write_stencil_face(key, &depth_stencil->stencilBack);
+    key_write_u32(key, depth_stencil->stencilReadMask);
+    key_write_u32(key, depth_stencil->stencilWriteMask);
+    key_write_u32(key, (uint32_t)depth_stencil->depthBias);
+    key_write(key, &depth_stencil->depthBiasSlopeScale, sizeof(float));
+    key_write(key, &depth_stencil->depthBiasClamp, sizeof(float));
+  }
+
+  /* Multisample state */
+  key_write_u32(key, desc->multisample.count);
+  key_write_u32(key, desc->multisample.mask);
+  key_write_u32(key, desc->multisample.alphaToCoverageEnabled);
+
+  /* Fragment state */
+  const WGPUFragmentState* fragment = desc->fragment;
+  key_write_u32(key, fragment != NULL);
+  if (fragment != NULL) {
+    key_write_ptr(key, fragment->module);
+    key_write_string(key, fragment->entryPoint);
+    key_write_constants(key, fragment->constants, fragment->constantCount);
+    key_write_u32(key, (uint32_t)fragment->targetCount);
+    for (size_t i = 0; i < fragment->targetCount; ++i) {
+      const WGPUColorTargetState* target = &fragment->targets[i];
+      if (target->nextInChain) {
+        return false;
+      }
+      key_write_u32(key, (uint32_t)target->format);
+      key_write_u32(key, (uint32_t)target->writeMask);
+      key_write_u32(key, target->blend != NULL);
+      if (target->blend != NULL) {
+        key_write_blend_component(key, &target->blend->color);
+        key_write_blend_component(key, &target->blend->alpha);
+      }
+    }
+  }
+
+  return true;
+}
+
+/* Hash map callbacks */
+
+static uint64_t pipeline_cache_entry_hash(const void* item, uint64_t seed0,
+                                          uint64_t seed1)
+{
+  UNUSED_VAR(seed0);
+  UNUSED_VAR(seed1);
+
+  return ((const pipeline_cache_entry_t*)item)->hash;
+}
+
+static int pipeline_cache_entry_compare(const void* a, const void* b,
+                                        void* udata)
+{
+  UNUSED_VAR(udata);
+
+  const pipeline_key_t* ka = &((const pipeline_cache_entry_t*)a)->key;
+  const pipeline_key_t* kb = &((const pipeline_cache_entry_t*)b)->key;
+  if (ka->size != kb->size) {
+    return (ka->size > kb->size) ? 1 : -1;
+  }
+  return memcmp(ka->data, kb->data, ka->size);
+}
+
+static void pipeline_cache_entry_free(void* item)
+{
+  pipeline_cache_entry_t* entry = (pipeline_cache_entry_t*)item;
+  WGPU_RELEASE_RESOURCE(RenderPipeline, entry->pipeline)
+  WGPU_RELEASE_RESOURCE(PipelineLayout, entry->layout)
+  WGPU_RELEASE_RESOURCE(ShaderModule, entry->vertex_module)
+  WGPU_RELEASE_RESOURCE(ShaderModule, entry->fragment_module)
+  free(entry->key.data);
+}
+
+/* Pipeline cache creating/releasing */
+
+wgpu_pipeline_cache_t*
+wgpu_pipeline_cache_create(struct wgpu_context_t* wgpu_context)
+{
+  wgpu_pipeline_cache_t* cache
+    = (wgpu_pipeline_cache_t*)calloc(1, sizeof(wgpu_pipeline_cache_t));
+  cache->wgpu_context = wgpu_context;
+  cache->entries
+    = hashmap_new(sizeof(pipeline_cache_entry_t), 0, 0, 0,
+                  pipeline_cache_entry_hash, pipeline_cache_entry_compare,
+                  pipeline_cache_entry_free, NULL);
+
+  return cache;
+}
+
+void wgpu_pipeline_cache_destroy(wgpu_pipeline_cache_t* cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+
+  hashmap_free(cache->entries);
+  free(cache);
+}
+
+void wgpu_pipeline_cache_clear(wgpu_pipeline_cache_t* cache)
+{
+  hashmap_clear(cache->entries, false);
+  cache->stats.creation_time_ms = 0.0;
+}
+
+/* Pipeline lookup */
+
+static WGPURenderPipeline
+pipeline_cache_create_pipeline(wgpu_pipeline_cache_t* cache,
+                               const WGPURenderPipelineDescriptor* desc,
+                               uint64_t* creation_time_ns)
+{
+  const uint64_t start = platform_get_time_ns();
+  WGPURenderPipeline pipeline
+    = wgpuDeviceCreateRenderPipeline(cache->wgpu_context->device, desc);
+  *creation_time_ns = platform_get_time_ns() - start;
+  return pipeline;
+}
+
+WGPURenderPipeline
+wgpu_pipeline_cache_get_render_pipeline(wgpu_pipeline_cache_t* cache,
+                                        const WGPURenderPipelineDescriptor* desc)
+{
+  pipeline_cache_entry_t lookup = {0};
+  uint64_t creation_time_ns     = 0;
+  if (!key_write_descriptor(&lookup.key, desc)) {
+    free(lookup.key.data);
+    ++cache->stats.uncached_count;
+    return pipeline_cache_create_pipeline(cache, desc, &creation_time_ns);
+  }
+  lookup.hash = hashmap_murmur(lookup.key.data, lookup.key.size, 0, 0);
+
+  pipeline_cache_entry_t* entry
+    = (pipeline_cache_entry_t*)hashmap_get(cache->entries, &lookup);
+  if (entry != NULL) {
+    free(lookup.key.data);
+    ++entry->hit_count;
+    ++cache->stats.hit_count;
+    cache->stats.saved_time_ms += entry->creation_time_ns / 1000000.0;
+    wgpuRenderPipelineReference(entry->pipeline);
+    return entry->pipeline;
+  }
+
+  ++cache->stats.miss_count;
+  lookup.pipeline
+    = pipeline_cache_create_pipeline(cache, desc, &creation_time_ns);
+  if (lookup.pipeline == NULL) {
+    log_error("Unable to create render pipeline \"%s\"",
+              desc->label ? desc->label : "");
+    free(lookup.key.data);
+    return NULL;
+  }
+  cache->stats.creation_time_ms += creation_time_ns / 1000000.0;
+
+  /* The cache and the caller both own a reference */
+  lookup.creation_time_ns = creation_time_ns;
+  lookup.layout           = desc->layout;
+  lookup.vertex_module    = desc->vertex.module;
+  lookup.fragment_module  = desc->fragment ? desc->fragment->module : NULL;
+  if (lookup.layout != NULL) {
+    wgpuPipelineLayoutReference(lookup.layout);
+  }
+  if (lookup.vertex_module != NULL) {
+    wgpuShaderModuleReference(lookup.vertex_module);
+  }
+  if (lookup.fragment_module != NULL) {
+    wgpuShaderModuleReference(lookup.fragment_module);
+  }
+  wgpuRenderPipelineReference(lookup.pipeline);
+  hashmap_set(cache->entries, &lookup);
+
+  return lookup.pipeline;
+}
+
+void wgpu_pipeline_cache_get_stats(wgpu_pipeline_cache_t* cache,
+                                   wgpu_pipeline_cache_stats_t* stats)
+{
+  *stats             = cache->stats;
+  stats->entry_count = (uint32_t)hashmap_count(cache->entries);
+}
@@ -0,0 +1,44 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+/* Forward declarations */
+struct wgpu_context_t;
+
+typedef struct wgpu_pipeline_cache_t wgpu_pipeline_cache_t;
+
+typedef struct wgpu_pipeline_cache_stats_t {
+  uint32_t entry_count;    /* cached pipelines */
+  uint64_t hit_count;      /* lookups served from the cache */
+  uint64_t miss_count;     /* lookups that created a pipeline */
+  uint64_t uncached_count; /* descriptors with unsupported chained structs */
+  double creation_time_ms; /* time spent creating the cached pipelines */
+  double saved_time_ms;    /* estimated creation time saved by the hits */
+} wgpu_pipeline_cache_stats_t;
+
+/* Pipeline cache creating/releasing */
+wgpu_pipeline_cache_t*
+wgpu_pipeline_cache_create(struct wgpu_context_t* wgpu_context);
+void wgpu_pipeline_cache_destroy(wgpu_pipeline_cache_t* cache);
+
+/**
+ * @brief Returns a render pipeline for the descriptor, creating it on the first
+ * request. Descriptors are compared by content, except for the shader modules
+ * and the pipeline layout which are compared by identity. The label is ignored.
+ * @return a new reference the caller releases with WGPU_RELEASE_RESOURCE, the
+ * cache keeps its own reference until it is cleared
+ */
+WGPURenderPipeline
+wgpu_pipeline_cache_get_render_pipeline(wgpu_pipeline_cache_t* cache,
+                                        const WGPURenderPipelineDescriptor* desc);
+
+/* Drops the references held by the cache */
+void wgpu_pipeline_cache_clear(wgpu_pipeline_cache_t* cache);
+
+void wgpu_pipeline_cache_get_stats(wgpu_pipeline_cache_t* cache,
+                                   wgpu_pipeline_cache_stats_t* stats);
+
+#endif
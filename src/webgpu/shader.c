@@ -4,8 +4,10 @@
 #include <string.h>
 
 #include "../core/file.h"
+#include "../core/hashmap.h"
 #include "../core/log.h"
 #include "../core/macro.h"
+#include "../core/platform.h"
 
 static void
 wgpu_compilation_info_callback(WGPUCompilationInfoRequestStatus status,
@@ -25,57 +27,223 @@ wgpu_compilation_info_callback(WGPUCompilationInfoRequestStatus status,
 WGPUShaderModule wgpu_create_shader_module_from_spirv_file(WGPUDevice device,
                                                            const char* filename)
 {
-  file_read_result_t result;
-  read_file(filename, &result, 0);
-  log_debug("Read file: %s, size: %d bytes\n", filename, result.size);
+  file_view_t view;
+  if (!file_view_open(filename, FileViewFlags_Sequential, &view)) {
+    return NULL;
+  }
+  log_debug("Read file: %s, size: %zu bytes\n", filename, view.size);
   WGPUShaderModule shader_module
-    = wgpu_create_shader_module_from_spirv_bytecode(device, result.data,
-                                                    result.size);
-  free(result.data);
+    = wgpu_create_shader_module_from_spirv_bytecode(device, view.data,
+                                                    (uint32_t)view.size);
+  file_view_close(&view);
   return shader_module;
 }
 
 WGPUShaderModule wgpu_create_shader_module_from_wgsl_file(WGPUDevice device,
                                                           const char* filename)
 {
-  file_read_result_t result;
-  read_file(filename, &result, 1);
-  log_debug("Read file: %s, size: %d bytes\n", filename, result.size);
+  file_view_t view;
+  if (!file_view_open(filename, FileViewFlags_Text | FileViewFlags_Sequential,
+                      &view)) {
+    return NULL;
+  }
+  log_debug("Read file: %s, size: %zu bytes\n", filename, view.size);
   WGPUShaderModule shader_module
-    = wgpu_create_shader_module_from_wgsl(device, (char*)result.data);
-  free(result.data);
+    = wgpu_create_shader_module_from_wgsl(device, (const char*)view.data);
+  file_view_close(&view);
   return shader_module;
 }
 
+/* Shader module cache */
+
+typedef struct shader_cache_entry_t {
+  uint64_t hash;
+  bool spirv;
+  uint8_t* code; /* copy of the WGSL source or SPIR-V bytes */
+  size_t size;
+  char* label;
+  WGPUShaderModule module;
+  uint64_t creation_time_ns;
+} shader_cache_entry_t;
+
+struct wgpu_shader_cache_t {
+  struct hashmap* entries;
+  wgpu_shader_cache_stats_t stats;
+};
+
+static uint64_t shader_cache_entry_hash(const void* item, uint64_t seed0,
+                                        uint64_t seed1)
+{
+  UNUSED_VAR(seed0);
+  UNUSED_VAR(seed1);
+
+  return ((const shader_cache_entry_t*)item)->hash;
+}
+
+static int shader_cache_entry_compare(const void* a, const void* b,
+                                      void* udata)
+{
+  UNUSED_VAR(udata);
+
+  const shader_cache_entry_t* ea = (const shader_cache_entry_t*)a;
+  const shader_cache_entry_t* eb = (const shader_cache_entry_t*)b;
+  if (ea->spirv != eb->spirv || ea->size != eb->size) {
+    return 1;
+  }
+  const int label_cmp
+    = strcmp(ea->label ? ea->label : "", eb->label ? eb->label : "");
+  return (label_cmp != 0) ? label_cmp : memcmp(ea->code, eb->code, ea->size);
+}
+
+static void shader_cache_entry_free(void* item)
+{
+  shader_cache_entry_t* entry = (shader_cache_entry_t*)item;
+  WGPU_RELEASE_RESOURCE(ShaderModule, entry->module)
+  free(entry->code);
+  free(entry->label);
+}
+
+wgpu_shader_cache_t* wgpu_shader_cache_create(void)
+{
+  wgpu_shader_cache_t* cache
+    = (wgpu_shader_cache_t*)calloc(1, sizeof(wgpu_shader_cache_t));
+  cache->entries
+    = hashmap_new(sizeof(shader_cache_entry_t), 0, 0, 0,
+                  shader_cache_entry_hash, shader_cache_entry_compare,
+                  shader_cache_entry_free, NULL);
+
+  return cache;
+}
+
+void wgpu_shader_cache_destroy(wgpu_shader_cache_t* cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+
+  hashmap_free(cache->entries);
+  free(cache);
+}
+
+void wgpu_shader_cache_get_stats(wgpu_shader_cache_t* cache,
+                                 wgpu_shader_cache_stats_t* stats)
+{
+  *stats             = cache->stats;
+  stats->entry_count = (uint32_t)hashmap_count(cache->entries);
+}
+
+static WGPUShaderModule create_shader_module(WGPUDevice device,
+                                             const uint8_t* code, size_t size,
+                                             bool spirv)
+{
+  return spirv ? wgpu_create_shader_module_from_spirv_bytecode(
+                   device, code, (uint32_t)size) :
+                 wgpu_create_shader_module_from_wgsl(device, (const char*)code);
+}
+
+/* Returns a new reference to the cached module, the WGSL code has to be zero
+ * terminated */
+static WGPUShaderModule shader_cache_get_module(wgpu_shader_cache_t* cache,
+                                                WGPUDevice device,
+                                                const uint8_t* code,
+                                                size_t size, bool spirv,
+                                                const char* label)
+{
+  shader_cache_entry_t lookup = {
+    .spirv = spirv,
+    .code  = (uint8_t*)code,
+    .size  = size,
+    .label = (char*)label,
+  };
+  lookup.hash = hashmap_murmur(code, size, spirv, 0);
+  if (label != NULL) {
+    lookup.hash ^= hashmap_murmur(label, strlen(label), 0, 1);
+  }
+
+  shader_cache_entry_t* entry
+    = (shader_cache_entry_t*)hashmap_get(cache->entries, &lookup);
+  if (entry != NULL) {
+    ++cache->stats.hit_count;
+    cache->stats.saved_time_ms += entry->creation_time_ns / 1000000.0;
+    wgpuShaderModuleReference(entry->module);
+    return entry->module;
+  }
+
+  ++cache->stats.miss_count;
+  const uint64_t start = platform_get_time_ns();
+  lookup.module        = create_shader_module(device, code, size, spirv);
+  if (lookup.module == NULL) {
+    return NULL;
+  }
+  lookup.creation_time_ns = platform_get_time_ns() - start;
+  cache->stats.compile_time_ms += lookup.creation_time_ns / 1000000.0;
+  cache->stats.source_bytes += size;
+
+  /* The cache owns copies of the key data */
+  lookup.code = (uint8_t*)malloc(spirv ? size : size + 1);
+  memcpy(lookup.code, code, spirv ? size : size + 1);
+  if (label != NULL) {
+    lookup.label = (char*)malloc(strlen(label) + 1);
+    memcpy(lookup.label, label, strlen(label) + 1);
+  }
+  wgpuShaderModuleReference(lookup.module);
+  hashmap_set(cache->entries, &lookup);
+
+  return lookup.module;
+}
+
 WGPUShaderModule
 wgpu_create_shader_module(wgpu_context_t* wgpu_context,
                           const wgpu_shader_desc_t* shader_desc)
 {
-  WGPUShaderModule shader_module = NULL;
+  file_view_t file    = {0};
+  const uint8_t* code = NULL;
+  size_t size         = 0;
+  bool spirv          = false;
 
   if (shader_desc->file != NULL) {
-    /* WebGPU Shader from file */
+    /* WebGPU Shader from file, the mapped bytes are used in place */
     if (filename_has_extension(shader_desc->file, "spv")) {
-      shader_module = wgpu_create_shader_module_from_spirv_file(
-        wgpu_context->device, shader_desc->file);
+      if (file_view_open(shader_desc->file, FileViewFlags_Sequential, &file)) {
+        code  = file.data;
+        size  = file.size;
+        spirv = true;
+      }
     }
     else if (filename_has_extension(shader_desc->file, "wgsl")) {
-      shader_module = wgpu_create_shader_module_from_wgsl_file(
-        wgpu_context->device, shader_desc->file);
+      if (file_view_open(shader_desc->file,
+                         FileViewFlags_Text | FileViewFlags_Sequential,
+                         &file)) {
+        code = file.data;
+        size = strlen((const char*)code);
+      }
     }
+    log_debug("Read file: %s, size: %zu bytes\n", shader_desc->file,
+              file.size);
   }
   else if ((shader_desc->byte_code.data != NULL)
            && (shader_desc->byte_code.size != 0)) {
     /* WebGPU Shader from SPIR-V bytecode */
-    shader_module = wgpu_create_shader_module_from_spirv_bytecode(
-      wgpu_context->device, shader_desc->byte_code.data,
-      shader_desc->byte_code.size);
+    code  = shader_desc->byte_code.data;
+    size  = shader_desc->byte_code.size;
+    spirv = true;
   }
   else if (shader_desc->wgsl_code.source != NULL) {
     /* WebGPU Shader from WGSL code */
-    shader_module = wgpu_create_shader_module_from_wgsl(
-      wgpu_context->device, shader_desc->wgsl_code.source);
+    code = (const uint8_t*)shader_desc->wgsl_code.source;
+    size = strlen(shader_desc->wgsl_code.source);
+  }
+
+  WGPUShaderModule shader_module = NULL;
+  if (code != NULL) {
+    shader_module
+      = (wgpu_context->shader_cache != NULL) ?
+          shader_cache_get_module(wgpu_context->shader_cache,
+                                  wgpu_context->device, code, size, spirv,
+                                  shader_desc->label) :
+          create_shader_module(wgpu_context->device, code, size, spirv);
   }
+  file_view_close(&file);
 
   return shader_module;
 }
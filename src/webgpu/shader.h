@@ -26,6 +26,23 @@ typedef struct wgpu_shader_t {
   WGPUShaderModule module;
 } wgpu_shader_t;
 
+/* Shader module cache, modules are deduplicated by source and label */
+typedef struct wgpu_shader_cache_t wgpu_shader_cache_t;
+
+typedef struct wgpu_shader_cache_stats_t {
+  uint32_t entry_count;     /* cached shader modules */
+  uint64_t hit_count;       /* requests served from the cache */
+  uint64_t miss_count;      /* requests that created a shader module */
+  uint64_t source_bytes;    /* WGSL / SPIR-V bytes held by the cache */
+  double compile_time_ms;   /* time spent creating the cached modules */
+  double saved_time_ms;     /* estimated creation time saved by the hits */
+} wgpu_shader_cache_stats_t;
+
+wgpu_shader_cache_t* wgpu_shader_cache_create(void);
+void wgpu_shader_cache_destroy(wgpu_shader_cache_t* cache);
+void wgpu_shader_cache_get_stats(wgpu_shader_cache_t* cache,
+                                 wgpu_shader_cache_stats_t* stats);
+
 /* Helper functions */
 WGPUShaderModule
 wgpu_create_shader_module_from_spirv_file(WGPUDevice device,
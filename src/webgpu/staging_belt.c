@@ -0,0 +1,454 @@
+#include "staging_belt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/log.h"
+#include "../core/macro.h"
+#include "../core/platform.h"
+
+#include "context.h"
+
+/* Staging chunk, a MapWrite buffer that is sub-allocated linearly */
+typedef struct staging_chunk_t {
+  wgpu_staging_belt_t* belt;
+  WGPUBuffer buffer;
+  uint64_t size;
+  uint64_t offset; /* start of the unused part of the chunk */
+  uint8_t* data;   /* mapped range of the whole chunk */
+  /* Encoder recording the copies from the active chunk, referenced so that
+   * the handle is not reused by another encoder before the chunk is closed */
+  WGPUCommandEncoder encoder;
+  struct staging_chunk_t* next;
+} staging_chunk_t;
+
+/* Chunks move from free to active on allocation, from active to closed when
+ * the encoder that copies from them is finished and from closed back to free
+ * once remapped after their copies executed. Every encoder sub-allocates from
+ * its own active chunks, so that finishing one encoder does not unmap the
+ * memory of another encoder that is still recording. */
+struct wgpu_staging_belt_t {
+  wgpu_context_t* wgpu_context;
+  uint64_t chunk_size;
+  staging_chunk_t* active; /* mapped, sub-allocated by the recorded copies */
+  staging_chunk_t* closed; /* unmapped, referenced by recorded copies */
+  staging_chunk_t* free;   /* mapped and unused */
+  uint32_t mapping_count;  /* chunks waiting for their map callback */
+  wgpu_staging_belt_stats_t stats;
+};
+
+static staging_chunk_t* staging_chunk_create(wgpu_staging_belt_t* belt,
+                                             uint64_t size)
+{
+  WGPUBufferDescriptor buffer_desc = {
+    .label            = "Staging belt chunk",
+    .usage            = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc,
+    .size             = size,
+    .mappedAtCreation = true,
+  };
+  WGPUBuffer buffer
+    = wgpuDeviceCreateBuffer(belt->wgpu_context->device, &buffer_desc);
+  uint8_t* data = (buffer != NULL) ?
+                    (uint8_t*)wgpuBufferGetMappedRange(buffer, 0, size) :
+                    NULL;
+  if (data == NULL) {
+    log_error("Unable to create staging buffer (%llu bytes)",
+              (unsigned long long)size);
+    WGPU_RELEASE_RESOURCE(Buffer, buffer)
+    return NULL;
+  }
+
+  staging_chunk_t* chunk = (staging_chunk_t*)calloc(1, sizeof(*chunk));
+  chunk->belt            = belt;
+  chunk->buffer          = buffer;
+  chunk->size            = size;
+  chunk->data            = data;
+
+  ++belt->stats.chunk_count;
+  ++belt->stats.created_chunk_count;
+  belt->stats.chunk_bytes += size;
+
+  return chunk;
+}
+
+static void staging_chunk_destroy(staging_chunk_t* chunk)
+{
+  wgpu_staging_belt_t* belt = chunk->belt;
+  --belt->stats.chunk_count;
+  belt->stats.chunk_bytes -= chunk->size;
+
+  WGPU_RELEASE_RESOURCE(CommandEncoder, chunk->encoder)
+  WGPU_RELEASE_RESOURCE(Buffer, chunk->buffer)
+  free(chunk);
+}
+
+static void staging_chunk_list_destroy(staging_chunk_t* chunk)
+{
+  while (chunk != NULL) {
+    staging_chunk_t* next = chunk->next;
+    staging_chunk_destroy(chunk);
+    chunk = next;
+  }
+}
+
+wgpu_staging_belt_t*
+wgpu_staging_belt_create(struct wgpu_context_t* wgpu_context,
+                         uint64_t chunk_size)
+{
+  wgpu_staging_belt_t* belt
+    = (wgpu_staging_belt_t*)calloc(1, sizeof(wgpu_staging_belt_t));
+  belt->wgpu_context = wgpu_context;
+  belt->chunk_size   = (chunk_size > 0) ? (chunk_size + 3) & ~3ull :
+                                          WGPU_STAGING_BELT_CHUNK_SIZE;
+
+  return belt;
+}
+
+void wgpu_staging_belt_destroy(wgpu_staging_belt_t* belt)
+{
+  if (belt == NULL) {
+    return;
+  }
+
+  /* Map callbacks reference the chunks */
+  while (belt->mapping_count > 0) {
+    wgpuDeviceTick(belt->wgpu_context->device);
+  }
+
+  staging_chunk_list_destroy(belt->active);
+  staging_chunk_list_destroy(belt->closed);
+  staging_chunk_list_destroy(belt->free);
+  free(belt);
+}
+
+/* Takes a free chunk of at least the given size or creates a new one */
+static staging_chunk_t* staging_belt_acquire_chunk(wgpu_staging_belt_t* belt,
+                                                   uint64_t size)
+{
+  staging_chunk_t** link = &belt->free;
+  for (; *link != NULL; link = &(*link)->next) {
+    if ((*link)->size >= size) {
+      staging_chunk_t* chunk = *link;
+      *link                  = chunk->next;
+      return chunk;
+    }
+  }
+
+  /* Uploads larger than the chunk size get a dedicated chunk */
+  return staging_chunk_create(belt, MAX(belt->chunk_size, size));
+}
+
+bool wgpu_staging_belt_allocate(wgpu_staging_belt_t* belt,
+                                WGPUCommandEncoder cmd_enc, uint64_t size,
+                                uint64_t alignment,
+                                wgpu_staging_allocation_t* allocation)
+{
+  ASSERT(cmd_enc != NULL);
+  ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+  /* Copy sizes and buffer offsets are multiples of 4 */
+  size      = (size + 3) & ~3ull;
+  alignment = MAX(alignment, 4u);
+
+  /* The most recent chunk of the encoder comes first in the active list */
+  staging_chunk_t* chunk = belt->active;
+  while (chunk != NULL && chunk->encoder != cmd_enc) {
+    chunk = chunk->next;
+  }
+  uint64_t offset
+    = (chunk != NULL) ? (chunk->offset + alignment - 1) & ~(alignment - 1) : 0;
+  if (chunk == NULL || offset + size > chunk->size) {
+    chunk = staging_belt_acquire_chunk(belt, size);
+    if (chunk == NULL) {
+      return false;
+    }
+    wgpuCommandEncoderReference(cmd_enc);
+    chunk->encoder = cmd_enc;
+    chunk->next    = belt->active;
+    belt->active   = chunk;
+    offset         = 0;
+  }
+  chunk->offset = offset + size;
+
+  allocation->buffer = chunk->buffer;
+  allocation->offset = offset;
+  allocation->data   = chunk->data + offset;
+  belt->stats.staged_bytes += size;
+
+  return true;
+}
+
+void wgpu_staging_belt_write_buffer(wgpu_staging_belt_t* belt,
+                                    WGPUCommandEncoder cmd_enc,
+                                    WGPUBuffer buffer, uint64_t buffer_offset,
+                                    uint64_t copy_size, const void* data,
+                                    uint64_t data_size)
+{
+  ASSERT(copy_size % 4 == 0 && data_size <= copy_size);
+
+  wgpu_staging_allocation_t allocation = {0};
+  if (!wgpu_staging_belt_allocate(belt, cmd_enc, copy_size, 4, &allocation)) {
+    return;
+  }
+
+  memcpy(allocation.data, data, data_size);
+  if (copy_size > data_size) {
+    memset((uint8_t*)allocation.data + data_size, 0, copy_size - data_size);
+  }
+  wgpuCommandEncoderCopyBufferToBuffer(cmd_enc, allocation.buffer,
+                                       allocation.offset, buffer,
+                                       buffer_offset, copy_size);
+}
+
+void wgpu_staging_belt_write_texture(wgpu_staging_belt_t* belt,
+                                     WGPUCommandEncoder cmd_enc,
+                                     const WGPUImageCopyTexture* destination,
+                                     const void* data, uint64_t data_size,
+                                     const WGPUTextureDataLayout* layout,
+                                     const WGPUExtent3D* copy_size)
+{
+  wgpu_staging_allocation_t allocation = {0};
+  if (!wgpu_staging_belt_allocate(belt, cmd_enc, data_size,
+                                  WGPU_STAGING_BELT_TEXTURE_ALIGNMENT,
+                                  &allocation)) {
+    return;
+  }
+
+  memcpy(allocation.data, data, data_size);
+  WGPUImageCopyBuffer source = {
+    .buffer = allocation.buffer,
+    .layout = *layout,
+  };
+  source.layout.offset += allocation.offset;
+  wgpuCommandEncoderCopyBufferToTexture(cmd_enc, &source, destination,
+                                        copy_size);
+}
+
+/* Unmaps an active chunk that was removed from the active list */
+static void staging_chunk_close(staging_chunk_t* chunk)
+{
+  wgpu_staging_belt_t* belt = chunk->belt;
+  wgpuBufferUnmap(chunk->buffer);
+  WGPU_RELEASE_RESOURCE(CommandEncoder, chunk->encoder)
+  /* Dedicated chunks of large uploads are not kept around, their buffer is
+   * released once the copies executed */
+  if (chunk->size > belt->chunk_size) {
+    WGPU_DEFER_RELEASE(belt->wgpu_context, Buffer, chunk->buffer)
+    staging_chunk_destroy(chunk);
+    return;
+  }
+  chunk->data  = NULL;
+  chunk->next  = belt->closed;
+  belt->closed = chunk;
+}
+
+/* Closes the active chunks of cmd_enc, or of all encoders except open_enc
+ * if cmd_enc is NULL */
+static void staging_belt_close_chunks(wgpu_staging_belt_t* belt,
+                                      WGPUCommandEncoder cmd_enc,
+                                      WGPUCommandEncoder open_enc)
+{
+  staging_chunk_t** link = &belt->active;
+  while (*link != NULL) {
+    staging_chunk_t* chunk = *link;
+    const bool matches     = (cmd_enc != NULL) ? chunk->encoder == cmd_enc :
+                                                 chunk->encoder != open_enc;
+    if (!matches) {
+      link = &chunk->next;
+      continue;
+    }
+    *link = chunk->next;
+    staging_chunk_close(chunk);
+  }
+}
+
+void wgpu_staging_belt_finish(wgpu_staging_belt_t* belt,
+                              WGPUCommandEncoder cmd_enc)
+{
+  ASSERT(cmd_enc != NULL);
+  staging_belt_close_chunks(belt, cmd_enc, NULL);
+}
+
+void wgpu_staging_belt_finish_all(wgpu_staging_belt_t* belt,
+                                  WGPUCommandEncoder open_enc)
+{
+  staging_belt_close_chunks(belt, NULL, open_enc);
+}
+
+static void staging_chunk_map_callback(WGPUBufferMapAsyncStatus status,
+                                       void* user_data)
+{
+  staging_chunk_t* chunk    = (staging_chunk_t*)user_data;
+  wgpu_staging_belt_t* belt = chunk->belt;
+  --belt->mapping_count;
+
+  if (status != WGPUBufferMapAsyncStatus_Success) {
+    staging_chunk_destroy(chunk);
+    return;
+  }
+
+  chunk->data
+    = (uint8_t*)wgpuBufferGetMappedRange(chunk->buffer, 0, chunk->size);
+  chunk->offset = 0;
+  chunk->next   = belt->free;
+  belt->free    = chunk;
+}
+
+void wgpu_staging_belt_recall(wgpu_staging_belt_t* belt)
+{
+  while (belt->closed != NULL) {
+    staging_chunk_t* chunk = belt->closed;
+    belt->closed           = chunk->next;
+    chunk->next            = NULL;
+    /* The map callback fires once the GPU finished the copies */
+    ++belt->mapping_count;
+    wgpuBufferMapAsync(chunk->buffer, WGPUMapMode_Write, 0, chunk->size,
+                       staging_chunk_map_callback, chunk);
+  }
+}
+
+void wgpu_staging_belt_get_stats(wgpu_staging_belt_t* belt,
+                                 wgpu_staging_belt_stats_t* stats)
+{
+  *stats                  = belt->stats;
+  stats->free_chunk_count = 0;
+  for (staging_chunk_t* chunk = belt->free; chunk != NULL;
+       chunk                  = chunk->next) {
+    ++stats->free_chunk_count;
+  }
+}
+
+/* Staging belt stress test */
+#define STAGING_STRESS_FRAME_COUNT 600u
+#define STAGING_STRESS_UPLOADS_PER_FRAME 4096u
+#define STAGING_STRESS_NESTED_UPLOADS 64u
+#define STAGING_STRESS_MAX_UPLOAD_SIZE 256u
+#define STAGING_STRESS_BUFFER_SIZE (4u * 1024u * 1024u)
+/* More chunks than this means that the belt does not recycle its chunks */
+#define STAGING_STRESS_MAX_CHUNK_COUNT 16u
+
+static void staging_stress_error_callback(WGPUErrorType type,
+                                          char const* message, void* userdata)
+{
+  bool* result = (bool*)userdata;
+  if (type != WGPUErrorType_NoError) {
+    log_error("Staging stress test error: %s", message);
+    result[0] = false;
+  }
+  result[1] = true; /* error scope popped */
+}
+
+static void staging_stress_work_done_callback(WGPUQueueWorkDoneStatus status,
+                                              void* userdata)
+{
+  UNUSED_VAR(status);
+  *(bool*)userdata = true;
+}
+
+/* Records small uploads of random size to random offsets of the buffer */
+static void staging_stress_record_uploads(wgpu_staging_belt_t* belt,
+                                          WGPUCommandEncoder cmd_enc,
+                                          WGPUBuffer buffer,
+                                          const uint8_t* data,
+                                          uint32_t upload_count)
+{
+  for (uint32_t i = 0; i < upload_count; ++i) {
+    const uint64_t size
+      = 4 * (1 + (uint64_t)rand() % (STAGING_STRESS_MAX_UPLOAD_SIZE / 4));
+    const uint64_t offset
+      = 4 * ((uint64_t)rand() % ((STAGING_STRESS_BUFFER_SIZE - size) / 4));
+    wgpu_staging_belt_write_buffer(belt, cmd_enc, buffer, offset, size, data,
+                                   size);
+  }
+}
+
+bool wgpu_staging_belt_stress_test(struct wgpu_context_t* wgpu_context)
+{
+  wgpu_staging_belt_t* belt = wgpu_context->staging_belt;
+  WGPUDevice device         = wgpu_context->device;
+
+  WGPUBuffer buffer = wgpuDeviceCreateBuffer(
+    device, &(WGPUBufferDescriptor){
+              .label = "Staging stress test buffer",
+              .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc,
+              .size  = STAGING_STRESS_BUFFER_SIZE,
+            });
+  ASSERT(buffer != NULL);
+  uint8_t data[STAGING_STRESS_MAX_UPLOAD_SIZE];
+  for (uint32_t i = 0; i < STAGING_STRESS_MAX_UPLOAD_SIZE; ++i) {
+    data[i] = (uint8_t)i;
+  }
+
+  bool result[2] = {true, false}; /* no errors, error scope popped */
+  wgpuDevicePushErrorScope(device, WGPUErrorFilter_Validation);
+  srand(1);
+
+  uint32_t max_chunk_count = 0;
+  const uint64_t start_ns  = platform_get_time_ns();
+  for (uint32_t frame = 0; frame < STAGING_STRESS_FRAME_COUNT; ++frame) {
+    wgpu_context->cmd_enc = wgpuDeviceCreateCommandEncoder(device, NULL);
+    staging_stress_record_uploads(belt, wgpu_context->cmd_enc, buffer, data,
+                                  STAGING_STRESS_UPLOADS_PER_FRAME / 2);
+
+    // Nested upload submitted while the frame encoder is still recording,
+    // like an asset uploaded during frame recording
+    WGPUCommandEncoder nested_enc
+      = wgpuDeviceCreateCommandEncoder(device, NULL);
+    staging_stress_record_uploads(belt, nested_enc, buffer, data,
+                                  STAGING_STRESS_NESTED_UPLOADS);
+    wgpu_staging_belt_finish(belt, nested_enc);
+    WGPUCommandBuffer command_buffer = wgpu_get_command_buffer(nested_enc);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, nested_enc)
+    wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
+
+    staging_stress_record_uploads(belt, wgpu_context->cmd_enc, buffer, data,
+                                  STAGING_STRESS_UPLOADS_PER_FRAME / 2);
+    command_buffer = wgpu_get_command_buffer(wgpu_context->cmd_enc);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, wgpu_context->cmd_enc)
+    wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
+
+    wgpuDeviceTick(device);
+    max_chunk_count = MAX(max_chunk_count, belt->stats.chunk_count);
+  }
+  const uint64_t record_ns = platform_get_time_ns() - start_ns;
+
+  // Wait for the copies and the remapping of the chunks
+  bool work_done = false;
+  wgpuQueueOnSubmittedWorkDone(wgpu_context->queue, 0,
+                               staging_stress_work_done_callback, &work_done);
+  while (!work_done || belt->mapping_count > 0) {
+    wgpuDeviceTick(device);
+  }
+  wgpuDevicePopErrorScope(device, staging_stress_error_callback, result);
+  while (!result[1]) {
+    wgpuDeviceTick(device);
+  }
+  WGPU_RELEASE_RESOURCE(Buffer, buffer)
+
+  const uint32_t upload_count
+    = STAGING_STRESS_FRAME_COUNT
+      * (STAGING_STRESS_UPLOADS_PER_FRAME + STAGING_STRESS_NESTED_UPLOADS);
+  wgpu_staging_belt_stats_t stats = {0};
+  wgpu_staging_belt_get_stats(belt, &stats);
+  printf("Staging belt stress test: %u frames, %u uploads per frame, "
+         "%u nested uploads per frame\n",
+         STAGING_STRESS_FRAME_COUNT, STAGING_STRESS_UPLOADS_PER_FRAME,
+         STAGING_STRESS_NESTED_UPLOADS);
+  printf("  CPU time: %.3f ms per frame, %.1f ns per upload\n",
+         (double)record_ns / 1e6 / STAGING_STRESS_FRAME_COUNT,
+         (double)record_ns / upload_count);
+  printf("  Staged: %.1f MB, chunks created: %u, max chunks: %u (%.1f MB "
+         "held at exit)\n",
+         (double)stats.staged_bytes / (1024.0 * 1024.0),
+         stats.created_chunk_count, max_chunk_count,
+         (double)stats.chunk_bytes / (1024.0 * 1024.0));
+
+  const bool passed
+    = result[0] && max_chunk_count <= STAGING_STRESS_MAX_CHUNK_COUNT;
+  if (max_chunk_count > STAGING_STRESS_MAX_CHUNK_COUNT) {
+    log_error("Staging chunks are not recycled (%u chunks)", max_chunk_count);
+  }
+  printf("  Result: %s\n", passed ? "passed" : "FAILED");
+  return passed;
+}
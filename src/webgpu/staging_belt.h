@@ -0,0 +1,105 @@
+#ifndef STAGING_BELT_H
+#define STAGING_BELT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+/* Default size of the staging chunks, larger uploads get a dedicated chunk */
+#define WGPU_STAGING_BELT_CHUNK_SIZE (1024u * 1024u)
+/* Offset alignment that satisfies buffer and texture copies of all formats */
+#define WGPU_STAGING_BELT_TEXTURE_ALIGNMENT 16u
+
+/* Forward declarations */
+struct wgpu_context_t;
+
+typedef struct wgpu_staging_belt_t wgpu_staging_belt_t;
+
+/* Mapped staging memory, data is valid until the encoder is finished */
+typedef struct wgpu_staging_allocation_t {
+  WGPUBuffer buffer;
+  uint64_t offset;
+  void* data;
+} wgpu_staging_allocation_t;
+
+typedef struct wgpu_staging_belt_stats_t {
+  uint32_t chunk_count;         /* chunks owned by the belt */
+  uint32_t free_chunk_count;    /* mapped chunks ready for reuse */
+  uint32_t created_chunk_count; /* chunks created since the belt was created */
+  uint64_t chunk_bytes;         /* memory held by the chunks */
+  uint64_t staged_bytes;        /* bytes staged since the belt was created */
+} wgpu_staging_belt_stats_t;
+
+/* Staging belt creating/releasing */
+wgpu_staging_belt_t*
+wgpu_staging_belt_create(struct wgpu_context_t* wgpu_context,
+                         uint64_t chunk_size);
+void wgpu_staging_belt_destroy(wgpu_staging_belt_t* belt);
+
+/**
+ * @brief Sub-allocates mapped staging memory from the current chunk of the
+ * encoder.
+ * @param cmd_enc the encoder recording the copy from the staging memory
+ * @param alignment offset alignment, must be a power of two
+ * @return false if no staging buffer could be created
+ */
+bool wgpu_staging_belt_allocate(wgpu_staging_belt_t* belt,
+                                WGPUCommandEncoder cmd_enc, uint64_t size,
+                                uint64_t alignment,
+                                wgpu_staging_allocation_t* allocation);
+
+/**
+ * @brief Records a copy of data into the destination buffer. The remaining
+ * bytes of copy_size after data_size are zero filled.
+ */
+void wgpu_staging_belt_write_buffer(wgpu_staging_belt_t* belt,
+                                    WGPUCommandEncoder cmd_enc,
+                                    WGPUBuffer buffer, uint64_t buffer_offset,
+                                    uint64_t copy_size, const void* data,
+                                    uint64_t data_size);
+
+/**
+ * @brief Records a copy of data into the destination texture, the layout
+ * offset is relative to data.
+ */
+void wgpu_staging_belt_write_texture(wgpu_staging_belt_t* belt,
+                                     WGPUCommandEncoder cmd_enc,
+                                     const WGPUImageCopyTexture* destination,
+                                     const void* data, uint64_t data_size,
+                                     const WGPUTextureDataLayout* layout,
+                                     const WGPUExtent3D* copy_size);
+
+/**
+ * @brief Unmaps the chunks the encoder copies from, has to be called before
+ * submitting its command buffer. Chunks of other encoders stay mapped.
+ */
+void wgpu_staging_belt_finish(wgpu_staging_belt_t* belt,
+                              WGPUCommandEncoder cmd_enc);
+
+/**
+ * @brief Unmaps the chunks of all encoders except open_enc, which is still
+ * being recorded (may be NULL).
+ */
+void wgpu_staging_belt_finish_all(wgpu_staging_belt_t* belt,
+                                  WGPUCommandEncoder open_enc);
+
+/**
+ * @brief Maps the finished chunks again, once all command buffers copying from
+ * them were submitted. Chunks are reused after the GPU is done with them.
+ */
+void wgpu_staging_belt_recall(wgpu_staging_belt_t* belt);
+
+void wgpu_staging_belt_get_stats(wgpu_staging_belt_t* belt,
+                                 wgpu_staging_belt_stats_t* stats);
+
+/**
+ * @brief Records thousands of small buffer uploads per frame for a few hundred
+ * frames, with a nested upload submitted in the middle of every frame, and
+ * prints the CPU time and the chunk statistics. Meant to be run on the Null
+ * backend.
+ * @return false on validation errors or if the chunks are not recycled
+ */
+bool wgpu_staging_belt_stress_test(struct wgpu_context_t* wgpu_context);
+
+#endif
@@ -149,11 +149,10 @@ static void text_overlay_create_fonts_texture(text_overlay_t* text_overlay)
 
   WGPUCommandBuffer copy_command = wgpu_copy_buffer_to_texture(
     wgpu_context, &buffer_copy_view, &texture_copy_view, &texture_size);
-  /* Submit to the queue */
-  wgpuQueueSubmit(wgpu_context->queue, 1, &copy_command);
+  /* Submit to the queue, this releases the command buffer */
+  wgpu_flush_command_buffers(wgpu_context, &copy_command, 1);
 
-  /* Release command buffer and staging buffer */
-  WGPU_RELEASE_RESOURCE(CommandBuffer, copy_command)
+  /* Release staging buffer */
   wgpu_destroy_buffer(&gpu_buffer);
 
   /* Create texture view */
@@ -1,13 +1,22 @@
 #include "texture.h"
 
 #include <math.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../core/block_compress.h"
 #include "../core/file.h"
+#include "../core/job_system.h"
+#include "../core/ktx2.h"
 #include "../core/log.h"
 #include "../core/macro.h"
+#include "../core/mip_chain.h"
+#include "../core/platform.h"
+#include "asset_loader.h"
 #include "shader.h"
+#include "staging_belt.h"
 
 #ifdef __GNUC__
 #pragma GCC diagnostic push
@@ -31,9 +40,6 @@
 #pragma GCC diagnostic pop
 #endif
 
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-#include "stb_image_resize.h"
-
 /* Basis Universal Supercompressed GPU Texture Codec */
 #include <wgpu_basisu.h>
 
@@ -88,30 +94,6 @@ static bool is_power_of_2(int n)
   return (n & (n - 1)) == 0;
 }
 
-static int make_multiple_of_256(int value)
-{
-  int resized_width;
-  if (value % 256 == 0) {
-    resized_width = value;
-  }
-  else {
-    resized_width = (value / 256 + 1) * 256;
-  }
-  return resized_width;
-}
-
-static void copy_padding_buffer(unsigned char* dst, unsigned char* src,
-                                int width, int height, int padding)
-{
-  unsigned char* s = src;
-  unsigned char* d = dst;
-  for (int i = 0; i < height; ++i) {
-    memcpy(d, s, width * 4);
-    s += width * 4;
-    d += padding * 4;
-  }
-}
-
 static WGPUTextureFormat linear_to_sgrb_format(WGPUTextureFormat format)
 {
   switch (format) {
@@ -165,6 +147,115 @@ static WGPUTextureFormat format_for_color_space(WGPUTextureFormat format,
   }
 }
 
+/* Block layout of the formats KTX files are uploaded in, uncompressed formats
+ * have 1x1 blocks */
+typedef struct texture_format_info_t {
+  WGPUTextureFormat format;
+  uint32_t gl_internal_format; /* KTX 1 glInternalformat, 0 if unused */
+  uint32_t vk_format;          /* KTX 2 vkFormat */
+  uint32_t block_width;
+  uint32_t block_height;
+  uint32_t block_size;     /* bytes per block */
+  WGPUFeatureName feature; /* device feature required by the format */
+} texture_format_info_t;
+
+static const texture_format_info_t texture_format_infos[] = {
+  // clang-format off
+  {WGPUTextureFormat_RGBA8Unorm,            0x8058, 37,  1, 1, 4,  WGPUFeatureName_Undefined},
+  {WGPUTextureFormat_RGBA8UnormSrgb,        0x8C43, 43,  1, 1, 4,  WGPUFeatureName_Undefined},
+  {WGPUTextureFormat_BGRA8Unorm,            0,      44,  1, 1, 4,  WGPUFeatureName_Undefined},
+  {WGPUTextureFormat_BGRA8UnormSrgb,        0,      50,  1, 1, 4,  WGPUFeatureName_Undefined},
+  {WGPUTextureFormat_RGBA16Float,           0x881A, 97,  1, 1, 8,  WGPUFeatureName_Undefined},
+  {WGPUTextureFormat_RGBA32Float,           0x8814, 109, 1, 1, 16, WGPUFeatureName_Undefined},
+  /* BC1 without alpha is sampled as BC1 with opaque alpha */
+  {WGPUTextureFormat_BC1RGBAUnorm,          0x83F0, 131, 4, 4, 8,  WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC1RGBAUnormSrgb,      0x8C4C, 132, 4, 4, 8,  WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC1RGBAUnorm,          0x83F1, 133, 4, 4, 8,  WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC1RGBAUnormSrgb,      0x8C4D, 134, 4, 4, 8,  WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC2RGBAUnorm,          0x83F2, 135, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC2RGBAUnormSrgb,      0x8C4E, 136, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC3RGBAUnorm,          0x83F3, 137, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC3RGBAUnormSrgb,      0x8C4F, 138, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC4RUnorm,             0x8DBB, 139, 4, 4, 8,  WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC5RGUnorm,            0x8DBD, 141, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC6HRGBUfloat,         0x8E8F, 143, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC7RGBAUnorm,          0x8E8C, 145, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_BC7RGBAUnormSrgb,      0x8E8D, 146, 4, 4, 16, WGPUFeatureName_TextureCompressionBC},
+  {WGPUTextureFormat_ETC2RGB8Unorm,         0x9274, 147, 4, 4, 8,  WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_ETC2RGB8UnormSrgb,     0x9275, 148, 4, 4, 8,  WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_ETC2RGB8A1Unorm,       0x9276, 149, 4, 4, 8,  WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_ETC2RGB8A1UnormSrgb,   0x9277, 150, 4, 4, 8,  WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_ETC2RGBA8Unorm,        0x9278, 151, 4, 4, 16, WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_ETC2RGBA8UnormSrgb,    0x9279, 152, 4, 4, 16, WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_EACR11Unorm,           0x9270, 153, 4, 4, 8,  WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_EACRG11Unorm,          0x9272, 155, 4, 4, 16, WGPUFeatureName_TextureCompressionETC2},
+  {WGPUTextureFormat_ASTC4x4Unorm,          0x93B0, 157, 4, 4, 16, WGPUFeatureName_TextureCompressionASTC},
+  {WGPUTextureFormat_ASTC4x4UnormSrgb,      0x93D0, 158, 4, 4, 16, WGPUFeatureName_TextureCompressionASTC},
+  {WGPUTextureFormat_ASTC6x6Unorm,          0x93B4, 165, 6, 6, 16, WGPUFeatureName_TextureCompressionASTC},
+  {WGPUTextureFormat_ASTC6x6UnormSrgb,      0x93D4, 166, 6, 6, 16, WGPUFeatureName_TextureCompressionASTC},
+  {WGPUTextureFormat_ASTC8x8Unorm,          0x93B7, 171, 8, 8, 16, WGPUFeatureName_TextureCompressionASTC},
+  {WGPUTextureFormat_ASTC8x8UnormSrgb,      0x93D7, 172, 8, 8, 16, WGPUFeatureName_TextureCompressionASTC},
+  // clang-format on
+};
+
+static const texture_format_info_t*
+texture_format_info_from_gl(uint32_t gl_internal_format)
+{
+  if (gl_internal_format == 0) {
+    return NULL;
+  }
+  for (uint32_t i = 0; i < (uint32_t)ARRAY_SIZE(texture_format_infos); ++i) {
+    if (texture_format_infos[i].gl_internal_format == gl_internal_format) {
+      return &texture_format_infos[i];
+    }
+  }
+  return NULL;
+}
+
+static const texture_format_info_t*
+texture_format_info_from_vk(uint32_t vk_format)
+{
+  for (uint32_t i = 0; i < (uint32_t)ARRAY_SIZE(texture_format_infos); ++i) {
+    if (texture_format_infos[i].vk_format == vk_format) {
+      return &texture_format_infos[i];
+    }
+  }
+  return NULL;
+}
+
+static const char* texture_format_feature_name(WGPUFeatureName feature)
+{
+  switch (feature) {
+    case WGPUFeatureName_TextureCompressionBC:
+      return "texture-compression-bc";
+    case WGPUFeatureName_TextureCompressionETC2:
+      return "texture-compression-etc2";
+    case WGPUFeatureName_TextureCompressionASTC:
+      return "texture-compression-astc";
+    default:
+      return "unknown";
+  }
+}
+
+/* Buffer to texture copies require bytesPerRow to be a multiple of 256 */
+#define TEXTURE_COPY_BYTES_PER_ROW_ALIGNMENT 256u
+
+static uint32_t texture_copy_row_pitch(uint32_t row_size)
+{
+  return (row_size + TEXTURE_COPY_BYTES_PER_ROW_ALIGNMENT - 1)
+         & ~(TEXTURE_COPY_BYTES_PER_ROW_ALIGNMENT - 1);
+}
+
+/* Bytes of one image of a level with tightly packed rows of blocks */
+static size_t texture_format_image_size(const texture_format_info_t* info,
+                                        uint32_t width, uint32_t height)
+{
+  const uint32_t blocks_x = (width + info->block_width - 1) / info->block_width;
+  const uint32_t blocks_y
+    = (height + info->block_height - 1) / info->block_height;
+  return (size_t)blocks_x * blocks_y * info->block_size;
+}
+
 /**
  * @brief Determines the number of mip levels needed for a full mip chain given
  * the width and height of texture level 0.
@@ -178,77 +269,13 @@ static uint32_t calculate_mip_level_count(int width, int height)
   return (uint32_t)(floor((float)(log2(MAX(width, height))))) + 1;
 }
 
-/**
- * @brief Deallocates image data.
- */
-static void destroy_image_data(uint8_t** pixel_vec, int width, int height)
-{
-  uint32_t mipmap_level = calculate_mip_level_count(width, height);
-  for (uint32_t i = 0; i < mipmap_level; ++i) {
-    free(pixel_vec[i]);
-  }
-  free(pixel_vec);
-}
-
-/**
- * @brief Generates mipmaps on the CPU.
- * @see https://github.com/webatintel/aquarium
- */
-static void generate_mipmap(uint8_t* input_pixels, int input_w, int input_h,
-                            int input_stride_in_bytes, uint8_t*** output_pixels,
-                            int output_w, int output_h,
-                            int output_stride_in_bytes, int num_channels,
-                            bool is_256_padding)
-{
-  uint32_t mipmap_level = calculate_mip_level_count(output_w, output_h);
-  uint8_t** mipmap_pixels
-    = (unsigned char**)malloc(mipmap_level * sizeof(unsigned char**));
-  *output_pixels = mipmap_pixels;
-  int height     = output_h;
-  int width      = output_w;
-
-  if (!is_256_padding) {
-    for (uint32_t i = 0; i < mipmap_level; ++i) {
-      mipmap_pixels[i]
-        = (unsigned char*)malloc(output_w * height * 4 * sizeof(char));
-      stbir_resize_uint8(input_pixels, input_w, input_h, input_stride_in_bytes,
-                         mipmap_pixels[i], width, height,
-                         output_stride_in_bytes, num_channels);
-
-      height >>= 1;
-      width >>= 1;
-      if (height == 0) {
-        height = 1;
-      }
-    }
-  }
-  else {
-    uint8_t* pixels
-      = (unsigned char*)malloc(output_w * height * 4 * sizeof(char));
-
-    for (uint32_t i = 0; i < mipmap_level; ++i) {
-      mipmap_pixels[i]
-        = (unsigned char*)malloc(output_w * height * 4 * sizeof(char));
-      stbir_resize_uint8(input_pixels, input_w, input_h, input_stride_in_bytes,
-                         pixels, width, height, output_stride_in_bytes,
-                         num_channels);
-      copy_padding_buffer(mipmap_pixels[i], pixels, width, height, output_w);
-
-      height >>= 1;
-      width >>= 1;
-      if (height == 0) {
-        height = 1;
-      }
-    }
-    free(pixels);
-  }
-}
-
 /* -------------------------------------------------------------------------- *
  * WebGPU Mipmap Generator
  * -------------------------------------------------------------------------- */
 
 #define NUMBER_OF_TEXTURE_FORMATS WGPUTextureFormat_R8BG8Biplanar420Unorm
+/* Compute dispatches: levels 1 to 6, then levels 7 and up */
+#define MIPMAP_COMPUTE_DISPATCH_COUNT 2u
 
 struct wgpu_mipmap_generator {
   wgpu_context_t* wgpu_context;
@@ -260,6 +287,12 @@ struct wgpu_mipmap_generator {
   // Vertex state and  Fragment state are shared between all pipelines
   WGPUVertexState vertex_state_desc;
   WGPUFragmentState fragment_state_desc;
+  // Compute pipelines of every dispatch, the bind group layout is shared
+  WGPUBindGroupLayout compute_bind_group_layout;
+  WGPUPipelineLayout compute_pipeline_layout;
+  WGPUComputePipeline compute_pipelines[(uint32_t)NUMBER_OF_TEXTURE_FORMATS]
+                                       [MIPMAP_COMPUTE_DISPATCH_COUNT];
+  wgpu_mipmap_generator_mode_enum mode;
 };
 
 wgpu_mipmap_generator_t*
@@ -269,6 +302,7 @@ wgpu_mipmap_generator_create(wgpu_context_t* wgpu_context)
     = (wgpu_mipmap_generator_t*)malloc(sizeof(wgpu_mipmap_generator_t));
   memset(mipmap_generator, 0, sizeof(wgpu_mipmap_generator_t));
   mipmap_generator->wgpu_context = wgpu_context;
+  mipmap_generator->mode         = MipmapGeneratorMode_Auto;
 
   // Create sampler
   WGPUSamplerDescriptor sampler_desc = {
@@ -298,7 +332,15 @@ void wgpu_mipmap_generator_destroy(wgpu_mipmap_generator_t* mipmap_generator)
       WGPU_RELEASE_RESOURCE(RenderPipeline, mipmap_generator->pipelines[i])
       mipmap_generator->active_pipelines[i] = false;
     }
+    for (uint32_t j = 0; j < MIPMAP_COMPUTE_DISPATCH_COUNT; ++j) {
+      WGPU_RELEASE_RESOURCE(ComputePipeline,
+                            mipmap_generator->compute_pipelines[i][j])
+    }
   }
+  WGPU_RELEASE_RESOURCE(PipelineLayout,
+                        mipmap_generator->compute_pipeline_layout)
+  WGPU_RELEASE_RESOURCE(BindGroupLayout,
+                        mipmap_generator->compute_bind_group_layout)
   if (!mipmap_generator->vertex_state_desc.module
       || !mipmap_generator->fragment_state_desc.module) {
     WGPU_RELEASE_RESOURCE(ShaderModule,
@@ -424,10 +466,16 @@ WGPURenderPipeline wgpu_mipmap_generator_get_mipmap_pipeline(
   return mipmap_generator->pipelines[pipeline_index];
 }
 
-WGPUTexture
-wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator,
-                                      WGPUTexture texture,
-                                      WGPUTextureDescriptor* texture_desc)
+void wgpu_mipmap_generator_set_mode(wgpu_mipmap_generator_t* mipmap_generator,
+                                    wgpu_mipmap_generator_mode_enum mode)
+{
+  mipmap_generator->mode = mode;
+}
+
+/* One render pass per mip level and array layer */
+static WGPUTexture wgpu_mipmap_generator_generate_mipmap_render(
+  wgpu_mipmap_generator_t* mipmap_generator, WGPUTexture texture,
+  WGPUTextureDescriptor* texture_desc)
 {
   WGPURenderPipeline pipeline = wgpu_mipmap_generator_get_mipmap_pipeline(
     mipmap_generator, texture_desc->format);
@@ -596,8 +644,7 @@ wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator,
   WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
 
   // Sumbit commmand buffer and cleanup
-  wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
-  WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
+  wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
 
   if (!render_to_source) {
     WGPU_RELEASE_RESOURCE(Texture, mip_texture);
@@ -616,222 +663,847 @@ wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator,
   return texture;
 }
 
-/* -------------------------------------------------------------------------- *
- * WebGPU Texture Client
- * -------------------------------------------------------------------------- */
-
-typedef struct texture_result_t {
-  WGPUTexture texture;
-  uint32_t width;
-  uint32_t height;
-  uint32_t depth;
+/* Compute downsampler: a workgroup of 256 invocations reduces a 64x64 tile
+ * of level 0 down to one texel of level 6 in workgroup memory. A second
+ * dispatch with one workgroup per array layer reduces the 64x64 texels of
+ * level 6 down to level 12. WGSL has no memory model that would let the last
+ * workgroup of the first dispatch read what the other workgroups wrote, the
+ * dispatch boundary makes those writes visible. All levels are written into
+ * one storage buffer and copied into the texture afterwards, so the texture
+ * format doesn't need storage support. */
+#define MIPMAP_COMPUTE_MAX_LEVEL_COUNT 13u
+#define MIPMAP_COMPUTE_MAX_SIZE 4096u
+#define MIPMAP_COMPUTE_MAX_BUFFER_SIZE (128u * 1024u * 1024u)
+#define MIPMAP_COMPUTE_TILE_SIZE 64u
+
+/* Layout of the uniform buffer of the compute shader */
+typedef struct mipmap_compute_params_t {
+  uint32_t size[2];
   uint32_t mip_level_count;
+  uint32_t texel_words;
+  uint32_t layer_words;
+  uint32_t padding[3];
+  /* word offset and words per row of each level in an array layer */
+  uint32_t levels[MIPMAP_COMPUTE_MAX_LEVEL_COUNT][4];
+} mipmap_compute_params_t;
+
+/* Formats supported by the compute path, with the WGSL function that stores
+ * a texel into the output buffer */
+typedef struct mipmap_compute_format_t {
   WGPUTextureFormat format;
-  WGPUTextureDimension dimension;
-} texture_result_t;
+  uint32_t texel_words;
+  const char* store_texel_wgsl;
+} mipmap_compute_format_t;
+
+// clang-format off
+static const char* mipmap_compute_srgb_wgsl = CODE(
+  fn to_srgb(c : vec3<f32>) -> vec3<f32> {
+    return select(1.055 * pow(c, vec3<f32>(1.0 / 2.4)) - 0.055, c * 12.92,
+                  c <= vec3<f32>(0.0031308));
+  }
+);
 
-texture_result_t wgpu_texture_client_load_texture_from_memory(
-  struct wgpu_texture_client_t* texture_client, void* data, size_t data_size,
-  struct wgpu_texture_load_options_t* options)
-{
-  if (!texture_client->wgpu_context) {
-    log_error("Cannot create new textures after object has been destroyed.");
-    return (texture_result_t){0};
+static const mipmap_compute_format_t mipmap_compute_formats[] = {
+  {
+    .format           = WGPUTextureFormat_RGBA8Unorm,
+    .texel_words      = 1,
+    .store_texel_wgsl = CODE(
+      fn store_texel(i : u32, v : vec4<f32>) {
+        dst[i] = pack4x8unorm(v);
+      }
+    ),
+  },
+  {
+    .format           = WGPUTextureFormat_RGBA8UnormSrgb,
+    .texel_words      = 1,
+    .store_texel_wgsl = CODE(
+      fn store_texel(i : u32, v : vec4<f32>) {
+        dst[i] = pack4x8unorm(vec4<f32>(to_srgb(v.rgb), v.a));
+      }
+    ),
+  },
+  {
+    .format           = WGPUTextureFormat_BGRA8Unorm,
+    .texel_words      = 1,
+    .store_texel_wgsl = CODE(
+      fn store_texel(i : u32, v : vec4<f32>) {
+        dst[i] = pack4x8unorm(v.bgra);
+      }
+    ),
+  },
+  {
+    .format           = WGPUTextureFormat_BGRA8UnormSrgb,
+    .texel_words      = 1,
+    .store_texel_wgsl = CODE(
+      fn store_texel(i : u32, v : vec4<f32>) {
+        dst[i] = pack4x8unorm(vec4<f32>(to_srgb(v.bgr), v.a));
+      }
+    ),
+  },
+  {
+    .format           = WGPUTextureFormat_RGBA16Float,
+    .texel_words      = 2,
+    .store_texel_wgsl = CODE(
+      fn store_texel(i : u32, v : vec4<f32>) {
+        dst[i]      = pack2x16float(v.xy);
+        dst[i + 1u] = pack2x16float(v.zw);
+      }
+    ),
+  },
+  {
+    .format           = WGPUTextureFormat_RGBA32Float,
+    .texel_words      = 4,
+    .store_texel_wgsl = CODE(
+      fn store_texel(i : u32, v : vec4<f32>) {
+        dst[i]      = bitcast<u32>(v.x);
+        dst[i + 1u] = bitcast<u32>(v.y);
+        dst[i + 2u] = bitcast<u32>(v.z);
+        dst[i + 3u] = bitcast<u32>(v.w);
+      }
+    ),
+  },
+};
+
+/* Workgroup barriers are kept in uniform control flow, the invocations that
+ * have nothing to do for a level only skip the loads and stores */
+static const char* mipmap_compute_shader_wgsl = CODE(
+  struct Params {
+    size : vec2<u32>,
+    mipLevelCount : u32,
+    texelWords : u32,
+    layerWords : u32,
+    levels : array<vec4<u32>, 13>,
   }
 
-  static const uint8_t comp_map[5] = {
-    0, //
-    1, //
-    2, //
-    4, //
-    4  //
-  };
-  static const uint32_t channels[5] = {
-    STBI_default,    // only used for req_comp
-    STBI_grey,       //
-    STBI_grey_alpha, //
-    STBI_rgb_alpha,  //
-    STBI_rgb_alpha   //
-  };
+  @group(0) @binding(0) var src : texture_2d_array<f32>;
+  @group(0) @binding(1) var<storage, read_write> dst : array<u32>;
+  @group(0) @binding(2) var<storage, read_write> mid : array<vec4<f32>>;
+  @group(0) @binding(3) var<uniform> params : Params;
 
-  bool is_hdr = stbi_is_hdr_from_memory((stbi_uc*)data, data_size);
-  int width = 0, height = 0, read_comps = 4;
-  stbi_set_flip_vertically_on_load(options ? options->flip_y : false);
-  uint8_t* pixel_data
-    = is_hdr ? (uint8_t*)stbi_loadf_from_memory((stbi_uc*)data, data_size,
-                                                &width, &height, &read_comps,
-                                                channels[read_comps]) :
-               (uint8_t*)stbi_load_from_memory((stbi_uc*)data, data_size,
-                                               &width, &height, &read_comps,
-                                               channels[read_comps]);
+  var<workgroup> tile : array<vec4<f32>, 256>;
 
-  if (pixel_data == NULL) {
-    log_warn("Couldn't parse image data!");
-    return (texture_result_t){0};
+  fn mip_size(level : u32) -> vec2<u32> {
+    return max(params.size >> vec2<u32>(level), vec2<u32>(1u));
   }
-  ASSERT(pixel_data);
 
-  const uint8_t comps         = comp_map[read_comps];
-  const bool generate_mipmaps = options ? options->generate_mipmaps : false;
-  const uint32_t mip_level_count
-    = generate_mipmaps ? calculate_mip_level_count(width, height) : 1u;
+  fn store(level : u32, layer : u32, coord : vec2<u32>, v : vec4<f32>) {
+    let size = mip_size(level);
+    if (level < params.mipLevelCount && coord.x < size.x && coord.y < size.y) {
+      let l = params.levels[level];
+      store_texel(layer * params.layerWords + l.x + coord.y * l.y
+                  + coord.x * params.texelWords, v);
+    }
+  }
 
-  const WGPUTextureUsage usage
-    = WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding;
+  fn mid_index(coord : vec2<u32>, layer : u32) -> u32 {
+    return (layer * 64u + coord.y) * 64u + coord.x;
+  }
 
-  WGPUExtent3D texture_size = {
-    .width              = width,
-    .height             = height,
-    .depthOrArrayLayers = 1,
-  };
-  WGPUTextureDescriptor texture_desc = {
-    .usage         = usage,
-    .dimension     = WGPUTextureDimension_2D,
-    .size          = texture_size,
-    .format        = options ? (options->format != WGPUTextureFormat_Undefined ?
-                                  format_for_color_space(options->format,
-                                                         options->color_space) :
-                                  WGPUTextureFormat_RGBA8Unorm) :
-                               WGPUTextureFormat_RGBA8Unorm,
-    .mipLevelCount = mip_level_count,
-    .sampleCount   = 1,
-  };
-  WGPUTexture texture = wgpuDeviceCreateTexture(
-    texture_client->wgpu_context->device, &texture_desc);
+  fn load_base(level : u32, coord : vec2<u32>, layer : u32) -> vec4<f32> {
+    let c = min(coord, mip_size(level - 1u) - vec2<u32>(1u));
+    if (level == 1u) {
+      return textureLoad(src, vec2<i32>(c), i32(layer), 0);
+    }
+    return mid[mid_index(c, layer)];
+  }
 
-  // Copy pixel data to texture and free allocated memory
-  wgpu_image_to_texure(texture_client->wgpu_context, texture, pixel_data,
-                       texture_size, comps);
-  free(pixel_data);
+  fn reduce_quad(level : u32, q : vec2<u32>, layer : u32) -> vec4<f32> {
+    var v : array<vec4<f32>, 4>;
+    for (var i = 0u; i < 4u; i++) {
+      let p = 2u * q + vec2<u32>(i & 1u, i >> 1u);
+      let a = 2u * p;
+      v[i] = 0.25 * (load_base(level, a, layer)
+                     + load_base(level, a + vec2<u32>(1u, 0u), layer)
+                     + load_base(level, a + vec2<u32>(0u, 1u), layer)
+                     + load_base(level, a + vec2<u32>(1u, 1u), layer));
+      store(level, layer, p, v[i]);
+    }
+    let last = mip_size(level) - vec2<u32>(1u);
+    let dx = select(1u, 0u, 2u * q.x + 1u > last.x);
+    let dy = select(2u, 0u, 2u * q.y + 1u > last.y);
+    let r = 0.25 * (v[0] + v[dx] + v[dy] + v[dx + dy]);
+    store(level + 1u, layer, q, r);
+    return r;
+  }
 
-  if (generate_mipmaps) {
-    texture = wgpu_mipmap_generator_generate_mipmap(
-      texture_client->wgpu_mipmap_generator, texture, &texture_desc);
+  fn reduce_tile(level : u32, n : u32, origin : vec2<u32>, layer : u32,
+                 li : u32) {
+    let busy = li < n * n;
+    let p = vec2<u32>(li % n, li / n);
+    var r : vec4<f32>;
+    if (busy) {
+      let m = 2u * n;
+      let a = 2u * p;
+      let g = 2u * (origin + p);
+      let last = mip_size(level - 1u) - vec2<u32>(1u);
+      let dx = select(1u, 0u, g.x + 1u > last.x);
+      let dy = select(m, 0u, g.y + 1u > last.y);
+      let i = a.y * m + a.x;
+      r = 0.25 * (tile[i] + tile[i + dx] + tile[i + dy] + tile[i + dx + dy]);
+      store(level, layer, origin + p, r);
+    }
+    workgroupBarrier();
+    if (busy) {
+      tile[li] = r;
+    }
+    workgroupBarrier();
   }
 
-  return (texture_result_t){
-    .texture         = texture,
-    .width           = texture_desc.size.width,
-    .height          = texture_desc.size.height,
-    .depth           = texture_desc.size.depthOrArrayLayers,
-    .mip_level_count = texture_desc.mipLevelCount,
-    .format          = texture_desc.format,
-    .dimension       = texture_desc.dimension,
-  };
-}
+  // Levels 1 to 6, one workgroup per 64x64 tile
+  @compute @workgroup_size(256)
+  fn main(@builtin(workgroup_id) wg : vec3<u32>,
+          @builtin(local_invocation_index) li : u32) {
+    let layer = wg.z;
+    let q = vec2<u32>(li % 16u, li / 16u);
+
+    tile[li] = reduce_quad(1u, wg.xy * 16u + q, layer);
+    workgroupBarrier();
+    reduce_tile(3u, 8u, wg.xy * 8u, layer, li);
+    reduce_tile(4u, 4u, wg.xy * 4u, layer, li);
+    reduce_tile(5u, 2u, wg.xy * 2u, layer, li);
+    reduce_tile(6u, 1u, wg.xy, layer, li);
+
+    // Level 6 is the source of the second dispatch
+    if (li == 0u && params.mipLevelCount > 7u) {
+      mid[mid_index(wg.xy, layer)] = tile[0];
+    }
+  }
 
-typedef struct {
-  int32_t image_width;
-  int32_t image_height;
-  int32_t channel_count;
-  stbi_uc* pixel_data;
-} stb_image_load_result_t;
+  // Levels 7 to 12, one workgroup per array layer
+  @compute @workgroup_size(256)
+  fn main_mid(@builtin(workgroup_id) wg : vec3<u32>,
+              @builtin(local_invocation_index) li : u32) {
+    let layer = wg.z;
+    let q = vec2<u32>(li % 16u, li / 16u);
+
+    tile[li] = reduce_quad(7u, q, layer);
+    workgroupBarrier();
+    reduce_tile(9u, 8u, vec2<u32>(0u), layer, li);
+    reduce_tile(10u, 4u, vec2<u32>(0u), layer, li);
+    reduce_tile(11u, 2u, vec2<u32>(0u), layer, li);
+    reduce_tile(12u, 1u, vec2<u32>(0u), layer, li);
+  }
+);
+// clang-format on
 
-static stb_image_load_result_t
-stb_image_load_image_from_file(const char* filename, bool flip_y)
+static const mipmap_compute_format_t*
+mipmap_compute_find_format(WGPUTextureFormat format)
 {
-  static const uint8_t comp_map[5] = {
-    0, //
-    1, //
-    2, //
-    4, //
-    4  //
-  };
-  static const uint32_t channels[5] = {
-    STBI_default,    // only used for req_comp
-    STBI_grey,       //
-    STBI_grey_alpha, //
-    STBI_rgb_alpha,  //
-    STBI_rgb_alpha   //
-  };
+  for (uint32_t i = 0; i < (uint32_t)ARRAY_SIZE(mipmap_compute_formats); ++i) {
+    if (mipmap_compute_formats[i].format == format) {
+      return &mipmap_compute_formats[i];
+    }
+  }
+  return NULL;
+}
 
-  int width = 0, height = 0;
-  // Force loading 4 channel images to 3 channel by stb becasue Dawn doesn't
-  // support 3 channel formats currently. The group is discussing on whether
-  // webgpu shoud support 3 channel format.
-  // https://github.com/gpuweb/gpuweb/issues/66#issuecomment-410021505
-  int read_comps = 4;
-  stbi_set_flip_vertically_on_load(flip_y);
-  stbi_uc* pixel_data = stbi_load(filename,            //
-                                  &width,              //
-                                  &height,             //
-                                  &read_comps,         //
-                                  channels[read_comps] //
-  );
+/* Returns the pipelines of both dispatches for the format */
+static WGPUComputePipeline* wgpu_mipmap_generator_get_compute_pipelines(
+  wgpu_mipmap_generator_t* mipmap_generator,
+  const mipmap_compute_format_t* format)
+{
+  const uint32_t pipeline_index = (uint32_t)format->format;
+  ASSERT(pipeline_index < (uint32_t)NUMBER_OF_TEXTURE_FORMATS)
+  WGPUComputePipeline* pipelines
+    = mipmap_generator->compute_pipelines[pipeline_index];
+  if (pipelines[0] != NULL) {
+    return pipelines;
+  }
 
-  if (pixel_data == NULL) {
-    log_error("Couldn't load '%s'\n", filename);
+  wgpu_context_t* wgpu_context = mipmap_generator->wgpu_context;
+
+  // Bind group layout and pipeline layout are shared between all formats
+  if (mipmap_generator->compute_bind_group_layout == NULL) {
+    WGPUBindGroupLayoutEntry bgl_entries[4] = {
+      [0] = (WGPUBindGroupLayoutEntry) {
+        .binding    = 0,
+        .visibility = WGPUShaderStage_Compute,
+        .texture = (WGPUTextureBindingLayout) {
+          .sampleType    = WGPUTextureSampleType_UnfilterableFloat,
+          .viewDimension = WGPUTextureViewDimension_2DArray,
+          .multisampled  = false,
+        },
+      },
+      [1] = (WGPUBindGroupLayoutEntry) {
+        .binding    = 1,
+        .visibility = WGPUShaderStage_Compute,
+        .buffer = (WGPUBufferBindingLayout) {
+          .type = WGPUBufferBindingType_Storage,
+        },
+      },
+      [2] = (WGPUBindGroupLayoutEntry) {
+        .binding    = 2,
+        .visibility = WGPUShaderStage_Compute,
+        .buffer = (WGPUBufferBindingLayout) {
+          .type = WGPUBufferBindingType_Storage,
+        },
+      },
+      [3] = (WGPUBindGroupLayoutEntry) {
+        .binding    = 3,
+        .visibility = WGPUShaderStage_Compute,
+        .buffer = (WGPUBufferBindingLayout) {
+          .type           = WGPUBufferBindingType_Uniform,
+          .minBindingSize = sizeof(mipmap_compute_params_t),
+        },
+      },
+    };
+    mipmap_generator->compute_bind_group_layout
+      = wgpuDeviceCreateBindGroupLayout(
+        wgpu_context->device,
+        &(WGPUBindGroupLayoutDescriptor){
+          .label      = "mipmap_compute_bind_group_layout",
+          .entryCount = (uint32_t)ARRAY_SIZE(bgl_entries),
+          .entries    = bgl_entries,
+        });
+    ASSERT(mipmap_generator->compute_bind_group_layout != NULL);
+
+    mipmap_generator->compute_pipeline_layout = wgpuDeviceCreatePipelineLayout(
+      wgpu_context->device,
+      &(WGPUPipelineLayoutDescriptor){
+        .label                = "mipmap_compute_pipeline_layout",
+        .bindGroupLayoutCount = 1,
+        .bindGroupLayouts     = &mipmap_generator->compute_bind_group_layout,
+      });
+    ASSERT(mipmap_generator->compute_pipeline_layout != NULL);
   }
-  else {
-    log_debug("Loaded image %s (%d, %d, %d / %d)\n", filename, width, height,
-              read_comps, comp_map[read_comps]);
+
+  // The shader is completed with the texel store function of the format
+  const size_t main_size  = strlen(mipmap_compute_shader_wgsl);
+  const size_t srgb_size  = strlen(mipmap_compute_srgb_wgsl);
+  const size_t store_size = strlen(format->store_texel_wgsl);
+  char* source = (char*)malloc(main_size + srgb_size + store_size + 1);
+  memcpy(source, mipmap_compute_shader_wgsl, main_size);
+  memcpy(source + main_size, mipmap_compute_srgb_wgsl, srgb_size);
+  memcpy(source + main_size + srgb_size, format->store_texel_wgsl,
+         store_size + 1);
+
+  wgpu_shader_t comp_shader = wgpu_shader_create(
+    wgpu_context, &(wgpu_shader_desc_t){
+                    // Compute shader WGSL
+                    .label            = "mipmap_compute_shader",
+                    .wgsl_code.source = source,
+                    .entry            = "main",
+                  });
+  free(source);
+
+  static const char* entry_points[MIPMAP_COMPUTE_DISPATCH_COUNT]
+    = {"main", "main_mid"};
+  for (uint32_t i = 0; i < MIPMAP_COMPUTE_DISPATCH_COUNT; ++i) {
+    WGPUProgrammableStageDescriptor stage
+      = comp_shader.programmable_stage_descriptor;
+    stage.entryPoint = entry_points[i];
+    pipelines[i]     = wgpuDeviceCreateComputePipeline(
+      wgpu_context->device,
+      &(WGPUComputePipelineDescriptor){
+        .label   = "mipmap_compute_pipeline",
+        .layout  = mipmap_generator->compute_pipeline_layout,
+        .compute = stage,
+      });
+    ASSERT(pipelines[i] != NULL);
   }
+  wgpu_shader_release(&comp_shader);
 
-  return (stb_image_load_result_t){
-    .image_width   = width,
-    .image_height  = height,
-    .channel_count = comp_map[read_comps],
-    .pixel_data    = pixel_data,
-  };
+  return pipelines;
 }
 
-static texture_result_t
-wgpu_texture_load_with_stb(struct wgpu_texture_client_t* texture_client,
-                           const char* filename,
-                           struct wgpu_texture_load_options_t* options)
+/* Returns false without recording anything if the texture isn't supported by
+ * the compute path */
+static bool wgpu_mipmap_generator_generate_mipmap_compute(
+  wgpu_mipmap_generator_t* mipmap_generator, WGPUTexture texture,
+  WGPUTextureDescriptor* texture_desc)
 {
-  if (!texture_client->wgpu_context) {
-    log_error("Cannot create new textures after object has been destroyed.");
-    return (texture_result_t){0};
+  const mipmap_compute_format_t* format
+    = mipmap_compute_find_format(texture_desc->format);
+  const WGPUTextureUsage required_usage
+    = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+  if (format == NULL || texture_desc->dimension != WGPUTextureDimension_2D
+      || (texture_desc->usage & required_usage) != required_usage
+      || texture_desc->sampleCount > 1 || texture_desc->mipLevelCount < 2
+      || texture_desc->mipLevelCount > MIPMAP_COMPUTE_MAX_LEVEL_COUNT
+      || texture_desc->size.width > MIPMAP_COMPUTE_MAX_SIZE
+      || texture_desc->size.height > MIPMAP_COMPUTE_MAX_SIZE) {
+    return false;
   }
 
-  const bool flip_y = options ? options->flip_y : false;
-  stb_image_load_result_t image_load_result
-    = stb_image_load_image_from_file(filename, flip_y);
+  const uint32_t width             = texture_desc->size.width;
+  const uint32_t height            = texture_desc->size.height;
+  const uint32_t mip_level_count   = texture_desc->mipLevelCount;
+  const uint32_t array_layer_count = texture_desc->size.depthOrArrayLayers > 0 ?
+                                       texture_desc->size.depthOrArrayLayers :
+                                       1;
 
-  stbi_uc* pixel_data = image_load_result.pixel_data;
-  if (pixel_data == NULL) {
-    return (texture_result_t){0};
+  // Levels 1 and up of every array layer, rows are aligned for the copies
+  mipmap_compute_params_t params = {
+    .size            = {width, height},
+    .mip_level_count = mip_level_count,
+    .texel_words     = format->texel_words,
+  };
+  uint64_t layer_size = 0;
+  for (uint32_t level = 1; level < mip_level_count; ++level) {
+    const uint32_t level_width  = MAX(width >> level, 1u);
+    const uint32_t level_height = MAX(height >> level, 1u);
+    const uint32_t row_pitch
+      = (level_width * format->texel_words * 4 + 255) & ~255u;
+    params.levels[level][0] = (uint32_t)(layer_size / 4);
+    params.levels[level][1] = row_pitch / 4;
+    layer_size += (uint64_t)row_pitch * level_height;
+  }
+  const uint64_t dst_size = layer_size * array_layer_count;
+  if (dst_size > MIPMAP_COMPUTE_MAX_BUFFER_SIZE) {
+    return false;
+  }
+  params.layer_words = (uint32_t)(layer_size / 4);
+
+  const WGPUComputePipeline* pipelines
+    = wgpu_mipmap_generator_get_compute_pipelines(mipmap_generator, format);
+  wgpu_context_t* wgpu_context = mipmap_generator->wgpu_context;
+  WGPUDevice device            = wgpu_context->device;
+
+  // Level 6 is only needed by the second dispatch for more than 7 levels
+  const uint64_t mid_size
+    = (mip_level_count > 7) ?
+        (uint64_t)MIPMAP_COMPUTE_TILE_SIZE * MIPMAP_COMPUTE_TILE_SIZE * 16
+          * array_layer_count :
+        16;
+  WGPUBuffer dst_buffer = wgpuDeviceCreateBuffer(
+    device, &(WGPUBufferDescriptor){
+              .label = "mipmap_compute_dst_buffer",
+              .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc,
+              .size  = dst_size,
+            });
+  WGPUBuffer mid_buffer = wgpuDeviceCreateBuffer(
+    device, &(WGPUBufferDescriptor){
+              .label = "mipmap_compute_mid_buffer",
+              .usage = WGPUBufferUsage_Storage,
+              .size  = mid_size,
+            });
+  WGPUBuffer params_buffer = wgpuDeviceCreateBuffer(
+    device, &(WGPUBufferDescriptor){
+              .label = "mipmap_compute_params_buffer",
+              .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+              .size  = sizeof(params),
+            });
+  wgpuQueueWriteBuffer(wgpu_context->queue, params_buffer, 0, &params,
+                       sizeof(params));
+
+  WGPUTextureView src_view = wgpuTextureCreateView(
+    texture, &(WGPUTextureViewDescriptor){
+               .label           = "src_view",
+               .aspect          = WGPUTextureAspect_All,
+               .baseMipLevel    = 0,
+               .mipLevelCount   = 1,
+               .dimension       = WGPUTextureViewDimension_2DArray,
+               .baseArrayLayer  = 0,
+               .arrayLayerCount = array_layer_count,
+             });
+
+  WGPUBindGroupEntry bg_entries[4] = {
+    [0] = (WGPUBindGroupEntry){
+      .binding     = 0,
+      .textureView = src_view,
+    },
+    [1] = (WGPUBindGroupEntry){
+      .binding = 1,
+      .buffer  = dst_buffer,
+      .size    = dst_size,
+    },
+    [2] = (WGPUBindGroupEntry){
+      .binding = 2,
+      .buffer  = mid_buffer,
+      .size    = mid_size,
+    },
+    [3] = (WGPUBindGroupEntry){
+      .binding = 3,
+      .buffer  = params_buffer,
+      .size    = sizeof(params),
+    },
+  };
+  WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(
+    device, &(WGPUBindGroupDescriptor){
+              .layout     = mipmap_generator->compute_bind_group_layout,
+              .entryCount = (uint32_t)ARRAY_SIZE(bg_entries),
+              .entries    = bg_entries,
+            });
+  ASSERT(bind_group != NULL);
+
+  WGPUCommandEncoder cmd_encoder = wgpuDeviceCreateCommandEncoder(device, NULL);
+  WGPUComputePassEncoder pass_encoder
+    = wgpuCommandEncoderBeginComputePass(cmd_encoder, NULL);
+  wgpuComputePassEncoderSetPipeline(pass_encoder, pipelines[0]);
+  wgpuComputePassEncoderSetBindGroup(pass_encoder, 0, bind_group, 0, NULL);
+  wgpuComputePassEncoderDispatchWorkgroups(
+    pass_encoder,
+    (width + MIPMAP_COMPUTE_TILE_SIZE - 1) / MIPMAP_COMPUTE_TILE_SIZE,
+    (height + MIPMAP_COMPUTE_TILE_SIZE - 1) / MIPMAP_COMPUTE_TILE_SIZE,
+    array_layer_count);
+  // The level 6 texels of all workgroups are visible to the next dispatch
+  if (mip_level_count > 7) {
+    wgpuComputePassEncoderSetPipeline(pass_encoder, pipelines[1]);
+    wgpuComputePassEncoderDispatchWorkgroups(pass_encoder, 1, 1,
+                                             array_layer_count);
+  }
+  wgpuComputePassEncoderEnd(pass_encoder);
+  WGPU_RELEASE_RESOURCE(ComputePassEncoder, pass_encoder)
+
+  for (uint32_t layer = 0; layer < array_layer_count; ++layer) {
+    for (uint32_t level = 1; level < mip_level_count; ++level) {
+      wgpuCommandEncoderCopyBufferToTexture(cmd_encoder,
+        // Source
+        &(WGPUImageCopyBuffer) {
+          .buffer = dst_buffer,
+          .layout = (WGPUTextureDataLayout) {
+            .offset       = layer * layer_size
+                            + (uint64_t)params.levels[level][0] * 4,
+            .bytesPerRow  = params.levels[level][1] * 4,
+            .rowsPerImage = MAX(height >> level, 1u),
+          },
+        },
+        // Destination
+        &(WGPUImageCopyTexture){
+          .texture  = texture,
+          .mipLevel = level,
+          .origin = (WGPUOrigin3D) {
+            .x = 0,
+            .y = 0,
+            .z = layer,
+          },
+          .aspect = WGPUTextureAspect_All,
+        },
+        // Copy size
+        &(WGPUExtent3D){
+          .width              = MAX(width >> level, 1u),
+          .height             = MAX(height >> level, 1u),
+          .depthOrArrayLayers = 1,
+        });
+    }
   }
-  ASSERT(pixel_data);
 
-  const int width             = image_load_result.image_width;
-  const int height            = image_load_result.image_height;
-  const int channel_count     = image_load_result.channel_count;
-  const bool generate_mipmaps = options ? options->generate_mipmaps : false;
-  const uint32_t mip_level_count
-    = generate_mipmaps ? calculate_mip_level_count(width, height) : 1u;
+  WGPUCommandBuffer command_buffer
+    = wgpuCommandEncoderFinish(cmd_encoder, NULL);
+  ASSERT(command_buffer != NULL);
+  WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
 
-  const WGPUTextureUsage usage
-    = options ? (options->usage != WGPUTextureUsage_None ?
-                   options->usage :
-                   WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding) :
-                WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding;
+  // Sumbit commmand buffer and cleanup
+  wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
 
-  WGPUExtent3D texture_size = {
-    .width              = width,
-    .height             = height,
-    .depthOrArrayLayers = 1,
-  };
-  WGPUTextureDescriptor texture_desc = {
-    .usage         = usage,
-    .dimension     = WGPUTextureDimension_2D,
-    .size          = texture_size,
-    .format        = options ? (options->format != WGPUTextureFormat_Undefined ?
-                                  format_for_color_space(options->format,
-                                                         options->color_space) :
-                                  WGPUTextureFormat_RGBA8Unorm) :
-                               WGPUTextureFormat_RGBA8Unorm,
-    .mipLevelCount = mip_level_count,
-    .sampleCount   = 1,
-  };
+  WGPU_RELEASE_RESOURCE(BindGroup, bind_group)
+  WGPU_RELEASE_RESOURCE(TextureView, src_view)
+  WGPU_RELEASE_RESOURCE(Buffer, params_buffer)
+  WGPU_RELEASE_RESOURCE(Buffer, mid_buffer)
+  WGPU_RELEASE_RESOURCE(Buffer, dst_buffer)
+
+  return true;
+}
+
+WGPUTexture
+wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator,
+                                      WGPUTexture texture,
+                                      WGPUTextureDescriptor* texture_desc)
+{
+  if (mipmap_generator->mode == MipmapGeneratorMode_Auto
+      && wgpu_mipmap_generator_generate_mipmap_compute(mipmap_generator,
+                                                       texture, texture_desc)) {
+    return texture;
+  }
+  return wgpu_mipmap_generator_generate_mipmap_render(mipmap_generator,
+                                                      texture, texture_desc);
+}
+
+/* Mip map generator benchmark */
+static void mipmap_benchmark_work_done_callback(WGPUQueueWorkDoneStatus status,
+                                                void* userdata)
+{
+  UNUSED_VAR(status);
+  *(bool*)userdata = true;
+}
+
+static void mipmap_benchmark_wait_for_queue(wgpu_context_t* wgpu_context)
+{
+  bool done = false;
+  wgpuQueueOnSubmittedWorkDone(wgpu_context->queue, 0,
+                               mipmap_benchmark_work_done_callback, &done);
+  while (!done) {
+    wgpuDeviceTick(wgpu_context->device);
+  }
+}
+
+/* Best of the measured runs in milliseconds, including the GPU execution */
+static double mipmap_benchmark_run(wgpu_mipmap_generator_t* mipmap_generator,
+                                   WGPUTexture texture,
+                                   WGPUTextureDescriptor* texture_desc,
+                                   wgpu_mipmap_generator_mode_enum mode)
+{
+  const uint32_t warmup_run_count = 2, measured_run_count = 5;
+  wgpu_context_t* wgpu_context    = mipmap_generator->wgpu_context;
+  wgpu_mipmap_generator_set_mode(mipmap_generator, mode);
+  // Warm up runs create the pipelines
+  for (uint32_t i = 0; i < warmup_run_count; ++i) {
+    wgpu_mipmap_generator_generate_mipmap(mipmap_generator, texture,
+                                          texture_desc);
+    mipmap_benchmark_wait_for_queue(wgpu_context);
+  }
+  double best_ms = 0.0;
+  for (uint32_t i = 0; i < measured_run_count; ++i) {
+    const uint64_t start_ns = platform_get_time_ns();
+    wgpu_mipmap_generator_generate_mipmap(mipmap_generator, texture,
+                                          texture_desc);
+    mipmap_benchmark_wait_for_queue(wgpu_context);
+    const double elapsed_ms
+      = (double)(platform_get_time_ns() - start_ns) / 1000000.0;
+    best_ms = (i == 0) ? elapsed_ms : MIN(best_ms, elapsed_ms);
+  }
+  return best_ms;
+}
+
+void wgpu_mipmap_generator_benchmark(wgpu_context_t* wgpu_context)
+{
+  wgpu_mipmap_generator_t* mipmap_generator
+    = wgpu_mipmap_generator_create(wgpu_context);
+
+  printf("Mipmap generation of RGBA8 textures, best of 5 runs (ms)\n");
+  printf("%10s %12s %12s %9s\n", "size", "render", "compute", "speedup");
+  for (uint32_t size = 256; size <= MIPMAP_COMPUTE_MAX_SIZE; size *= 2) {
+    WGPUTextureDescriptor texture_desc = {
+      .usage = WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding
+               | WGPUTextureUsage_RenderAttachment,
+      .dimension     = WGPUTextureDimension_2D,
+      .size          = (WGPUExtent3D){size, size, 1},
+      .format        = WGPUTextureFormat_RGBA8Unorm,
+      .mipLevelCount = calculate_mip_level_count(size, size),
+      .sampleCount   = 1,
+    };
+    WGPUTexture texture
+      = wgpuDeviceCreateTexture(wgpu_context->device, &texture_desc);
+    ASSERT(texture != NULL);
+
+    // Level 0 is filled with noise
+    const size_t data_size = (size_t)size * size * 4;
+    uint8_t* pixels        = (uint8_t*)malloc(data_size);
+    for (size_t i = 0; i < data_size; ++i) {
+      pixels[i] = (uint8_t)rand();
+    }
+    wgpuQueueWriteTexture(wgpu_context->queue,
+                          &(WGPUImageCopyTexture){
+                            .texture  = texture,
+                            .mipLevel = 0,
+                            .aspect   = WGPUTextureAspect_All,
+                          },
+                          pixels, data_size,
+                          &(WGPUTextureDataLayout){
+                            .bytesPerRow  = size * 4,
+                            .rowsPerImage = size,
+                          },
+                          &texture_desc.size);
+    free(pixels);
+
+    const double render_ms = mipmap_benchmark_run(
+      mipmap_generator, texture, &texture_desc, MipmapGeneratorMode_Render);
+    const double compute_ms = mipmap_benchmark_run(
+      mipmap_generator, texture, &texture_desc, MipmapGeneratorMode_Auto);
+    printf("%5ux%-4u %12.3f %12.3f %8.2fx\n", size, size, render_ms,
+           compute_ms, render_ms / MAX(compute_ms, 1e-6));
+
+    WGPU_RELEASE_RESOURCE(Texture, texture)
+  }
+
+  wgpu_mipmap_generator_destroy(mipmap_generator);
+}
+
+/* -------------------------------------------------------------------------- *
+ * WebGPU Texture Client
+ * -------------------------------------------------------------------------- */
+
+typedef struct texture_result_t {
+  WGPUTexture texture;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  uint32_t mip_level_count;
+  WGPUTextureFormat format;
+  WGPUTextureDimension dimension;
+} texture_result_t;
+
+/* Decoded texture data, the decode step only touches CPU memory and can run
+ * on any thread, the upload step creates the GPU resources on the main thread
+ */
+typedef enum texture_data_type_enum {
+  TextureDataType_Stb   = 0,
+  TextureDataType_Ktx   = 1,
+  TextureDataType_Basis = 2,
+} texture_data_type_enum;
+
+typedef struct {
+  int32_t image_width;
+  int32_t image_height;
+  int32_t channel_count;
+  stbi_uc* pixel_data;
+} stb_image_load_result_t;
+
+typedef struct {
+  file_view_t file; /* mapped KTX file, the texture reads from it */
+  ktxTexture* ktx_texture; /* KTX 1 files, NULL for KTX 2 files */
+  ktx2_texture_t ktx2;
+  /* Block format of compressed KTX 1 files and of all KTX 2 files, the levels
+   * of the file are uploaded as they are. NULL for uncompressed KTX 1 files,
+   * which are uploaded as RGBA8. */
+  const texture_format_info_t* native_format;
+  /* Byte offsets of the levels of KTX 1 files in the mapped file and the
+   * distance between the faces of a level */
+  struct {
+    size_t offset;
+    size_t face_stride;
+  } ktx1_levels[KTX2_MAX_LEVELS];
+  mip_chain_t mip_chain; /* generated mip chain of RGBA8 2D textures */
+} ktx_image_load_result_t;
+
+/* Transcoded levels of a basis file, laid out for buffer to texture copies:
+ * the faces of a level follow each other, the rows of blocks are padded to
+ * 256 bytes */
+typedef struct {
+  basisu_texture_desc_t desc;
+  uint8_t* data;
+  size_t size;
+  struct {
+    size_t offset;      /* byte offset of the first face of the level */
+    size_t image_size;  /* bytes per face */
+    uint32_t row_pitch; /* bytes per row of blocks */
+    uint32_t rows;      /* rows of blocks */
+  } levels[BASISU_MAX_MIPMAPS];
+} basis_image_load_result_t;
+
+struct wgpu_texture_data_t {
+  texture_data_type_enum type;
+  union {
+    stb_image_load_result_t stb;
+    ktx_image_load_result_t ktx;
+    basis_image_load_result_t basis;
+  } image;
+};
+
+/* Basis Universal keeps a global codebook, it is set up by the first decode
+ * and shared by all transcoders. Each texture client that decoded a basis file
+ * holds a reference, the codebook is released with the last client. */
+static pthread_mutex_t basisu_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t basisu_ref_count    = 0;
+
+static const uint8_t stb_comp_map[5] = {
+  0, //
+  1, //
+  2, //
+  4, //
+  4  //
+};
+static const uint32_t stb_channels[5] = {
+  STBI_default,    // only used for req_comp
+  STBI_grey,       //
+  STBI_grey_alpha, //
+  STBI_rgb_alpha,  //
+  STBI_rgb_alpha   //
+};
+
+static stb_image_load_result_t
+stb_image_load_image_from_memory(const void* data, size_t data_size,
+                                 bool flip_y)
+{
+  int width = 0, height = 0, read_comps = 4;
+  // The flip flag is per thread, images are decoded on the job workers
+  stbi_set_flip_vertically_on_load_thread(flip_y);
+  const bool is_hdr = stbi_is_hdr_from_memory((stbi_uc*)data, data_size);
+  stbi_uc* pixel_data
+    = is_hdr ? (stbi_uc*)stbi_loadf_from_memory((stbi_uc*)data, data_size,
+                                                &width, &height, &read_comps,
+                                                stb_channels[read_comps]) :
+               stbi_load_from_memory((stbi_uc*)data, data_size, &width,
+                                     &height, &read_comps,
+                                     stb_channels[read_comps]);
+
+  if (pixel_data == NULL) {
+    log_warn("Couldn't parse image data!");
+  }
+
+  return (stb_image_load_result_t){
+    .image_width   = width,
+    .image_height  = height,
+    .channel_count = stb_comp_map[read_comps],
+    .pixel_data    = pixel_data,
+  };
+}
+
+static stb_image_load_result_t
+stb_image_load_image_from_file(const char* filename, bool flip_y)
+{
+  int width = 0, height = 0;
+  // Force loading 4 channel images to 3 channel by stb becasue Dawn doesn't
+  // support 3 channel formats currently. The group is discussing on whether
+  // webgpu shoud support 3 channel format.
+  // https://github.com/gpuweb/gpuweb/issues/66#issuecomment-410021505
+  int read_comps = 4;
+  // The flip flag is per thread, images are decoded on the job workers
+  stbi_set_flip_vertically_on_load_thread(flip_y);
+  stbi_uc* pixel_data = stbi_load(filename,                //
+                                  &width,                  //
+                                  &height,                 //
+                                  &read_comps,             //
+                                  stb_channels[read_comps] //
+  );
+
+  if (pixel_data == NULL) {
+    log_error("Couldn't load '%s'\n", filename);
+  }
+  else {
+    log_debug("Loaded image %s (%d, %d, %d / %d)\n", filename, width, height,
+              read_comps, stb_comp_map[read_comps]);
+  }
+
+  return (stb_image_load_result_t){
+    .image_width   = width,
+    .image_height  = height,
+    .channel_count = stb_comp_map[read_comps],
+    .pixel_data    = pixel_data,
+  };
+}
+
+static texture_result_t
+wgpu_texture_upload_stb(struct wgpu_texture_client_t* texture_client,
+                        stb_image_load_result_t* image,
+                        struct wgpu_texture_load_options_t* options)
+{
+  const int width             = image->image_width;
+  const int height            = image->image_height;
+  const int channel_count     = image->channel_count;
+  const bool generate_mipmaps = options ? options->generate_mipmaps : false;
+  const uint32_t mip_level_count
+    = generate_mipmaps ? calculate_mip_level_count(width, height) : 1u;
+
+  const WGPUTextureUsage usage
+    = options ? (options->usage != WGPUTextureUsage_None ?
+                   options->usage :
+                   WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding) :
+                WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding;
+
+  WGPUExtent3D texture_size = {
+    .width              = width,
+    .height             = height,
+    .depthOrArrayLayers = 1,
+  };
+  WGPUTextureDescriptor texture_desc = {
+    .usage         = usage,
+    .dimension     = WGPUTextureDimension_2D,
+    .size          = texture_size,
+    .format        = options ? (options->format != WGPUTextureFormat_Undefined ?
+                                  format_for_color_space(options->format,
+                                                         options->color_space) :
+                                  WGPUTextureFormat_RGBA8Unorm) :
+                               WGPUTextureFormat_RGBA8Unorm,
+    .mipLevelCount = mip_level_count,
+    .sampleCount   = 1,
+  };
   WGPUTexture texture = wgpuDeviceCreateTexture(
     texture_client->wgpu_context->device, &texture_desc);
 
-  // Copy pixel data to texture and free allocated memory
-  wgpu_image_to_texure(texture_client->wgpu_context, texture, pixel_data,
+  // Copy pixel data to texture
+  wgpu_image_to_texure(texture_client->wgpu_context, texture, image->pixel_data,
                        texture_size, channel_count);
-  stbi_image_free(pixel_data);
 
   if (generate_mipmaps) {
     if (texture_client->wgpu_mipmap_generator == NULL) {
@@ -909,39 +1581,9 @@ wgpu_texture_cubemap_load_with_stb(wgpu_context_t* wgpu_context,
   WGPUCommandEncoder cmd_encoder
     = wgpuDeviceCreateCommandEncoder(wgpu_context->device, NULL);
 
-  // Create a host-visible staging buffers that contains the raw image data for
-  // each face of the cubemap
-  WGPUBuffer staging_buffers[6] = {0};
   for (uint32_t face = 0; face < depth; ++face) {
-    WGPUBufferDescriptor staging_buffer_desc = {
-      .usage            = WGPUBufferUsage_CopySrc | WGPUBufferUsage_MapWrite,
-      .size             = texture_size,
-      .mappedAtCreation = true,
-    };
-    staging_buffers[face]
-      = wgpuDeviceCreateBuffer(wgpu_context->device, &staging_buffer_desc);
-    ASSERT(staging_buffers[face])
-  }
-
-  for (uint32_t face = 0; face < depth; ++face) {
-    // Copy texture data into staging buffer
-    void* mapping
-      = wgpuBufferGetMappedRange(staging_buffers[face], 0, texture_size);
-    ASSERT(mapping)
-    memcpy(mapping, image_load_results[face].pixel_data, texture_size);
-    wgpuBufferUnmap(staging_buffers[face]);
-
-    // Upload staging buffer to texture
-    wgpuCommandEncoderCopyBufferToTexture(cmd_encoder,
-      // Source
-      &(WGPUImageCopyBuffer) {
-        .buffer = staging_buffers[face],
-        .layout = (WGPUTextureDataLayout) {
-          .offset       = 0,
-          .bytesPerRow  = width * channel_count,
-          .rowsPerImage = height,
-        },
-      },
+    // Upload the raw image data of each face through the staging belt
+    wgpu_staging_belt_write_texture(wgpu_context->staging_belt, cmd_encoder,
       // Destination
       &(WGPUImageCopyTexture){
         .texture = texture,
@@ -953,6 +1595,13 @@ wgpu_texture_cubemap_load_with_stb(wgpu_context_t* wgpu_context,
         },
         .aspect = WGPUTextureAspect_All,
       },
+      // Source
+      image_load_results[face].pixel_data, texture_size,
+      &(WGPUTextureDataLayout) {
+        .offset       = 0,
+        .bytesPerRow  = width * channel_count,
+        .rowsPerImage = height,
+      },
       // Copy size
       &(WGPUExtent3D){
         .width              = width,
@@ -961,6 +1610,9 @@ wgpu_texture_cubemap_load_with_stb(wgpu_context_t* wgpu_context,
       });
   }
 
+  // The staging chunks of the encoder have to be unmapped before the submit,
+  // the chunks of other encoders that are still recording stay mapped
+  wgpu_staging_belt_finish(wgpu_context->staging_belt, cmd_encoder);
   WGPUCommandBuffer command_buffer
     = wgpuCommandEncoderFinish(cmd_encoder, NULL);
   WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
@@ -968,15 +1620,11 @@ wgpu_texture_cubemap_load_with_stb(wgpu_context_t* wgpu_context,
   // Sumbit commmand buffer and cleanup
   ASSERT(command_buffer != NULL)
 
-  // Submit to the queue
-  wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
+  // Submit to the queue, batched writes are flushed before
+  wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
 
-  // Release command buffer
-  WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
-
-  // Clean up staging resources and pixel data
+  // Clean up pixel data
   for (uint32_t face = 0; face < depth; ++face) {
-    WGPU_RELEASE_RESOURCE(Buffer, staging_buffers[face]);
     stbi_image_free(image_load_results[face].pixel_data);
   }
 
@@ -991,35 +1639,649 @@ wgpu_texture_cubemap_load_with_stb(wgpu_context_t* wgpu_context,
   };
 }
 
-static ktxResult load_ktx_file(const char* filename, ktxTexture** target)
+#define KTX1_HEADER_SIZE 64u
+
+static uint32_t ktx1_read_u32(const uint8_t* data, bool swap)
+{
+  uint32_t value = 0;
+  memcpy(&value, data, sizeof(value));
+  if (swap) {
+    value = (value >> 24) | ((value >> 8) & 0xFF00u)
+            | ((value << 8) & 0xFF0000u) | (value << 24);
+  }
+  return value;
+}
+
+/* Smallest image of a level of a KTX 1 file, only the base level of
+ * uncompressed 2D textures is read */
+static size_t ktx1_min_image_size(const ktx_image_load_result_t* image,
+                                  uint32_t level)
+{
+  const ktxTexture* ktx_texture = image->ktx_texture;
+  if (image->native_format != NULL) {
+    return texture_format_image_size(
+      image->native_format, MAX(1u, ktx_texture->baseWidth >> level),
+      MAX(1u, ktx_texture->baseHeight >> level));
+  }
+  if (level > 0 || ktx_texture->isCubemap) {
+    return 0;
+  }
+  return (size_t)ktx_texture->baseWidth * ktx_texture->baseHeight * 4u;
+}
+
+/* Locates the levels of a KTX 1 file in the mapped file. Every level starts
+ * with its image size, the faces of non-array cube maps are padded to 4 bytes
+ * and so are the levels. */
+static bool ktx1_image_find_levels(ktx_image_load_result_t* image)
+{
+  const ktxTexture* ktx_texture = image->ktx_texture;
+  const uint8_t* data           = image->file.data;
+  const size_t size             = image->file.size;
+  if (size < KTX1_HEADER_SIZE || ktx_texture->numLevels > KTX2_MAX_LEVELS) {
+    return false;
+  }
+
+  // Byte swapped files are only read in place if no swapping is needed
+  const bool swap = ktx1_read_u32(data + 12, false) != 0x04030201u;
+  if (swap && ktx1_read_u32(data + 20, true) > 1u) {
+    return false;
+  }
+
+  const bool face_images = ktx_texture->isCubemap && !ktx_texture->isArray;
+  size_t offset = KTX1_HEADER_SIZE + (size_t)ktx1_read_u32(data + 60, swap);
+  for (uint32_t level = 0; level < ktx_texture->numLevels; ++level) {
+    if (offset > size || size - offset < 4) {
+      return false;
+    }
+    const size_t image_size = ktx1_read_u32(data + offset, swap);
+    const size_t face_stride
+      = face_images ? (image_size + 3) & ~(size_t)3 :
+                      image_size / ktx_texture->numFaces;
+    const size_t level_size
+      = face_images ? face_stride * ktx_texture->numFaces : image_size;
+    offset += 4;
+    if (size - offset < level_size
+        || face_stride < ktx1_min_image_size(image, level)) {
+      return false;
+    }
+    image->ktx1_levels[level].offset      = offset;
+    image->ktx1_levels[level].face_stride = face_stride;
+    offset += (level_size + 3) & ~(size_t)3;
+  }
+  return true;
+}
+
+/* KTX 1 files are parsed by libktx, the image data is read from the mapped
+ * file. The image data of uncompressed cube maps is loaded at upload time,
+ * straight into the staging buffer. */
+static bool ktx1_image_load(const char* filename,
+                            ktx_image_load_result_t* image)
 {
-  ktxResult result = KTX_SUCCESS;
-  if (!file_exists(filename)) {
+  ktxTexture* ktx_texture = NULL;
+  ktxResult result
+    = ktxTexture_CreateFromMemory(image->file.data, image->file.size,
+                                  KTX_TEXTURE_CREATE_NO_FLAGS, &ktx_texture);
+  if (result != KTX_SUCCESS) {
     log_fatal("Could not load texture from %s", filename);
-    return KTX_FILE_OPEN_FAILED;
+    return false;
   }
-  result = ktxTexture_CreateFromNamedFile(
-    filename, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, target);
-  return result;
+  image->ktx_texture = ktx_texture;
+
+  if (ktx_texture->isCompressed) {
+    image->native_format
+      = texture_format_info_from_gl(ktx_texture->glInternalformat);
+    if (image->native_format == NULL) {
+      log_error("Unsupported compressed format 0x%04X of %s",
+                ktx_texture->glInternalformat, filename);
+      return false;
+    }
+  }
+
+  if (!ktx1_image_find_levels(image)) {
+    log_fatal("Could not read the image data of %s", filename);
+    return false;
+  }
+
+  if (image->native_format != NULL || ktx_texture->isCubemap) {
+    return true;
+  }
+
+  // Generate Mipmap, WebGPU requires that the bytes per row is a multiple of
+  // 256
+  if (!mip_chain_create(
+        &(mip_chain_desc_t){
+          .pixels        = image->file.data + image->ktx1_levels[0].offset,
+          .width         = ktx_texture->baseWidth,
+          .height        = ktx_texture->baseHeight,
+          .row_alignment = TEXTURE_COPY_BYTES_PER_ROW_ALIGNMENT,
+          .color_space   = MipChainColorSpace_Linear,
+        },
+        &image->mip_chain)) {
+    log_fatal("Could not generate the mip chain of %s", filename);
+    return false;
+  }
+  return true;
 }
 
+/* KTX 2 files are uploaded in their own format, the levels are read from the
+ * mapped file */
+static bool ktx2_image_load(const char* filename,
+                            ktx_image_load_result_t* image)
+{
+  ktx2_texture_t* ktx2 = &image->ktx2;
+  if (!ktx2_parse(image->file.data, image->file.size, ktx2)) {
+    log_fatal("Could not load texture from %s", filename);
+    return false;
+  }
+
+  image->native_format = texture_format_info_from_vk(ktx2->vk_format);
+  if (image->native_format == NULL || ktx2->supercompression_scheme != 0
+      || ktx2->depth > 1 || ktx2->layer_count > 1) {
+    log_error("Unsupported KTX 2.0 texture %s (vkFormat %u, "
+              "supercompression %u)",
+              filename, ktx2->vk_format, ktx2->supercompression_scheme);
+    return false;
+  }
+
+  for (uint32_t level = 0; level < ktx2->level_count; ++level) {
+    const size_t image_size = texture_format_image_size(
+      image->native_format, MAX(1u, ktx2->width >> level),
+      MAX(1u, ktx2->height >> level));
+    if (ktx2->levels[level].size < image_size * ktx2->face_count) {
+      log_error("Level %u of %s is truncated", level, filename);
+      return false;
+    }
+  }
+  return true;
+}
+
+static void ktx_image_destroy(ktx_image_load_result_t* image)
+{
+  mip_chain_destroy(&image->mip_chain);
+  if (image->ktx_texture != NULL) {
+    ktxTexture_Destroy(image->ktx_texture);
+    image->ktx_texture = NULL;
+  }
+  file_view_close(&image->file);
+}
+
+/* Parses the KTX file of the image, the image is destroyed on failure */
+static bool ktx_image_load_from_view(const char* filename,
+                                     ktx_image_load_result_t* image)
+{
+  bool loaded = ktx2_has_identifier(image->file.data, image->file.size) ?
+                  ktx2_image_load(filename, image) :
+                  ktx1_image_load(filename, image);
+
+  // Compressed textures have to be a multiple of the block size
+  const texture_format_info_t* format = image->native_format;
+  if (loaded && format != NULL) {
+    const uint32_t width  = image->ktx_texture ? image->ktx_texture->baseWidth :
+                                                 image->ktx2.width;
+    const uint32_t height = image->ktx_texture ?
+                              image->ktx_texture->baseHeight :
+                              MAX(1u, image->ktx2.height);
+    if (width % format->block_width != 0
+        || height % format->block_height != 0) {
+      log_error("The size of %s (%ux%u) is not a multiple of the block size",
+                filename, width, height);
+      loaded = false;
+    }
+  }
+
+  if (!loaded) {
+    ktx_image_destroy(image);
+  }
+  return loaded;
+}
+
+static bool ktx_image_load_from_file(const char* filename,
+                                     ktx_image_load_result_t* image)
+{
+  *image = (ktx_image_load_result_t){0};
+  if (!file_exists(filename)
+      || !file_view_open(filename, FileViewFlags_Sequential, &image->file)) {
+    log_fatal("Could not load texture from %s", filename);
+    return false;
+  }
+  return ktx_image_load_from_view(filename, image);
+}
+
+/* Block formats are uploaded as they are, there is no CPU decoder for them.
+ * The image is destroyed if the device lacks the feature of its format. */
+static bool ktx_image_check_format_support(wgpu_context_t* wgpu_context,
+                                           const char* filename,
+                                           ktx_image_load_result_t* image)
+{
+  const texture_format_info_t* format = image->native_format;
+  if (format == NULL || format->feature == WGPUFeatureName_Undefined
+      || wgpu_has_feature(wgpu_context, format->feature)) {
+    return true;
+  }
+
+  if (image->ktx_texture != NULL) {
+    log_error("The format 0x%04X of %s requires the unsupported device "
+              "feature %s",
+              image->ktx_texture->glInternalformat, filename,
+              texture_format_feature_name(format->feature));
+  }
+  else {
+    log_error("The format (vkFormat %u) of %s requires the unsupported device "
+              "feature %s",
+              image->ktx2.vk_format, filename,
+              texture_format_feature_name(format->feature));
+  }
+  ktx_image_destroy(image);
+  return false;
+}
+
+/* Load-time BC1 / BC3 / BC7 compression of jpg and png files. The compressed
+ * mip chain is stored as KTX 2 file named after a hash of the source file
+ * and the encoder settings, later loads upload the cached file as it is. */
+
+/* Changes of the encoder output have to bump the version, which invalidates
+ * the cached textures */
+#define TEXTURE_CACHE_VERSION 1u
+#define TEXTURE_CACHE_HASH_SEED 0xcbf29ce484222325ull
+
+typedef struct texture_cache_key_t {
+  uint32_t version;
+  uint32_t mode; /* wgpu_texture_compression_enum */
+  uint32_t bc7_quality;
+  uint32_t flip_y;
+  uint32_t srgb;
+  uint32_t mipmaps;
+} texture_cache_key_t;
+
+static uint64_t texture_cache_hash(uint64_t hash, const void* data,
+                                   size_t size)
+{
+  // FNV-1a
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+/* Only sampled RGBA8 textures are compressed, other formats and usages (e.g.
+ * storage textures and GPU generated mipmaps) require the uncompressed data */
+static bool
+stb_image_use_compression(wgpu_context_t* wgpu_context,
+                          struct wgpu_texture_load_options_t* options,
+                          bool* srgb)
+{
+  if (wgpu_context->texture_compression.mode == TextureCompression_Off
+      || !wgpu_has_feature(wgpu_context,
+                           WGPUFeatureName_TextureCompressionBC)) {
+    return false;
+  }
+  if (options != NULL && options->usage != WGPUTextureUsage_None
+      && options->usage
+           != (WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding)) {
+    return false;
+  }
+  // Same format as the uncompressed upload
+  const WGPUTextureFormat format
+    = (options != NULL && options->format != WGPUTextureFormat_Undefined) ?
+        format_for_color_space(options->format, options->color_space) :
+        WGPUTextureFormat_RGBA8Unorm;
+  *srgb = (format == WGPUTextureFormat_RGBA8UnormSrgb);
+  return format == WGPUTextureFormat_RGBA8Unorm || *srgb;
+}
+
+/* Generates the mip chain of the image and compresses every level into a KTX
+ * 2 file in memory, the blocks of a level are encoded on the job system */
+static bool stb_image_compress(wgpu_context_t* wgpu_context,
+                               const stb_image_load_result_t* image,
+                               bool srgb, bool mipmaps, file_view_t* file)
+{
+  const uint32_t width  = (uint32_t)image->image_width;
+  const uint32_t height = (uint32_t)image->image_height;
+
+  block_compress_format_enum format = BlockCompressFormat_BC1;
+  switch (wgpu_context->texture_compression.mode) {
+    case TextureCompression_BC3:
+      format = BlockCompressFormat_BC3;
+      break;
+    case TextureCompression_BC7:
+      format = BlockCompressFormat_BC7;
+      break;
+    case TextureCompression_Auto:
+      format = block_compress_is_opaque(image->pixel_data, width, height, 0) ?
+                 BlockCompressFormat_BC1 :
+                 BlockCompressFormat_BC3;
+      break;
+    default:
+      break;
+  }
+  // vkFormat of the unorm and the sRGB variant
+  static const uint32_t vk_formats[3][2] = {
+    {131, 132}, /* BC1_RGB */
+    {137, 138}, /* BC3 */
+    {145, 146}, /* BC7 */
+  };
+
+  mip_chain_t mip_chain = {0};
+  if (!mip_chain_create(
+        &(mip_chain_desc_t){
+          .pixels      = image->pixel_data,
+          .width       = width,
+          .height      = height,
+          .level_count = mipmaps ? 0 : 1,
+          .color_space
+          = srgb ? MipChainColorSpace_Srgb : MipChainColorSpace_Linear,
+        },
+        &mip_chain)) {
+    return false;
+  }
+
+  ktx2_write_desc_t ktx2_desc = {
+    .vk_format   = vk_formats[format][srgb ? 1 : 0],
+    .width       = width,
+    .height      = height,
+    .level_count = mip_chain.level_count,
+  };
+  size_t blocks_size = 0;
+  for (uint32_t level = 0; level < mip_chain.level_count; ++level) {
+    blocks_size += block_compress_image_size(
+      format, mip_chain.levels[level].width, mip_chain.levels[level].height);
+  }
+  uint8_t* blocks = (uint8_t*)malloc(blocks_size);
+  if (blocks == NULL) {
+    mip_chain_destroy(&mip_chain);
+    return false;
+  }
+
+  size_t offset = 0;
+  for (uint32_t level = 0; level < mip_chain.level_count; ++level) {
+    const mip_chain_level_t* mip_level = &mip_chain.levels[level];
+    const size_t size                  = block_compress_image_size(
+      format, mip_level->width, mip_level->height);
+    block_compress(
+      &(block_compress_desc_t){
+        .pixels      = mip_chain.data + mip_level->offset,
+        .width       = mip_level->width,
+        .height      = mip_level->height,
+        .row_pitch   = mip_level->row_pitch,
+        .format      = format,
+        .bc7_quality = wgpu_context->texture_compression.bc7_quality,
+      },
+      blocks + offset);
+    ktx2_desc.levels[level].data = blocks + offset;
+    ktx2_desc.levels[level].size = size;
+    offset += size;
+  }
+  mip_chain_destroy(&mip_chain);
+
+  uint8_t* ktx2_data = NULL;
+  size_t ktx2_size   = 0;
+  const bool written = ktx2_write(&ktx2_desc, &ktx2_data, &ktx2_size);
+  free(blocks);
+  if (!written) {
+    return false;
+  }
+
+  // Heap backed view, released by file_view_close()
+  *file = (file_view_t){
+    .data = ktx2_data,
+    .size = ktx2_size,
+  };
+  return true;
+}
+
+/* Loads the compressed texture from the cache or decodes and compresses the
+ * image, images that are no multiple of the block size are kept as RGBA8 */
+static bool
+stb_image_load_compressed(wgpu_context_t* wgpu_context, const char* filename,
+                          struct wgpu_texture_load_options_t* options,
+                          bool srgb, wgpu_texture_data_t* data)
+{
+  const char* cache_dir = wgpu_context->texture_compression.cache_dir;
+  const bool flip_y     = options ? options->flip_y : false;
+  const bool mipmaps    = options ? options->generate_mipmaps : false;
+
+  file_view_t file = {0};
+  if (!file_view_open(filename, FileViewFlags_Sequential, &file)) {
+    log_error("Couldn't load '%s'\n", filename);
+    return false;
+  }
+
+  // The key covers the encoded image and all settings that change the output
+  const texture_cache_key_t key = {
+    .version     = TEXTURE_CACHE_VERSION,
+    .mode        = wgpu_context->texture_compression.mode,
+    .bc7_quality = wgpu_context->texture_compression.bc7_quality,
+    .flip_y      = flip_y,
+    .srgb        = srgb,
+    .mipmaps     = mipmaps,
+  };
+  uint64_t hash
+    = texture_cache_hash(TEXTURE_CACHE_HASH_SEED, file.data, file.size);
+  hash = texture_cache_hash(hash, &key, sizeof(key));
+
+  char cache_filename[STRMAX + 32] = {0};
+  if (cache_dir[0] != '\0') {
+    snprintf(cache_filename, sizeof(cache_filename), "%s/%016llx.ktx2",
+             cache_dir, (unsigned long long)hash);
+    if (file_exists(cache_filename)
+        && ktx_image_load_from_file(cache_filename, &data->image.ktx)) {
+      file_view_close(&file);
+      data->type = TextureDataType_Ktx;
+      log_debug("Loaded compressed image %s from %s\n", filename,
+                cache_filename);
+      return true;
+    }
+  }
+
+  int width = 0, height = 0, read_comps = 0;
+  // The flip flag is per thread, images are decoded on the job workers
+  stbi_set_flip_vertically_on_load_thread(flip_y);
+  stbi_uc* pixel_data
+    = stbi_load_from_memory(file.data, (int)file.size, &width, &height,
+                            &read_comps, STBI_rgb_alpha);
+  file_view_close(&file);
+  if (pixel_data == NULL) {
+    log_error("Couldn't load '%s'\n", filename);
+    return false;
+  }
+  const stb_image_load_result_t image = {
+    .image_width   = width,
+    .image_height  = height,
+    .channel_count = 4,
+    .pixel_data    = pixel_data,
+  };
+  data->type      = TextureDataType_Stb;
+  data->image.stb = image;
+
+  if ((width % 4) != 0 || (height % 4) != 0) {
+    log_debug("The size of %s (%dx%d) is not a multiple of 4, it is not "
+              "compressed\n",
+              filename, width, height);
+    return true;
+  }
+
+  ktx_image_load_result_t ktx_image = {0};
+  if (!stb_image_compress(wgpu_context, &image, srgb, mipmaps,
+                          &ktx_image.file)) {
+    log_warn("Could not compress %s, it is uploaded uncompressed", filename);
+    return true;
+  }
+  if (cache_filename[0] != '\0' && file_create_directories(cache_dir)) {
+    file_write_atomic(cache_filename, ktx_image.file.data,
+                      ktx_image.file.size);
+  }
+  if (!ktx_image_load_from_view(filename, &ktx_image)) {
+    return true;
+  }
+
+  stbi_image_free(pixel_data);
+  data->type      = TextureDataType_Ktx;
+  data->image.ktx = ktx_image;
+  return true;
+}
+
+/* Stages one image with tightly packed rows of blocks and records its copy,
+ * the rows are padded to the bytes per row alignment of buffer copies */
+static void wgpu_texture_write_blocks(wgpu_context_t* wgpu_context,
+                                      WGPUCommandEncoder cmd_encoder,
+                                      WGPUTexture texture,
+                                      const texture_format_info_t* format,
+                                      uint32_t level, uint32_t layer,
+                                      uint32_t width, uint32_t height,
+                                      const uint8_t* data)
+{
+  const uint32_t blocks_x
+    = (width + format->block_width - 1) / format->block_width;
+  const uint32_t blocks_y
+    = (height + format->block_height - 1) / format->block_height;
+  const uint32_t row_size  = blocks_x * format->block_size;
+  const uint32_t row_pitch = texture_copy_row_pitch(row_size);
+
+  wgpu_staging_allocation_t allocation = {0};
+  if (!wgpu_staging_belt_allocate(
+        wgpu_context->staging_belt, cmd_encoder, (uint64_t)row_pitch * blocks_y,
+        WGPU_STAGING_BELT_TEXTURE_ALIGNMENT, &allocation)) {
+    log_error("Could not stage level %u, layer %u of the texture (%ux%u)",
+              level, layer, width, height);
+    return;
+  }
+  uint8_t* staged = (uint8_t*)allocation.data;
+  if (row_pitch == row_size) {
+    memcpy(staged, data, (size_t)row_size * blocks_y);
+  }
+  else {
+    for (uint32_t row = 0; row < blocks_y; ++row) {
+      memcpy(staged + (size_t)row * row_pitch, data + (size_t)row * row_size,
+             row_size);
+    }
+  }
+
+  // The copy covers the physical size of the level, which is rounded up to
+  // whole blocks
+  wgpuCommandEncoderCopyBufferToTexture(cmd_encoder,
+    // Source
+    &(WGPUImageCopyBuffer) {
+      .buffer = allocation.buffer,
+      .layout = (WGPUTextureDataLayout) {
+        .offset = allocation.offset,
+        .bytesPerRow = row_pitch,
+        .rowsPerImage= blocks_y,
+      },
+    },
+    // Destination
+    &(WGPUImageCopyTexture){
+      .texture = texture,
+      .mipLevel = level,
+      .origin = (WGPUOrigin3D) {
+        .x=0,
+        .y=0,
+        .z=layer,
+      },
+      .aspect = WGPUTextureAspect_All,
+    },
+    // Copy size
+    &(WGPUExtent3D){
+      .width               = blocks_x * format->block_width,
+      .height              = blocks_y * format->block_height,
+      .depthOrArrayLayers  = 1,
+    });
+}
+
+/* Uploads the levels and faces of the file in their own (block) format */
 static texture_result_t
-wgpu_texture_load_from_ktx_file(wgpu_context_t* wgpu_context,
-                                const char* filename)
+wgpu_texture_upload_ktx_native(wgpu_context_t* wgpu_context,
+                               ktx_image_load_result_t* image)
 {
-  ktxTexture* ktx_texture;
-  ktxResult result = load_ktx_file(filename, &ktx_texture);
-  assert(result == KTX_SUCCESS);
+  // The loader rejects formats the device doesn't support
+  const texture_format_info_t* format = image->native_format;
+  ASSERT(format->feature == WGPUFeatureName_Undefined
+         || wgpu_has_feature(wgpu_context, format->feature));
+
+  ktxTexture* ktx_texture    = image->ktx_texture;
+  const ktx2_texture_t* ktx2 = &image->ktx2;
+  const uint32_t texture_width
+    = ktx_texture ? ktx_texture->baseWidth : ktx2->width;
+  const uint32_t texture_height
+    = ktx_texture ? ktx_texture->baseHeight : MAX(1u, ktx2->height);
+  const uint32_t texture_depth
+    = ktx_texture ? ktx_texture->numFaces : ktx2->face_count;
+  const uint32_t texture_mip_level_count
+    = ktx_texture ? ktx_texture->numLevels : ktx2->level_count;
 
-  ktx_uint8_t* ktx_texture_data = ktxTexture_GetData(ktx_texture);
+  WGPUTextureDescriptor texture_desc = {
+    .size          = (WGPUExtent3D) {
+      .width               = texture_width,
+      .height              = texture_height,
+      .depthOrArrayLayers  = texture_depth,
+     },
+    .mipLevelCount = texture_mip_level_count,
+    .sampleCount   = 1,
+    .dimension     = WGPUTextureDimension_2D,
+    .format        = format->format,
+    .usage         = WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding,
+  };
+  WGPUTexture texture
+    = wgpuDeviceCreateTexture(wgpu_context->device, &texture_desc);
 
-  // WebGPU requires that the bytes per row is a multiple of 256
-  uint32_t resized_width = make_multiple_of_256(ktx_texture->baseWidth);
+  WGPUCommandEncoder cmd_encoder
+    = wgpuDeviceCreateCommandEncoder(wgpu_context->device, NULL);
+
+  for (uint32_t level = 0; level < texture_mip_level_count; ++level) {
+    const uint32_t width  = MAX(1u, texture_width >> level);
+    const uint32_t height = MAX(1u, texture_height >> level);
+    for (uint32_t face = 0; face < texture_depth; ++face) {
+      const uint8_t* data = NULL;
+      if (ktx_texture != NULL) {
+        data = image->file.data + image->ktx1_levels[level].offset
+               + face * image->ktx1_levels[level].face_stride;
+      }
+      else {
+        data = image->file.data + ktx2->levels[level].offset
+               + face * texture_format_image_size(format, width, height);
+      }
+      wgpu_texture_write_blocks(wgpu_context, cmd_encoder, texture, format,
+                                level, face, width, height, data);
+    }
+  }
+
+  // The staging chunks of the encoder have to be unmapped before the submit,
+  // the chunks of other encoders that are still recording stay mapped
+  wgpu_staging_belt_finish(wgpu_context->staging_belt, cmd_encoder);
+  WGPUCommandBuffer command_buffer
+    = wgpuCommandEncoderFinish(cmd_encoder, NULL);
+  WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
+
+  // Sumbit commmand buffer and cleanup
+  ASSERT(command_buffer != NULL)
+
+  // Submit to the queue, batched writes are flushed before
+  wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
+
+  return (texture_result_t){
+    .texture         = texture,
+    .width           = texture_desc.size.width,
+    .height          = texture_desc.size.height,
+    .depth           = texture_desc.size.depthOrArrayLayers,
+    .mip_level_count = texture_desc.mipLevelCount,
+    .format          = texture_desc.format,
+    .dimension       = texture_desc.dimension,
+  };
+}
+
+static texture_result_t wgpu_texture_upload_ktx(wgpu_context_t* wgpu_context,
+                                                ktx_image_load_result_t* image)
+{
+  if (image->native_format != NULL) {
+    return wgpu_texture_upload_ktx_native(wgpu_context, image);
+  }
+
+  // Uncompressed KTX 1 files are uploaded as RGBA8
+  ktxTexture* ktx_texture = image->ktx_texture;
 
   // Get properties required for using and upload texture data from the ktx
   // texture object
-  uint32_t texture_width
-    = ktx_texture->isCubemap ? ktx_texture->baseWidth : resized_width;
+  uint32_t texture_width  = ktx_texture->baseWidth;
   uint32_t texture_height = ktx_texture->baseHeight;
   uint32_t texture_depth  = ktx_texture->isCubemap ? 6u : 1u;
   uint32_t numLevelsOffset /* bytesPerRow must multiple of 256. */
@@ -1029,8 +2291,7 @@ wgpu_texture_load_from_ktx_file(wgpu_context_t* wgpu_context,
         (ktx_texture->numLevels > 6u ?
            ktx_texture->numLevels - numLevelsOffset :
            1u) :
-        calculate_mip_level_count(ktx_texture->baseWidth,
-                                  ktx_texture->baseHeight);
+        image->mip_chain.level_count;
   WGPUTextureFormat texture_format = WGPUTextureFormat_RGBA8Unorm;
 
   WGPUTextureDescriptor texture_desc = {
@@ -1052,23 +2313,19 @@ wgpu_texture_load_from_ktx_file(wgpu_context_t* wgpu_context,
     = wgpuDeviceCreateCommandEncoder(wgpu_context->device, NULL);
 
   if (ktx_texture->isCubemap) {
-    // Create a host-visible staging buffer that contains the raw image data
-    ktx_size_t ktx_texture_size              = ktxTexture_GetSize(ktx_texture);
-    WGPUBufferDescriptor staging_buffer_desc = {
-      .usage            = WGPUBufferUsage_CopySrc | WGPUBufferUsage_MapWrite,
-      .size             = ktx_texture_size,
-      .mappedAtCreation = true,
-    };
-    WGPUBuffer staging_buffer
-      = wgpuDeviceCreateBuffer(wgpu_context->device, &staging_buffer_desc);
-    ASSERT(staging_buffer)
-
-    // Copy texture data into staging buffer
-    void* mapping
-      = wgpuBufferGetMappedRange(staging_buffer, 0, ktx_texture_size);
-    ASSERT(mapping)
-    memcpy(mapping, ktx_texture_data, ktx_texture_size);
-    wgpuBufferUnmap(staging_buffer);
+    // Load the raw image data of all faces and levels from the mapped file
+    // directly into the staging buffer
+    ktx_size_t ktx_texture_size          = ktxTexture_GetSize(ktx_texture);
+    wgpu_staging_allocation_t allocation = {0};
+    wgpu_staging_belt_allocate(wgpu_context->staging_belt, cmd_encoder,
+                               ktx_texture_size,
+                               WGPU_STAGING_BELT_TEXTURE_ALIGNMENT,
+                               &allocation);
+    ASSERT(allocation.data)
+    KTX_error_code load_result
+      = ktxTexture_LoadImageData(ktx_texture, allocation.data, ktx_texture_size);
+    ASSERT(load_result == KTX_SUCCESS);
+    UNUSED_VAR(load_result);
 
     for (uint32_t face = 0; face < texture_depth; ++face) {
       for (uint32_t level = 0; level < texture_mip_level_count; ++level) {
@@ -1084,9 +2341,9 @@ wgpu_texture_load_from_ktx_file(wgpu_context_t* wgpu_context,
         wgpuCommandEncoderCopyBufferToTexture(cmd_encoder,
           // Source
           &(WGPUImageCopyBuffer) {
-            .buffer = staging_buffer,
+            .buffer = allocation.buffer,
             .layout = (WGPUTextureDataLayout) {
-              .offset = offset,
+              .offset = allocation.offset + offset,
               .bytesPerRow = width * 4,
               .rowsPerImage= height,
             },
@@ -1110,80 +2367,48 @@ wgpu_texture_load_from_ktx_file(wgpu_context_t* wgpu_context,
           });
       }
     }
-
-    WGPU_RELEASE_RESOURCE(Buffer, staging_buffer);
   }
   else { /* WGPUTextureDimension_2D */
-    // Generate Mipmap
-    uint8_t** resized_vec = NULL;
-    generate_mipmap(ktx_texture_data, ktx_texture->baseWidth,
-                    ktx_texture->baseHeight, 0, &resized_vec, resized_width,
-                    ktx_texture->baseHeight, 0, 4, true);
-
-    // Setup buffer copy regions for each face including all of its mip levels
-    // and copy the texture regions from the staging buffer into the texture
-    for (uint32_t face = 0; face < texture_depth; ++face) {
-      for (uint32_t level = 0; level < texture_mip_level_count; ++level) {
-        uint32_t width  = texture_width >> level;
-        uint32_t height = texture_height >> level;
-        if (height == 0) {
-          height = 1;
-        }
-
-        // Create a host-visible staging buffer that contains the raw image data
-        size_t ktx_texture_size                  = texture_width * height * 4;
-        WGPUBufferDescriptor staging_buffer_desc = {
-          .usage = WGPUBufferUsage_CopySrc | WGPUBufferUsage_MapWrite,
-          .size  = ktx_texture_size,
-          .mappedAtCreation = true,
-        };
-        WGPUBuffer staging_buffer
-          = wgpuDeviceCreateBuffer(wgpu_context->device, &staging_buffer_desc);
-        ASSERT(staging_buffer)
-
-        // Copy texture data into staging buffer
-        void* mapping
-          = wgpuBufferGetMappedRange(staging_buffer, 0, ktx_texture_size);
-        ASSERT(mapping)
-        memcpy(mapping, resized_vec[level], ktx_texture_size);
-        wgpuBufferUnmap(staging_buffer);
-
-        // Upload statging buffer to texture
-        wgpuCommandEncoderCopyBufferToTexture(cmd_encoder,
-          // Source
-          &(WGPUImageCopyBuffer) {
-            .buffer = staging_buffer,
-            .layout = (WGPUTextureDataLayout) {
-              .offset = 0,
-              .bytesPerRow = texture_width * 4,
-              .rowsPerImage= height,
-            },
-          },
-          // Destination
-          &(WGPUImageCopyTexture){
-            .texture = texture,
-            .mipLevel = level,
-            .origin = (WGPUOrigin3D) {
-              .x=0,
-              .y=0,
-              .z=face,
-            },
-            .aspect = WGPUTextureAspect_All,
+    const mip_chain_t* mip_chain = &image->mip_chain;
+
+    // Copy the levels of the mip chain from the staging buffer into the
+    // texture, the rows of every level are padded to 256 bytes
+    for (uint32_t level = 0; level < texture_mip_level_count; ++level) {
+      const mip_chain_level_t* mip_level = &mip_chain->levels[level];
+
+      // Upload the raw image data through the staging belt
+      size_t ktx_texture_size = mip_level->row_pitch * mip_level->height;
+      wgpu_staging_belt_write_texture(wgpu_context->staging_belt, cmd_encoder,
+        // Destination
+        &(WGPUImageCopyTexture){
+          .texture = texture,
+          .mipLevel = level,
+          .origin = (WGPUOrigin3D) {
+            .x=0,
+            .y=0,
+            .z=0,
           },
-          // Copy size
-          &(WGPUExtent3D){
-            .width               = MAX(1u, width),
-            .height              = MAX(1u, height),
-            .depthOrArrayLayers  = 1,
-          });
-
-        WGPU_RELEASE_RESOURCE(Buffer, staging_buffer);
-      }
+          .aspect = WGPUTextureAspect_All,
+        },
+        // Source
+        mip_chain->data + mip_level->offset, ktx_texture_size,
+        &(WGPUTextureDataLayout) {
+          .offset = 0,
+          .bytesPerRow = mip_level->row_pitch,
+          .rowsPerImage= mip_level->height,
+        },
+        // Copy size
+        &(WGPUExtent3D){
+          .width               = mip_level->width,
+          .height              = mip_level->height,
+          .depthOrArrayLayers  = 1,
+        });
     }
-    // Free image data after upload to GPU
-    destroy_image_data(resized_vec, resized_width, ktx_texture->baseHeight);
   }
 
+  // The staging chunks of the encoder have to be unmapped before the submit,
+  // the chunks of other encoders that are still recording stay mapped
+  wgpu_staging_belt_finish(wgpu_context->staging_belt, cmd_encoder);
   WGPUCommandBuffer command_buffer
     = wgpuCommandEncoderFinish(cmd_encoder, NULL);
   WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
@@ -1191,14 +2416,8 @@ wgpu_texture_load_from_ktx_file(wgpu_context_t* wgpu_context,
   // Sumbit commmand buffer and cleanup
   ASSERT(command_buffer != NULL)
 
-  // Submit to the queue
-  wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
-
-  // Release command buffer
-  WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
-
-  // Clean up staging resources
-  ktxTexture_Destroy(ktx_texture);
+  // Submit to the queue, batched writes are flushed before
+  wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
 
   return (texture_result_t){
     .texture         = texture,
@@ -1211,47 +2430,140 @@ wgpu_texture_load_from_ktx_file(wgpu_context_t* wgpu_context,
   };
 }
 
-static texture_result_t
-wgpu_texture_load_from_basis_file(wgpu_context_t* wgpu_context,
-                                  const char* filename)
+/* Transcoding of the (face, level) pairs of a basis file on the job system */
+typedef struct basis_transcode_pass_t {
+  const basisu_transcoder_t* transcoder;
+  basis_image_load_result_t* image;
+  uint32_t failed_count;
+} basis_transcode_pass_t;
+
+static void basis_transcode_levels(uint32_t begin, uint32_t end, void* data)
 {
-  // Read file into memory
-  if (!file_exists(filename)) {
-    log_fatal("Could not load texture from %s", filename);
-    return (texture_result_t){0};
+  basis_transcode_pass_t* pass     = (basis_transcode_pass_t*)data;
+  basis_image_load_result_t* image = pass->image;
+  for (uint32_t i = begin; i < end; ++i) {
+    // Ordered by level, the largest images are handed out first
+    const uint32_t level = i / image->desc.image_count;
+    const uint32_t face  = i % image->desc.image_count;
+    uint8_t* output = image->data + image->levels[level].offset
+                      + face * image->levels[level].image_size;
+    if (!basisu_transcoder_transcode_level(pass->transcoder, face, level,
+                                           output,
+                                           image->levels[level].row_pitch)) {
+      __atomic_add_fetch(&pass->failed_count, 1, __ATOMIC_RELAXED);
+    }
   }
+}
+
+static void basis_image_destroy(basis_image_load_result_t* image)
+{
+  free(image->data);
+  image->data = NULL;
+}
 
-  file_read_result_t file_read_result = {0};
-  read_file(filename, &file_read_result, false);
+static bool
+basis_image_load_from_file(struct wgpu_texture_client_t* texture_client,
+                           const char* filename,
+                           basis_image_load_result_t* image)
+{
+  // Map the file, the transcode jobs read it in parallel
+  file_view_t file = {0};
+  if (!file_exists(filename)
+      || !file_view_open(filename, FileViewFlags_WillNeed, &file)) {
+    log_fatal("Could not load texture from %s", filename);
+    return false;
+  }
 
-  struct wgpu_texture_client_t* texture_client = wgpu_context->texture_client;
+  pthread_mutex_lock(&basisu_mutex);
+  if (!texture_client->holds_basisu) {
+    if (basisu_ref_count++ == 0 && !basisu_is_initialized()) {
+      basisu_setup();
+    }
+    texture_client->holds_basisu = true;
+  }
+  pthread_mutex_unlock(&basisu_mutex);
 
-  // Transcode file
-  basisu_setup();
-  basisu_transcode_result_t transcode_result = basisu_transcode(
+  // The transcode target is picked from the formats the device supports
+  uint32_t result_code            = BASIS_TRANSCODE_RESULT_SUCCESS;
+  basisu_transcoder_t* transcoder = basisu_transcoder_create(
     (basisu_data_t){
-      .ptr  = file_read_result.data,
-      .size = file_read_result.size,
+      .ptr  = file.data,
+      .size = file.size,
     },
-    &texture_client->supported_format_list.values,
-    texture_client->supported_format_list.count, false);
-  if (transcode_result.result_code != BASIS_TRANSCODE_RESULT_SUCCESS) {
+    texture_client->supported_format_list.values,
+    (uint32_t)texture_client->supported_format_list.count, true,
+    &result_code);
+  if (transcoder == NULL) {
+    log_fatal("Could not transcode texture from %s (error %u)", filename,
+              result_code);
+    file_view_close(&file);
+    return false;
+  }
+
+  // Precompute the offsets of all levels, the jobs write straight into one
+  // allocation that is staged as a whole
+  *image                            = (basis_image_load_result_t){0};
+  const basisu_texture_desc_t* desc = &image->desc;
+  basisu_transcoder_get_texture_desc(transcoder, &image->desc);
+  for (uint32_t level = 0; level < desc->level_count; ++level) {
+    const uint32_t width    = MAX(1u, desc->width >> level);
+    const uint32_t height   = MAX(1u, desc->height >> level);
+    const uint32_t blocks_x
+      = (width + desc->block_width - 1) / desc->block_width;
+    const uint32_t rows
+      = (height + desc->block_height - 1) / desc->block_height;
+    const uint32_t row_pitch
+      = texture_copy_row_pitch(blocks_x * desc->block_size);
+    image->levels[level].offset     = image->size;
+    image->levels[level].image_size = (size_t)row_pitch * rows;
+    image->levels[level].row_pitch  = row_pitch;
+    image->levels[level].rows       = rows;
+    image->size += image->levels[level].image_size * desc->image_count;
+  }
+  image->data = (uint8_t*)calloc(1, image->size);
+  if (image->data == NULL) {
+    log_error("Could not allocate %zu bytes for the levels of %s",
+              image->size, filename);
+    basisu_transcoder_destroy(transcoder);
+    file_view_close(&file);
+    return false;
+  }
+
+  basis_transcode_pass_t pass = {
+    .transcoder = transcoder,
+    .image      = image,
+  };
+  job_parallel_for(desc->level_count * desc->image_count, 1,
+                   basis_transcode_levels, &pass);
+
+  basisu_transcoder_destroy(transcoder);
+  file_view_close(&file);
+
+  if (pass.failed_count > 0) {
     log_fatal("Could not transcode texture from %s", filename);
-    return (texture_result_t){0};
+    basis_image_destroy(image);
+    return false;
   }
+  return true;
+}
 
-  // Create file
-  basisu_image_desc_t* image_desc = &transcode_result.image_desc;
+static texture_result_t
+wgpu_texture_upload_basis(wgpu_context_t* wgpu_context,
+                          basis_image_load_result_t* image)
+{
+  const basisu_texture_desc_t* desc = &image->desc;
+
+  // Create texture
   WGPUTextureDescriptor texture_desc = {
     .size          = (WGPUExtent3D) {
-      .width               = image_desc->width,
-      .height              = image_desc->height,
-      .depthOrArrayLayers  = 1,
+      .width               = desc->width,
+      .height              = desc->height,
+      .depthOrArrayLayers  = desc->image_count,
      },
-    .mipLevelCount = image_desc->level_count,
+    .mipLevelCount = desc->level_count,
     .sampleCount   = 1,
     .dimension     = WGPUTextureDimension_2D,
-    .format        = image_desc->format,
+    .format        = desc->format,
     .usage         = WGPUTextureUsage_CopyDst | WGPUTextureUsage_TextureBinding,
   };
   WGPUTexture texture
@@ -1260,40 +2572,29 @@ wgpu_texture_load_from_basis_file(wgpu_context_t* wgpu_context,
   WGPUCommandEncoder cmd_encoder
     = wgpuDeviceCreateCommandEncoder(wgpu_context->device, NULL);
 
-  for (uint32_t level = 0; level < image_desc->level_count; ++level) {
-    uint32_t width  = image_desc->width >> level;
-    uint32_t height = image_desc->height >> level;
-    if (height == 0) {
-      height = 1;
-    }
-
-    // Create a host-visible staging buffer that contains the raw image data
-    size_t texture_size = image_desc->levels[level].size * 4;
-    WGPUBufferDescriptor staging_buffer_desc = {
-      .usage            = WGPUBufferUsage_CopySrc | WGPUBufferUsage_MapWrite,
-      .size             = texture_size,
-      .mappedAtCreation = true,
-    };
-    WGPUBuffer staging_buffer
-      = wgpuDeviceCreateBuffer(wgpu_context->device, &staging_buffer_desc);
-    ASSERT(staging_buffer)
-
-    // Copy texture data into staging buffer
-    void* mapping = wgpuBufferGetMappedRange(staging_buffer, 0, texture_size);
-    ASSERT(mapping)
-    memcpy(mapping, image_desc->levels[level].ptr,
-           image_desc->levels[level].size);
-    wgpuBufferUnmap(staging_buffer);
-
-    // Upload statging buffer to texture
+  // Stage all levels at once, they are already laid out for the copies
+  wgpu_staging_allocation_t allocation = {0};
+  wgpu_staging_belt_allocate(wgpu_context->staging_belt, cmd_encoder,
+                             image->size, WGPU_STAGING_BELT_TEXTURE_ALIGNMENT,
+                             &allocation);
+  ASSERT(allocation.data)
+  memcpy(allocation.data, image->data, image->size);
+
+  for (uint32_t level = 0; level < desc->level_count; ++level) {
+    const uint32_t width = MAX(1u, desc->width >> level);
+    const uint32_t blocks_x
+      = (width + desc->block_width - 1) / desc->block_width;
+
+    // Upload all faces of the level, the copy covers the physical size of the
+    // level, which is rounded up to whole blocks
     wgpuCommandEncoderCopyBufferToTexture(cmd_encoder,
       // Source
       &(WGPUImageCopyBuffer) {
-        .buffer = staging_buffer,
+        .buffer = allocation.buffer,
         .layout = (WGPUTextureDataLayout) {
-          .offset = 0,
-          .bytesPerRow = texture_size / height,
-          .rowsPerImage= height,
+          .offset = allocation.offset + image->levels[level].offset,
+          .bytesPerRow = image->levels[level].row_pitch,
+          .rowsPerImage= image->levels[level].rows,
         },
       },
       // Destination
@@ -1309,14 +2610,15 @@ wgpu_texture_load_from_basis_file(wgpu_context_t* wgpu_context,
       },
       // Copy size
       &(WGPUExtent3D){
-        .width               = MAX(1u, width),
-        .height              = MAX(1u, height),
-        .depthOrArrayLayers  = 1,
+        .width               = blocks_x * desc->block_width,
+        .height              = image->levels[level].rows * desc->block_height,
+        .depthOrArrayLayers  = desc->image_count,
       });
-
-    WGPU_RELEASE_RESOURCE(Buffer, staging_buffer);
   }
 
+  // The staging chunks of the encoder have to be unmapped before the submit,
+  // the chunks of other encoders that are still recording stay mapped
+  wgpu_staging_belt_finish(wgpu_context->staging_belt, cmd_encoder);
   WGPUCommandBuffer command_buffer
     = wgpuCommandEncoderFinish(cmd_encoder, NULL);
   WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
@@ -1324,16 +2626,8 @@ wgpu_texture_load_from_basis_file(wgpu_context_t* wgpu_context,
   // Sumbit commmand buffer and cleanup
   ASSERT(command_buffer != NULL)
 
-  // Submit to the queue
-  wgpuQueueSubmit(wgpu_context->queue, 1, &command_buffer);
-
-  // Release command buffer
-  WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
-
-  // Clean up staging resources
-  basisu_free(image_desc);
-  basisu_shutdown();
-  free(file_read_result.data);
+  // Submit to the queue, batched writes are flushed before
+  wgpu_flush_command_buffers(wgpu_context, &command_buffer, 1);
 
   return (texture_result_t){
     .texture         = texture,
@@ -1346,21 +2640,56 @@ wgpu_texture_load_from_basis_file(wgpu_context_t* wgpu_context,
   };
 }
 
-static texture_result_t wgpu_texture_client_load_texture_from_file(
+static bool wgpu_texture_client_decode_texture_from_file(
   struct wgpu_texture_client_t* texture_client, const char* filename,
-  struct wgpu_texture_load_options_t* options)
+  struct wgpu_texture_load_options_t* options, wgpu_texture_data_t* data)
 {
   if (filename_has_extension(filename, "jpg")
       || filename_has_extension(filename, "png")) {
-    return wgpu_texture_load_with_stb(texture_client, filename, options);
+    bool srgb = false;
+    if (stb_image_use_compression(texture_client->wgpu_context, options,
+                                  &srgb)) {
+      return stb_image_load_compressed(texture_client->wgpu_context,
+                                       filename, options, srgb, data);
+    }
+    const bool flip_y = options ? options->flip_y : false;
+    data->type        = TextureDataType_Stb;
+    data->image.stb   = stb_image_load_image_from_file(filename, flip_y);
+    return data->image.stb.pixel_data != NULL;
   }
   else if (filename_has_extension(filename, "ktx")) {
-    return wgpu_texture_load_from_ktx_file(texture_client->wgpu_context,
-                                           filename);
+    data->type = TextureDataType_Ktx;
+    return ktx_image_load_from_file(filename, &data->image.ktx)
+           && ktx_image_check_format_support(texture_client->wgpu_context,
+                                             filename, &data->image.ktx);
   }
   else if (filename_has_extension(filename, "basis")) {
-    return wgpu_texture_load_from_basis_file(texture_client->wgpu_context,
-                                             filename);
+    data->type = TextureDataType_Basis;
+    return basis_image_load_from_file(texture_client, filename,
+                                      &data->image.basis);
+  }
+
+  return false;
+}
+
+static texture_result_t wgpu_texture_client_upload_texture_data(
+  struct wgpu_texture_client_t* texture_client, wgpu_texture_data_t* data,
+  struct wgpu_texture_load_options_t* options)
+{
+  if (!texture_client->wgpu_context) {
+    log_error("Cannot create new textures after object has been destroyed.");
+    return (texture_result_t){0};
+  }
+
+  switch (data->type) {
+    case TextureDataType_Stb:
+      return wgpu_texture_upload_stb(texture_client, &data->image.stb, options);
+    case TextureDataType_Ktx:
+      return wgpu_texture_upload_ktx(texture_client->wgpu_context,
+                                     &data->image.ktx);
+    case TextureDataType_Basis:
+      return wgpu_texture_upload_basis(texture_client->wgpu_context,
+                                       &data->image.basis);
   }
 
   return (texture_result_t){0};
@@ -1449,28 +2778,73 @@ wgpu_texture_client_create(wgpu_context_t* wgpu_context)
   }
 
   {
-    static const WGPUTextureFormat supported_format_list[12] = {
-      // Uncompressed format list
-      WGPUTextureFormat_RGBA8Unorm,
-      WGPUTextureFormat_RGBA8UnormSrgb,
-      WGPUTextureFormat_BGRA8Unorm,
-      WGPUTextureFormat_BGRA8UnormSrgb,
-      // Compressed format list
-      WGPUTextureFormat_BC1RGBAUnorm,
-      WGPUTextureFormat_BC1RGBAUnormSrgb,
-      WGPUTextureFormat_BC2RGBAUnorm,
-      WGPUTextureFormat_BC2RGBAUnormSrgb,
-      WGPUTextureFormat_BC3RGBAUnorm,
-      WGPUTextureFormat_BC3RGBAUnormSrgb,
-      WGPUTextureFormat_BC7RGBAUnorm,
-      WGPUTextureFormat_BC7RGBAUnormSrgb,
+    // Uncompressed formats and the compressed formats of the texture
+    // compression features the device supports, basis files are transcoded to
+    // one of them
+    static const struct {
+      WGPUFeatureName feature;
+      WGPUTextureFormat formats[8];
+      size_t count;
+    } format_groups[4] = {
+      {
+        .feature = WGPUFeatureName_Undefined,
+        .formats = {
+          WGPUTextureFormat_RGBA8Unorm,
+          WGPUTextureFormat_RGBA8UnormSrgb,
+          WGPUTextureFormat_BGRA8Unorm,
+          WGPUTextureFormat_BGRA8UnormSrgb,
+        },
+        .count = 4,
+      },
+      {
+        .feature = WGPUFeatureName_TextureCompressionBC,
+        .formats = {
+          WGPUTextureFormat_BC1RGBAUnorm,
+          WGPUTextureFormat_BC1RGBAUnormSrgb,
+          WGPUTextureFormat_BC2RGBAUnorm,
+          WGPUTextureFormat_BC2RGBAUnormSrgb,
+          WGPUTextureFormat_BC3RGBAUnorm,
+          WGPUTextureFormat_BC3RGBAUnormSrgb,
+          WGPUTextureFormat_BC7RGBAUnorm,
+          WGPUTextureFormat_BC7RGBAUnormSrgb,
+        },
+        .count = 8,
+      },
+      {
+        .feature = WGPUFeatureName_TextureCompressionETC2,
+        .formats = {
+          WGPUTextureFormat_ETC2RGB8Unorm,
+          WGPUTextureFormat_ETC2RGB8UnormSrgb,
+          WGPUTextureFormat_ETC2RGBA8Unorm,
+          WGPUTextureFormat_ETC2RGBA8UnormSrgb,
+        },
+        .count = 4,
+      },
+      {
+        .feature = WGPUFeatureName_TextureCompressionASTC,
+        .formats = {
+          WGPUTextureFormat_ASTC4x4Unorm,
+          WGPUTextureFormat_ASTC4x4UnormSrgb,
+        },
+        .count = 2,
+      },
     };
-    memcpy(texture_client->supported_format_list.values, supported_format_list,
-           sizeof(supported_format_list));
-    texture_client->allow_compressed_formats = wgpuDeviceHasFeature(
-      wgpu_context->device, WGPUFeatureName_TextureCompressionBC);
-    texture_client->supported_format_list.count
-      = texture_client->allow_compressed_formats ? 12 : 4;
+    size_t count = 0;
+    for (uint32_t i = 0; i < (uint32_t)ARRAY_SIZE(format_groups); ++i) {
+      if (format_groups[i].feature != WGPUFeatureName_Undefined
+          && !wgpu_has_feature(wgpu_context, format_groups[i].feature)) {
+        continue;
+      }
+      ASSERT(count + format_groups[i].count
+             <= ARRAY_SIZE(texture_client->supported_format_list.values));
+      memcpy(&texture_client->supported_format_list.values[count],
+             format_groups[i].formats,
+             format_groups[i].count * sizeof(WGPUTextureFormat));
+      count += format_groups[i].count;
+    }
+    texture_client->supported_format_list.count = count;
+    texture_client->allow_compressed_formats
+      = count > texture_client->uncompressed_format_list.count;
   }
 
   return texture_client;
@@ -1483,6 +2857,12 @@ void wgpu_texture_client_destroy(struct wgpu_texture_client_t* texture_client)
       wgpu_mipmap_generator_destroy(texture_client->wgpu_mipmap_generator);
       texture_client->wgpu_mipmap_generator = NULL;
     }
+    pthread_mutex_lock(&basisu_mutex);
+    if (texture_client->holds_basisu && --basisu_ref_count == 0
+        && basisu_is_initialized()) {
+      basisu_shutdown();
+    }
+    pthread_mutex_unlock(&basisu_mutex);
     free(texture_client);
     texture_client = NULL;
   }
@@ -1507,19 +2887,78 @@ void get_supported_formats(struct wgpu_texture_client_t* texture_client,
  * Helper functions
  * -------------------------------------------------------------------------- */
 
+wgpu_texture_data_t*
+wgpu_texture_data_load_from_memory(const void* data, size_t data_size,
+                                   struct wgpu_texture_load_options_t* options)
+{
+  const bool flip_y = options ? options->flip_y : false;
+  stb_image_load_result_t image
+    = stb_image_load_image_from_memory(data, data_size, flip_y);
+  if (image.pixel_data == NULL) {
+    return NULL;
+  }
+
+  wgpu_texture_data_t* texture_data
+    = (wgpu_texture_data_t*)calloc(1, sizeof(wgpu_texture_data_t));
+  texture_data->type      = TextureDataType_Stb;
+  texture_data->image.stb = image;
+  return texture_data;
+}
+
+wgpu_texture_data_t*
+wgpu_texture_data_load_from_file(wgpu_context_t* wgpu_context,
+                                 const char* filename,
+                                 struct wgpu_texture_load_options_t* options)
+{
+  ASSERT(wgpu_context->texture_client != NULL);
+
+  wgpu_texture_data_t* texture_data
+    = (wgpu_texture_data_t*)calloc(1, sizeof(wgpu_texture_data_t));
+  if (!wgpu_texture_client_decode_texture_from_file(
+        wgpu_context->texture_client, filename, options, texture_data)) {
+    free(texture_data);
+    return NULL;
+  }
+  return texture_data;
+}
+
+void wgpu_texture_data_destroy(wgpu_texture_data_t* texture_data)
+{
+  if (texture_data == NULL) {
+    return;
+  }
+
+  switch (texture_data->type) {
+    case TextureDataType_Stb:
+      stbi_image_free(texture_data->image.stb.pixel_data);
+      break;
+    case TextureDataType_Ktx:
+      ktx_image_destroy(&texture_data->image.ktx);
+      break;
+    case TextureDataType_Basis:
+      basis_image_destroy(&texture_data->image.basis);
+      break;
+  }
+  free(texture_data);
+}
+
 texture_t
-wgpu_create_texture_from_memory(wgpu_context_t* wgpu_context, void* data,
-                                size_t data_size,
-                                struct wgpu_texture_load_options_t* options)
+wgpu_create_texture_from_data(wgpu_context_t* wgpu_context,
+                              wgpu_texture_data_t* texture_data,
+                              struct wgpu_texture_load_options_t* options)
 {
+  if (texture_data == NULL) {
+    return (texture_t){0};
+  }
+
   if (wgpu_context->texture_client == NULL) {
     wgpu_create_texture_client(wgpu_context);
   }
   struct wgpu_texture_client_t* texture_client = wgpu_context->texture_client;
 
-  texture_result_t texture_result
-    = wgpu_texture_client_load_texture_from_memory(texture_client, data,
-                                                   data_size, options);
+  texture_result_t texture_result = wgpu_texture_client_upload_texture_data(
+    texture_client, texture_data, options);
+  wgpu_texture_data_destroy(texture_data);
 
   if (texture_result.texture) {
     return wgpu_create_texture(texture_client->wgpu_context, &texture_result,
@@ -1529,6 +2968,16 @@ wgpu_create_texture_from_memory(wgpu_context_t* wgpu_context, void* data,
   return (texture_t){0};
 }
 
+texture_t
+wgpu_create_texture_from_memory(wgpu_context_t* wgpu_context, void* data,
+                                size_t data_size,
+                                struct wgpu_texture_load_options_t* options)
+{
+  wgpu_texture_data_t* texture_data
+    = wgpu_texture_data_load_from_memory(data, data_size, options);
+  return wgpu_create_texture_from_data(wgpu_context, texture_data, options);
+}
+
 texture_t
 wgpu_create_texture_from_file(wgpu_context_t* wgpu_context,
                               const char* filename,
@@ -1537,17 +2986,74 @@ wgpu_create_texture_from_file(wgpu_context_t* wgpu_context,
   if (wgpu_context->texture_client == NULL) {
     wgpu_create_texture_client(wgpu_context);
   }
-  struct wgpu_texture_client_t* texture_client = wgpu_context->texture_client;
 
-  texture_result_t texture_result = wgpu_texture_client_load_texture_from_file(
-    texture_client, filename, options);
+  wgpu_texture_data_t* texture_data
+    = wgpu_texture_data_load_from_file(wgpu_context, filename, options);
+  return wgpu_create_texture_from_data(wgpu_context, texture_data, options);
+}
 
-  if (texture_result.texture) {
-    return wgpu_create_texture(texture_client->wgpu_context, &texture_result,
-                               options);
+/* Asynchronous texture loading */
+
+typedef struct {
+  wgpu_context_t* wgpu_context;
+  char filename[STRMAX];
+  struct wgpu_texture_load_options_t options;
+  bool has_options;
+  texture_t* texture;
+} texture_async_load_t;
+
+static void* texture_async_decode(void* user_data)
+{
+  texture_async_load_t* load = (texture_async_load_t*)user_data;
+  return wgpu_texture_data_load_from_file(
+    load->wgpu_context, load->filename,
+    load->has_options ? &load->options : NULL);
+}
+
+static bool texture_async_upload(wgpu_context_t* wgpu_context, void* decoded,
+                                 void* user_data)
+{
+  texture_async_load_t* load = (texture_async_load_t*)user_data;
+
+  bool ready = false;
+  if (decoded != NULL) {
+    *load->texture = wgpu_create_texture_from_data(
+      wgpu_context, (wgpu_texture_data_t*)decoded,
+      load->has_options ? &load->options : NULL);
+    ready = load->texture->texture != NULL;
   }
+  free(load);
+  return ready;
+}
 
-  return (texture_t){0};
+wgpu_asset_t*
+wgpu_create_texture_from_file_async(wgpu_context_t* wgpu_context,
+                                    const char* filename,
+                                    struct wgpu_texture_load_options_t* options,
+                                    texture_t* texture)
+{
+  // The decode job reads the supported format list of the texture client
+  if (wgpu_context->texture_client == NULL) {
+    wgpu_create_texture_client(wgpu_context);
+  }
+
+  texture_async_load_t* load
+    = (texture_async_load_t*)calloc(1, sizeof(texture_async_load_t));
+  load->wgpu_context = wgpu_context;
+  load->has_options  = options != NULL;
+  load->texture      = texture;
+  snprintf(load->filename, sizeof(load->filename), "%s", filename);
+  if (options != NULL) {
+    load->options = *options;
+  }
+
+  wgpu_asset_desc_t asset_desc = {
+    .label     = filename,
+    .decode    = texture_async_decode,
+    .upload    = texture_async_upload,
+    .user_data = load,
+  };
+  return wgpu_load_asset_async(wgpu_context, &asset_desc);
 }
 
 texture_t wgpu_create_texture_cubemap_from_files(
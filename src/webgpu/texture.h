@@ -1,6 +1,7 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include "asset_loader.h"
 #include "context.h"
 
 typedef enum color_space_enum_t {
@@ -43,10 +44,21 @@ void wgpu_destroy_texture(texture_t* texture);
 /* Mip map generator */
 typedef struct wgpu_mipmap_generator wgpu_mipmap_generator_t;
 
+/* Mip map generation strategy */
+typedef enum wgpu_mipmap_generator_mode_enum {
+  /* Compute shader (two dispatches) for 2D textures up to 4096x4096 in RGBA8,
+   * BGRA8 (incl. sRGB), RGBA16Float or RGBA32Float, render passes otherwise */
+  MipmapGeneratorMode_Auto = 0,
+  /* One render pass per mip level and array layer */
+  MipmapGeneratorMode_Render = 1,
+} wgpu_mipmap_generator_mode_enum;
+
 /* Mip map generator construction / destruction */
 wgpu_mipmap_generator_t*
 wgpu_mipmap_generator_create(wgpu_context_t* wgpu_context);
 void wgpu_mipmap_generator_destroy(wgpu_mipmap_generator_t* mipmap_generator);
+void wgpu_mipmap_generator_set_mode(wgpu_mipmap_generator_t* mipmap_generator,
+                                    wgpu_mipmap_generator_mode_enum mode);
 
 /* Mip map generator factory function */
 WGPURenderPipeline wgpu_mipmap_generator_get_mipmap_pipeline(
@@ -54,6 +66,8 @@ WGPURenderPipeline wgpu_mipmap_generator_get_mipmap_pipeline(
 
 /**
  * @brief Generates mipmaps for the given GPUTexture from the data in level 0.
+ * The compute path requires TextureBinding and CopyDst usage, the render path
+ * uses RenderAttachment usage when available.
  *
  * @param {wgpu_mipmap_generator_t*} mipmap_generator - The mip map generator.
  * @param {WGPUTexture*} texture - Texture to generate mipmaps for.
@@ -66,6 +80,12 @@ wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator,
                                       WGPUTexture texture,
                                       WGPUTextureDescriptor* texture_desc);
 
+/**
+ * @brief Compares the render pass and the compute mip map generators on RGBA8
+ * textures from 256x256 up to 4096x4096, prints the results to stdout.
+ */
+void wgpu_mipmap_generator_benchmark(wgpu_context_t* wgpu_context);
+
 /* -------------------------------------------------------------------------- *
  * WebGPU Texture Client
  * -------------------------------------------------------------------------- */
@@ -74,14 +94,15 @@ typedef struct wgpu_texture_client_t {
   wgpu_context_t* wgpu_context;
   wgpu_mipmap_generator_t* wgpu_mipmap_generator;
   bool allow_compressed_formats;
+  bool holds_basisu; /* holds a reference to the Basis Universal setup */
   struct {
     WGPUTextureFormat values[4];
     size_t count;
   } uncompressed_format_list;
   struct {
-    WGPUTextureFormat values[12];
+    WGPUTextureFormat values[18];
     size_t count;
-  } supported_format_list;
+  } supported_format_list; /* depends on the texture compression features */
 } wgpu_texture_client;
 
 typedef struct wgpu_texture_load_options_t {
@@ -113,6 +134,33 @@ void get_supported_formats(struct wgpu_texture_client_t* texture_client,
  * Texture creation functions
  * -------------------------------------------------------------------------- */
 
+/* Decoded texture data, created on any thread and uploaded on the main thread
+ */
+typedef struct wgpu_texture_data_t wgpu_texture_data_t;
+
+/* Image decoding from memory (jpg, png, hdr), returns NULL on failure */
+wgpu_texture_data_t*
+wgpu_texture_data_load_from_memory(const void* data, size_t data_size,
+                                   struct wgpu_texture_load_options_t* options);
+
+/**
+ * @brief Reads and decodes a jpg, png, ktx or basis file without touching the
+ * GPU, can be called from worker threads once the texture client is created.
+ * @return the decoded texture data or NULL on failure
+ */
+wgpu_texture_data_t*
+wgpu_texture_data_load_from_file(wgpu_context_t* wgpu_context,
+                                 const char* filename,
+                                 struct wgpu_texture_load_options_t* options);
+
+void wgpu_texture_data_destroy(wgpu_texture_data_t* texture_data);
+
+/* Texture creation from decoded data, takes ownership of the data */
+texture_t
+wgpu_create_texture_from_data(wgpu_context_t* wgpu_context,
+                              wgpu_texture_data_t* texture_data,
+                              struct wgpu_texture_load_options_t* options);
+
 /* Texture creation from memory */
 texture_t
 wgpu_create_texture_from_memory(wgpu_context_t* wgpu_context, void* data,
@@ -125,6 +173,18 @@ wgpu_create_texture_from_file(wgpu_context_t* wgpu_context,
                               const char* filename,
                               struct wgpu_texture_load_options_t* options);
 
+/**
+ * @brief Decodes the file on a job worker and creates the texture on the main
+ * thread, the texture is written once the asset is ready and must stay valid
+ * until then.
+ * @return an asset handle the caller releases with wgpu_asset_release
+ */
+wgpu_asset_t*
+wgpu_create_texture_from_file_async(wgpu_context_t* wgpu_context,
+                                    const char* filename,
+                                    struct wgpu_texture_load_options_t* options,
+                                    texture_t* texture);
+
 /* Texture cubemap creation from 6 individual image files */
 texture_t wgpu_create_texture_cubemap_from_files(
   wgpu_context_t* wgpu_context, const char* filenames[6],
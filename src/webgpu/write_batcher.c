@@ -0,0 +1,213 @@
+#include "write_batcher.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/macro.h"
+
+#include "context.h"
+
+/* Recorded write, the data lives in the staging block */
+typedef struct write_entry_t {
+  WGPUBuffer buffer; /* referenced until the write is flushed */
+  uint64_t offset;
+  uint64_t size;
+  uint64_t data_offset; /* offset into the staging block */
+  uint32_t sequence;    /* recording order, later writes win */
+} write_entry_t;
+
+struct wgpu_write_batcher_t {
+  wgpu_context_t* wgpu_context;
+  struct {
+    uint8_t* data;
+    uint64_t size;
+    uint64_t capacity;
+  } staging;
+  struct {
+    write_entry_t* data;
+    uint32_t count;
+    uint32_t capacity;
+  } entries;
+  struct {
+    uint8_t* data;
+    uint64_t capacity;
+  } scratch; /* merged data of overlapping writes */
+  wgpu_write_batcher_stats_t stats;
+};
+
+wgpu_write_batcher_t*
+wgpu_write_batcher_create(struct wgpu_context_t* wgpu_context)
+{
+  wgpu_write_batcher_t* batcher
+    = (wgpu_write_batcher_t*)calloc(1, sizeof(wgpu_write_batcher_t));
+  batcher->wgpu_context     = wgpu_context;
+  batcher->staging.capacity = WGPU_WRITE_BATCHER_STAGING_SIZE;
+  batcher->staging.data     = (uint8_t*)malloc(batcher->staging.capacity);
+
+  return batcher;
+}
+
+static void write_batcher_reset(wgpu_write_batcher_t* batcher)
+{
+  for (uint32_t i = 0; i < batcher->entries.count; ++i) {
+    wgpuBufferRelease(batcher->entries.data[i].buffer);
+  }
+  batcher->entries.count = 0;
+  batcher->staging.size  = 0;
+}
+
+void wgpu_write_batcher_destroy(wgpu_write_batcher_t* batcher)
+{
+  if (batcher == NULL) {
+    return;
+  }
+
+  /* Pending writes are dropped */
+  write_batcher_reset(batcher);
+  free(batcher->staging.data);
+  free(batcher->entries.data);
+  free(batcher->scratch.data);
+  free(batcher);
+}
+
+void wgpu_write_batcher_write(wgpu_write_batcher_t* batcher, WGPUBuffer buffer,
+                              uint64_t buffer_offset, const void* data,
+                              uint64_t size)
+{
+  if (buffer == NULL || size == 0) {
+    return;
+  }
+
+  /* Copy the data, the caller may reuse its memory right away */
+  if (batcher->staging.size + size > batcher->staging.capacity) {
+    while (batcher->staging.size + size > batcher->staging.capacity) {
+      batcher->staging.capacity *= 2;
+    }
+    batcher->staging.data = (uint8_t*)realloc(batcher->staging.data,
+                                              batcher->staging.capacity);
+  }
+  const uint64_t data_offset = batcher->staging.size;
+  memcpy(batcher->staging.data + data_offset, data, size);
+  batcher->staging.size += size;
+
+  ++batcher->stats.write_count;
+  batcher->stats.write_bytes += size;
+
+  /* Sequential writes to the same buffer extend the previous entry */
+  if (batcher->entries.count > 0) {
+    write_entry_t* last = &batcher->entries.data[batcher->entries.count - 1];
+    if (last->buffer == buffer && last->offset + last->size == buffer_offset
+        && last->data_offset + last->size == data_offset) {
+      last->size += size;
+      return;
+    }
+  }
+
+  if (batcher->entries.count == batcher->entries.capacity) {
+    batcher->entries.capacity = MAX(batcher->entries.capacity * 2, 64u);
+    batcher->entries.data     = (write_entry_t*)realloc(
+      batcher->entries.data, batcher->entries.capacity * sizeof(write_entry_t));
+  }
+  wgpuBufferReference(buffer);
+  batcher->entries.data[batcher->entries.count] = (write_entry_t){
+    .buffer      = buffer,
+    .offset      = buffer_offset,
+    .size        = size,
+    .data_offset = data_offset,
+    .sequence    = batcher->entries.count,
+  };
+  ++batcher->entries.count;
+}
+
+/* Orders by buffer, then by offset, then by recording order */
+static int compare_write_entries(const void* a, const void* b)
+{
+  const write_entry_t* ea = (const write_entry_t*)a;
+  const write_entry_t* eb = (const write_entry_t*)b;
+  const uintptr_t ba = (uintptr_t)ea->buffer, bb = (uintptr_t)eb->buffer;
+  if (ba != bb) {
+    return (ba > bb) - (ba < bb);
+  }
+  if (ea->offset != eb->offset) {
+    return (ea->offset > eb->offset) - (ea->offset < eb->offset);
+  }
+  return (ea->sequence > eb->sequence) - (ea->sequence < eb->sequence);
+}
+
+static int compare_write_sequences(const void* a, const void* b)
+{
+  const write_entry_t* ea = (const write_entry_t*)a;
+  const write_entry_t* eb = (const write_entry_t*)b;
+  return (ea->sequence > eb->sequence) - (ea->sequence < eb->sequence);
+}
+
+static void write_batcher_emit(wgpu_write_batcher_t* batcher, WGPUBuffer buffer,
+                               uint64_t offset, const void* data, uint64_t size)
+{
+  wgpuQueueWriteBuffer(batcher->wgpu_context->queue, buffer, offset, data,
+                       size);
+  ++batcher->stats.copy_count;
+  batcher->stats.copy_bytes += size;
+}
+
+void wgpu_write_batcher_flush(wgpu_write_batcher_t* batcher)
+{
+  if (batcher == NULL || batcher->entries.count == 0) {
+    return;
+  }
+
+  write_entry_t* entries = batcher->entries.data;
+  const uint32_t count   = batcher->entries.count;
+  qsort(entries, count, sizeof(write_entry_t), compare_write_entries);
+
+  for (uint32_t i = 0; i < count;) {
+    /* Collect the range of writes that overlap or touch each other */
+    const uint64_t start = entries[i].offset;
+    uint64_t end         = start + entries[i].size;
+    bool overlapping     = false;
+    uint32_t j           = i + 1;
+    for (; j < count && entries[j].buffer == entries[i].buffer
+           && entries[j].offset <= end;
+         ++j) {
+      overlapping = overlapping || entries[j].offset < end;
+      end         = MAX(end, entries[j].offset + entries[j].size);
+    }
+
+    if (j == i + 1) {
+      write_batcher_emit(batcher, entries[i].buffer, start,
+                         batcher->staging.data + entries[i].data_offset,
+                         entries[i].size);
+      i = j;
+      continue;
+    }
+
+    /* Assemble the merged range, overlapping writes are applied in
+     * recording order */
+    const uint64_t size = end - start;
+    if (size > batcher->scratch.capacity) {
+      batcher->scratch.capacity = size;
+      batcher->scratch.data
+        = (uint8_t*)realloc(batcher->scratch.data, batcher->scratch.capacity);
+    }
+    if (overlapping) {
+      qsort(&entries[i], j - i, sizeof(write_entry_t),
+            compare_write_sequences);
+    }
+    for (uint32_t k = i; k < j; ++k) {
+      memcpy(batcher->scratch.data + (entries[k].offset - start),
+             batcher->staging.data + entries[k].data_offset, entries[k].size);
+    }
+    write_batcher_emit(batcher, entries[i].buffer, start,
+                       batcher->scratch.data, size);
+    i = j;
+  }
+
+  ++batcher->stats.flush_count;
+  write_batcher_reset(batcher);
+}
+
+void wgpu_write_batcher_get_stats(wgpu_write_batcher_t* batcher,
+                                  wgpu_write_batcher_stats_t* stats)
+{
+  *stats = batcher->stats;
+}
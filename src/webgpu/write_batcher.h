@@ -0,0 +1,47 @@
+#ifndef WRITE_BATCHER_H
+#define WRITE_BATCHER_H
+
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+/* Initial size of the CPU staging block, it grows on demand */
+#define WGPU_WRITE_BATCHER_STAGING_SIZE (64u * 1024u)
+
+/* Forward declarations */
+struct wgpu_context_t;
+
+typedef struct wgpu_write_batcher_t wgpu_write_batcher_t;
+
+typedef struct wgpu_write_batcher_stats_t {
+  uint64_t write_count; /* buffer writes recorded */
+  uint64_t write_bytes; /* bytes recorded, including overwritten bytes */
+  uint64_t copy_count;  /* queue writes emitted by the flushes */
+  uint64_t copy_bytes;  /* bytes uploaded by the flushes */
+  uint64_t flush_count; /* flushes that emitted at least one queue write */
+} wgpu_write_batcher_stats_t;
+
+/* Write batcher creating/releasing */
+wgpu_write_batcher_t*
+wgpu_write_batcher_create(struct wgpu_context_t* wgpu_context);
+void wgpu_write_batcher_destroy(wgpu_write_batcher_t* batcher);
+
+/**
+ * @brief Copies data into the CPU staging block, the write is applied to the
+ * buffer by the next flush. Later writes to the same range win.
+ */
+void wgpu_write_batcher_write(wgpu_write_batcher_t* batcher, WGPUBuffer buffer,
+                              uint64_t buffer_offset, const void* data,
+                              uint64_t size);
+
+/**
+ * @brief Merges overlapping and adjacent writes to the same buffer and issues
+ * one queue write per merged range. Has to be called before submitting work
+ * that reads the written buffers.
+ */
+void wgpu_write_batcher_flush(wgpu_write_batcher_t* batcher);
+
+void wgpu_write_batcher_get_stats(wgpu_write_batcher_t* batcher,
+                                  wgpu_write_batcher_stats_t* stats);
+
+#endif